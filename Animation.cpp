@@ -0,0 +1,200 @@
+#include "Animation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+namespace {
+
+// Inverse of a matrix whose last column is (0, 0, 0, 1).
+Float4x4 InverseAffine(const Float4x4& m) noexcept {
+    const float (*a)[4] = m.m;
+    float c00 = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+    float c01 = a[0][2] * a[2][1] - a[0][1] * a[2][2];
+    float c02 = a[0][1] * a[1][2] - a[0][2] * a[1][1];
+    float det = a[0][0] * c00 + a[1][0] * c01 + a[2][0] * c02;
+    float inv = det != 0.0f ? 1.0f / det : 0.0f;
+    Float4x4 r = MatrixIdentity();
+    r.m[0][0] = c00 * inv;
+    r.m[0][1] = c01 * inv;
+    r.m[0][2] = c02 * inv;
+    r.m[1][0] = (a[1][2] * a[2][0] - a[1][0] * a[2][2]) * inv;
+    r.m[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * inv;
+    r.m[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * inv;
+    r.m[2][0] = (a[1][0] * a[2][1] - a[1][1] * a[2][0]) * inv;
+    r.m[2][1] = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * inv;
+    r.m[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * inv;
+    for (int c = 0; c < 3; ++c) {
+        r.m[3][c] = -(a[3][0] * r.m[0][c] + a[3][1] * r.m[1][c] + a[3][2] * r.m[2][c]);
+    }
+    return r;
+}
+
+#if GFX_X86
+// Same sums in the same order as Multiply, one row per register.
+void MultiplySSE(const Float4x4& a, const Float4x4& b, Float4x4& out) noexcept {
+    const __m128 b0 = _mm_loadu_ps(b.m[0]), b1 = _mm_loadu_ps(b.m[1]), b2 = _mm_loadu_ps(b.m[2]), b3 = _mm_loadu_ps(b.m[3]);
+    for (int i = 0; i < 4; ++i) {
+        __m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a.m[i][0]), b0), _mm_mul_ps(_mm_set1_ps(a.m[i][1]), b1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.m[i][2]), b2));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.m[i][3]), b3));
+        _mm_storeu_ps(out.m[i], r);
+    }
+}
+#endif
+
+inline void Multiply(const Float4x4& a, const Float4x4& b, Float4x4& out, SimdLevel level) noexcept {
+#if GFX_X86
+    if (level != SimdLevel::Scalar) {
+        MultiplySSE(a, b, out);
+        return;
+    }
+#else
+    (void)level;
+#endif
+    out = gfx::Multiply(a, b);
+}
+
+// Index k of the key pair [k, k + 1] around t, clamped to the first and last pair.
+uint32_t FindKey(const float* times, uint32_t count, float t, uint32_t hint) noexcept {
+    if (hint + 1 < count && times[hint] <= t) {
+        if (t < times[hint + 1]) return hint;
+        if (hint + 2 < count && t < times[hint + 2]) return hint + 1;
+    }
+    uint32_t k = static_cast<uint32_t>(std::upper_bound(times, times + count, t) - times);
+    return std::min(k > 0 ? k - 1 : 0, count - 2);
+}
+
+Float4 Lerp(const Float4& a, const Float4& b, float t) noexcept {
+    return { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t };
+}
+
+Float3 Lerp(const Float3& a, const Float3& b, float t) noexcept {
+    return { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t };
+}
+
+Float4 Nlerp(const Float4& a, Float4 b, float t) noexcept {
+    if (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w < 0.0f) b = { -b.x, -b.y, -b.z, -b.w };
+    Float4 q = Lerp(a, b, t);
+    float length = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    float inv = length > 0.0f ? 1.0f / length : 0.0f;
+    return { q.x * inv, q.y * inv, q.z * inv, q.w * inv };
+}
+
+} // namespace
+
+void ComputeInverseBind(Skeleton& skeleton) {
+    const uint32_t count = skeleton.JointCount();
+    std::vector<Float4x4> model(count);
+    skeleton.inverseBind.resize(count);
+    for (uint32_t j = 0; j < count; ++j) {
+        Float4x4 local = JointMatrix(skeleton.bindPose[j]);
+        model[j] = skeleton.parents[j] == NoJoint ? local : Multiply(local, model[skeleton.parents[j]]);
+        skeleton.inverseBind[j] = InverseAffine(model[j]);
+    }
+}
+
+Float4x4 MatrixRotationQuaternion(const Float4& q) noexcept {
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    return { {
+        { 1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f },
+        { 2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f },
+        { 2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f },
+        { 0.0f, 0.0f, 0.0f, 1.0f }
+    } };
+}
+
+Float4x4 JointMatrix(const JointTransform& transform) noexcept {
+    Float4x4 m = MatrixRotationQuaternion(transform.rotation);
+    const float scale[3] = { transform.scale.x, transform.scale.y, transform.scale.z };
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) m.m[r][c] *= scale[r];
+    }
+    m.m[3][0] = transform.translation.x;
+    m.m[3][1] = transform.translation.y;
+    m.m[3][2] = transform.translation.z;
+    return m;
+}
+
+Float4 QuaternionRotationAxis(const Float3& axis, float angle) noexcept {
+    float s = std::sin(0.5f * angle);
+    return { axis.x * s, axis.y * s, axis.z * s, std::cos(0.5f * angle) };
+}
+
+AnimationClip::AnimationClip(uint32_t jointCount, float duration)
+    : m_duration(duration), m_jointCount(jointCount), m_tracks(size_t(jointCount) * 3) {}
+
+void AnimationClip::SetKeys(uint32_t joint, AnimationChannel channel, const float* times, const Float4* values, uint32_t count) {
+    AnimationTrack& track = m_tracks[joint * 3 + static_cast<uint32_t>(channel)];
+    track.firstKey = static_cast<uint32_t>(m_times.size());
+    track.keyCount = count;
+    m_times.insert(m_times.end(), times, times + count);
+    m_values.insert(m_values.end(), values, values + count);
+}
+
+void SampleClip(const AnimationClip& clip, const Skeleton& skeleton, float time, JointTransform* pose, AnimationCursor* cursor) {
+    const float duration = clip.Duration();
+    if (duration > 0.0f) {
+        time = std::fmod(time, duration);
+        if (time < 0.0f) time += duration;
+    } else {
+        time = 0.0f;
+    }
+    const uint32_t trackCount = clip.JointCount() * 3;
+    if (cursor && (cursor->clip != &clip || cursor->keys.size() != trackCount)) {
+        cursor->clip = &clip;
+        cursor->keys.assign(trackCount, 0);
+    }
+
+    const float* times = clip.Times();
+    const Float4* values = clip.Values();
+    const uint32_t jointCount = skeleton.JointCount();
+    for (uint32_t j = 0; j < jointCount; ++j) {
+        JointTransform& out = pose[j];
+        out = skeleton.bindPose[j];
+        if (j >= clip.JointCount()) continue;
+        for (uint32_t c = 0; c < 3; ++c) {
+            const AnimationTrack& track = clip.Track(j, static_cast<AnimationChannel>(c));
+            if (track.keyCount == 0) continue;
+            Float4 value = values[track.firstKey];
+            if (track.keyCount > 1) {
+                const float* keyTimes = times + track.firstKey;
+                uint32_t k = FindKey(keyTimes, track.keyCount, time, cursor ? cursor->keys[j * 3 + c] : 0);
+                if (cursor) cursor->keys[j * 3 + c] = k;
+                float span = keyTimes[k + 1] - keyTimes[k];
+                float t = span > 0.0f ? std::min(std::max((time - keyTimes[k]) / span, 0.0f), 1.0f) : 0.0f;
+                const Float4& a = values[track.firstKey + k];
+                const Float4& b = values[track.firstKey + k + 1];
+                value = c == 0 ? Nlerp(a, b, t) : Lerp(a, b, t);
+            }
+            if (c == 0) out.rotation = value;
+            else if (c == 1) out.translation = { value.x, value.y, value.z };
+            else out.scale = { value.x, value.y, value.z };
+        }
+    }
+}
+
+void BlendPoses(const JointTransform* a, const JointTransform* b, float weight, uint32_t jointCount, JointTransform* out) noexcept {
+    for (uint32_t j = 0; j < jointCount; ++j) {
+        JointTransform blended;
+        blended.rotation = Nlerp(a[j].rotation, b[j].rotation, weight);
+        blended.translation = Lerp(a[j].translation, b[j].translation, weight);
+        blended.scale = Lerp(a[j].scale, b[j].scale, weight);
+        out[j] = blended;
+    }
+}
+
+void ComputeSkinMatrices(const Skeleton& skeleton, const JointTransform* pose, const Float4x4& world, Float4x4* joints,
+                         Float4x4* skin, SimdLevel level) noexcept {
+    const uint32_t count = skeleton.JointCount();
+    for (uint32_t j = 0; j < count; ++j) {
+        const uint32_t parent = skeleton.parents[j];
+        Multiply(JointMatrix(pose[j]), parent == NoJoint ? world : joints[parent], joints[j], level);
+        Multiply(skeleton.inverseBind[j], joints[j], skin[j], level);
+    }
+}
+
+} // namespace gfx
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "MathTypes.h"
+#include "Simd.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+constexpr uint32_t NoJoint = ~0u;
+
+// Local joint transform: scale, then rotation (unit quaternion xyzw), then translation.
+struct JointTransform {
+    Float4 rotation = { 0.0f, 0.0f, 0.0f, 1.0f };
+    Float3 translation = { 0.0f, 0.0f, 0.0f };
+    Float3 scale = { 1.0f, 1.0f, 1.0f };
+};
+
+// Joints are ordered so that every parent precedes its children, which lets the
+// hierarchy be resolved in one forward pass.
+struct Skeleton {
+    // parents[j] < j, or NoJoint for a root.
+    std::vector<uint32_t> parents;
+    std::vector<JointTransform> bindPose;
+    // Inverse of each joint's bind-pose model matrix, see ComputeInverseBind.
+    std::vector<Float4x4> inverseBind;
+
+    uint32_t JointCount() const noexcept { return static_cast<uint32_t>(parents.size()); }
+};
+
+// Fills inverseBind from bindPose and the hierarchy.
+void ComputeInverseBind(Skeleton& skeleton);
+
+// Same as XMMatrixRotationQuaternion.
+Float4x4 MatrixRotationQuaternion(const Float4& q) noexcept;
+// scale * rotation * translation, in the row-vector convention.
+Float4x4 JointMatrix(const JointTransform& transform) noexcept;
+// Quaternion for a rotation of angle radians about a unit axis.
+Float4 QuaternionRotationAxis(const Float3& axis, float angle) noexcept;
+
+enum class AnimationChannel : uint32_t { Rotation, Translation, Scale };
+
+struct AnimationTrack {
+    uint32_t firstKey = 0;
+    uint32_t keyCount = 0;
+};
+
+// Keyframed tracks for every joint of one skeleton. Rotation keys hold quaternions,
+// translation and scale keys use xyz. The keys of all tracks share two arrays, so a
+// clip is a few allocations however many joints it animates. A joint channel without
+// keys keeps the bind pose.
+class AnimationClip {
+public:
+    AnimationClip() = default;
+    AnimationClip(uint32_t jointCount, float duration);
+
+    // times must be ascending and within [0, Duration()]. Meant to be called once
+    // per track; calling it again appends a new set of keys for the track.
+    void SetKeys(uint32_t joint, AnimationChannel channel, const float* times, const Float4* values, uint32_t count);
+
+    float Duration() const noexcept { return m_duration; }
+    uint32_t JointCount() const noexcept { return m_jointCount; }
+    const AnimationTrack& Track(uint32_t joint, AnimationChannel channel) const noexcept {
+        return m_tracks[joint * 3 + static_cast<uint32_t>(channel)];
+    }
+    const float* Times() const noexcept { return m_times.data(); }
+    const Float4* Values() const noexcept { return m_values.data(); }
+    size_t KeyCount() const noexcept { return m_times.size(); }
+
+private:
+    float m_duration = 0.0f;
+    uint32_t m_jointCount = 0;
+    std::vector<AnimationTrack> m_tracks;
+    std::vector<float> m_times;
+    std::vector<Float4> m_values;
+};
+
+// Last key used by each track of a clip. Playback mostly moves forward by a
+// fraction of a key per frame, so sampling with a cursor checks the cached key and
+// its successor before falling back to a binary search.
+struct AnimationCursor {
+    const AnimationClip* clip = nullptr;
+    std::vector<uint32_t> keys;
+};
+
+// Samples every joint at time, wrapped into [0, Duration()) so clips loop.
+// Rotations are normalized-lerped along the shorter arc. cursor may be null.
+void SampleClip(const AnimationClip& clip, const Skeleton& skeleton, float time, JointTransform* pose,
+                AnimationCursor* cursor = nullptr);
+
+// out = a blended towards b by weight in [0, 1]; out may alias a or b.
+void BlendPoses(const JointTransform* a, const JointTransform* b, float weight, uint32_t jointCount, JointTransform* out) noexcept;
+
+// Resolves the hierarchy: joints[j] = JointMatrix(pose[j]) * joints[parent], with world
+// standing in for the parent of a root, and skin[j] = inverseBind[j] * joints[j], which takes a bind-pose vertex to world space.
+void ComputeSkinMatrices(const Skeleton& skeleton, const JointTransform* pose, const Float4x4& world, Float4x4* joints,
+                         Float4x4* skin, SimdLevel level = BestSimdLevel()) noexcept;
+
+} // namespace gfx
@@ -0,0 +1,227 @@
+#pragma once
+
+// Small timing harness for the benchmark executables: warm-up runs, repeated timed
+// runs, summary statistics, a JSON report and comparison against a report from an
+// earlier build. A case regresses when its median is slower than the baseline by
+// more than the threshold and by more than its own spread (twice the larger
+// standard deviation), so noisy cases do not raise false alarms.
+//
+// Options understood by ParseOptions:
+//   --warmup N       untimed runs per case (default 3)
+//   --reps N         timed runs per case (default 15)
+//   --filter TEXT    only cases whose name contains TEXT
+//   --json PATH      write the report
+//   --compare PATH   compare with a report written by --json
+//   --threshold PCT  allowed median slowdown in percent (default 5)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+struct Options {
+    uint32_t warmup = 3;
+    uint32_t repetitions = 15;
+    std::string filter;
+    std::string jsonPath;
+    std::string baselinePath;
+    double thresholdPercent = 5.0;
+};
+
+struct Result {
+    std::string name;
+    // Work done by one run, e.g. vertices; 0 when throughput is meaningless.
+    uint64_t items = 0;
+    uint32_t repetitions = 0;
+    double minMs = 0.0;
+    double medianMs = 0.0;
+    double meanMs = 0.0;
+    double stddevMs = 0.0;
+    double p90Ms = 0.0;
+};
+
+// Returns false and prints usage on an unknown option. Positional arguments are
+// collected for the caller.
+inline bool ParseOptions(int argc, char** argv, Options& options, std::vector<std::string>* positional = nullptr) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--warmup") && hasValue) options.warmup = static_cast<uint32_t>(atoi(argv[++i]));
+        else if (!strcmp(arg, "--reps") && hasValue) options.repetitions = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(arg, "--filter") && hasValue) options.filter = argv[++i];
+        else if (!strcmp(arg, "--json") && hasValue) options.jsonPath = argv[++i];
+        else if (!strcmp(arg, "--compare") && hasValue) options.baselinePath = argv[++i];
+        else if (!strcmp(arg, "--threshold") && hasValue) options.thresholdPercent = atof(argv[++i]);
+        else if (arg[0] != '-' && positional) positional->push_back(arg);
+        else {
+            fprintf(stderr, "usage: %s [--warmup N] [--reps N] [--filter TEXT] [--json PATH] [--compare PATH] [--threshold PCT]\n",
+                    argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+class Suite {
+public:
+    explicit Suite(const Options& options) : m_options(options) {}
+
+    // fn performs one run of the case; its return value is accumulated so the
+    // compiler cannot drop the work. Returns the statistics, valid until the next
+    // Run, or nullptr when the filter skipped the case.
+    template<typename Fn>
+    const Result* Run(const char* name, uint64_t items, Fn&& fn) {
+        if (!m_options.filter.empty() && !strstr(name, m_options.filter.c_str())) return nullptr;
+        for (uint32_t i = 0; i < m_options.warmup; ++i) m_sink += static_cast<uint64_t>(fn());
+
+        std::vector<double> times(m_options.repetitions);
+        for (double& t : times) {
+            auto start = std::chrono::steady_clock::now();
+            m_sink += static_cast<uint64_t>(fn());
+            t = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        Result r;
+        r.name = name;
+        r.items = items;
+        r.repetitions = m_options.repetitions;
+        for (double t : times) r.meanMs += t;
+        r.meanMs /= times.size();
+        for (double t : times) r.stddevMs += (t - r.meanMs) * (t - r.meanMs);
+        r.stddevMs = std::sqrt(r.stddevMs / times.size());
+        std::sort(times.begin(), times.end());
+        r.minMs = times.front();
+        r.medianMs = times.size() % 2 ? times[times.size() / 2] : 0.5 * (times[times.size() / 2 - 1] + times[times.size() / 2]);
+        r.p90Ms = times[std::min(times.size() - 1, times.size() * 9 / 10)];
+        m_results.push_back(r);
+
+        printf("%-28s %10.4f %10.4f %10.4f %8.1f%%", name, r.medianMs, r.minMs, r.p90Ms, r.meanMs > 0.0 ? 100.0 * r.stddevMs / r.meanMs : 0.0);
+        if (items) printf(" %12.2f", items / (r.medianMs * 1e3));
+        printf("\n");
+        return &m_results.back();
+    }
+
+    template<typename Fn>
+    const Result* Run(const std::string& name, uint64_t items, Fn&& fn) {
+        return Run(name.c_str(), items, std::forward<Fn>(fn));
+    }
+
+    void PrintHeader() const {
+        printf("%u warm-up + %u timed runs per case\n", m_options.warmup, m_options.repetitions);
+        printf("%-28s %10s %10s %10s %9s %12s\n", "case", "median ms", "min ms", "p90 ms", "cv", "M items/s");
+    }
+
+    const std::vector<Result>& Results() const noexcept { return m_results; }
+    uint64_t Sink() const noexcept { return m_sink; }
+
+    // Writes the report when --json was given; context is free-form key/value pairs
+    // such as the SIMD level, copied into the report so runs can be told apart.
+    bool WriteJson(const std::vector<std::pair<std::string, std::string>>& context) const {
+        if (m_options.jsonPath.empty()) return true;
+        FILE* file = fopen(m_options.jsonPath.c_str(), "w");
+        if (!file) {
+            fprintf(stderr, "cannot write %s\n", m_options.jsonPath.c_str());
+            return false;
+        }
+        fprintf(file, "{\n  \"schema\": 1,\n  \"context\": {");
+        for (size_t i = 0; i < context.size(); ++i) {
+            fprintf(file, "%s\n    \"%s\": \"%s\"", i ? "," : "", context[i].first.c_str(), context[i].second.c_str());
+        }
+        fprintf(file, "\n  },\n  \"results\": [");
+        for (size_t i = 0; i < m_results.size(); ++i) {
+            const Result& r = m_results[i];
+            fprintf(file,
+                    "%s\n    { \"name\": \"%s\", \"items\": %llu, \"repetitions\": %u, \"min_ms\": %.6f, \"median_ms\": %.6f, "
+                    "\"mean_ms\": %.6f, \"stddev_ms\": %.6f, \"p90_ms\": %.6f }",
+                    i ? "," : "", r.name.c_str(), static_cast<unsigned long long>(r.items), r.repetitions, r.minMs, r.medianMs,
+                    r.meanMs, r.stddevMs, r.p90Ms);
+        }
+        fprintf(file, "\n  ]\n}\n");
+        fclose(file);
+        printf("wrote %s\n", m_options.jsonPath.c_str());
+        return true;
+    }
+
+    // Compares with the --compare report; returns false when a case regressed or the
+    // baseline could not be read. Cases missing on either side are listed, not failed.
+    bool CompareWithBaseline() const {
+        if (m_options.baselinePath.empty()) return true;
+        std::vector<Result> baseline;
+        if (!ReadJson(m_options.baselinePath, baseline)) {
+            fprintf(stderr, "cannot read baseline %s\n", m_options.baselinePath.c_str());
+            return false;
+        }
+        printf("\ncompared with %s (threshold %.1f%%)\n", m_options.baselinePath.c_str(), m_options.thresholdPercent);
+        printf("%-28s %12s %12s %9s  %s\n", "case", "base ms", "now ms", "change", "");
+        uint32_t regressions = 0;
+        for (const Result& now : m_results) {
+            auto base = std::find_if(baseline.begin(), baseline.end(), [&](const Result& b) { return b.name == now.name; });
+            if (base == baseline.end()) {
+                printf("%-28s %12s %12.4f %9s  new\n", now.name.c_str(), "-", now.medianMs, "");
+                continue;
+            }
+            double change = base->medianMs > 0.0 ? 100.0 * (now.medianMs / base->medianMs - 1.0) : 0.0;
+            double noise = 2.0 * std::max(now.stddevMs, base->stddevMs);
+            const char* verdict = "";
+            if (change > m_options.thresholdPercent && now.medianMs - base->medianMs > noise) {
+                verdict = "REGRESSION";
+                ++regressions;
+            } else if (change < -m_options.thresholdPercent && base->medianMs - now.medianMs > noise) {
+                verdict = "faster";
+            }
+            printf("%-28s %12.4f %12.4f %+8.1f%%  %s\n", now.name.c_str(), base->medianMs, now.medianMs, change, verdict);
+        }
+        for (const Result& base : baseline) {
+            bool present = std::any_of(m_results.begin(), m_results.end(), [&](const Result& r) { return r.name == base.name; });
+            if (!present && (m_options.filter.empty() || strstr(base.name.c_str(), m_options.filter.c_str()))) {
+                printf("%-28s %12.4f %12s %9s  missing\n", base.name.c_str(), base.medianMs, "-", "");
+            }
+        }
+        printf("%u regression(s)\n", regressions);
+        return regressions == 0;
+    }
+
+private:
+    // Reads back the fields WriteJson emits; not a general JSON parser.
+    static bool ReadJson(const std::string& path, std::vector<Result>& results) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) return false;
+        std::string text;
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) text.append(buffer, read);
+        fclose(file);
+
+        auto number = [&](size_t from, size_t to, const char* key) {
+            size_t at = text.find(std::string("\"") + key + "\":", from);
+            return at < to ? atof(text.c_str() + at + strlen(key) + 3) : 0.0;
+        };
+        for (size_t at = text.find("\"name\":"); at != std::string::npos; at = text.find("\"name\":", at + 1)) {
+            size_t open = text.find('"', at + 7);
+            size_t close = open == std::string::npos ? open : text.find('"', open + 1);
+            if (close == std::string::npos) return false;
+            size_t end = text.find('}', close);
+            Result r;
+            r.name = text.substr(open + 1, close - open - 1);
+            r.medianMs = number(close, end, "median_ms");
+            r.stddevMs = number(close, end, "stddev_ms");
+            r.minMs = number(close, end, "min_ms");
+            results.push_back(r);
+        }
+        return !results.empty();
+    }
+
+    Options m_options;
+    std::vector<Result> m_results;
+    uint64_t m_sink = 0;
+};
+
+} // namespace bench
@@ -0,0 +1,404 @@
+// BVH ray queries: checks closest hits and occlusion against a brute-force loop
+// over every triangle (same intersection arithmetic, so hits must match exactly),
+// that builds with any thread count and queries at any SIMD level agree, that
+// MeshBvh::Refit after moving vertices still matches brute force, and that an
+// InstanceBvh refitted after SetTransform answers like a rebuilt one. Then
+// measures build time on a terrain and an icosphere with 1 to N threads, and
+// rays per second for coherent camera rays, incoherent rays and shadow rays,
+// scalar against SIMD on one thread and batched over the pool.
+// Usage: BvhBench [harness options] [terrainCells] [maxThreads]
+
+#include "BenchHarness.h"
+
+#include "../Bvh.h"
+
+#include "../Camera.h"
+#include "../ProceduralGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+struct Mesh {
+    std::vector<ColoredVertex> vertices;
+    std::vector<uint32_t> indices;
+
+    TriangleMesh View() const {
+        return { vertices.data(), sizeof(ColoredVertex), static_cast<uint32_t>(vertices.size()), indices.data(),
+                 static_cast<uint32_t>(indices.size() / 3) };
+    }
+};
+
+Mesh MakeTerrain(uint32_t cells, ThreadPool* pool) {
+    TerrainDesc desc;
+    desc.grid.cellsX = desc.grid.cellsZ = cells;
+    MeshCounts counts = TerrainCounts(desc);
+    Mesh mesh;
+    mesh.vertices.resize(counts.vertexCount);
+    mesh.indices.resize(counts.indexCount);
+    GenerateTerrain(desc, mesh.vertices.data(), mesh.indices.data(), pool);
+    return mesh;
+}
+
+Mesh MakeIcosphere(uint32_t frequency, ThreadPool* pool) {
+    IcosphereDesc desc;
+    desc.frequency = frequency;
+    MeshCounts counts = IcosphereCounts(desc);
+    Mesh mesh;
+    mesh.vertices.resize(counts.vertexCount);
+    mesh.indices.resize(counts.indexCount);
+    GenerateIcosphere(desc, mesh.vertices.data(), mesh.indices.data(), pool);
+    return mesh;
+}
+
+// Moller-Trumbore in the order MeshBvh evaluates it.
+bool HitTriangle(const Mesh& mesh, uint32_t triangle, const Ray& ray, float tMax, float& t, float& u, float& v) {
+    const float* p0 = mesh.vertices[mesh.indices[triangle * 3 + 0]].position;
+    const float* p1 = mesh.vertices[mesh.indices[triangle * 3 + 1]].position;
+    const float* p2 = mesh.vertices[mesh.indices[triangle * 3 + 2]].position;
+    const float e1x = p1[0] - p0[0], e1y = p1[1] - p0[1], e1z = p1[2] - p0[2];
+    const float e2x = p2[0] - p0[0], e2y = p2[1] - p0[1], e2z = p2[2] - p0[2];
+    const Float3& d = ray.direction;
+    const float px = d.y * e2z - d.z * e2y, py = d.z * e2x - d.x * e2z, pz = d.x * e2y - d.y * e2x;
+    const float det = e1x * px + e1y * py + e1z * pz;
+    const float sx = ray.origin.x - p0[0], sy = ray.origin.y - p0[1], sz = ray.origin.z - p0[2];
+    const float inv = 1.0f / det;
+    u = (sx * px + sy * py + sz * pz) * inv;
+    const float qx = sy * e1z - sz * e1y, qy = sz * e1x - sx * e1z, qz = sx * e1y - sy * e1x;
+    v = (d.x * qx + d.y * qy + d.z * qz) * inv;
+    t = (e2x * qx + e2y * qy + e2z * qz) * inv;
+    return det != 0.0f && u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= ray.tMin && t <= tMax;
+}
+
+RayHit BruteForce(const Mesh& mesh, const Ray& ray) {
+    RayHit best;
+    best.t = ray.tMax;
+    for (uint32_t i = 0; i < mesh.indices.size() / 3; ++i) {
+        float t, u, v;
+        if (HitTriangle(mesh, i, ray, best.t, t, u, v) && (t < best.t || best.triangle == NoHit)) best = { t, u, v, i, NoHit };
+    }
+    if (best.triangle == NoHit) return RayHit();
+    return best;
+}
+
+bool SameHit(const RayHit& a, const RayHit& b) {
+    return a.triangle == b.triangle && a.instance == b.instance &&
+           (a.triangle == NoHit || (a.t == b.t && a.u == b.u && a.v == b.v));
+}
+
+bool SameHits(const std::vector<RayHit>& a, const std::vector<RayHit>& b) {
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!SameHit(a[i], b[i])) return false;
+    }
+    return true;
+}
+
+Float3 RandomDirection(std::mt19937& rng) {
+    std::normal_distribution<float> normal;
+    for (;;) {
+        Float3 d = { normal(rng), normal(rng), normal(rng) };
+        if (Dot(d, d) > 1e-6f) return Normalize(d);
+    }
+}
+
+// Camera rays over a width x width image, looking down at the middle of the mesh.
+std::vector<Ray> PrimaryRays(uint32_t width, const Float3& eye, const Float3& target) {
+    CachedCamera camera;
+    camera.SetLookAt(eye, target, { 0.0f, 1.0f, 0.0f });
+    camera.SetPerspective(0.9f, 1.0f, 0.01f, 100.0f);
+    std::vector<Ray> rays(size_t(width) * width);
+    for (uint32_t y = 0; y < width; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            Ray& ray = rays[size_t(y) * width + x];
+            ray.origin = eye;
+            ray.direction = camera.RayDirection((x + 0.5f) / width * 2.0f - 1.0f, 1.0f - (y + 0.5f) / width * 2.0f);
+        }
+    }
+    return rays;
+}
+
+// Random origins inside the box around the mesh, random directions.
+std::vector<Ray> IncoherentRays(uint32_t count, const MeshBvh& bvh, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const Float3 low = bvh.BoundsMin(), size = bvh.BoundsMax() - bvh.BoundsMin();
+    std::vector<Ray> rays(count);
+    for (Ray& ray : rays) {
+        ray.origin = { low.x + size.x * unit(rng), low.y + size.y * unit(rng), low.z + size.z * unit(rng) };
+        ray.direction = RandomDirection(rng);
+    }
+    return rays;
+}
+
+// From random vertices, lifted a little along +Y, towards a fixed light.
+std::vector<Ray> ShadowRays(uint32_t count, const Mesh& mesh, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, mesh.vertices.size() - 1);
+    const Float3 light = Normalize({ 0.6f, 0.35f, 0.4f });
+    std::vector<Ray> rays(count);
+    for (Ray& ray : rays) {
+        const float* p = mesh.vertices[pick(rng)].position;
+        ray.origin = { p[0], p[1] + 1e-3f, p[2] };
+        ray.direction = light;
+        ray.tMin = 1e-4f;
+    }
+    return rays;
+}
+
+// Every sampled ray against brute force, and the occlusion answer with a cut tMax.
+bool CheckAgainstBruteForce(const Mesh& mesh, const MeshBvh& bvh, const std::vector<Ray>& rays, uint32_t samples) {
+    const uint32_t step = std::max<uint32_t>(1, static_cast<uint32_t>(rays.size()) / samples);
+    for (size_t i = 0; i < rays.size(); i += step) {
+        const RayHit expected = BruteForce(mesh, rays[i]);
+        for (SimdLevel level : { SimdLevel::Scalar, BestSimdLevel() }) {
+            RayHit hit;
+            const bool found = bvh.Intersect(rays[i], hit, level);
+            if (found != (expected.triangle != NoHit) || !SameHit(hit, expected)) return false;
+            Ray shortened = rays[i];
+            shortened.tMax = found ? expected.t * 0.5f : 1e30f;
+            const bool blocked = BruteForce(mesh, shortened).triangle != NoHit;
+            if (bvh.Occluded(rays[i], level) != found || bvh.Occluded(shortened, level) != blocked) return false;
+        }
+    }
+    return true;
+}
+
+std::vector<RayHit> Trace(const MeshBvh& bvh, const std::vector<Ray>& rays, ThreadPool* pool, SimdLevel level) {
+    std::vector<RayHit> hits(rays.size());
+    bvh.IntersectBatch(rays.data(), static_cast<uint32_t>(rays.size()), hits.data(), pool, level);
+    return hits;
+}
+
+// Builds with every thread count must give the same answers at every level.
+bool CheckDeterminism(const Mesh& mesh, const std::vector<Ray>& rays, const std::vector<uint32_t>& threadCounts) {
+    MeshBvh reference;
+    reference.Build(mesh.View());
+    const std::vector<RayHit> expected = Trace(reference, rays, nullptr, SimdLevel::Scalar);
+    for (uint32_t threads : threadCounts) {
+        ThreadPool pool(threads);
+        MeshBvh bvh;
+        bvh.Build(mesh.View(), &pool);
+        if (bvh.NodeCount() != reference.NodeCount()) return false;
+        for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 }) {
+            if (!SameHits(Trace(bvh, rays, &pool, level), expected)) return false;
+        }
+    }
+    return true;
+}
+
+// Bends the terrain, refits, and compares with brute force and with a fresh build.
+bool CheckRefit(Mesh mesh, ThreadPool* pool) {
+    MeshBvh bvh;
+    bvh.Build(mesh.View(), pool);
+    for (ColoredVertex& v : mesh.vertices) v.position[1] = v.position[1] * 1.5f + 0.1f * std::sin(v.position[0] * 9.0f);
+    bvh.Refit(mesh.View(), pool);
+    MeshBvh rebuilt;
+    rebuilt.Build(mesh.View(), pool);
+    const std::vector<Ray> rays = IncoherentRays(4096, rebuilt, 7);
+    return CheckAgainstBruteForce(mesh, bvh, rays, 256) && SameHits(Trace(bvh, rays, pool, BestSimdLevel()), Trace(rebuilt, rays, pool, BestSimdLevel()));
+}
+
+Float4x4 InstanceTransform(uint32_t i, float time) {
+    const float x = static_cast<float>(i % 8) - 3.5f, z = static_cast<float>(i / 8) - 3.5f;
+    const float scale = 0.6f + 0.05f * static_cast<float>(i % 5);
+    return Multiply(Multiply(MatrixScaling(scale, scale * 0.8f, scale), MatrixRotationY(time + 0.3f * static_cast<float>(i))),
+                    MatrixTranslation(x, 0.2f * std::sin(time + static_cast<float>(i)), z));
+}
+
+// A refitted InstanceBvh against a rebuilt one and against testing every instance.
+bool CheckInstances(const MeshBvh& mesh, ThreadPool* pool) {
+    constexpr uint32_t InstanceCount = 64;
+    InstanceBvh refitted;
+    for (uint32_t i = 0; i < InstanceCount; ++i) refitted.AddInstance(mesh, InstanceTransform(i, 0.0f));
+    refitted.Build(pool);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray> rays(4096);
+    for (Ray& ray : rays) {
+        ray.origin = { 6.0f * unit(rng), 3.0f + unit(rng), 6.0f * unit(rng) };
+        ray.direction = Normalize({ unit(rng) * 0.5f, -1.0f, unit(rng) * 0.5f });
+    }
+
+    bool ok = true;
+    for (float time : { 0.0f, 0.4f, 2.5f }) {
+        for (uint32_t i = 0; i < InstanceCount; i += time == 0.4f ? 3 : 1) refitted.SetTransform(i, InstanceTransform(i, time));
+        refitted.Refit();
+        InstanceBvh rebuilt;
+        std::vector<Float4x4> worlds(InstanceCount);
+        for (uint32_t i = 0; i < InstanceCount; ++i) {
+            worlds[i] = InstanceTransform(i, time == 0.4f && i % 3 ? 0.0f : time);
+            rebuilt.AddInstance(mesh, worlds[i]);
+        }
+        rebuilt.Build(pool);
+
+        std::vector<RayHit> a(rays.size()), b(rays.size());
+        std::vector<uint8_t> blocked(rays.size());
+        refitted.IntersectBatch(rays.data(), static_cast<uint32_t>(rays.size()), a.data(), pool);
+        rebuilt.IntersectBatch(rays.data(), static_cast<uint32_t>(rays.size()), b.data(), pool, SimdLevel::Scalar);
+        refitted.OccludedBatch(rays.data(), static_cast<uint32_t>(rays.size()), blocked.data(), pool);
+        ok &= SameHits(a, b);
+        for (size_t r = 0; r < rays.size(); r += 16) {
+            // Every instance in turn, with the same tie rule.
+            RayHit expected;
+            for (uint32_t i = 0; i < InstanceCount; ++i) {
+                // A one-instance tree moves the ray exactly as the full one does.
+                InstanceBvh single;
+                single.AddInstance(mesh, worlds[i]);
+                single.Build();
+                RayHit hit;
+                if (single.Intersect(rays[r], hit) && (hit.t < expected.t || expected.triangle == NoHit)) {
+                    expected = hit;
+                    expected.instance = i;
+                }
+            }
+            ok &= SameHit(a[r], expected) && (blocked[r] != 0) == (expected.triangle != NoHit);
+        }
+    }
+    return ok;
+}
+
+// Median of a case, 0 when the filter skipped it.
+double MedianMs(const bench::Result* result) {
+    return result ? result->medianMs : 0.0;
+}
+
+// Prints how much faster a case ran than a reference median measured before it.
+void PrintSpeedup(double referenceMs, const bench::Result* result, const char* over) {
+    if (referenceMs > 0.0 && result) printf("%28s %9.2fx over %s\n", "", referenceMs / result->medianMs, over);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Options options;
+    options.warmup = 1;
+    options.repetitions = 5;
+    std::vector<std::string> args;
+    if (!bench::ParseOptions(argc, argv, options, &args)) return 2;
+    uint32_t cells = args.size() > 0 ? std::max(atoi(args[0].c_str()), 1) : 1024;
+    uint32_t maxThreads = args.size() > 1 ? std::max(atoi(args[1].c_str()), 1) : std::max(1u, std::thread::hardware_concurrency());
+    bench::Suite suite(options);
+
+    std::vector<uint32_t> threadCounts;
+    for (uint32_t t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    ThreadPool pool(maxThreads);
+    bool ok = true;
+    {
+        Mesh terrain = MakeTerrain(96, &pool);
+        Mesh sphere = MakeIcosphere(24, &pool);
+        MeshBvh terrainBvh, sphereBvh;
+        terrainBvh.Build(terrain.View(), &pool);
+        sphereBvh.Build(sphere.View(), &pool);
+        std::vector<Ray> rays = PrimaryRays(64, { 0.1f, 0.6f, -0.8f }, {});
+        std::vector<Ray> incoherent = IncoherentRays(4096, terrainBvh, 3);
+        rays.insert(rays.end(), incoherent.begin(), incoherent.end());
+        std::vector<Ray> sphereRays = IncoherentRays(4096, sphereBvh, 5);
+        std::vector<Ray> shadows = ShadowRays(2048, terrain, 9);
+        bool brute = CheckAgainstBruteForce(terrain, terrainBvh, rays, 1024) &&
+                     CheckAgainstBruteForce(sphere, sphereBvh, sphereRays, 512) &&
+                     CheckAgainstBruteForce(terrain, terrainBvh, shadows, 512);
+        std::vector<uint32_t> buildThreads = threadCounts;
+        buildThreads.push_back(maxThreads + 3);
+        bool deterministic = CheckDeterminism(MakeTerrain(512, &pool), PrimaryRays(128, { 0.0f, 0.7f, -0.7f }, {}), buildThreads);
+        bool refit = CheckRefit(terrain, &pool);
+        bool instances = CheckInstances(sphereBvh, &pool);
+        printf("closest hits and occlusion match brute force: %s\n", brute ? "ok" : "FAILED");
+        printf("same hits for every build thread count and SIMD level: %s\n", deterministic ? "ok" : "FAILED");
+        printf("refit after moving vertices matches brute force and a rebuild: %s\n", refit ? "ok" : "FAILED");
+        printf("instance refit matches a rebuild and every instance: %s\n", instances ? "ok" : "FAILED");
+        ok &= brute && deterministic && refit && instances;
+    }
+
+    Mesh terrain = MakeTerrain(cells, &pool);
+    Mesh sphere = MakeIcosphere(std::max(1u, cells / 4), &pool);
+    struct Case {
+        const char* name;
+        const Mesh* mesh;
+        MeshBvh bvh;
+    } cases[] = { { "terrain", &terrain, {} }, { "icosphere", &sphere, {} } };
+
+    printf("\nitems are triangles for builds and refits, rays for queries; pool cases use %u threads\n", maxThreads);
+    suite.PrintHeader();
+    for (Case& c : cases) {
+        const TriangleMesh view = c.mesh->View();
+        double singleThreadMs = 0.0;
+        for (uint32_t threads : threadCounts) {
+            ThreadPool buildPool(threads);
+            const bench::Result* result = suite.Run(std::string("build/") + c.name + "/t" + std::to_string(threads), view.triangleCount, [&] {
+                c.bvh.Build(view, &buildPool);
+                return c.bvh.NodeCount();
+            });
+            if (threads == 1) singleThreadMs = MedianMs(result);
+            else PrintSpeedup(singleThreadMs, result, "one thread");
+        }
+        // Refit needs a built tree even when the filter skipped the builds.
+        if (c.bvh.NodeCount() == 0) c.bvh.Build(view, &pool);
+        suite.Run(std::string("refit/") + c.name, view.triangleCount, [&] {
+            c.bvh.Refit(view, &pool);
+            return c.bvh.NodeCount();
+        });
+    }
+
+    const MeshBvh& terrainBvh = cases[0].bvh;
+    const MeshBvh& sphereBvh = cases[1].bvh;
+    struct RaySet {
+        const char* name;
+        const MeshBvh* bvh;
+        std::vector<Ray> rays;
+        bool occlusion;
+    } sets[] = {
+        { "terrain_cam", &terrainBvh, PrimaryRays(512, { 0.1f, 0.6f, -0.8f }, {}), false },
+        { "terrain_rand", &terrainBvh, IncoherentRays(1u << 18, terrainBvh, 21), false },
+        { "terrain_shadow", &terrainBvh, ShadowRays(1u << 18, terrain, 23), true },
+        { "sphere_cam", &sphereBvh, PrimaryRays(512, { 0.0f, 0.3f, -1.5f }, {}), false },
+        { "sphere_rand", &sphereBvh, IncoherentRays(1u << 18, sphereBvh, 25), false },
+    };
+
+    const SimdLevel best = BestSimdLevel();
+    for (RaySet& set : sets) {
+        std::vector<RayHit> hits(set.rays.size());
+        std::vector<uint8_t> blocked(set.rays.size());
+        const uint32_t count = static_cast<uint32_t>(set.rays.size());
+        // Cases run on the pool carry its thread count in the name.
+        auto run = [&](ThreadPool* p, SimdLevel level) {
+            std::string name = std::string("rays/") + set.name + "/" + SimdLevelName(level);
+            if (p) name += "/t" + std::to_string(maxThreads);
+            return suite.Run(name, count, [&] {
+                uint64_t sum = 0;
+                if (set.occlusion) {
+                    set.bvh->OccludedBatch(set.rays.data(), count, blocked.data(), p, level);
+                    for (uint8_t b : blocked) sum += b;
+                } else {
+                    set.bvh->IntersectBatch(set.rays.data(), count, hits.data(), p, level);
+                    for (const RayHit& hit : hits) sum += hit.triangle;
+                }
+                return sum;
+            });
+        };
+        const double scalarMs = MedianMs(run(nullptr, SimdLevel::Scalar));
+        const bench::Result* simd = run(nullptr, best);
+        PrintSpeedup(scalarMs, simd, "scalar");
+        const double simdMs = MedianMs(simd);
+        PrintSpeedup(simdMs, run(&pool, best), "one thread");
+    }
+
+    printf("checksum %llu\n", static_cast<unsigned long long>(suite.Sink()));
+    ok &= suite.WriteJson({ { "simd", SimdLevelName(best) }, { "terrain_cells", std::to_string(cells) },
+                            { "max_threads", std::to_string(maxThreads) } });
+    ok &= suite.CompareWithBaseline();
+    printf("%s\n", ok ? "all checks passed" : "CHECKS FAILED");
+    return ok ? 0 : 1;
+}
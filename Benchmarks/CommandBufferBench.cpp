@@ -0,0 +1,95 @@
+// State changes and CPU cost of naive vs sorted-and-elided replay on the null device.
+// Usage: CommandBufferBench [draws] [frames]
+
+#include "../CommandBuffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+constexpr uint32_t PipelineCount = 8;
+constexpr uint32_t MaterialCount = 64;
+constexpr uint32_t MeshCount = 32;
+
+struct Object {
+    uint32_t pipeline;
+    uint32_t material;
+    uint32_t mesh;
+    float depth;
+};
+
+// Resource ids: meshes own a vertex and an index buffer, materials one constant buffer,
+// and one constant buffer holds viewProj for the whole frame.
+void Record(CommandBuffer& commands, const std::vector<Object>& objects, bool keyed) {
+    const ResourceId viewProjBuffer = 1;
+    const ResourceId firstMaterialBuffer = 2;
+    const ResourceId firstMeshBuffer = firstMaterialBuffer + MaterialCount;
+
+    commands.Reset();
+    commands.SetPass(0, { 1, NullResource, { 0.0f, 0.0f, 800.0f, 600.0f, 0.0f, 1.0f }, { 0, 0, 800, 600 } });
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const Object& o = objects[i];
+        DrawCommand draw = {};
+        draw.pipeline = 1 + o.pipeline;
+        draw.vertexBuffer = firstMeshBuffer + o.mesh * 2;
+        draw.vertexStride = 16;
+        draw.indexBuffer = firstMeshBuffer + o.mesh * 2 + 1;
+        draw.indexFormat = IndexFormat::UInt16;
+        draw.constantBuffers[0] = firstMaterialBuffer + o.material;
+        draw.constantBuffers[1] = viewProjBuffer;
+        draw.indexCount = 36;
+        uint64_t key = keyed ? MakeSortKey(0, o.pipeline, o.material * MeshCount + o.mesh, o.depth) : MakeSortKey(0, 0, 0, 0.0f);
+        commands.Draw(key, draw);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint32_t drawCount = argc > 1 ? atoi(argv[1]) : 10000;
+    uint32_t frames = argc > 2 ? atoi(argv[2]) : 200;
+
+    std::mt19937 rng(7);
+    std::vector<Object> objects(drawCount);
+    for (Object& o : objects) {
+        o = { static_cast<uint32_t>(rng() % PipelineCount), static_cast<uint32_t>(rng() % MaterialCount),
+              static_cast<uint32_t>(rng() % MeshCount), (rng() % 10000) / 10000.0f };
+    }
+
+    CommandBuffer commands;
+    CommandReplayer replayer;
+    NullCommandDevice device;
+
+    printf("%u draws, %u frames\n", drawCount, frames);
+    printf("%-22s %14s %14s %12s %12s %12s\n", "mode", "state/frame", "draws/frame", "record us", "sort us", "replay us");
+
+    for (int mode = 0; mode < 3; ++mode) {
+        const char* name = mode == 0 ? "naive (RenderFrame)" : (mode == 1 ? "elided, submit order" : "sorted + elided");
+        double recordUs = 0, sortUs = 0, replayUs = 0;
+        device.ResetCounters();
+        replayer.Invalidate();
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            auto t0 = std::chrono::steady_clock::now();
+            Record(commands, objects, mode == 2);
+            auto t1 = std::chrono::steady_clock::now();
+            if (mode == 2) commands.Sort();
+            auto t2 = std::chrono::steady_clock::now();
+            if (mode == 0) replayer.ReplayNaive(commands, device);
+            else replayer.Replay(commands, device);
+            auto t3 = std::chrono::steady_clock::now();
+            recordUs += std::chrono::duration<double, std::micro>(t1 - t0).count();
+            sortUs += std::chrono::duration<double, std::micro>(t2 - t1).count();
+            replayUs += std::chrono::duration<double, std::micro>(t3 - t2).count();
+        }
+        const DeviceCounters& c = device.Counters();
+        printf("%-22s %14.1f %14.1f %12.1f %12.1f %12.1f\n", name, double(c.StateChanges()) / frames, double(c.draws) / frames,
+               recordUs / frames, sortUs / frames, replayUs / frames);
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+// Regression benchmark for the platform-independent core: per-frame math (camera,
+// matrix products, transform hierarchy), vertex transform, index processing and
+// upload packing, on fixed deterministic inputs. Each case gets warm-up runs and a
+// number of timed repetitions; --json writes the statistics and --compare checks
+// them against a report from another commit, returning 1 when a case regressed.
+// Usage: CoreBench [--warmup N] [--reps N] [--filter TEXT] [--json PATH] [--compare PATH] [--threshold PCT]
+
+#include "BenchHarness.h"
+
+#include "../Camera.h"
+#include "../MeshOptimizer.h"
+#include "../ProceduralGeometry.h"
+#include "../TransformHierarchy.h"
+#include "../UploadRing.h"
+#include "../VertexQuantization.h"
+#include "../VertexTransform.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+constexpr uint32_t GridCells = 255; // 65536 vertices, the largest mesh with 16-bit indices
+constexpr uint32_t Objects = 10000;
+constexpr uint32_t FramesPerRun = 1000;
+
+struct Mesh {
+    std::vector<ColoredVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<float> x, y, z;
+    std::vector<float> positions;
+    std::vector<uint32_t> colors;
+};
+
+// Grid with its triangles shuffled, the worst case for the vertex cache optimizer.
+Mesh BuildMesh() {
+    GridDesc desc;
+    desc.cellsX = desc.cellsZ = GridCells;
+    MeshCounts counts = GridCounts(desc);
+    Mesh mesh;
+    mesh.vertices.resize(counts.vertexCount);
+    mesh.indices.resize(counts.indexCount);
+    GenerateGrid(desc, mesh.vertices.data(), mesh.indices.data());
+
+    std::mt19937 rng(7);
+    size_t triangles = mesh.indices.size() / 3;
+    for (size_t i = triangles - 1; i > 0; --i) {
+        size_t j = rng() % (i + 1);
+        for (size_t k = 0; k < 3; ++k) std::swap(mesh.indices[i * 3 + k], mesh.indices[j * 3 + k]);
+    }
+
+    size_t count = mesh.vertices.size();
+    mesh.x.resize(count);
+    mesh.y.resize(count);
+    mesh.z.resize(count);
+    SplitPositions(mesh.vertices.data(), count, mesh.x.data(), mesh.y.data(), mesh.z.data());
+    for (const ColoredVertex& v : mesh.vertices) {
+        mesh.positions.insert(mesh.positions.end(), v.position, v.position + 3);
+        mesh.colors.push_back(v.rgba);
+    }
+    return mesh;
+}
+
+std::vector<Float4x4> RandomMatrices(size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Float4x4> matrices(count);
+    for (Float4x4& m : matrices) {
+        m = Multiply(MatrixRotationY(unit(rng) * 3.14159f), MatrixTranslation(unit(rng), unit(rng), unit(rng)));
+    }
+    return matrices;
+}
+
+// Bits of a float, so results feed the sink without float-to-int overflow.
+uint32_t Bits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Options options;
+    if (!bench::ParseOptions(argc, argv, options)) return 2;
+    bench::Suite suite(options);
+
+    const Mesh mesh = BuildMesh();
+    const size_t vertexCount = mesh.vertices.size();
+    const size_t indexCount = mesh.indices.size();
+    printf("mesh: %zu vertices, %zu indices; %u objects; SIMD: %s\n", vertexCount, indexCount, Objects,
+           SimdLevelName(BestSimdLevel()));
+    suite.PrintHeader();
+
+    // Frame update: camera orbit, per-object model * viewProj, hierarchy propagation.
+    CachedCamera camera;
+    camera.SetPerspective(0.785398f, 16.0f / 9.0f, 0.1f, 500.0f);
+    float angle = 0.0f;
+    suite.Run("frame/camera_orbit", FramesPerRun, [&] {
+        uint32_t h = 0;
+        for (uint32_t i = 0; i < FramesPerRun; ++i) {
+            angle += 0.01f;
+            camera.SetOrbit({ 0.0f, 0.0f, 0.0f }, angle, 1.2f, 10.0f);
+            h ^= Bits(camera.ViewProj().m[3][2]);
+        }
+        return h;
+    });
+
+    const std::vector<Float4x4> models = RandomMatrices(Objects, 1);
+    std::vector<Float4x4> mvp(Objects);
+    suite.Run("frame/matrix_multiply", Objects, [&] {
+        const Float4x4& viewProj = camera.ViewProj();
+        for (uint32_t i = 0; i < Objects; ++i) mvp[i] = Multiply(models[i], viewProj);
+        return Bits(mvp[Objects / 2].m[3][3]);
+    });
+
+    TransformHierarchy hierarchy;
+    hierarchy.Reserve(Objects);
+    for (uint32_t i = 0; i < Objects; ++i) hierarchy.Add(models[i], i < 64 ? NoTransform : (i * 2654435761u) % (i / 2 + 1));
+    const std::vector<Float4x4> animated = RandomMatrices(Objects / 20, 2);
+    uint32_t frame = 0;
+    suite.Run("frame/transform_update", Objects, [&] {
+        // 5% of the nodes move each frame, spread over all levels.
+        for (uint32_t i = 0; i < animated.size(); ++i) hierarchy.SetLocal((i * 20 + frame) % Objects, animated[i]);
+        ++frame;
+        return hierarchy.Update();
+    });
+
+    // Vertex transform into SoA clip streams.
+    std::vector<float> cx(vertexCount), cy(vertexCount), cz(vertexCount), cw(vertexCount);
+    const ClipStreams clip = { cx.data(), cy.data(), cz.data(), cw.data() };
+    const PositionStreams streams = { mesh.x.data(), mesh.y.data(), mesh.z.data() };
+    suite.Run("vertex/split_positions", vertexCount, [&] {
+        SplitPositions(mesh.vertices.data(), vertexCount, cx.data(), cy.data(), cz.data());
+        return Bits(cx[vertexCount / 3]);
+    });
+    suite.Run("vertex/transform_scalar", vertexCount, [&] {
+        TransformPositions(streams, vertexCount, models[0], camera.ViewProj(), clip, SimdLevel::Scalar);
+        return Bits(cw[vertexCount / 3]);
+    });
+    suite.Run("vertex/transform_simd", vertexCount, [&] {
+        TransformPositions(streams, vertexCount, models[0], camera.ViewProj(), clip);
+        return Bits(cw[vertexCount / 3]);
+    });
+
+    // Index processing.
+    std::vector<uint32_t> optimized(indexCount);
+    suite.Run("index/vertex_cache_optimize", indexCount, [&] {
+        OptimizeVertexCache(optimized.data(), mesh.indices.data(), indexCount, static_cast<uint32_t>(vertexCount));
+        return optimized[indexCount / 2];
+    });
+    suite.Run("index/analyze", indexCount, [&] {
+        return AnalyzeVertexCache(optimized.data(), indexCount, static_cast<uint32_t>(vertexCount)).transformedVertices;
+    });
+    const IndexFormat indexFormat = ChooseIndexFormat(static_cast<uint32_t>(vertexCount));
+    std::vector<uint8_t> packedIndices(indexCount * IndexSize(indexFormat));
+    suite.Run("index/pack", indexCount, [&] {
+        PackIndices(packedIndices.data(), optimized.data(), indexCount, indexFormat);
+        return packedIndices[packedIndices.size() / 2];
+    });
+
+    // Upload packing: per-object constants sub-allocated from a ring, and vertex
+    // encoding into the quantized upload format.
+    UploadRing ring(Objects * ConstantBlockAlignment * 3, 2);
+    std::vector<uint8_t> uploadMemory(ring.Capacity());
+    suite.Run("upload/ring_pack", Objects, [&] {
+        ring.BeginFrame();
+        uint32_t failed = 0;
+        for (uint32_t i = 0; i < Objects; ++i) {
+            UploadAllocation block;
+            if (!ring.Allocate(sizeof(Float4x4), block)) {
+                ++failed;
+                continue;
+            }
+            memcpy(uploadMemory.data() + block.offset, &mvp[i], sizeof(Float4x4));
+        }
+        ring.EndFrame();
+        return failed + uploadMemory[ring.Capacity() / 2];
+    });
+
+    VertexFormat packedFormat;
+    packedFormat.position = PositionEncoding::UNorm16;
+    const QuantizationBounds bounds = ComputeQuantizationBounds(mesh.positions.data(), vertexCount);
+    const VertexStreams vertexStreams = { mesh.positions.data(), nullptr, nullptr, mesh.colors.data() };
+    std::vector<uint8_t> packedVertices(vertexCount * BuildVertexLayout(packedFormat).stride);
+    suite.Run("upload/encode_vertices", vertexCount, [&] {
+        EncodeVertices(vertexStreams, vertexCount, packedFormat, bounds, packedVertices.data());
+        return packedVertices[packedVertices.size() / 2];
+    });
+
+    printf("checksum %llu\n", static_cast<unsigned long long>(suite.Sink()));
+    bool ok = suite.WriteJson({ { "simd", SimdLevelName(BestSimdLevel()) }, { "vertices", std::to_string(vertexCount) },
+                                { "objects", std::to_string(Objects) } });
+    ok &= suite.CompareWithBaseline();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+// Frustum culling cost per frame against object count and thread count.
+// Usage: CullingBench [frames]
+
+#include "../FrustumCulling.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+// Unit cubes scattered through a 400-unit box around the camera orbit.
+void BuildScene(Scene& scene, uint32_t count) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> scale(0.5f, 4.0f);
+    scene.Clear();
+    scene.Reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        float s = scale(rng);
+        Float4x4 world = Multiply(Multiply(MatrixScaling(s, s, s), MatrixRotationY(angle(rng))),
+                                  MatrixTranslation(position(rng), position(rng), position(rng)));
+        scene.AddObject(world, { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f });
+    }
+}
+
+Float4x4 CameraViewProj(float phi) {
+    Float3 eye = { 30.0f * std::sin(phi), 10.0f, 30.0f * std::cos(phi) };
+    Float4x4 view = MatrixLookAtLH(eye, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+    return Multiply(view, MatrixPerspectiveFovLH(3.14159265f / 4.0f, 800.0f / 600.0f, 0.1f, 300.0f));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint32_t frames = argc > 1 ? atoi(argv[1]) : 100;
+    uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    const uint32_t objectCounts[] = { 10000, 100000, 250000, 1000000 };
+
+    printf("%10s %8s %6s %12s %10s\n", "objects", "threads", "simd", "ms/frame", "visible");
+    std::vector<uint32_t> visible;
+    Scene scene;
+    for (uint32_t count : objectCounts) {
+        BuildScene(scene, count);
+        for (uint32_t threads = 1; threads <= maxThreads; threads = threads < maxThreads && threads * 2 > maxThreads ? maxThreads : threads * 2) {
+            ThreadPool pool(threads);
+            FrustumCuller culler(pool);
+            const SimdLevel levels[] = { SimdLevel::Scalar, BestSimdLevel() };
+            for (SimdLevel level : levels) {
+                if (level == SimdLevel::Scalar && (threads != 1 || BestSimdLevel() == SimdLevel::Scalar)) continue;
+                culler.SetSimdLevel(level);
+                size_t visibleTotal = 0;
+                auto start = std::chrono::steady_clock::now();
+                for (uint32_t frame = 0; frame < frames; ++frame) {
+                    culler.Cull(scene, ExtractFrustum(CameraViewProj(frame * 0.05f)), visible);
+                    visibleTotal += visible.size();
+                }
+                auto end = std::chrono::steady_clock::now();
+                double ms = std::chrono::duration<double, std::milli>(end - start).count() / frames;
+                printf("%10u %8u %6s %12.4f %10zu\n", count, threads, SimdLevelName(level), ms, visibleTotal / frames);
+            }
+            if (threads == maxThreads) break;
+        }
+    }
+    return 0;
+}
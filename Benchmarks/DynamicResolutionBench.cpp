@@ -0,0 +1,201 @@
+// Dynamic resolution against a synthetic frame-cost model: a fixed CPU/GPU cost plus
+// a pixel cost that follows the render scale squared and a scene load that changes
+// in phases, with per-frame noise and occasional single-frame spikes. Compares the
+// hysteresis controller with one that reacts to every frame, per phase: mean scale,
+// frames over budget and scale changes. Checks that the controller gets under budget
+// in heavy phases, returns to full resolution in light ones long enough to climb
+// back from the minimum, ignores isolated spikes,
+// and that resize coalescing yields one rebuild for a burst of WM_SIZE messages.
+// Usage: DynamicResolutionBench [targetMs] [framesPerPhase] [seed]
+
+#include "../DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+struct Phase {
+    const char* name;
+    // Pixel cost at full resolution, in ms.
+    float pixelMs;
+};
+
+// Frame time = fixed part + pixel part scaled by the pixel count, plus noise.
+class FrameCostModel {
+public:
+    FrameCostModel(float fixedMs, float noise, float spikeChance, uint32_t seed)
+        : m_fixedMs(fixedMs), m_noise(noise), m_spikeChance(spikeChance), m_rng(seed) {}
+
+    float Frame(float pixelMs, float scale) {
+        std::normal_distribution<float> noise(1.0f, m_noise);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        float ms = (m_fixedMs + pixelMs * scale * scale) * std::max(0.5f, noise(m_rng));
+        if (unit(m_rng) < m_spikeChance) ms *= 3.0f;
+        return ms;
+    }
+
+private:
+    float m_fixedMs;
+    float m_noise;
+    float m_spikeChance;
+    std::mt19937 m_rng;
+};
+
+struct PhaseResult {
+    double meanScale = 0.0;
+    double overBudget = 0.0;
+    uint32_t changes = 0;
+    float measuredScale = 0.0f;
+    float finalScale = 0.0f;
+};
+
+// The second half of each phase is measured, after the controller had time to settle.
+std::vector<PhaseResult> Run(DynamicResolution& controller, const std::vector<Phase>& phases, uint32_t framesPerPhase,
+                             uint32_t seed, float spikeChance) {
+    FrameCostModel model(3.0f, 0.05f, spikeChance, seed);
+    controller.Reset();
+    std::vector<PhaseResult> results;
+    const float budget = controller.Settings().targetFrameMs;
+    for (const Phase& phase : phases) {
+        PhaseResult result;
+        uint32_t changesBefore = controller.ScaleChanges();
+        uint32_t measured = 0;
+        for (uint32_t frame = 0; frame < framesPerPhase; ++frame) {
+            float ms = model.Frame(phase.pixelMs, controller.Scale());
+            if (frame == framesPerPhase / 2) result.measuredScale = controller.Scale();
+            if (frame >= framesPerPhase / 2) {
+                result.meanScale += controller.Scale();
+                result.overBudget += ms > budget ? 1.0 : 0.0;
+                ++measured;
+            }
+            controller.Update(ms);
+        }
+        result.meanScale /= measured;
+        result.overBudget = 100.0 * result.overBudget / measured;
+        result.changes = controller.ScaleChanges() - changesBefore;
+        result.finalScale = controller.Scale();
+        results.push_back(result);
+    }
+    return results;
+}
+
+// Frames until the smoothed time has mostly followed a step in the load.
+uint32_t SmoothingFrames(const DynamicResolutionSettings& s) {
+    return static_cast<uint32_t>(std::ceil(std::log(0.05f) / std::log(1.0f - s.smoothing)));
+}
+
+// Phases shorter than this cannot settle before the measured half starts, even
+// for the drops, which take a couple of reactions to reach the minimum.
+uint32_t MinPhaseFrames(const DynamicResolutionSettings& s) {
+    return 2 * (SmoothingFrames(s) + s.framesAbove + s.settleFrames);
+}
+
+// Frames the controller needs to climb from the minimum to the maximum scale: each
+// capped increase waits out the settle frames and a full run below the band.
+uint32_t RecoveryFrames(const DynamicResolutionSettings& s) {
+    float step = s.scaleStep > 0.0f ? std::max(std::round(s.maxIncrease / s.scaleStep), 1.0f) * s.scaleStep : s.maxIncrease;
+    uint32_t increases = static_cast<uint32_t>(std::ceil((s.maxScale - s.minScale) / step - 1e-4f));
+    return increases * (s.settleFrames + s.framesBelow) + SmoothingFrames(s);
+}
+
+bool CheckSpikes(const DynamicResolutionSettings& settings) {
+    DynamicResolution controller(settings);
+    for (uint32_t frame = 0; frame < 600; ++frame) {
+        float ms = settings.targetFrameMs * 0.6f;
+        if (frame % 50 == 25) ms = settings.targetFrameMs * 4.0f;
+        controller.Update(ms);
+    }
+    return controller.ScaleChanges() == 0 && controller.Scale() == settings.maxScale;
+}
+
+bool CheckResizeCoalescing() {
+    ResizeCoalescer resize;
+    resize.SetApplied(1280, 720);
+    uint32_t w = 0, h = 0;
+    bool ok = !resize.Consume(w, h);
+    for (uint32_t i = 0; i < 100; ++i) resize.Request(1280 + i * 3, 720 + i);
+    resize.Request(0, 0);
+    ok &= resize.Consume(w, h) && w == 1280 + 99 * 3 && h == 720 + 99;
+    ok &= !resize.Consume(w, h);
+    resize.Request(800, 600);
+    resize.Request(w, h);
+    ok &= !resize.Consume(w, h);
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    float targetMs = argc > 1 ? static_cast<float>(atof(argv[1])) : 1000.0f / 60.0f;
+    uint32_t framesPerPhase = argc > 2 ? static_cast<uint32_t>(std::max(atoi(argv[2]), 0)) : 600;
+    uint32_t seed = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 1;
+
+    // Pixel cost at full resolution relative to the budget left after the fixed 3 ms.
+    const float room = targetMs - 3.0f;
+    const std::vector<Phase> phases = {
+        { "light", room * 0.6f },
+        { "heavy", room * 1.8f },
+        { "light", room * 0.5f },
+        { "medium", room * 1.15f },
+        { "extreme", room * 6.0f },
+        { "light", room * 0.6f },
+    };
+
+    DynamicResolutionSettings settings;
+    settings.targetFrameMs = targetMs;
+    DynamicResolutionSettings eager = settings;
+    eager.framesAbove = eager.framesBelow = 1;
+    eager.lowerBound = eager.upperBound;
+    eager.settleFrames = 0;
+    eager.smoothing = 1.0f;
+    eager.spikeLimit = 1e9f;
+    eager.maxIncrease = 1.0f;
+
+    if (framesPerPhase < MinPhaseFrames(settings)) {
+        framesPerPhase = MinPhaseFrames(settings);
+        printf("phases raised to %u frames so the controller can settle\n", framesPerPhase);
+    }
+
+    bool ok = true;
+    bool coalesced = CheckResizeCoalescing();
+    printf("resize coalescing: %s\n", coalesced ? "ok" : "FAILED");
+    bool spikes = CheckSpikes(settings);
+    printf("isolated spikes ignored: %s\n", spikes ? "ok" : "FAILED");
+    ok &= coalesced && spikes;
+
+    DynamicResolution controller(settings), eagerController(eager);
+    std::vector<PhaseResult> hysteresis = Run(controller, phases, framesPerPhase, seed, 0.01f);
+    std::vector<PhaseResult> direct = Run(eagerController, phases, framesPerPhase, seed, 0.01f);
+
+    const uint32_t recoveryFrames = RecoveryFrames(settings);
+    printf("target %.2f ms, %u frames per phase, second half measured\n", targetMs, framesPerPhase);
+    printf("%-8s %10s | %10s %8s %8s | %10s %8s %8s\n", "phase", "full ms", "scale", "over %", "changes", "eager scl", "over %",
+           "changes");
+    for (size_t i = 0; i < phases.size(); ++i) {
+        const PhaseResult& h = hysteresis[i];
+        const PhaseResult& d = direct[i];
+        printf("%-8s %10.2f | %10.3f %7.1f%% %8u | %10.3f %7.1f%% %8u\n", phases[i].name, 3.0f + phases[i].pixelMs, h.meanScale,
+               h.overBudget, h.changes, d.meanScale, d.overBudget, d.changes);
+
+        // Light phases end at full resolution, or, when they are too short to climb all
+        // the way, do not lose scale while measured; phases that fit at some scale stay mostly under
+        // budget; the extreme one pins the minimum.
+        float fullMs = 3.0f + phases[i].pixelMs;
+        float minMs = 3.0f + phases[i].pixelMs * settings.minScale * settings.minScale;
+        if (fullMs < targetMs * settings.lowerBound && framesPerPhase >= recoveryFrames) ok &= h.finalScale == settings.maxScale;
+        else if (fullMs < targetMs * settings.lowerBound) ok &= h.finalScale >= h.measuredScale;
+        else if (minMs < targetMs * settings.lowerBound) ok &= h.overBudget < 10.0;
+        else ok &= h.finalScale == settings.minScale;
+    }
+    printf("total scale changes: %u with hysteresis, %u eager\n", controller.ScaleChanges(), eagerController.ScaleChanges());
+    ok &= controller.ScaleChanges() * 4 < eagerController.ScaleChanges();
+    printf("%s\n", ok ? "all checks passed" : "CHECKS FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+// A synthetic frame of transient CPU data (visible list, sort keys, draw packets,
+// per-job scratch on the thread pool, short-lived light records in a list), built
+// once with std containers on the heap and once with the frame arena, per-thread
+// arenas and a pooled list. Reports heap allocations per frame and the frame time
+// spread. With GFX_ALLOCATOR_DEBUG it also checks that the debug checks fire.
+// Usage: FrameAllocatorBench [objects] [frames] [threads]
+
+#include "../FrameAllocator.h"
+#include "../ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <new>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> g_heapAllocations{ 0 };
+
+} // namespace
+
+void* operator new(size_t size) {
+    g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+using namespace gfx;
+
+namespace {
+
+struct DrawPacket {
+    uint64_t key;
+    uint32_t object;
+    uint32_t lod;
+};
+
+struct LightRecord {
+    float position[3];
+    float radius;
+    uint32_t object;
+};
+
+constexpr uint32_t JobCount = 64;
+constexpr uint32_t JobScratch = 512;
+
+uint32_t Hash(uint32_t x) noexcept {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    return x ^ (x >> 16);
+}
+
+// One frame of work. Visible, Keys, Packets and Scratch are vector types; Lights is a list.
+template<typename MakeVector, typename MakeScratch, typename Lights>
+uint64_t Frame(uint32_t frame, uint32_t objects, ThreadPool& pool, MakeVector makeVector, MakeScratch makeScratch,
+               Lights& lights) {
+    auto visible = makeVector(uint32_t{});
+    for (uint32_t i = 0; i < objects; ++i) {
+        if ((Hash(i + frame * 977) & 3) != 0) visible.push_back(i);
+    }
+
+    auto keys = makeVector(uint64_t{});
+    for (uint32_t i : visible) keys.push_back((uint64_t(Hash(i) & 0xFFFF) << 32) | i);
+    std::sort(keys.begin(), keys.end());
+
+    auto packets = makeVector(DrawPacket{});
+    for (uint64_t key : keys) packets.push_back({ key, static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 40) & 3 });
+
+    std::atomic<uint64_t> jobSum{ 0 };
+    pool.Run(JobCount, [&](uint32_t task, uint32_t thread) {
+        auto scratch = makeScratch(thread);
+        for (uint32_t i = 0; i < JobScratch; ++i) scratch.push_back(static_cast<float>(Hash(task * JobScratch + i) & 255));
+        float sum = 0.0f;
+        for (float v : scratch) sum += v;
+        jobSum.fetch_add(static_cast<uint64_t>(sum), std::memory_order_relaxed);
+    });
+
+    for (size_t i = 0; i < packets.size(); i += 8) {
+        lights.push_back({ { 0.0f, 1.0f, 2.0f }, 1.0f, packets[i].object });
+    }
+    uint64_t lightSum = 0;
+    for (const LightRecord& light : lights) lightSum += light.object;
+    lights.clear();
+
+    return packets.size() + jobSum.load() + lightSum;
+}
+
+struct Result {
+    double meanMs;
+    double stddevMs;
+    double p99Ms;
+    double maxMs;
+    double allocationsPerFrame;
+};
+
+template<typename RunFrame>
+Result Measure(uint32_t frames, RunFrame runFrame, uint64_t& sink) {
+    // Warm-up frames let the arenas and pools reach their working size.
+    for (uint32_t f = 0; f < 8; ++f) sink += runFrame(f);
+
+    std::vector<double> times;
+    times.reserve(frames);
+    uint64_t allocationsBefore = g_heapAllocations.load();
+    for (uint32_t f = 0; f < frames; ++f) {
+        auto start = std::chrono::steady_clock::now();
+        sink += runFrame(f + 8);
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    uint64_t allocations = g_heapAllocations.load() - allocationsBefore;
+
+    Result result = {};
+    for (double t : times) result.meanMs += t;
+    result.meanMs /= frames;
+    for (double t : times) result.stddevMs += (t - result.meanMs) * (t - result.meanMs);
+    result.stddevMs = std::sqrt(result.stddevMs / frames);
+    std::sort(times.begin(), times.end());
+    result.p99Ms = times[std::min<size_t>(frames - 1, frames * 99 / 100)];
+    result.maxMs = times.back();
+    result.allocationsPerFrame = double(allocations) / frames;
+    return result;
+}
+
+bool CheckDebugChecks() {
+#if GFX_ALLOCATOR_DEBUG
+    bool ok = true;
+    LinearArena arena(1024);
+    uint8_t* bytes = arena.AllocateArray<uint8_t>(16);
+    bytes[16] = 0;
+    arena.Reset();
+    ok &= arena.DebugStats().overruns == 1;
+
+    ArenaVector<int> kept{ ArenaAllocator<int>(arena) };
+    kept.push_back(1);
+    arena.Reset();
+    kept.push_back(2);
+    kept.push_back(3);
+    ok &= arena.DebugStats().useAfterFree > 0;
+
+    FixedPool pool(32, 4);
+    void* a = pool.Allocate();
+    pool.Free(a);
+    pool.Free(a);
+    int local = 0;
+    pool.Free(&local);
+    ok &= pool.DebugStats().invalidFrees == 2;
+    static_cast<uint8_t*>(a)[20] = 1;
+    pool.Allocate();
+    ok &= pool.DebugStats().useAfterFree == 1;
+
+    printf("debug checks: %s\n", ok ? "overrun, use after reset, invalid free and write after free detected" : "FAILED");
+    return ok;
+#else
+    printf("debug checks: compiled out (GFX_ALLOCATOR_DEBUG=0)\n");
+    return true;
+#endif
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint32_t objects = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 50000;
+    uint32_t frames = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 300;
+    uint32_t threads = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 4;
+
+    bool ok = CheckDebugChecks();
+    ThreadPool pool(threads);
+    uint64_t heapSink = 0, arenaSink = 0;
+
+    std::list<LightRecord> heapLights;
+    Result heap = Measure(frames, [&](uint32_t f) {
+        return Frame(f, objects, pool, [](auto value) { return std::vector<decltype(value)>(); },
+                     [](uint32_t) { return std::vector<float>(); }, heapLights);
+    }, heapSink);
+
+    LinearArena frameArena;
+    ThreadArenas threadArenas(pool.ThreadCount());
+    FixedPool lightPool(64, 1024);
+    std::list<LightRecord, PoolAllocator<LightRecord>> pooledLights{ PoolAllocator<LightRecord>(lightPool) };
+    Result arena = Measure(frames, [&](uint32_t f) {
+        uint64_t result = Frame(f, objects, pool,
+                                [&](auto value) { return ArenaVector<decltype(value)>(ArenaAllocator<decltype(value)>(frameArena)); },
+                                [&](uint32_t thread) { return ArenaVector<float>(ArenaAllocator<float>(threadArenas[thread])); },
+                                pooledLights);
+        frameArena.Reset();
+        threadArenas.ResetAll();
+        return result;
+    }, arenaSink);
+
+    if (heapSink != arenaSink) {
+        printf("results differ: %llu vs %llu\n", static_cast<unsigned long long>(heapSink),
+               static_cast<unsigned long long>(arenaSink));
+        ok = false;
+    }
+
+    printf("%u objects, %u frames, %u threads, GFX_ALLOCATOR_DEBUG=%d\n", objects, frames, pool.ThreadCount(), GFX_ALLOCATOR_DEBUG);
+    printf("%-8s %14s %10s %10s %10s %10s\n", "path", "allocs/frame", "mean ms", "stddev ms", "p99 ms", "max ms");
+    printf("%-8s %14.1f %10.3f %10.3f %10.3f %10.3f\n", "heap", heap.allocationsPerFrame, heap.meanMs, heap.stddevMs, heap.p99Ms,
+           heap.maxMs);
+    printf("%-8s %14.1f %10.3f %10.3f %10.3f %10.3f\n", "arena", arena.allocationsPerFrame, arena.meanMs, arena.stddevMs,
+           arena.p99Ms, arena.maxMs);
+    printf("frame arena %zu KiB (peak %llu KiB used), light pool peak %llu blocks in %llu chunks\n", frameArena.Capacity() / 1024,
+           static_cast<unsigned long long>(frameArena.Stats().peakBytes / 1024),
+           static_cast<unsigned long long>(lightPool.Stats().peakBlocks),
+           static_cast<unsigned long long>(lightPool.Stats().chunkAllocations));
+    return ok ? 0 : 1;
+}
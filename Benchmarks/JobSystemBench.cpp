@@ -0,0 +1,337 @@
+// Work-stealing job system: checks the Chase-Lev deque under concurrent
+// stealing, that ParallelFor visits every index exactly once, that nested jobs
+// join, that TaskGraph never starts a task before its dependencies, and that a
+// ThreadPool over the job system runs concurrent batches in full. Then
+// measures the cost of spawning empty jobs against ThreadPool::Run, ParallelFor
+// scaling on a uniform and a skewed workload, and a synthetic frame graph
+// (animation, physics, particles, culling, constants, command recording) run
+// with 1 to N threads; one timed run of the graph is one frame. Speedups are
+// against one thread of the same system.
+// Usage: JobSystemBench [harness options] [maxThreads]
+
+#include "BenchHarness.h"
+
+#include "../JobSystem.h"
+
+#include "../ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+// Deterministic busy work: a chain of dependent shifts.
+uint32_t Burn(uint32_t seed, uint32_t iterations) {
+    uint32_t x = seed | 1;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+    return x;
+}
+
+// The owner pushes and pops while thieves steal; every job must come out once.
+bool CheckDeque(uint32_t thieves) {
+    constexpr uint32_t JobCount = 1u << 20;
+    std::vector<Job> jobs(JobCount);
+    std::vector<std::atomic<uint32_t>> seen(JobCount);
+    for (uint32_t i = 0; i < JobCount; ++i) jobs[i].begin = i;
+
+    WorkStealingDeque deque(16);
+    std::atomic<bool> done{ false };
+    auto take = [&](Job* job) { seen[job->begin].fetch_add(1, std::memory_order_relaxed); };
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < thieves; ++t) {
+        threads.emplace_back([&] {
+            while (!done.load(std::memory_order_acquire) || !deque.LooksEmpty()) {
+                if (Job* job = deque.Steal()) take(job);
+            }
+        });
+    }
+    for (uint32_t i = 0; i < JobCount; ++i) {
+        deque.Push(&jobs[i]);
+        if (i % 3 == 0) {
+            if (Job* job = deque.Pop()) take(job);
+        }
+    }
+    while (Job* job = deque.Pop()) take(job);
+    done.store(true, std::memory_order_release);
+    for (std::thread& thread : threads) thread.join();
+
+    for (uint32_t i = 0; i < JobCount; ++i) {
+        if (seen[i].load(std::memory_order_relaxed) != 1) return false;
+    }
+    return true;
+}
+
+bool CheckParallelFor(JobSystem& jobs) {
+    const uint32_t count = 100003;
+    std::vector<std::atomic<uint32_t>> visits(count);
+    for (uint32_t grain : { 0u, 1u, 7u, 1000u, count }) {
+        for (auto& v : visits) v.store(0, std::memory_order_relaxed);
+        jobs.ParallelFor(count, [&](uint32_t begin, uint32_t end, uint32_t) {
+            for (uint32_t i = begin; i < end; ++i) visits[i].fetch_add(1, std::memory_order_relaxed);
+        }, grain);
+        for (auto& v : visits) {
+            if (v.load(std::memory_order_relaxed) != 1) return false;
+        }
+    }
+    return true;
+}
+
+// Binary tree of jobs, each joining its children inside a job.
+uint64_t SpawnTree(JobSystem& jobs, uint32_t depth) {
+    if (depth == 0) return 1;
+    uint64_t left = 0, right = 0;
+    JobCounter counter;
+    jobs.Spawn(counter, [&] { left = SpawnTree(jobs, depth - 1); });
+    jobs.Spawn(counter, [&] { right = SpawnTree(jobs, depth - 1); });
+    jobs.Wait(counter);
+    return left + right + 1;
+}
+
+// Random DAGs: every task checks that its dependencies finished before it started.
+bool CheckTaskGraph(JobSystem& jobs) {
+    std::mt19937 rng(11);
+    for (uint32_t round = 0; round < 200; ++round) {
+        const uint32_t count = 2 + rng() % 60;
+        std::vector<std::vector<uint32_t>> dependencies(count);
+        std::vector<std::atomic<uint32_t>> finished(count);
+        std::atomic<bool> ordered{ true };
+        TaskGraph graph;
+        for (uint32_t i = 0; i < count; ++i) {
+            const TaskGraph::TaskId task = graph.Add("task", [&, i] {
+                for (uint32_t d : dependencies[i]) {
+                    if (finished[d].load(std::memory_order_acquire) != 1) ordered.store(false);
+                }
+                Burn(i, 200);
+                finished[i].fetch_add(1, std::memory_order_release);
+            });
+            const uint32_t edges = i > 0 ? rng() % 4 : 0;
+            for (uint32_t k = 0; k < edges; ++k) {
+                const uint32_t d = rng() % i;
+                if (std::find(dependencies[i].begin(), dependencies[i].end(), d) != dependencies[i].end()) continue;
+                dependencies[i].push_back(d);
+                graph.DependsOn(task, d);
+            }
+        }
+        // Runs the same graph a few times, as a frame loop would.
+        for (uint32_t repeat = 0; repeat < 3; ++repeat) {
+            for (auto& f : finished) f.store(0, std::memory_order_relaxed);
+            graph.Run(jobs);
+            for (auto& f : finished) {
+                if (f.load(std::memory_order_relaxed) != 1) return false;
+            }
+        }
+        if (!ordered.load()) return false;
+    }
+    return true;
+}
+
+// Two graph tasks run batches on one ThreadPool that shares the job system's
+// threads; both must cover every task with valid thread indices.
+bool CheckSharedPool(JobSystem& jobs) {
+    ThreadPool pool(jobs);
+    const uint32_t count = 4096;
+    std::vector<std::atomic<uint32_t>> visits(count * 2);
+    std::atomic<bool> threadsValid{ true };
+    auto batch = [&](uint32_t first) {
+        pool.Run(count, [&, first](uint32_t task, uint32_t thread) {
+            if (thread >= pool.ThreadCount()) threadsValid.store(false);
+            Burn(task, 20);
+            visits[first + task].fetch_add(1, std::memory_order_relaxed);
+        });
+    };
+    TaskGraph graph;
+    graph.Add("batch a", [&] { batch(0); });
+    graph.Add("batch b", [&] { batch(count); });
+    graph.Run(jobs);
+    for (auto& v : visits) {
+        if (v.load(std::memory_order_relaxed) != 1) return false;
+    }
+    return pool.ThreadCount() == jobs.ThreadCount() && threadsValid.load();
+}
+
+// Empty work in batches of SpawnBatch jobs: Spawn + Wait, ParallelFor with grain
+// 1, and ThreadPool::Run with the same number of tasks.
+constexpr uint32_t SpawnBatch = 1000;
+
+void BenchSpawn(bench::Suite& suite, uint32_t threads) {
+    JobSystem jobs(threads);
+    ThreadPool pool(threads);
+    std::atomic<uint32_t> sink{ 0 };
+    const std::string suffix = "/t" + std::to_string(threads);
+    suite.Run("spawn/wait" + suffix, SpawnBatch, [&] {
+        JobCounter counter;
+        for (uint32_t i = 0; i < SpawnBatch; ++i) jobs.Spawn(counter, [&sink] { sink.fetch_add(1, std::memory_order_relaxed); });
+        jobs.Wait(counter);
+        return sink.load(std::memory_order_relaxed);
+    });
+    suite.Run("spawn/parallel_for" + suffix, SpawnBatch, [&] {
+        jobs.ParallelFor(SpawnBatch, [&sink](uint32_t begin, uint32_t end, uint32_t) {
+            sink.fetch_add(end - begin, std::memory_order_relaxed);
+        }, 1);
+        return sink.load(std::memory_order_relaxed);
+    });
+    suite.Run("spawn/thread_pool" + suffix, SpawnBatch, [&] {
+        pool.Run(SpawnBatch, [&sink](uint32_t, uint32_t) { sink.fetch_add(1, std::memory_order_relaxed); });
+        return sink.load(std::memory_order_relaxed);
+    });
+}
+
+// Burn over count items; skewed items cost in proportion to their index.
+void Scale(JobSystem& jobs, std::vector<uint32_t>& results, bool skewed) {
+    const uint32_t count = static_cast<uint32_t>(results.size());
+    jobs.ParallelFor(count, [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (uint32_t i = begin; i < end; ++i) results[i] = Burn(i, skewed ? 1 + i * 512u / count : 256);
+    });
+}
+
+uint64_t Sum(const std::vector<uint32_t>& values) {
+    uint64_t sum = 0;
+    for (uint32_t v : values) sum += v;
+    return sum;
+}
+
+// Prints the speedup of a case over its one-thread run, kept in base.
+void PrintSpeedup(const bench::Result* result, uint32_t threads, double& base) {
+    if (!result) return;
+    if (threads == 1) base = result->medianMs;
+    else if (base > 0.0) printf("%28s %9.2fx over one thread\n", "", base / result->medianMs);
+}
+
+// Synthetic frame: the stages of a renderer's CPU frame with the usual
+// dependencies. Parallel stages split their items with ParallelFor; the others
+// are single jobs. Checksum() folds every stage's output.
+struct SyntheticFrame {
+    static constexpr uint32_t Characters = 2000, Bodies = 4000, Particles = 60000, Objects = 20000, Draws = 4000;
+
+    std::vector<uint32_t> poses = std::vector<uint32_t>(Characters);
+    std::vector<uint32_t> bodies = std::vector<uint32_t>(Bodies);
+    std::vector<uint32_t> particles = std::vector<uint32_t>(Particles);
+    std::vector<uint32_t> visible = std::vector<uint32_t>(Objects);
+    std::vector<uint32_t> commands = std::vector<uint32_t>(Draws);
+    uint32_t input = 0, constants = 0, viewProj = 0, submitted = 0;
+    uint32_t frame = 0;
+    TaskGraph graph;
+
+    explicit SyntheticFrame(JobSystem& jobs) {
+        auto parallel = [&jobs](std::vector<uint32_t>& out, uint32_t seed, uint32_t cost) {
+            jobs.ParallelFor(static_cast<uint32_t>(out.size()), [&out, seed, cost](uint32_t begin, uint32_t end, uint32_t) {
+                for (uint32_t i = begin; i < end; ++i) out[i] = Burn(seed + i, cost);
+            });
+        };
+        const auto in = graph.Add("Input", [this] { input = Burn(frame, 20000); });
+        const auto animation = graph.Add("Animation", [this, parallel] { parallel(poses, input, 400); }, { in });
+        const auto physics = graph.Add("Physics", [this, parallel] { parallel(bodies, input + 1, 300); }, { in });
+        const auto particleStage = graph.Add("Particles", [this, parallel] { parallel(particles, frame, 20); });
+        const auto view = graph.Add("ViewProj", [this] { viewProj = Burn(input, 5000); }, { in });
+        const auto culling = graph.Add("Culling", [this, parallel] { parallel(visible, poses[0] ^ bodies[0] ^ viewProj, 40); }, { animation, physics, view });
+        const auto model = graph.Add("ModelConstants", [this] { constants = Burn(poses.back(), 30000); }, { animation });
+        const auto record = graph.Add("RecordCommands", [this, parallel] { parallel(commands, visible[7] ^ constants, 200); }, { culling, model });
+        graph.Add("Submit", [this] { submitted = Burn(commands[0] ^ particles[0], 30000); }, { record, particleStage });
+    }
+
+    uint64_t Checksum() const {
+        uint64_t sum = input + uint64_t(constants) + viewProj + submitted;
+        for (const std::vector<uint32_t>* v : { &poses, &bodies, &particles, &visible, &commands }) {
+            for (uint32_t x : *v) sum = sum * 31 + x;
+        }
+        return sum;
+    }
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Options options;
+    std::vector<std::string> args;
+    if (!bench::ParseOptions(argc, argv, options, &args)) return 2;
+    uint32_t maxThreads = args.size() > 0 ? std::max(atoi(args[0].c_str()), 1) : std::max(1u, std::thread::hardware_concurrency());
+    bench::Suite suite(options);
+
+    std::vector<uint32_t> threadCounts;
+    for (uint32_t t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    bool ok = true;
+    {
+        JobSystem jobs(std::max(maxThreads, 4u));
+        bool deque = CheckDeque(3);
+        bool ranges = CheckParallelFor(jobs);
+        bool tree = SpawnTree(jobs, 12) == (1u << 13) - 1;
+        bool graph = CheckTaskGraph(jobs);
+        bool shared = CheckSharedPool(jobs);
+        printf("deque pops and steals every job once: %s\n", deque ? "ok" : "FAILED");
+        printf("ParallelFor visits every index once: %s\n", ranges ? "ok" : "FAILED");
+        printf("nested jobs join: %s\n", tree ? "ok" : "FAILED");
+        printf("task graph respects dependencies: %s\n", graph ? "ok" : "FAILED");
+        printf("ThreadPool on the job system runs concurrent batches: %s\n", shared ? "ok" : "FAILED");
+        ok &= deque && ranges && tree && graph && shared;
+    }
+
+    printf("\nempty jobs in batches of %u; ParallelFor over %u items, automatic grain; synthetic frame graph\n", SpawnBatch, 1u << 18);
+    suite.PrintHeader();
+    for (uint32_t threads : threadCounts) BenchSpawn(suite, threads);
+
+    std::vector<uint32_t> results(1u << 18);
+    for (bool skewed : { false, true }) {
+        double base = 0.0;
+        uint64_t expected = 0;
+        bool measured = false;
+        for (uint32_t threads : threadCounts) {
+            JobSystem jobs(threads);
+            std::string name = std::string(skewed ? "parallel_for/skewed" : "parallel_for/uniform") + "/t" + std::to_string(threads);
+            const bench::Result* result = suite.Run(name, results.size(), [&] {
+                Scale(jobs, results, skewed);
+                return results[results.size() / 2];
+            });
+            if (!result) continue;
+            const uint64_t sum = Sum(results);
+            if (!measured) expected = sum;
+            measured = true;
+            if (sum != expected) {
+                printf("%s with %u threads differs: FAILED\n", skewed ? "skewed" : "uniform", threads);
+                ok = false;
+            }
+            PrintSpeedup(result, threads, base);
+        }
+    }
+
+    // Every configuration runs the same number of frames, so the last frames match.
+    double frameBase = 0.0;
+    uint64_t frameExpected = 0;
+    bool frameMeasured = false;
+    for (uint32_t threads : threadCounts) {
+        JobSystem jobs(threads);
+        SyntheticFrame scene(jobs);
+        const bench::Result* result = suite.Run("frame_graph/t" + std::to_string(threads), 0, [&] {
+            scene.graph.Run(jobs);
+            return ++scene.frame;
+        });
+        if (!result) continue;
+        const uint64_t checksum = scene.Checksum();
+        if (!frameMeasured) frameExpected = checksum;
+        frameMeasured = true;
+        if (checksum != frameExpected) {
+            printf("frame result with %u threads differs from the first: FAILED\n", threads);
+            ok = false;
+        }
+        PrintSpeedup(result, threads, frameBase);
+    }
+
+    printf("checksum %llu\n", static_cast<unsigned long long>(suite.Sink()));
+    ok &= suite.WriteJson({ { "max_threads", std::to_string(maxThreads) } });
+    ok &= suite.CompareWithBaseline();
+    printf("%s\n", ok ? "all checks passed" : "CHECKS FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+// Load time of a triangulated grid as OBJ (parallel import) vs the mapped binary format,
+// plus a check that ValidateIndices rejects out-of-range and partial triangles.
+// Usage: MeshLoadBench [triangles] [workDir]
+
+#include "../Hash.h"
+#include "../MeshFile.h"
+#include "../ObjImporter.h"
+#include "../ThreadPool.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+using namespace gfx;
+
+namespace {
+
+double MsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Square height-field grid written as quads with per-vertex colour, texcoord and normal.
+bool WriteGridObj(const char* path, uint64_t triangles) {
+    uint32_t side = static_cast<uint32_t>(std::sqrt(triangles / 2.0)) + 1;
+    FILE* file = std::fopen(path, "wb");
+    if (!file) return false;
+    for (uint32_t y = 0; y <= side; ++y) {
+        for (uint32_t x = 0; x <= side; ++x) {
+            float h = std::sin(x * 0.05f) * std::cos(y * 0.05f);
+            std::fprintf(file, "v %.6f %.6f %.6f %.3f %.3f %.3f\n", x * 0.1f, h, y * 0.1f,
+                         float(x) / side, float(y) / side, 0.5f + 0.5f * h);
+        }
+    }
+    for (uint32_t y = 0; y <= side; ++y) {
+        for (uint32_t x = 0; x <= side; ++x) std::fprintf(file, "vt %.6f %.6f\n", float(x) / side, float(y) / side);
+    }
+    std::fprintf(file, "vn 0 1 0\n");
+    for (uint32_t y = 0; y < side; ++y) {
+        for (uint32_t x = 0; x < side; ++x) {
+            uint32_t a = y * (side + 1) + x + 1;
+            uint32_t b = a + 1, c = a + side + 2, d = a + side + 1;
+            std::fprintf(file, "f %u/%u/1 %u/%u/1 %u/%u/1 %u/%u/1\n", a, a, d, d, c, c, b, b);
+        }
+    }
+    return std::fclose(file) == 0;
+}
+
+uint64_t HashMesh(const ObjMesh& mesh) {
+    return HashCombine(Hash64(mesh.vertices.data(), mesh.vertices.size()),
+                       Hash64(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t)));
+}
+
+// Three vertices with the given indices; ValidateIndices must reject both bad lists.
+bool CheckBadIndices(const std::filesystem::path& dir) {
+    const float vertices[3 * 4] = {};
+    const uint16_t outOfRange[3] = { 0, 1, 3 };
+    const uint16_t partial[4] = { 0, 1, 2, 0 };
+    const uint16_t good[3] = { 0, 1, 2 };
+    struct Case {
+        const uint16_t* indices;
+        uint64_t count;
+        bool valid;
+    };
+    const Case cases[] = { { outOfRange, 3, false }, { partial, 4, false }, { good, 3, true } };
+    std::string path = (dir / "indices.gmsh").string();
+    for (const Case& c : cases) {
+        MeshSource source = { ColoredVertexLayout(), vertices, 3, c.indices, IndexFormat::UInt16, c.count };
+        MeshFile mesh;
+        if (!WriteMeshFile(path.c_str(), source) || !mesh.Open(path.c_str())) return false;
+        if (mesh.ValidateIndices() != c.valid) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t triangles = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    std::filesystem::path dir = argc > 2 ? argv[2] : "MeshLoadBench.tmp";
+    std::filesystem::create_directories(dir);
+    std::string objPath = (dir / "grid.obj").string();
+    std::string meshPath = (dir / "grid.gmsh").string();
+
+    auto start = std::chrono::steady_clock::now();
+    if (!WriteGridObj(objPath.c_str(), triangles)) {
+        printf("cannot write %s\n", objPath.c_str());
+        return 1;
+    }
+    printf("generated %s (%.1f MB) in %.0f ms\n", objPath.c_str(),
+           std::filesystem::file_size(objPath) / 1048576.0, MsSince(start));
+
+    ObjImportOptions options;
+    options.keepTexcoords = true;
+    printf("%8s %12s %12s %12s %18s\n", "threads", "obj ms", "vertices", "triangles", "mesh hash");
+    uint32_t maxThreads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    for (uint32_t threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool pool(threads);
+        ObjMesh mesh;
+        std::string error;
+        start = std::chrono::steady_clock::now();
+        if (!ImportObj(objPath.c_str(), pool, mesh, options, &error)) {
+            printf("import failed: %s\n", error.c_str());
+            return 1;
+        }
+        double ms = MsSince(start);
+        printf("%8u %12.1f %12llu %12zu %18llx\n", threads, ms, static_cast<unsigned long long>(mesh.vertexCount),
+               mesh.indices.size() / 3, static_cast<unsigned long long>(HashMesh(mesh)));
+    }
+
+    ThreadPool pool;
+    std::string error;
+    start = std::chrono::steady_clock::now();
+    if (!ConvertObjToMeshFile(objPath.c_str(), meshPath.c_str(), pool, options, &error)) {
+        printf("convert failed: %s\n", error.c_str());
+        return 1;
+    }
+    printf("converted to %s (%.1f MB) in %.0f ms\n", meshPath.c_str(),
+           std::filesystem::file_size(meshPath) / 1048576.0, MsSince(start));
+
+    // Open only maps and validates the header; the checksum and touch rows read every page.
+    MeshFile mesh;
+    start = std::chrono::steady_clock::now();
+    bool opened = mesh.Open(meshPath.c_str(), &error);
+    double openMs = MsSince(start);
+    uint64_t sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; opened && i < mesh.VertexBytes(); i += 4096) sum += static_cast<const uint8_t*>(mesh.VertexData())[i];
+    for (uint64_t i = 0; opened && i < mesh.IndexBytes(); i += 4096) sum += static_cast<const uint8_t*>(mesh.IndexData())[i];
+    double touchMs = MsSince(start);
+    mesh.Close();
+    start = std::chrono::steady_clock::now();
+    opened = opened && mesh.Open(meshPath.c_str(), &error, true);
+    double verifyMs = MsSince(start);
+    start = std::chrono::steady_clock::now();
+    opened = opened && mesh.ValidateIndices(&error);
+    double indicesMs = MsSince(start);
+    if (!opened) {
+        printf("open failed: %s\n", error.c_str());
+        return 1;
+    }
+    printf("binary open %.3f ms, page touch %.1f ms, open with checksum %.1f ms, index check %.1f ms (%llu vertices, %llu indices, %s)\n",
+           openMs, touchMs, verifyMs, indicesMs, static_cast<unsigned long long>(mesh.VertexCount()),
+           static_cast<unsigned long long>(mesh.IndexCount()),
+           mesh.GetIndexFormat() == IndexFormat::UInt16 ? "16-bit" : "32-bit");
+    (void)sum;
+
+    bool badIndices = CheckBadIndices(dir);
+    printf("out-of-range and partial triangles rejected: %s\n", badIndices ? "ok" : "FAILED");
+    return badIndices ? 0 : 1;
+}
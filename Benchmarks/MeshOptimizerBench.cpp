@@ -0,0 +1,101 @@
+// Vertex cache, overdraw and vertex fetch optimization throughput on large grids,
+// with ACMR/ATVR before and after each pass.
+// Usage: MeshOptimizerBench [triangles] [cacheSize]
+
+#include "../MeshOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+struct Mesh {
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+    uint32_t vertexCount;
+};
+
+// Rolling height field, triangles in row order.
+Mesh MakeGrid(uint64_t triangles) {
+    uint32_t side = static_cast<uint32_t>(std::sqrt(triangles / 2.0)) + 1;
+    Mesh mesh;
+    mesh.vertexCount = (side + 1) * (side + 1);
+    for (uint32_t y = 0; y <= side; ++y) {
+        for (uint32_t x = 0; x <= side; ++x) {
+            mesh.positions.insert(mesh.positions.end(), { x * 0.1f, std::sin(x * 0.05f) * std::cos(y * 0.05f), y * 0.1f });
+        }
+    }
+    for (uint32_t y = 0; y < side; ++y) {
+        for (uint32_t x = 0; x < side; ++x) {
+            uint32_t a = y * (side + 1) + x, b = a + 1, c = a + side + 2, d = a + side + 1;
+            mesh.indices.insert(mesh.indices.end(), { a, d, c, a, c, b });
+        }
+    }
+    return mesh;
+}
+
+void ShuffleTriangles(std::vector<uint32_t>& indices, uint32_t seed) {
+    std::mt19937 rng(seed);
+    for (size_t t = indices.size() / 3; t > 1; --t) {
+        size_t j = rng() % t;
+        std::swap_ranges(indices.begin() + (t - 1) * 3, indices.begin() + t * 3, indices.begin() + j * 3);
+    }
+}
+
+double MsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PrintRow(const char* stage, const Mesh& mesh, uint32_t cacheSize, double ms) {
+    VertexCacheStats stats = AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount, cacheSize);
+    double mtris = ms > 0.0 ? mesh.indices.size() / 3 / (ms * 1000.0) : 0.0;
+    printf("%-22s %8.3f %8.3f %12.1f %10.2f\n", stage, stats.acmr, stats.atvr, ms, mtris);
+}
+
+void Run(const char* name, Mesh mesh, uint32_t cacheSize) {
+    printf("\n%s: %zu triangles, %u vertices, %s indices\n", name, mesh.indices.size() / 3, mesh.vertexCount,
+           ChooseIndexFormat(mesh.vertexCount) == IndexFormat::UInt16 ? "16-bit" : "32-bit");
+    printf("%-22s %8s %8s %12s %10s\n", "stage", "ACMR", "ATVR", "ms", "Mtri/s");
+    PrintRow("input", mesh, cacheSize, 0.0);
+
+    auto start = std::chrono::steady_clock::now();
+    OptimizeVertexCache(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertexCount, cacheSize);
+    PrintRow("vertex cache", mesh, cacheSize, MsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    OptimizeOverdraw(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(), mesh.positions.data(),
+                     sizeof(float) * 3, mesh.vertexCount, 1.05f, cacheSize);
+    PrintRow("overdraw (1.05)", mesh, cacheSize, MsSince(start));
+
+    std::vector<float> positions(mesh.positions.size());
+    start = std::chrono::steady_clock::now();
+    mesh.vertexCount = OptimizeVertexFetch(positions.data(), mesh.indices.data(), mesh.indices.size(),
+                                           mesh.positions.data(), mesh.vertexCount, sizeof(float) * 3);
+    PrintRow("vertex fetch", mesh, cacheSize, MsSince(start));
+
+    std::vector<uint8_t> packed(mesh.indices.size() * IndexSize(ChooseIndexFormat(mesh.vertexCount)));
+    start = std::chrono::steady_clock::now();
+    PackIndices(packed.data(), mesh.indices.data(), mesh.indices.size(), ChooseIndexFormat(mesh.vertexCount));
+    printf("%-22s %8s %8s %12.1f %10s  (%.1f MB)\n", "pack indices", "", "", MsSince(start), "", packed.size() / 1048576.0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t triangles = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4000000;
+    uint32_t cacheSize = argc > 2 ? atoi(argv[2]) : DefaultVertexCacheSize;
+
+    Mesh grid = MakeGrid(triangles);
+    Run("grid, row order", grid, cacheSize);
+    ShuffleTriangles(grid.indices, 3);
+    Run("grid, shuffled", grid, cacheSize);
+    Run("small grid, shuffled", [] { Mesh m = MakeGrid(40000); ShuffleTriangles(m.indices, 5); return m; }(), cacheSize);
+    return 0;
+}
@@ -0,0 +1,256 @@
+// CPU occlusion culling on a dense synthetic city: a grid of blocks of box buildings
+// plus street furniture, seen from street level while the camera walks down an
+// avenue. Per frame the frustum survivors are culled against a depth buffer of the
+// nearest, largest buildings. Reports the share of frustum-visible objects culled
+// and the cost of each phase per thread count. Checks a wall hides what is behind
+// it and nothing else, and that the depth buffer does not depend on thread count
+// or SIMD level.
+// Usage: OcclusionBench [blocksPerSide] [props] [frames] [occluders] [maxThreads]
+
+#include "../CubeMesh.h"
+#include "../FrustumCulling.h"
+#include "../OcclusionCulling.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+constexpr float BlockSize = 40.0f;
+constexpr float StreetWidth = 12.0f;
+constexpr float Pitch = BlockSize + StreetWidth;
+
+std::vector<uint32_t> CubeIndices() {
+    return std::vector<uint32_t>(std::begin(g_CubeIndices), std::end(g_CubeIndices));
+}
+
+Float4x4 BoxWorld(const Float3& center, const Float3& size) {
+    return Multiply(MatrixScaling(size.x, size.y, size.z), MatrixTranslation(center.x, center.y, center.z));
+}
+
+struct City {
+    Scene scene;
+    uint32_t buildings = 0;
+    float halfSize = 0.0f;
+};
+
+// Four buildings of random height per block; props (cars, kiosks, lamps) both on
+// the streets and in the yards between the buildings. Buildings come first in the scene.
+void BuildCity(City& city, uint32_t blocksPerSide, uint32_t props) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    city.scene.Clear();
+    city.halfSize = blocksPerSide * Pitch * 0.5f;
+    const Float3 unitMin = { -0.5f, -0.5f, -0.5f }, unitMax = { 0.5f, 0.5f, 0.5f };
+    for (uint32_t bz = 0; bz < blocksPerSide; ++bz) {
+        for (uint32_t bx = 0; bx < blocksPerSide; ++bx) {
+            float x0 = bx * Pitch - city.halfSize + StreetWidth * 0.5f;
+            float z0 = bz * Pitch - city.halfSize + StreetWidth * 0.5f;
+            for (int b = 0; b < 4; ++b) {
+                float w = BlockSize * 0.5f - 2.0f, h = 12.0f + 60.0f * unit(rng) * unit(rng);
+                Float3 center = { x0 + (b & 1 ? 0.75f : 0.25f) * BlockSize, h * 0.5f, z0 + (b & 2 ? 0.75f : 0.25f) * BlockSize };
+                city.scene.AddObject(BoxWorld(center, { w, h, w }), unitMin, unitMax);
+            }
+        }
+    }
+    city.buildings = static_cast<uint32_t>(city.scene.ObjectCount());
+    for (uint32_t i = 0; i < props; ++i) {
+        Float3 size = { 0.5f + 3.5f * unit(rng), 0.5f + 2.5f * unit(rng), 0.5f + 3.5f * unit(rng) };
+        Float3 center = { (unit(rng) * 2.0f - 1.0f) * city.halfSize, size.y * 0.5f, (unit(rng) * 2.0f - 1.0f) * city.halfSize };
+        city.scene.AddObject(BoxWorld(center, size), unitMin, unitMax);
+    }
+}
+
+// Eye height 2, walking along the avenue at x = 0 and looking slightly left and right.
+Float4x4 StreetCamera(const City& city, uint32_t frame, uint32_t frames, Float3& eye) {
+    float t = frames > 1 ? float(frame) / float(frames - 1) : 0.0f;
+    float z = -city.halfSize * 0.8f + t * city.halfSize * 1.6f;
+    float yaw = 0.35f * std::sin(frame * 0.15f);
+    eye = { 0.0f, 2.0f, z };
+    Float3 target = { eye.x + std::sin(yaw), 2.2f, eye.z + std::cos(yaw) };
+    return Multiply(MatrixLookAtLH(eye, target, { 0.0f, 1.0f, 0.0f }), MatrixPerspectiveFovLH(1.0f, 16.0f / 9.0f, 0.5f, 2000.0f));
+}
+
+// The visible buildings with the largest size over distance squared.
+void SelectOccluders(const City& city, const std::vector<uint32_t>& visible, const Float3& eye, uint32_t maxOccluders,
+                     std::vector<uint32_t>& occluders) {
+    AabbStreams b = city.scene.Bounds();
+    std::vector<std::pair<float, uint32_t>> scored;
+    for (uint32_t object : visible) {
+        if (object >= city.buildings) break;
+        float dx = b.centerX[object] - eye.x, dy = b.centerY[object] - eye.y, dz = b.centerZ[object] - eye.z;
+        float area = b.extentX[object] * b.extentY[object] + b.extentZ[object] * b.extentY[object];
+        scored.push_back({ -area / (dx * dx + dy * dy + dz * dz + 1.0f), object });
+    }
+    size_t count = std::min<size_t>(maxOccluders, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + count, scored.end());
+    occluders.clear();
+    for (size_t i = 0; i < count; ++i) occluders.push_back(scored[i].second);
+}
+
+void AddBoxOccluder(OcclusionCuller& culler, const Float4x4& world, const std::vector<uint32_t>& indices) {
+    culler.AddOccluder(g_CubeVertices, sizeof(ColoredVertex), indices.data(), indices.size(), world);
+}
+
+// A 10 x 10 wall 20 units ahead of the camera.
+bool CheckWall(ThreadPool& pool) {
+    std::vector<uint32_t> indices = CubeIndices();
+    Float4x4 viewProj = Multiply(MatrixLookAtLH({ 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f }),
+                                 MatrixPerspectiveFovLH(1.0f, 2.0f, 0.5f, 500.0f));
+    OcclusionCuller culler(pool);
+    culler.BeginFrame(viewProj);
+    AddBoxOccluder(culler, BoxWorld({ 0.0f, 0.0f, 20.0f }, { 10.0f, 10.0f, 1.0f }), indices);
+    culler.RenderOccluders();
+
+    bool ok = !culler.IsVisible({ 0.0f, 0.0f, 40.0f }, { 1.0f, 1.0f, 1.0f });
+    ok &= !culler.IsVisible({ 2.0f, -3.0f, 200.0f }, { 4.0f, 4.0f, 4.0f });
+    ok &= culler.IsVisible({ 0.0f, 0.0f, 10.0f }, { 1.0f, 1.0f, 1.0f });
+    ok &= culler.IsVisible({ 14.0f, 0.0f, 40.0f }, { 1.0f, 1.0f, 1.0f });
+    ok &= culler.IsVisible({ 0.0f, 0.0f, 40.0f }, { 12.0f, 1.0f, 1.0f });
+    ok &= culler.IsVisible({ 0.0f, 0.0f, 0.2f }, { 1.0f, 1.0f, 1.0f });
+    ok &= !culler.IsVisible({ 0.0f, 0.0f, -40.0f }, { 1.0f, 1.0f, 1.0f });
+    return ok;
+}
+
+// A wall covering the screen but for the last pixel column (or row). A box behind
+// it that spans the screen is tested at a coarse level, whose edge texels must
+// still see the uncovered pixels. Odd level sizes used to drop them.
+bool CheckEdges(ThreadPool& pool, uint32_t width, uint32_t height) {
+    std::vector<uint32_t> indices = CubeIndices();
+    const float aspect = static_cast<float>(width) / static_cast<float>(height);
+    Float4x4 viewProj = Multiply(MatrixLookAtLH({ 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f }),
+                                 MatrixPerspectiveFovLH(1.0f, aspect, 0.5f, 500.0f));
+    const float halfY = 20.0f * std::tan(0.5f), halfX = halfY * aspect;
+    // Edge of the wall 1.5 pixels inside the screen edge, world units at depth 20,
+    // where the wall's front face sits.
+    const float openX = halfX * (1.0f - 3.0f / width), openY = halfY * (1.0f - 3.0f / height);
+    bool ok = true;
+    for (int side = 0; side < 2; ++side) {
+        OcclusionCuller culler(pool, width, height);
+        culler.BeginFrame(viewProj);
+        Float3 center = side == 0 ? Float3{ openX - 500.0f, 0.0f, 20.5f } : Float3{ 0.0f, -openY + 500.0f, 20.5f };
+        AddBoxOccluder(culler, BoxWorld(center, { 1000.0f, 1000.0f, 1.0f }), indices);
+        culler.RenderOccluders();
+        ok &= culler.IsVisible({ 0.0f, 0.0f, 40.0f }, { 100.0f, 100.0f, 1.0f });
+        ok &= !culler.IsVisible({ 0.0f, 0.0f, 40.0f }, { 1.0f, 1.0f, 1.0f });
+    }
+    return ok;
+}
+
+// Depth buffers at 1 and n threads and with scalar and SIMD rasterization.
+bool CheckDeterminism(const City& city, const std::vector<uint32_t>& occluders, const Float4x4& viewProj, uint32_t threads) {
+    std::vector<uint32_t> indices = CubeIndices();
+    ThreadPool serialPool(1), parallelPool(threads);
+    OcclusionCuller serial(serialPool), parallel(parallelPool), scalar(parallelPool);
+    scalar.SetSimdLevel(SimdLevel::Scalar);
+    for (OcclusionCuller* culler : { &serial, &parallel, &scalar }) {
+        culler->BeginFrame(viewProj);
+        for (uint32_t object : occluders) AddBoxOccluder(*culler, city.scene.World(object), indices);
+        culler->RenderOccluders();
+    }
+    bool ok = true;
+    for (uint32_t level = 0; level < serial.LevelCount(); ++level) {
+        size_t bytes = sizeof(float) * serial.LevelWidth(level) * serial.LevelHeight(level);
+        ok &= memcmp(serial.Depth(level), parallel.Depth(level), bytes) == 0;
+        ok &= memcmp(serial.Depth(level), scalar.Depth(level), bytes) == 0;
+    }
+    return ok;
+}
+
+double MsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint32_t blocksPerSide = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 32;
+    uint32_t props = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 200000;
+    uint32_t frames = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 60;
+    uint32_t maxOccluders = argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : 48;
+    uint32_t hardwareThreads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    uint32_t maxThreads = argc > 5 ? static_cast<uint32_t>(atoi(argv[5])) : std::max(hardwareThreads, 4u);
+
+    City city;
+    BuildCity(city, blocksPerSide, props);
+    std::vector<uint32_t> indices = CubeIndices();
+    printf("%u buildings, %u props, %u occluders, %s\n", city.buildings, props, maxOccluders, SimdLevelName(BestSimdLevel()));
+
+    bool ok = true;
+    {
+        ThreadPool pool(4);
+        bool wall = CheckWall(pool);
+        printf("wall test: %s\n", wall ? "ok" : "FAILED");
+        ok &= wall;
+        // Sizes whose pyramids have odd levels.
+        bool edges = true;
+        const uint32_t sizes[][2] = { { 256, 96 }, { 320, 96 }, { 96, 320 }, { 224, 160 } };
+        for (const auto& size : sizes) edges &= CheckEdges(pool, size[0], size[1]);
+        printf("non-power-of-two depth buffers: %s\n", edges ? "ok" : "FAILED");
+        ok &= edges;
+
+        FrustumCuller frustumCuller(pool);
+        std::vector<uint32_t> visible, occluders;
+        Float3 eye;
+        Float4x4 viewProj = StreetCamera(city, frames / 2, frames, eye);
+        frustumCuller.Cull(city.scene, ExtractFrustum(viewProj), visible);
+        SelectOccluders(city, visible, eye, maxOccluders, occluders);
+        bool same = CheckDeterminism(city, occluders, viewProj, 4);
+        printf("same depth pyramid for 1/4 threads and scalar/SIMD: %s\n", same ? "ok" : "FAILED");
+        ok &= same;
+    }
+
+    printf("%8s %12s %10s %12s %12s %12s %12s %12s\n", "threads", "frustum vis", "occluded", "frustum ms", "select ms",
+           "raster ms", "test ms", "total ms");
+    for (uint32_t threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool pool(threads);
+        FrustumCuller frustumCuller(pool);
+        OcclusionCuller occlusionCuller(pool);
+        std::vector<uint32_t> visible, occluders, unoccluded;
+        double frustumMs = 0.0, selectMs = 0.0, rasterMs = 0.0, testMs = 0.0;
+        uint64_t frustumVisible = 0;
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            Float3 eye;
+            Float4x4 viewProj = StreetCamera(city, frame, frames, eye);
+
+            auto start = std::chrono::steady_clock::now();
+            frustumCuller.Cull(city.scene, ExtractFrustum(viewProj), visible);
+            frustumMs += MsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            SelectOccluders(city, visible, eye, maxOccluders, occluders);
+            selectMs += MsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            occlusionCuller.BeginFrame(viewProj);
+            for (uint32_t object : occluders) AddBoxOccluder(occlusionCuller, city.scene.World(object), indices);
+            occlusionCuller.RenderOccluders();
+            rasterMs += MsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            unoccluded.clear();
+            occlusionCuller.Cull(city.scene.Bounds(), visible.data(), static_cast<uint32_t>(visible.size()), unoccluded);
+            testMs += MsSince(start);
+            frustumVisible += visible.size();
+        }
+        const OcclusionStats& stats = occlusionCuller.Stats();
+        printf("%8u %12.0f %9.1f%% %12.3f %12.3f %12.3f %12.3f %12.3f\n", threads, double(frustumVisible) / frames,
+               100.0 * stats.boxesOccluded / std::max<uint64_t>(1, stats.boxesTested), frustumMs / frames, selectMs / frames,
+               rasterMs / frames, testMs / frames, (frustumMs + selectMs + rasterMs + testMs) / frames);
+        if (threads == 1) {
+            printf("%8s %.0f occluder triangles/frame, %.0f after clipping\n", "",
+                   double(stats.occluderTriangles) / frames, double(stats.trianglesRasterized) / frames);
+        }
+    }
+    printf("(%u hardware threads)\n", hardwareThreads);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+// Recording throughput of ParallelCommandRecorder from 1 to 16 threads on the null device.
+// Usage: ParallelRecordingBench [draws] [frames] [slices]
+
+#include "../MathTypes.h"
+#include "../ParallelCommandRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+struct Object {
+    Float3 position;
+    uint32_t pipeline;
+    uint32_t material;
+    uint32_t mesh;
+};
+
+// Order-sensitive hash of the final submission, to show the merge is deterministic.
+uint64_t HashSubmission(const CommandBuffer& commands) {
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < commands.DrawCount(); ++i) {
+        uint64_t values[2] = { commands.KeyAt(i), commands.DrawAt(i).constantBuffers[0] };
+        for (uint64_t v : values) hash = (hash ^ v) * 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint32_t drawCount = argc > 1 ? atoi(argv[1]) : 200000;
+    uint32_t frames = argc > 2 ? std::max(atoi(argv[2]), 1) : 50;
+    // At least one slice, since each records drawCount / slices of the objects.
+    uint32_t slices = argc > 3 ? std::max(atoi(argv[3]), 1) : 64;
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> coord(-100.0f, 100.0f);
+    std::vector<Object> objects(drawCount);
+    for (Object& o : objects) {
+        o.position = { coord(rng), coord(rng), coord(rng) };
+        o.pipeline = static_cast<uint32_t>(rng() % 8);
+        o.material = static_cast<uint32_t>(rng() % 256);
+        o.mesh = static_cast<uint32_t>(rng() % 64);
+    }
+    Float4x4 view = MatrixLookAtLH({ 0.0f, 20.0f, -150.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+    const PassState mainPass = { 1, NullResource, { 0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f }, { 0, 0, 1280, 720 } };
+
+    // Per-draw work: view depth for the key plus filling the command, as a renderer would.
+    auto recordSlice = [&](CommandBuffer& list, uint32_t slice) {
+        uint32_t begin = static_cast<uint32_t>(uint64_t(drawCount) * slice / slices);
+        uint32_t end = static_cast<uint32_t>(uint64_t(drawCount) * (slice + 1) / slices);
+        if (slice == 0) list.SetPass(0, mainPass);
+        for (uint32_t i = begin; i < end; ++i) {
+            const Object& o = objects[i];
+            float viewZ = TransformPoint(o.position, view).z;
+            DrawCommand draw = {};
+            draw.pipeline = 1 + o.pipeline;
+            draw.vertexBuffer = 1 + o.mesh * 2;
+            draw.vertexStride = 16;
+            draw.indexBuffer = 2 + o.mesh * 2;
+            draw.indexFormat = IndexFormat::UInt16;
+            draw.constantBuffers[0] = 1000 + i;
+            draw.constantBuffers[1] = 999;
+            draw.indexCount = 36;
+            list.Draw(MakeSortKey(0, o.pipeline, o.material, viewZ / 300.0f), draw);
+        }
+    };
+
+    printf("%u draws, %u slices, %u frames\n", drawCount, slices, frames);
+    printf("%8s %12s %12s %12s %12s %14s %18s\n", "threads", "record ms", "merge ms", "sort ms", "replay ms", "record draws/ms", "submission hash");
+
+    CommandBuffer frame;
+    CommandReplayer replayer;
+    NullCommandDevice device;
+    for (uint32_t threads = 1; threads <= 16; threads *= 2) {
+        ThreadPool pool(threads);
+        ParallelCommandRecorder recorder(pool);
+        double recordMs = 0, mergeMs = 0, sortMs = 0, replayMs = 0;
+        for (uint32_t f = 0; f < frames; ++f) {
+            auto t0 = std::chrono::steady_clock::now();
+            recorder.Record(slices, recordSlice);
+            auto t1 = std::chrono::steady_clock::now();
+            recorder.Merge(frame);
+            auto t2 = std::chrono::steady_clock::now();
+            frame.Sort();
+            auto t3 = std::chrono::steady_clock::now();
+            replayer.Replay(frame, device);
+            auto t4 = std::chrono::steady_clock::now();
+            recordMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+            mergeMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+            sortMs += std::chrono::duration<double, std::milli>(t3 - t2).count();
+            replayMs += std::chrono::duration<double, std::milli>(t4 - t3).count();
+        }
+        printf("%8u %12.3f %12.3f %12.3f %12.3f %14.0f %18llx\n", threads, recordMs / frames, mergeMs / frames, sortMs / frames,
+               replayMs / frames, drawCount / (recordMs / frames), static_cast<unsigned long long>(HashSubmission(frame)));
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+// Particle emission and update at steady state: an emitter whose rate replaces the
+// particles that expire, timed per frame (Emit + Update writing the instance buffer)
+// for several particle counts, SIMD levels and thread counts; one timed run is one
+// frame. Checks the SoA update and branch-free compaction against a straightforward
+// array-of-structs version with a stable erase, and that the instance data is
+// bit-identical for every thread count and SIMD level.
+// Usage: ParticleBench [harness options] [maxParticles] [maxThreads]
+
+#include "BenchHarness.h"
+
+#include "../ParticleSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+constexpr float FrameDt = 1.0f / 60.0f;
+
+ParticleEmitter FountainEmitter(uint32_t particles) {
+    ParticleEmitter emitter;
+    emitter.position = { 0.0f, 0.5f, 0.0f };
+    emitter.velocity = { 0.0f, 4.0f, 0.0f };
+    emitter.velocitySpread = 1.5f;
+    emitter.lifetimeMin = 1.0f;
+    emitter.lifetimeMax = 2.0f;
+    emitter.rate = particles / (0.5f * (emitter.lifetimeMin + emitter.lifetimeMax));
+    return emitter;
+}
+
+ParticleSettings FountainSettings() {
+    ParticleSettings settings;
+    settings.groundHeight = 0.0f;
+    return settings;
+}
+
+struct ReferenceParticle {
+    float x, y, z, vx, vy, vz, age, lifetime;
+};
+
+// One Update written the obvious way, with the same arithmetic as the scalar path.
+void ReferenceUpdate(std::vector<ReferenceParticle>& particles, const ParticleSettings& settings, float dt,
+                     std::vector<ParticleInstance>& instances) {
+    const float damping = std::exp(-settings.drag * dt);
+    const float g[3] = { settings.gravity.x * dt, settings.gravity.y * dt, settings.gravity.z * dt };
+    for (ReferenceParticle& p : particles) {
+        p.vx = (p.vx + g[0]) * damping;
+        p.vy = (p.vy + g[1]) * damping;
+        p.vz = (p.vz + g[2]) * damping;
+        p.x = p.x + p.vx * dt;
+        p.y = p.y + p.vy * dt;
+        p.z = p.z + p.vz * dt;
+        if (p.y < settings.groundHeight) {
+            p.y = settings.groundHeight;
+            p.vy = p.vy * -settings.restitution;
+        }
+        p.age = p.age + dt;
+    }
+    particles.erase(std::remove_if(particles.begin(), particles.end(), [](const ReferenceParticle& p) { return !(p.age < p.lifetime); }),
+                    particles.end());
+
+    instances.clear();
+    for (const ReferenceParticle& p : particles) {
+        float t = p.age / p.lifetime;
+        ParticleInstance instance = { { p.x, p.y, p.z }, settings.startSize + (settings.endSize - settings.startSize) * t, 0 };
+        for (int c = 0; c < 4; ++c) {
+            float start = static_cast<float>((settings.startColor >> (c * 8)) & 0xFF);
+            float end = static_cast<float>((settings.endColor >> (c * 8)) & 0xFF);
+            instance.rgba |= static_cast<uint32_t>(static_cast<int32_t>(start + (end - start) * t + 0.5f)) << (c * 8);
+        }
+        instances.push_back(instance);
+    }
+}
+
+bool CheckAgainstReference(SimdLevel level, ThreadPool& pool) {
+    const ParticleSettings settings = FountainSettings();
+    ParticleSystem system(100000, settings, 7);
+    system.SetSimdLevel(level);
+    ParticleEmitter emitter = FountainEmitter(50000);
+    emitter.lifetimeMin = 0.05f;
+    emitter.lifetimeMax = 1.5f;
+    system.Burst(emitter, 50000, &pool);
+
+    std::vector<ReferenceParticle> reference(system.Count());
+    for (uint32_t i = 0; i < system.Count(); ++i) {
+        reference[i] = { system.Stream(ParticleX)[i], system.Stream(ParticleY)[i], system.Stream(ParticleZ)[i],
+                         system.Stream(ParticleVelocityX)[i], system.Stream(ParticleVelocityY)[i], system.Stream(ParticleVelocityZ)[i],
+                         system.Stream(ParticleAge)[i], system.Stream(ParticleLifetime)[i] };
+    }
+
+    std::vector<ParticleInstance> instances(system.Capacity()), expected;
+    for (uint32_t frame = 0; frame < 60; ++frame) {
+        uint32_t count = system.Update(FrameDt, instances.data(), &pool);
+        ReferenceUpdate(reference, settings, FrameDt, expected);
+        if (count != expected.size()) return false;
+        for (uint32_t i = 0; i < count; ++i) {
+            const ParticleInstance& a = instances[i];
+            const ParticleInstance& b = expected[i];
+            for (int k = 0; k < 3; ++k) {
+                if (std::fabs(a.position[k] - b.position[k]) > 1e-5f) return false;
+            }
+            if (std::fabs(a.size - b.size) > 1e-6f || a.rgba != b.rgba || a.position[1] < settings.groundHeight) return false;
+        }
+    }
+    const ParticleStats& stats = system.Stats();
+    return system.Count() == stats.emitted - stats.died;
+}
+
+// Output of a few frames of emission and update, for comparing configurations.
+std::vector<ParticleInstance> RunFrames(const ParticleSystem& start, uint32_t particles, SimdLevel level, ThreadPool* pool) {
+    ParticleSystem system = start;
+    system.SetSimdLevel(level);
+    ParticleEmitter emitter = FountainEmitter(particles);
+    std::vector<ParticleInstance> instances(system.Capacity());
+    uint32_t count = 0;
+    for (uint32_t frame = 0; frame < 10; ++frame) {
+        system.Emit(emitter, FrameDt, pool);
+        count = system.Update(FrameDt, instances.data(), pool);
+    }
+    instances.resize(count);
+    return instances;
+}
+
+bool SameInstances(const std::vector<ParticleInstance>& a, const std::vector<ParticleInstance>& b) {
+    return a.size() == b.size() && (a.empty() || !memcmp(a.data(), b.data(), a.size() * sizeof(ParticleInstance)));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Options options;
+    options.repetitions = 60;
+    std::vector<std::string> args;
+    if (!bench::ParseOptions(argc, argv, options, &args)) return 2;
+    uint32_t maxParticles = args.size() > 0 ? static_cast<uint32_t>(atoi(args[0].c_str())) : 1u << 20;
+    uint32_t maxThreads = args.size() > 1 ? static_cast<uint32_t>(atoi(args[1].c_str())) : std::max(1u, std::thread::hardware_concurrency());
+    const SimdLevel best = BestSimdLevel();
+    bench::Suite suite(options);
+
+    bool ok = true;
+    {
+        ThreadPool pool(std::min(maxThreads, 4u));
+        for (SimdLevel level : { SimdLevel::Scalar, best }) {
+            bool matches = CheckAgainstReference(level, pool);
+            printf("%s update matches array-of-structs reference: %s\n", SimdLevelName(level), matches ? "ok" : "FAILED");
+            ok &= matches;
+        }
+    }
+
+    std::vector<uint32_t> counts;
+    for (uint32_t n = std::max(maxParticles >> 3, 1024u); n < maxParticles; n *= 2) counts.push_back(n);
+    counts.push_back(maxParticles);
+    std::vector<uint32_t> threadCounts;
+    for (uint32_t t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    printf("\nframes of %.2f ms, emit + update + instance write; items are particles\n", FrameDt * 1000.0f);
+    suite.PrintHeader();
+    for (uint32_t particles : counts) {
+        // Runs the fountain past the longest lifetime so births and deaths balance.
+        ParticleSystem warm(particles + particles / 4, FountainSettings());
+        ParticleEmitter warmEmitter = FountainEmitter(particles);
+        for (uint32_t frame = 0; frame < static_cast<uint32_t>(warmEmitter.lifetimeMax / FrameDt) + 10; ++frame) {
+            warm.Emit(warmEmitter, FrameDt);
+            warm.Update(FrameDt, nullptr);
+        }
+
+        std::vector<ParticleInstance> baseline = RunFrames(warm, particles, SimdLevel::Scalar, nullptr);
+        std::vector<std::pair<SimdLevel, uint32_t>> configs = { { SimdLevel::Scalar, 1 } };
+        if (best == SimdLevel::AVX2) configs.push_back({ SimdLevel::SSE, 1 });
+        for (uint32_t threads : threadCounts) {
+            if (best != SimdLevel::Scalar || threads > 1) configs.push_back({ best, threads });
+        }
+
+        double singleThreadMs = 0.0;
+        for (const auto& config : configs) {
+            ThreadPool pool(config.second);
+            ThreadPool* poolArg = config.second > 1 ? &pool : nullptr;
+            if (!SameInstances(baseline, RunFrames(warm, particles, config.first, poolArg))) {
+                printf("%s with %u threads differs from scalar: FAILED\n", SimdLevelName(config.first), config.second);
+                ok = false;
+            }
+
+            ParticleSystem system = warm;
+            system.SetSimdLevel(config.first);
+            ParticleEmitter emitter = FountainEmitter(particles);
+            std::vector<ParticleInstance> instances(system.Capacity());
+            std::string name = "frame/" + std::to_string(particles) + "/" + SimdLevelName(config.first) + "/t" + std::to_string(config.second);
+            const bench::Result* result = suite.Run(name, particles, [&] {
+                system.Emit(emitter, FrameDt, poolArg);
+                return system.Update(FrameDt, instances.data(), poolArg);
+            });
+            if (!result || config.first != best) continue;
+            if (config.second == 1) singleThreadMs = result->medianMs;
+            else if (singleThreadMs > 0.0) printf("%28s %9.2fx over one thread\n", "", singleThreadMs / result->medianMs);
+        }
+    }
+
+    printf("checksum %llu\n", static_cast<unsigned long long>(suite.Sink()));
+    ok &= suite.WriteJson({ { "simd", SimdLevelName(best) }, { "max_particles", std::to_string(maxParticles) },
+                            { "max_threads", std::to_string(maxThreads) } });
+    ok &= suite.CompareWithBaseline();
+    printf("%s\n", ok ? "all checks passed" : "CHECKS FAILED");
+    return ok ? 0 : 1;
+}
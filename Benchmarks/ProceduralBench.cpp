@@ -0,0 +1,153 @@
+// Checks every generator (welded counts, closed surfaces, outward winding, identical output
+// for any thread count), then times a large terrain at increasing thread counts.
+// Usage: ProceduralBench [terrainTriangles] [maxThreads]
+
+#include "../Hash.h"
+#include "../ProceduralGeometry.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+struct Mesh {
+    std::vector<ColoredVertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+using GenerateFn = std::function<void(ColoredVertex*, uint32_t*, ThreadPool*)>;
+
+Mesh Generate(MeshCounts counts, const GenerateFn& generate, ThreadPool* pool) {
+    Mesh mesh;
+    mesh.vertices.resize(counts.vertexCount);
+    mesh.indices.resize(counts.indexCount);
+    generate(mesh.vertices.data(), mesh.indices.data(), pool);
+    return mesh;
+}
+
+uint64_t HashMesh(const Mesh& mesh) {
+    return HashCombine(Hash64(mesh.vertices.data(), mesh.vertices.size() * sizeof(ColoredVertex)),
+                       Hash64(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t)));
+}
+
+// Signed volume (positive when triangles are clockwise seen from outside) and Euler
+// characteristic V - E + F, where E = 3F / 2 holds for a closed, welded surface.
+bool Validate(const char* name, const Mesh& mesh, double expectedVolume, int expectedEuler) {
+    double volume = 0.0;
+    std::vector<uint32_t> used(mesh.vertices.size(), 0);
+    uint64_t badIndices = 0, degenerate = 0;
+    for (size_t t = 0; t < mesh.indices.size(); t += 3) {
+        uint32_t i0 = mesh.indices[t], i1 = mesh.indices[t + 1], i2 = mesh.indices[t + 2];
+        if (i0 >= mesh.vertices.size() || i1 >= mesh.vertices.size() || i2 >= mesh.vertices.size()) {
+            ++badIndices;
+            continue;
+        }
+        degenerate += i0 == i1 || i1 == i2 || i0 == i2;
+        used[i0] = used[i1] = used[i2] = 1;
+        const float* a = mesh.vertices[i0].position;
+        const float* b = mesh.vertices[i1].position;
+        const float* c = mesh.vertices[i2].position;
+        volume += (double(a[0]) * (double(b[1]) * c[2] - double(b[2]) * c[1]) -
+                   double(a[1]) * (double(b[0]) * c[2] - double(b[2]) * c[0]) +
+                   double(a[2]) * (double(b[0]) * c[1] - double(b[1]) * c[0])) / 6.0;
+    }
+    uint64_t unused = 0;
+    for (uint32_t u : used) unused += u == 0;
+    int64_t faces = mesh.indices.size() / 3;
+    int64_t euler = int64_t(mesh.vertices.size()) - faces * 3 / 2 + faces;
+    bool ok = !badIndices && !degenerate && !unused && (expectedEuler == 0 || euler == expectedEuler) &&
+              (expectedVolume == 0.0 || std::fabs(volume / expectedVolume - 1.0) < 0.05);
+    printf("%-10s %10zu %10zu %12.5f %12.5f %6lld %s\n", name, mesh.vertices.size(), mesh.indices.size() / 3, volume,
+           expectedVolume, static_cast<long long>(expectedEuler ? euler : 0), ok ? "ok" : "FAILED");
+    return ok;
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t terrainTriangles = argc > 1 ? strtoull(argv[1], nullptr, 10) : 50000000;
+    uint32_t hardwareThreads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    uint32_t maxThreads = argc > 2 ? atoi(argv[2]) : std::max(hardwareThreads, 4u);
+
+    ThreadPool checkPool(4);
+    bool ok = true;
+    printf("%-10s %10s %10s %12s %12s %6s\n", "shape", "vertices", "triangles", "volume", "expected", "euler");
+
+    struct Shape {
+        const char* name;
+        MeshCounts counts;
+        GenerateFn generate;
+        double volume;
+        int euler;
+    };
+    const float pi = 3.14159265f;
+    UVSphereDesc sphere{ 0.5f, 256, 128 };
+    IcosphereDesc ico{ 0.5f, 48 };
+    TorusDesc torus{ 0.4f, 0.15f, 256, 96 };
+    GridDesc grid{ 2.0f, 1.0f, 300, 150 };
+    TerrainDesc terrain{ grid, 0.3f, 6.0f, 5, 7 };
+    Shape shapes[] = {
+        { "uvsphere", UVSphereCounts(sphere), [&](ColoredVertex* v, uint32_t* i, ThreadPool* p) { GenerateUVSphere(sphere, v, i, p); },
+          4.0 / 3.0 * pi * 0.125, 2 },
+        { "icosphere", IcosphereCounts(ico), [&](ColoredVertex* v, uint32_t* i, ThreadPool* p) { GenerateIcosphere(ico, v, i, p); },
+          4.0 / 3.0 * pi * 0.125, 2 },
+        { "torus", TorusCounts(torus), [&](ColoredVertex* v, uint32_t* i, ThreadPool* p) { GenerateTorus(torus, v, i, p); },
+          2.0 * pi * pi * 0.4 * 0.15 * 0.15, 0 },
+        { "grid", GridCounts(grid), [&](ColoredVertex* v, uint32_t* i, ThreadPool* p) { GenerateGrid(grid, v, i, p); }, 0.0, 0 },
+        { "terrain", TerrainCounts(terrain), [&](ColoredVertex* v, uint32_t* i, ThreadPool* p) { GenerateTerrain(terrain, v, i, p); },
+          0.0, 0 },
+    };
+    for (const Shape& shape : shapes) {
+        Mesh serial = Generate(shape.counts, shape.generate, nullptr);
+        Mesh parallel = Generate(shape.counts, shape.generate, &checkPool);
+        ok &= Validate(shape.name, parallel, shape.volume, shape.euler);
+        if (HashMesh(serial) != HashMesh(parallel)) {
+            printf("%s: parallel output differs from serial\n", shape.name);
+            ok = false;
+        }
+    }
+
+    uint32_t side = static_cast<uint32_t>(std::sqrt(terrainTriangles / 2.0));
+    TerrainDesc big{ { 100.0f, 100.0f, side, side }, 8.0f, 16.0f, 5, 3 };
+    MeshCounts counts = TerrainCounts(big);
+    printf("\nterrain %ux%u cells: %llu triangles, %.0f MiB of vertices and indices\n", side, side,
+           static_cast<unsigned long long>(counts.indexCount / 3),
+           (counts.vertexCount * sizeof(ColoredVertex) + counts.indexCount * sizeof(uint32_t)) / 1048576.0);
+    std::unique_ptr<ColoredVertex[]> vertices(new ColoredVertex[counts.vertexCount]);
+    std::unique_ptr<uint32_t[]> indices(new uint32_t[counts.indexCount]);
+    // Untimed pass so page faults on the fresh buffers are not charged to the first row.
+    GenerateTerrain(big, vertices.get(), indices.get(), nullptr);
+    printf("%8s %10s %12s %10s\n", "threads", "seconds", "Mtri/s", "speedup");
+    double baseline = 0.0;
+    uint64_t firstHash = 0;
+    for (uint32_t threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool pool(threads);
+        auto start = std::chrono::steady_clock::now();
+        GenerateTerrain(big, vertices.get(), indices.get(), &pool);
+        double seconds = SecondsSince(start);
+        if (threads == 1) baseline = seconds;
+        printf("%8u %10.3f %12.2f %10.2f\n", threads, seconds, counts.indexCount / 3 / seconds * 1e-6, baseline / seconds);
+
+        uint64_t hash = HashCombine(Hash64(vertices.get(), counts.vertexCount * sizeof(ColoredVertex)),
+                                    Hash64(indices.get(), counts.indexCount * sizeof(uint32_t)));
+        if (threads == 1) firstHash = hash;
+        if (hash != firstHash) {
+            printf("output differs at %u threads\n", threads);
+            ok = false;
+        }
+    }
+    printf("(%u hardware threads)\n", hardwareThreads);
+    return ok ? 0 : 1;
+}
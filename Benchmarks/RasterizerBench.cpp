@@ -0,0 +1,141 @@
+// Headless benchmark of SoftRasterizer on the Lab3 cube and on a merged grid of cubes.
+// Usage: RasterizerBench [--width W] [--height H] [--frames N] [--grid N] [--ppm file]
+
+#include "../CubeMesh.h"
+#include "../SoftRasterizer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+struct Options {
+    uint32_t width = 800;
+    uint32_t height = 600;
+    uint32_t frames = 200;
+    uint32_t grid = 48;
+    const char* ppmPath = nullptr;
+};
+
+Options ParseOptions(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--width")) opt.width = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--height")) opt.height = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--frames")) opt.frames = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--grid")) opt.grid = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--ppm")) opt.ppmPath = argv[i + 1];
+    }
+    return opt;
+}
+
+// Same camera as UpdateViewProjBuffer in Lab3.cpp.
+Float4x4 OrbitViewProj(float camDist, float camTheta, float camPhi, float aspect) {
+    Float3 eye = {
+        camDist * std::sin(camTheta) * std::sin(camPhi),
+        camDist * std::cos(camTheta),
+        camDist * std::sin(camTheta) * std::cos(camPhi)
+    };
+    Float4x4 view = MatrixLookAtLH(eye, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+    Float4x4 proj = MatrixPerspectiveFovLH(3.14159265f / 4.0f, aspect, 0.1f, 100.0f);
+    return Multiply(view, proj);
+}
+
+// grid x grid x grid cubes baked into one vertex/index buffer.
+void BuildCubeGrid(uint32_t grid, std::vector<ColoredVertex>& vertices, std::vector<uint32_t>& indices) {
+    const float spacing = 1.0f / static_cast<float>(grid);
+    const float scale = 0.6f * spacing;
+    for (uint32_t z = 0; z < grid; ++z) {
+        for (uint32_t y = 0; y < grid; ++y) {
+            for (uint32_t x = 0; x < grid; ++x) {
+                uint32_t base = static_cast<uint32_t>(vertices.size());
+                float cx = (x + 0.5f) * spacing - 0.5f;
+                float cy = (y + 0.5f) * spacing - 0.5f;
+                float cz = (z + 0.5f) * spacing - 0.5f;
+                for (const ColoredVertex& v : g_CubeVertices) {
+                    vertices.push_back({ { cx + v.position[0] * scale, cy + v.position[1] * scale, cz + v.position[2] * scale }, v.rgba | 0xFF000000u });
+                }
+                for (uint16_t i : g_CubeIndices) indices.push_back(base + i);
+            }
+        }
+    }
+}
+
+void WritePPM(const char* path, const RenderTarget& target) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return;
+    fprintf(f, "P6\n%u %u\n255\n", target.width, target.height);
+    for (uint32_t p : target.pixels) {
+        unsigned char rgb[3] = { static_cast<unsigned char>(p & 0xFF), static_cast<unsigned char>((p >> 8) & 0xFF), static_cast<unsigned char>((p >> 16) & 0xFF) };
+        fwrite(rgb, 1, 3, f);
+    }
+    fclose(f);
+}
+
+double RenderFrames(SoftRasterizer& raster, const Options& opt, const ColoredVertex* vertices, uint32_t vertexCount,
+                    const void* indices, IndexFormat format, uint32_t indexCount) {
+    const float clearColor[4] = { 0.0f, 0.15f, 0.3f, 1.0f };
+    const float aspect = static_cast<float>(opt.width) / static_cast<float>(opt.height);
+    raster.SetViewport({ 0.0f, 0.0f, static_cast<float>(opt.width), static_cast<float>(opt.height), 0.0f, 1.0f });
+    raster.SetVertexBuffer(vertices, vertexCount);
+    raster.SetIndexBuffer(indices, format);
+    raster.SetViewProj(OrbitViewProj(3.0f, 3.14159265f / 2.0f, 0.0f, aspect));
+
+    float angle = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < opt.frames; ++frame) {
+        angle += 0.01f;
+        raster.ClearRenderTarget(clearColor);
+        raster.ClearDepth(1.0f);
+        raster.SetModel(MatrixRotationY(angle));
+        raster.DrawIndexed(indexCount, 0, 0);
+        raster.Flush();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / opt.frames;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt = ParseOptions(argc, argv);
+
+    std::vector<ColoredVertex> gridVertices;
+    std::vector<uint32_t> gridIndices;
+    BuildCubeGrid(opt.grid, gridVertices, gridIndices);
+
+    RenderTarget color;
+    DepthTarget depth;
+    color.Resize(opt.width, opt.height);
+    depth.Resize(opt.width, opt.height);
+
+    uint32_t maxThreads = std::thread::hardware_concurrency();
+    if (maxThreads == 0) maxThreads = 1;
+
+    printf("%ux%u, %u frames, grid %u^3 (%zu triangles)\n", opt.width, opt.height, opt.frames, opt.grid, gridIndices.size() / 3);
+    printf("%8s %14s %14s %10s\n", "threads", "cube ms/frame", "grid ms/frame", "speedup");
+
+    double baseline = 0.0;
+    for (uint32_t threads = 1; threads <= maxThreads; threads = threads < maxThreads && threads * 2 > maxThreads ? maxThreads : threads * 2) {
+        ThreadPool pool(threads);
+        SoftRasterizer raster(pool);
+
+        raster.SetRenderTargets(&color, nullptr);
+        double cubeMs = RenderFrames(raster, opt, g_CubeVertices, 8, g_CubeIndices, IndexFormat::UInt16, 36);
+        if (threads == 1 && opt.ppmPath) WritePPM(opt.ppmPath, color);
+
+        raster.SetRenderTargets(&color, &depth);
+        double gridMs = RenderFrames(raster, opt, gridVertices.data(), static_cast<uint32_t>(gridVertices.size()),
+                                     gridIndices.data(), IndexFormat::UInt32, static_cast<uint32_t>(gridIndices.size()));
+        if (threads == 1) baseline = gridMs;
+        printf("%8u %14.3f %14.3f %9.2fx\n", threads, cubeMs, gridMs, baseline / gridMs);
+        if (threads == maxThreads) break;
+    }
+    return 0;
+}
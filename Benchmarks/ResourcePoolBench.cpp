@@ -0,0 +1,151 @@
+// Create/destroy churn through ResourceRegistry on the null device: a steady set of live
+// buffers where every frame replaces a slice of them, against an unordered_map keyed by
+// incrementing ids. Also checks that stale handles miss, that nothing is released
+// before its frames have retired, and that every object is released in the end.
+// Usage: ResourcePoolBench [operations] [liveResources] [framesInFlight]
+
+#include "../ResourceRegistry.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+double NsPer(std::chrono::steady_clock::time_point start, uint64_t count) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+}
+
+struct Result {
+    double churnNs;
+    double lookupNs;
+    double iterateNs;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t operations = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    uint32_t live = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 50000;
+    uint32_t framesInFlight = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 3;
+    const uint32_t perFrame = live / 16 ? live / 16 : 1;
+    bool ok = true;
+
+    // Same replacement order for both containers.
+    std::mt19937 rng(7);
+    std::vector<uint32_t> victims(operations / 2);
+    for (uint32_t& v : victims) v = rng() % live;
+    std::vector<uint32_t> probes(operations);
+    for (uint32_t& p : probes) p = rng() % live;
+
+    NullResourceDevice device;
+    ResourceRegistry registry;
+    registry.Initialize(&device, framesInFlight);
+    const BufferDesc desc = { 256, BufferUsage::Immutable, BindVertexBuffer };
+
+    std::vector<BufferHandle> handles(live);
+    for (BufferHandle& h : handles) h = registry.CreateBuffer(desc);
+
+    Result pool = {};
+    std::vector<BufferHandle> stale;
+    std::vector<uint64_t> destroyedPerFrame;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < victims.size(); ++i) {
+        if (i % perFrame == 0) {
+            registry.BeginFrame();
+            destroyedPerFrame.push_back(0);
+        }
+        BufferHandle& h = handles[victims[i]];
+        if (stale.size() < 1024) stale.push_back(h);
+        registry.Destroy(h);
+        h = registry.CreateBuffer(desc);
+        ++destroyedPerFrame.back();
+
+        // Whatever was destroyed in the last framesInFlight frames, this one included, must still be pending.
+        if (i % perFrame == perFrame - 1) {
+            uint64_t expected = 0;
+            for (size_t f = destroyedPerFrame.size() > framesInFlight ? destroyedPerFrame.size() - framesInFlight : 0;
+                 f < destroyedPerFrame.size(); ++f)
+                expected += destroyedPerFrame[f];
+            if (registry.PendingReleases() != expected) {
+                printf("frame %llu: %zu pending releases, expected %llu\n", static_cast<unsigned long long>(registry.FrameIndex()),
+                       registry.PendingReleases(), static_cast<unsigned long long>(expected));
+                ok = false;
+                break;
+            }
+        }
+    }
+    pool.churnNs = NsPer(start, operations);
+
+    uint64_t staleHits = 0;
+    for (BufferHandle h : stale) staleHits += registry.Get(h) != nullptr;
+    if (staleHits) {
+        printf("%llu stale handles still resolve\n", static_cast<unsigned long long>(staleHits));
+        ok = false;
+    }
+
+    uint64_t sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t p : probes) sum += registry.Get(handles[p])->desc.size;
+    pool.lookupNs = NsPer(start, probes.size());
+
+    start = std::chrono::steady_clock::now();
+    const int passes = 20;
+    for (int pass = 0; pass < passes; ++pass) {
+        for (const BufferRecord& record : registry.Buffers()) sum += record.desc.size;
+    }
+    pool.iterateNs = NsPer(start, uint64_t(passes) * registry.Buffers().Size());
+
+    const ResourceRegistryStats stats = registry.Stats();
+    size_t slots = registry.Buffers().SlotCount();
+    registry.Clear();
+    if (device.Live() != 0) {
+        printf("%llu objects leaked\n", static_cast<unsigned long long>(device.Live()));
+        ok = false;
+    }
+
+    // Baseline: every object keyed by a fresh id in a hash map.
+    Result map = {};
+    {
+        std::unordered_map<uint32_t, BufferRecord> objects;
+        std::vector<uint32_t> ids(live);
+        uint32_t nextId = 1;
+        for (uint32_t& id : ids) {
+            id = nextId++;
+            objects.emplace(id, BufferRecord{ nullptr, desc });
+        }
+        start = std::chrono::steady_clock::now();
+        for (uint32_t v : victims) {
+            objects.erase(ids[v]);
+            ids[v] = nextId++;
+            objects.emplace(ids[v], BufferRecord{ nullptr, desc });
+        }
+        map.churnNs = NsPer(start, operations);
+
+        start = std::chrono::steady_clock::now();
+        for (uint32_t p : probes) sum += objects.find(ids[p])->second.desc.size;
+        map.lookupNs = NsPer(start, probes.size());
+
+        start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < passes; ++pass) {
+            for (const auto& entry : objects) sum += entry.second.desc.size;
+        }
+        map.iterateNs = NsPer(start, uint64_t(passes) * objects.size());
+    }
+
+    printf("%llu create+destroy operations, %u live buffers, %u replaced per frame, %u frames in flight\n",
+           static_cast<unsigned long long>(operations), live, perFrame, framesInFlight);
+    printf("%-14s %12s %12s %14s\n", "container", "churn ns/op", "lookup ns", "iterate ns/obj");
+    printf("%-14s %12.1f %12.1f %14.2f\n", "HandlePool", pool.churnNs, pool.lookupNs, pool.iterateNs);
+    printf("%-14s %12.1f %12.1f %14.2f\n", "unordered_map", map.churnNs, map.lookupNs, map.iterateNs);
+    printf("slots %zu for %u live, peak pending releases %llu, released %llu of %llu created (checksum %llu)\n", slots, live,
+           static_cast<unsigned long long>(stats.peakPendingReleases), static_cast<unsigned long long>(device.Released()),
+           static_cast<unsigned long long>(device.Created()), static_cast<unsigned long long>(sum));
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
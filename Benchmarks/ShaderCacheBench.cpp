@@ -0,0 +1,117 @@
+// Cold vs warm startup through ShaderCache with a stand-in compiler that burns
+// a fixed amount of CPU per shader, roughly what D3DCompile costs for small shaders.
+// Usage: ShaderCacheBench [shaderCount] [compileMs] [cacheDir]
+
+#include "../Hash.h"
+#include "../ShaderCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+class StandInCompiler final : public ShaderCompiler {
+public:
+    explicit StandInCompiler(double compileMs) : m_compileMs(compileMs) {}
+
+    uint64_t VersionHash() const noexcept override { return 0x5354414e44494e31ull; }
+
+    bool Compile(const ShaderCompileRequest& request, std::vector<uint8_t>& bytecode, std::string& errors) override {
+        ++compileCount;
+        if (request.sourceSize == 0) {
+            errors = "empty source";
+            return false;
+        }
+        uint64_t h = ShaderCache::ComputeKey(request, VersionHash());
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() < m_compileMs) {
+            for (int i = 0; i < 1000; ++i) h = Mix64(h + i);
+        }
+        bytecode.resize(2048 + (h & 1023));
+        for (size_t i = 0; i < bytecode.size(); ++i) bytecode[i] = static_cast<uint8_t>(Mix64(h + i));
+        return true;
+    }
+
+    uint32_t compileCount = 0;
+
+private:
+    double m_compileMs;
+};
+
+const char* g_Source = R"(
+cbuffer ModelBuffer : register(b0) { row_major float4x4 model; };
+cbuffer ViewProjBuffer : register(b1) { row_major float4x4 viewProj; };
+struct VS_INPUT { float3 pos : POSITION; float4 color : COLOR; };
+struct VS_OUTPUT { float4 pos : SV_Position; float4 color : COLOR; };
+VS_OUTPUT main(VS_INPUT input) {
+    VS_OUTPUT output;
+    output.pos = mul(mul(float4(input.pos, 1.0), model), viewProj);
+    output.color = input.color * VARIANT_SCALE;
+    return output;
+}
+)";
+
+// Loads every variant; returns milliseconds and the total bytecode size.
+double Startup(ShaderCache& cache, uint32_t shaderCount, size_t& totalBytes) {
+    totalBytes = 0;
+    std::vector<ShaderBytecode> shaders(shaderCount);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < shaderCount; ++i) {
+        std::string value = std::to_string(1.0 + i * 0.01);
+        ShaderDefine define = { "VARIANT_SCALE", value.c_str() };
+        ShaderCompileRequest request = { g_Source, strlen(g_Source), "main", "vs_5_0", &define, 1, 0, "variant.hlsl" };
+        if (!cache.Load(request, shaders[i])) return -1.0;
+        totalBytes += shaders[i].Size();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint32_t shaderCount = argc > 1 ? atoi(argv[1]) : 48;
+    double compileMs = argc > 2 ? atof(argv[2]) : 20.0;
+    std::string directory = argc > 3 ? argv[3] : "ShaderCacheBench.tmp";
+
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+
+    StandInCompiler compiler(compileMs);
+    size_t bytes = 0;
+    printf("%u shaders, stand-in compile %.1f ms each\n", shaderCount, compileMs);
+
+    ShaderCache cold(directory, compiler);
+    double coldMs = Startup(cold, shaderCount, bytes);
+    printf("cold: %9.2f ms  compiles %3u  hits %3u  misses %3u  (%zu bytes)\n", coldMs, compiler.compileCount, cold.Stats().hits, cold.Stats().misses, bytes);
+
+    compiler.compileCount = 0;
+    ShaderCache warm(directory, compiler);
+    double warmMs = Startup(warm, shaderCount, bytes);
+    printf("warm: %9.2f ms  compiles %3u  hits %3u  misses %3u  speedup %.0fx\n", warmMs, compiler.compileCount, warm.Stats().hits, warm.Stats().misses, coldMs / warmMs);
+
+    // Flip one byte of the first entry's bytecode; the next startup must detect and rebuild it.
+    ShaderDefine define = { "VARIANT_SCALE", "1.000000" };
+    ShaderCompileRequest first = { g_Source, strlen(g_Source), "main", "vs_5_0", &define, 1, 0, "variant.hlsl" };
+    std::string path = warm.EntryPath(ShaderCache::ComputeKey(first, compiler.VersionHash()));
+    if (FILE* f = fopen(path.c_str(), "r+b")) {
+        fseek(f, 100, SEEK_SET);
+        int c = fgetc(f);
+        fseek(f, 100, SEEK_SET);
+        fputc(c ^ 0xFF, f);
+        fclose(f);
+    }
+    compiler.compileCount = 0;
+    ShaderCache repaired(directory, compiler);
+    double repairMs = Startup(repaired, shaderCount, bytes);
+    printf("corrupt entry: %9.2f ms  compiles %3u  invalid %u\n", repairMs, compiler.compileCount, repaired.Stats().invalidEntries);
+
+    std::filesystem::remove_all(directory, ec);
+    return 0;
+}
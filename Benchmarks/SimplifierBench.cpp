@@ -0,0 +1,87 @@
+// LOD chains for large generated meshes: triangles and error per level, simplification
+// throughput, and which level the selector picks as the camera backs away.
+// Usage: SimplifierBench [triangles] [maxErrorPercent]
+
+#include "../MeshSimplifier.h"
+#include "../ProceduralGeometry.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+struct Mesh {
+    std::vector<ColoredVertex> vertices;
+    std::vector<uint32_t> indices;
+    float extent;
+};
+
+double MsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Run(const char* name, const Mesh& mesh, float maxErrorPercent) {
+    const uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    const float maxError = mesh.extent * maxErrorPercent * 0.01f;
+    LodChain chain;
+    auto start = std::chrono::steady_clock::now();
+    BuildLodChain(mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), sizeof(ColoredVertex), vertexCount,
+                  maxError, chain);
+    double ms = MsSince(start);
+
+    printf("\n%s: %zu triangles, %u vertices, error limit %.4f (%.2f%% of extent)\n", name, mesh.indices.size() / 3,
+           vertexCount, maxError, maxErrorPercent);
+    printf("%6s %12s %10s %12s %12s\n", "lod", "triangles", "percent", "error", "error/extent");
+    for (size_t i = 0; i < chain.lods.size(); ++i) {
+        const MeshLod& lod = chain.lods[i];
+        printf("%6zu %12u %9.1f%% %12.5f %11.4f%%\n", i, lod.indexCount / 3, 100.0 * lod.indexCount / mesh.indices.size(),
+               lod.error, 100.0 * lod.error / mesh.extent);
+    }
+    printf("chain built in %.1f ms, %.2f Mtri/s of input\n", ms, mesh.indices.size() / 3 / (ms * 1000.0));
+
+    // Camera on the +Z axis looking at the origin, 1080 pixels high, 60 degree FOV.
+    printf("%10s %6s %12s\n", "distance", "lod", "triangles");
+    for (float distance = mesh.extent; distance <= mesh.extent * 256.0f; distance *= 4.0f) {
+        Float4x4 viewProj = Multiply(MatrixLookAtLH({ 0.0f, 0.0f, -distance }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }),
+                                     MatrixPerspectiveFovLH(1.047f, 16.0f / 9.0f, 0.1f, 10000.0f));
+        LodProjection projection = MakeLodProjection(viewProj, 1080.0f);
+        uint32_t lod = SelectLod(projection, chain.lods.data(), static_cast<uint32_t>(chain.lods.size()), { 0.0f, 0.0f, 0.0f },
+                                 mesh.extent * 0.5f, 1.0f, 1.0f);
+        printf("%10.1f %6u %12u\n", distance, lod, chain.lods[lod].indexCount / 3);
+    }
+}
+
+template<typename Desc, typename CountsFn, typename GenerateFn>
+Mesh Make(const Desc& desc, CountsFn counts, GenerateFn generate, float extent) {
+    MeshCounts c = counts(desc);
+    Mesh mesh;
+    mesh.vertices.resize(c.vertexCount);
+    mesh.indices.resize(c.indexCount);
+    generate(desc, mesh.vertices.data(), mesh.indices.data(), nullptr);
+    mesh.extent = extent;
+    return mesh;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t triangles = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+    float maxErrorPercent = argc > 2 ? static_cast<float>(atof(argv[2])) : 1.0f;
+
+    IcosphereDesc sphere{ 1.0f, static_cast<uint32_t>(std::sqrt(triangles / 20.0)) };
+    Run("icosphere", Make(sphere, IcosphereCounts, GenerateIcosphere, 2.0f), maxErrorPercent);
+
+    uint32_t side = static_cast<uint32_t>(std::sqrt(triangles / 2.0));
+    TerrainDesc terrain{ { 10.0f, 10.0f, side, side }, 1.5f, 4.0f, 6, 11 };
+    Run("terrain (open border)", Make(terrain, TerrainCounts, GenerateTerrain, 10.0f), maxErrorPercent);
+
+    TorusDesc torus{ 1.0f, 0.3f, static_cast<uint32_t>(std::sqrt(triangles / 2.0 * 3.0)),
+                     static_cast<uint32_t>(std::sqrt(triangles / 2.0 / 3.0)) };
+    Run("torus", Make(torus, TorusCounts, GenerateTorus, 2.6f), maxErrorPercent);
+    return 0;
+}
@@ -0,0 +1,223 @@
+// Skeletal animation for a crowd of tentacle characters: every frame samples two
+// looping clips per character, blends them, resolves the skin matrices through the
+// joint chain and skins every vertex into one ColoredVertex stream. Poses and
+// skinning are timed separately, one frame per timed run, with joints and skinned
+// vertices as the items, for several crowd sizes, SIMD levels and thread counts.
+// Checks that cursor sampling matches a plain binary search, that the bind pose
+// reproduces the mesh, that skinning agrees with a per-joint reference, and that the
+// output is bit-identical for every SIMD level and thread count.
+// Usage: SkinningBench [harness options] [maxCharacters] [maxThreads]
+
+#include "BenchHarness.h"
+
+#include "../Skinning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+constexpr float FrameDt = 1.0f / 60.0f;
+
+struct Rig {
+    Skeleton skeleton;
+    SkinnedMesh mesh;
+    AnimationClip sway;
+    AnimationClip curl;
+};
+
+void BuildRig(Rig& rig) {
+    BuildTentacle(TentacleDesc{}, rig.skeleton, rig.mesh);
+    rig.sway = MakeSwayClip(rig.skeleton, 2.0f, { 0.0f, 0.0f, 1.0f }, 0.35f, 0.6f);
+    rig.curl = MakeSwayClip(rig.skeleton, 3.1f, { 1.0f, 0.0f, 0.0f }, 0.25f, 0.3f, 24);
+}
+
+// Characters on a grid, each with its own phase, speed and blend weight.
+void FillCrowd(CrowdAnimator& crowd, const Rig& rig, uint32_t count) {
+    crowd.Clear();
+    const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+    for (uint32_t i = 0; i < count; ++i) {
+        CharacterState state;
+        state.clip = &rig.sway;
+        state.time = 0.37f * static_cast<float>(i % 17);
+        state.blendClip = &rig.curl;
+        state.blendTime = 0.21f * static_cast<float>(i % 13);
+        state.blendWeight = static_cast<float>(i % 5) * 0.2f;
+        state.speed = 0.8f + 0.05f * static_cast<float>(i % 9);
+        state.world = MatrixTranslation(static_cast<float>(i % columns), 0.0f, static_cast<float>(i / columns));
+        crowd.Add(state);
+    }
+}
+
+// Bits of a float, so results feed the sink without float-to-int overflow.
+uint32_t Bits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+bool SamePose(const JointTransform* a, const JointTransform* b, uint32_t count) {
+    return !memcmp(a, b, sizeof(JointTransform) * count);
+}
+
+bool CheckCursor(const Rig& rig) {
+    const uint32_t joints = rig.skeleton.JointCount();
+    std::vector<JointTransform> cached(joints), searched(joints);
+    AnimationCursor cursor;
+    float time = 0.0f;
+    for (uint32_t frame = 0; frame < 1000; ++frame) {
+        // Mostly forward steps, with an occasional jump backwards.
+        time = frame % 97 == 0 ? time * 0.5f : time + FrameDt * (1.0f + static_cast<float>(frame % 7));
+        SampleClip(rig.curl, rig.skeleton, time, cached.data(), &cursor);
+        SampleClip(rig.curl, rig.skeleton, time, searched.data());
+        if (!SamePose(cached.data(), searched.data(), joints)) return false;
+    }
+    return true;
+}
+
+bool CheckBindPose(const Rig& rig, ThreadPool& pool) {
+    CrowdAnimator crowd(rig.skeleton, rig.mesh);
+    CharacterState state;
+    state.world = MatrixTranslation(2.0f, -1.0f, 0.5f);
+    crowd.Add(state);
+    std::vector<ColoredVertex> out(crowd.VertexCount());
+    crowd.Update(out.data(), &pool);
+    for (uint32_t i = 0; i < rig.mesh.VertexCount(); ++i) {
+        const ColoredVertex& a = rig.mesh.vertices[i];
+        const float expected[3] = { a.position[0] + 2.0f, a.position[1] - 1.0f, a.position[2] + 0.5f };
+        for (int c = 0; c < 3; ++c) {
+            if (std::fabs(out[i].position[c] - expected[c]) > 1e-5f) return false;
+        }
+        if (out[i].rgba != a.rgba) return false;
+    }
+    return true;
+}
+
+// Transforms each vertex by every joint separately and sums the weighted points.
+bool CheckAgainstReference(const Rig& rig, ThreadPool& pool) {
+    CrowdAnimator crowd(rig.skeleton, rig.mesh);
+    FillCrowd(crowd, rig, 16);
+    std::vector<ColoredVertex> out(crowd.VertexCount());
+    crowd.Update(out.data(), &pool);
+    const uint32_t vertexCount = rig.mesh.VertexCount();
+    for (uint32_t c = 0; c < crowd.Count(); ++c) {
+        const Float4x4* skin = crowd.SkinMatrices(c);
+        for (uint32_t i = 0; i < vertexCount; ++i) {
+            const ColoredVertex& bind = rig.mesh.vertices[i];
+            const SkinInfluence& influence = rig.mesh.influences[i];
+            double expected[3] = {};
+            for (uint32_t k = 0; k < MaxSkinInfluences; ++k) {
+                Float4 p = TransformPoint({ bind.position[0], bind.position[1], bind.position[2] }, skin[influence.joints[k]]);
+                expected[0] += double(influence.weights[k]) * p.x;
+                expected[1] += double(influence.weights[k]) * p.y;
+                expected[2] += double(influence.weights[k]) * p.z;
+            }
+            const ColoredVertex& v = out[size_t(c) * vertexCount + i];
+            for (int k = 0; k < 3; ++k) {
+                if (std::fabs(v.position[k] - expected[k]) > 1e-4) return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<ColoredVertex> RunFrames(const Rig& rig, uint32_t characters, SimdLevel level, ThreadPool* pool) {
+    CrowdAnimator crowd(rig.skeleton, rig.mesh);
+    crowd.SetSimdLevel(level);
+    FillCrowd(crowd, rig, characters);
+    std::vector<ColoredVertex> out(crowd.VertexCount());
+    for (uint32_t frame = 0; frame < 5; ++frame) {
+        crowd.Advance(FrameDt);
+        crowd.Update(out.data(), pool);
+    }
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Options options;
+    options.repetitions = 60;
+    std::vector<std::string> args;
+    if (!bench::ParseOptions(argc, argv, options, &args)) return 2;
+    uint32_t maxCharacters = args.size() > 0 ? std::max(atoi(args[0].c_str()), 1) : 1000;
+    uint32_t maxThreads = args.size() > 1 ? static_cast<uint32_t>(atoi(args[1].c_str())) : std::max(1u, std::thread::hardware_concurrency());
+    const SimdLevel best = BestSimdLevel();
+    bench::Suite suite(options);
+
+    Rig rig;
+    BuildRig(rig);
+    printf("tentacle rig: %u joints, %u vertices, %zu triangles\n", rig.skeleton.JointCount(), rig.mesh.VertexCount(),
+           rig.mesh.indices.size() / 3);
+
+    bool ok = true;
+    {
+        ThreadPool pool(std::min(maxThreads, 4u));
+        bool cursor = CheckCursor(rig);
+        bool bind = CheckBindPose(rig, pool);
+        bool reference = CheckAgainstReference(rig, pool);
+        printf("cursor sampling matches binary search: %s\n", cursor ? "ok" : "FAILED");
+        printf("bind pose reproduces the mesh: %s\n", bind ? "ok" : "FAILED");
+        printf("skinning matches per-joint reference: %s\n", reference ? "ok" : "FAILED");
+        ok &= cursor && bind && reference;
+    }
+
+    std::vector<uint32_t> counts;
+    for (uint32_t n = std::max(maxCharacters >> 2, 1u); n < maxCharacters; n *= 2) counts.push_back(n);
+    counts.push_back(maxCharacters);
+    std::vector<uint32_t> threadCounts;
+    for (uint32_t t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    printf("\nposes = sample 2 clips + blend + skin matrices, items are joints; skin items are vertices\n");
+    suite.PrintHeader();
+    for (uint32_t characters : counts) {
+        std::vector<ColoredVertex> baseline = RunFrames(rig, characters, SimdLevel::Scalar, nullptr);
+        std::vector<std::pair<SimdLevel, uint32_t>> configs = { { SimdLevel::Scalar, 1 } };
+        if (best == SimdLevel::AVX2) configs.push_back({ SimdLevel::SSE, 1 });
+        for (uint32_t threads : threadCounts) {
+            if (best != SimdLevel::Scalar || threads > 1) configs.push_back({ best, threads });
+        }
+
+        for (const auto& config : configs) {
+            ThreadPool pool(config.second);
+            ThreadPool* poolArg = config.second > 1 ? &pool : nullptr;
+            std::vector<ColoredVertex> result = RunFrames(rig, characters, config.first, poolArg);
+            if (memcmp(baseline.data(), result.data(), baseline.size() * sizeof(ColoredVertex)) != 0) {
+                printf("%s with %u threads differs from scalar: FAILED\n", SimdLevelName(config.first), config.second);
+                ok = false;
+            }
+
+            CrowdAnimator crowd(rig.skeleton, rig.mesh);
+            crowd.SetSimdLevel(config.first);
+            FillCrowd(crowd, rig, characters);
+            std::vector<ColoredVertex> out(crowd.VertexCount());
+            crowd.Update(out.data(), poolArg);
+            const std::string suffix = std::to_string(characters) + "/" + SimdLevelName(config.first) + "/t" + std::to_string(config.second);
+            suite.Run("pose/" + suffix, uint64_t(characters) * rig.skeleton.JointCount(), [&] {
+                crowd.Advance(FrameDt);
+                crowd.UpdatePoses(poolArg);
+                return Bits(crowd.SkinMatrices(characters - 1)[0].m[3][0]);
+            });
+            suite.Run("skin/" + suffix, crowd.VertexCount(), [&] {
+                crowd.Skin(out.data(), poolArg);
+                return Bits(out[out.size() / 2].position[1]);
+            });
+        }
+    }
+
+    printf("checksum %llu\n", static_cast<unsigned long long>(suite.Sink()));
+    ok &= suite.WriteJson({ { "simd", SimdLevelName(best) }, { "max_characters", std::to_string(maxCharacters) },
+                            { "max_threads", std::to_string(maxThreads) } });
+    ok &= suite.CompareWithBaseline();
+    printf("%s\n", ok ? "all checks passed" : "CHECKS FAILED");
+    return ok ? 0 : 1;
+}
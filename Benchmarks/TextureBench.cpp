@@ -0,0 +1,327 @@
+// Texture pipeline on a synthetic RGBA image: TGA/PPM decode, mip generation (box
+// and Kaiser) per SIMD level and thread count, BC1/BC3 compression per thread
+// count with PSNR against the source, and the mappable container. Checks that mips
+// and compressed blocks are identical for every configuration, that compression
+// quality stays above fixed PSNR floors, and that the container round-trips and
+// rejects a corrupted file.
+// Usage: TextureBench [harness options] [size] [maxThreads] [workDir]
+
+#include "BenchHarness.h"
+
+#include "../BlockCompression.h"
+#include "../Hash.h"
+#include "../Image.h"
+#include "../MipChain.h"
+#include "../TextureFile.h"
+#include "../TextureImporter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+constexpr double MinBC1Psnr = 32.0;
+constexpr double MinBC3Psnr = 32.0;
+constexpr double MinAlphaPsnr = 36.0;
+
+// Smooth gradients and rings with a little noise, hard-edged shapes and an alpha
+// ramp with a cut-out, so blocks range from flat to busy.
+Image MakeTestImage(uint32_t size) {
+    Image image;
+    image.Resize(size, size);
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            float u = (x + 0.5f) / size, v = (y + 0.5f) / size;
+            float ring = 0.5f + 0.5f * std::sin(40.0f * std::sqrt((u - 0.5f) * (u - 0.5f) + (v - 0.5f) * (v - 0.5f)));
+            uint32_t noise = static_cast<uint32_t>(Mix64(uint64_t(y) * size + x)) & 7;
+            float r = u, g = 0.3f + 0.5f * ring * v, b = 1.0f - 0.7f * u * v;
+            if (((x / (size / 8 + 1)) + (y / (size / 8 + 1))) % 5 == 0) {
+                r = 0.9f;
+                g = 0.2f;
+                b = 0.1f;
+            }
+            auto channel = [&](float c) { return static_cast<uint8_t>(std::min(255.0f, c * 247.0f + noise)); };
+            uint8_t a = (u - 0.7f) * (u - 0.7f) + (v - 0.3f) * (v - 0.3f) < 0.02f ? 0 : static_cast<uint8_t>(128 + 127 * v);
+            image.pixels[size_t(y) * size + x] = uint32_t(channel(r)) | (uint32_t(channel(g)) << 8) | (uint32_t(channel(b)) << 16) | (uint32_t(a) << 24);
+        }
+    }
+    return image;
+}
+
+// 32-bit run-length TGA with bottom-left origin, to exercise the other decoder paths.
+std::vector<uint8_t> EncodeRleTga(const Image& image) {
+    std::vector<uint8_t> out(18, 0);
+    out[2] = 10;
+    out[12] = static_cast<uint8_t>(image.width);
+    out[13] = static_cast<uint8_t>(image.width >> 8);
+    out[14] = static_cast<uint8_t>(image.height);
+    out[15] = static_cast<uint8_t>(image.height >> 8);
+    out[16] = 32;
+    out[17] = 8;
+    auto put = [&](uint32_t p) {
+        uint8_t bgra[4] = { uint8_t(p >> 16), uint8_t(p >> 8), uint8_t(p), uint8_t(p >> 24) };
+        out.insert(out.end(), bgra, bgra + 4);
+    };
+    for (uint32_t y = image.height; y-- > 0;) {
+        const uint32_t* row = image.pixels.data() + size_t(y) * image.width;
+        for (uint32_t x = 0; x < image.width;) {
+            uint32_t run = 1;
+            while (x + run < image.width && run < 128 && row[x + run] == row[x]) ++run;
+            if (run > 1) {
+                out.push_back(static_cast<uint8_t>(0x80 | (run - 1)));
+                put(row[x]);
+            } else {
+                while (x + run < image.width && run < 128 && row[x + run] != row[x + run - 1]) ++run;
+                out.push_back(static_cast<uint8_t>(run - 1));
+                for (uint32_t k = 0; k < run; ++k) put(row[x + k]);
+            }
+            x += run;
+        }
+    }
+    return out;
+}
+
+bool SameImage(const Image& a, const Image& b) {
+    return a.width == b.width && a.height == b.height && a.pixels == b.pixels;
+}
+
+uint64_t HashLevels(const std::vector<Image>& levels) {
+    uint64_t hash = 0;
+    for (const Image& level : levels) hash = HashCombine(hash, Hash64(level.pixels.data(), level.pixels.size() * sizeof(uint32_t)));
+    return hash;
+}
+
+bool CheckDecoders(bench::Suite& suite, const Image& source, const std::filesystem::path& dir) {
+    const uint64_t pixels = source.pixels.size();
+    std::string tgaPath = (dir / "source.tga").string(), ppmPath = (dir / "source.ppm").string(), error;
+    Image opaque = source;
+    for (uint32_t& p : opaque.pixels) p |= 0xFF000000u;
+
+    // Each decode is checked after the timed runs, unless the filter skipped it.
+    Image loaded;
+    bool tga = WriteTga(tgaPath.c_str(), source, &error);
+    if (suite.Run("decode/tga", pixels, [&] { return tga = tga && LoadImage(tgaPath.c_str(), loaded, &error); })) {
+        tga = tga && SameImage(loaded, source);
+        printf("TGA 32-bit top-down round trip: %s\n", tga ? "ok" : "FAILED");
+    }
+    bool ppm = WritePpm(ppmPath.c_str(), source, &error);
+    if (suite.Run("decode/ppm", pixels, [&] { return ppm = ppm && LoadImage(ppmPath.c_str(), loaded, &error); })) {
+        ppm = ppm && SameImage(loaded, opaque);
+        printf("PPM P6 round trip: %s\n", ppm ? "ok" : "FAILED");
+    }
+    std::vector<uint8_t> rle = EncodeRleTga(source);
+    bool rleOk = true;
+    if (suite.Run("decode/tga_rle", pixels, [&] { return rleOk = rleOk && DecodeTga(rle.data(), rle.size(), loaded, &error); })) {
+        rleOk = rleOk && SameImage(loaded, source);
+        printf("TGA RLE bottom-up round trip: %s\n", rleOk ? "ok" : "FAILED");
+    }
+    if (!error.empty()) printf("decode error: %s\n", error.c_str());
+    bool ok = tga && ppm && rleOk;
+
+    // Truncated input must fail cleanly rather than read past the end.
+    for (size_t size : { size_t(0), size_t(17), rle.size() / 2 }) ok &= !DecodeTga(rle.data(), size, loaded);
+    return ok;
+}
+
+bool BenchMips(bench::Suite& suite, const Image& source, const std::vector<uint32_t>& threadCounts) {
+    bool ok = true;
+    const SimdLevel best = BestSimdLevel();
+    for (MipFilter filter : { MipFilter::Box, MipFilter::Kaiser }) {
+        const char* name = filter == MipFilter::Box ? "box" : "kaiser";
+        MipOptions options;
+        options.filter = filter;
+        std::vector<Image> levels;
+        GenerateMips(source, options, levels, nullptr, SimdLevel::Scalar);
+        const uint64_t baseline = HashLevels(levels);
+        if (levels.size() != MipLevelCount(source.width, source.height) || levels.back().pixels.size() != 1) {
+            printf("%s chain has the wrong shape: FAILED\n", name);
+            ok = false;
+        }
+        // The weights sum to one, so a flat image stays exactly flat at every level.
+        Image flat;
+        flat.Resize(source.width, source.height / 2 + 1);
+        std::fill(flat.pixels.begin(), flat.pixels.end(), 0x80C06020u);
+        std::vector<Image> flatLevels;
+        GenerateMips(flat, options, flatLevels, nullptr, best);
+        for (const Image& level : flatLevels) {
+            if (std::any_of(level.pixels.begin(), level.pixels.end(), [](uint32_t p) { return p != 0x80C06020u; })) {
+                printf("%s mips of a flat image are not flat: FAILED\n", name);
+                ok = false;
+                break;
+            }
+        }
+
+        std::vector<std::pair<SimdLevel, uint32_t>> configs = { { SimdLevel::Scalar, 1 } };
+        if (best == SimdLevel::AVX2) configs.push_back({ SimdLevel::SSE, 1 });
+        for (uint32_t threads : threadCounts) {
+            if (best != SimdLevel::Scalar || threads > 1) configs.push_back({ best, threads });
+        }
+        double singleThreadMs = 0.0;
+        for (const auto& config : configs) {
+            ThreadPool pool(config.second);
+            ThreadPool* poolArg = config.second > 1 ? &pool : nullptr;
+            std::string caseName = std::string("mips/") + name + "/" + SimdLevelName(config.first) + "/t" + std::to_string(config.second);
+            const bench::Result* result = suite.Run(caseName, source.pixels.size(), [&] {
+                GenerateMips(source, options, levels, poolArg, config.first);
+                return levels.size();
+            });
+            if (!result) continue;
+            if (HashLevels(levels) != baseline) {
+                printf("%s mips with %s and %u threads differ from scalar: FAILED\n", name, SimdLevelName(config.first), config.second);
+                ok = false;
+            }
+            if (config.first != best) continue;
+            if (config.second == 1) singleThreadMs = result->medianMs;
+            else if (singleThreadMs > 0.0) printf("%28s %9.2fx over one thread\n", "", singleThreadMs / result->medianMs);
+        }
+    }
+    return ok;
+}
+
+bool BenchCompression(bench::Suite& suite, const Image& source, const std::vector<uint32_t>& threadCounts) {
+    bool ok = true;
+    for (TextureFormat format : { TextureFormat::BC1_UNorm, TextureFormat::BC3_UNorm }) {
+        const bool bc3 = format == TextureFormat::BC3_UNorm;
+        std::vector<uint8_t> baseline, blocks;
+        CompressImage(source, format, baseline, nullptr);
+        Image decoded;
+        DecompressImage(baseline.data(), format, source.width, source.height, decoded);
+        const double rgbPsnr = ComputePsnr(source.pixels.data(), decoded.pixels.data(), source.pixels.size(), PsnrRgb);
+        const double alphaPsnr = ComputePsnr(source.pixels.data(), decoded.pixels.data(), source.pixels.size(), PsnrAlpha);
+        const bool quality = rgbPsnr >= (bc3 ? MinBC3Psnr : MinBC1Psnr) && (!bc3 || alphaPsnr >= MinAlphaPsnr);
+        printf("%s PSNR: RGB %.2f dB", bc3 ? "BC3" : "BC1", rgbPsnr);
+        if (bc3) printf(", alpha %.2f dB", alphaPsnr);
+        printf(", above the floor: %s\n", quality ? "ok" : "FAILED");
+        ok &= quality;
+
+        double singleThreadMs = 0.0;
+        for (uint32_t threads : threadCounts) {
+            ThreadPool pool(threads);
+            std::string caseName = std::string(bc3 ? "compress/bc3" : "compress/bc1") + "/t" + std::to_string(threads);
+            const bench::Result* result = suite.Run(caseName, source.pixels.size(), [&] {
+                CompressImage(source, format, blocks, threads > 1 ? &pool : nullptr);
+                return blocks.size();
+            });
+            if (!result) continue;
+            if (blocks != baseline) {
+                printf("%s blocks with %u threads differ: FAILED\n", bc3 ? "BC3" : "BC1", threads);
+                ok = false;
+            }
+            if (threads == 1) singleThreadMs = result->medianMs;
+            else if (singleThreadMs > 0.0) printf("%28s %9.2fx over one thread\n", "", singleThreadMs / result->medianMs);
+        }
+    }
+
+    // A flat block must come back exactly, through the single-color tables.
+    for (uint32_t color : { 0xFF000000u, 0xFFFFFFFFu, 0xFF7F3F1Fu, 0x80C0A060u }) {
+        uint32_t pixels[16], decoded[16];
+        uint8_t block[16];
+        std::fill_n(pixels, 16, color);
+        EncodeBC3Block(pixels, block);
+        DecodeBC3Block(block, decoded);
+        for (uint32_t i = 0; i < 16; ++i) {
+            int32_t worst = 0;
+            for (uint32_t c = 0; c < 32; c += 8) worst = std::max(worst, std::abs(int32_t((decoded[i] >> c) & 0xFF) - int32_t((color >> c) & 0xFF)));
+            if (worst > 1) {
+                printf("flat block %08x decodes to %08x: FAILED\n", color, decoded[i]);
+                ok = false;
+                break;
+            }
+        }
+    }
+    return ok;
+}
+
+bool BenchContainer(bench::Suite& suite, const Image& source, const std::filesystem::path& dir, uint32_t threads) {
+    ThreadPool pool(threads);
+    const uint64_t pixels = source.pixels.size();
+    std::string texturePath = (dir / "source.gtex").string(), tgaPath = (dir / "source.tga").string(), error;
+    TextureData texture;
+    bool ok = BuildTexture(source, pool, texture, {}, &error) && WriteTextureFile(texturePath.c_str(), texture.Source(), &error);
+    suite.Run("container/build", pixels, [&] { return BuildTexture(source, pool, texture, {}, &error); });
+    suite.Run("container/write", 0, [&] { return WriteTextureFile(texturePath.c_str(), texture.Source(), &error); });
+
+    TextureFile file;
+    ok = ok && file.Open(texturePath.c_str(), &error, true);
+    suite.Run("container/open_checksum", 0, [&] { return file.Open(texturePath.c_str(), &error, true); });
+    for (uint32_t level = 0; ok && level < file.MipCount(); ++level) {
+        ok = file.Mip(level).size == texture.mips[level].size() && file.MipData(level) != nullptr &&
+             reinterpret_cast<uintptr_t>(file.MipData(level)) % TextureFileBlobAlignment == 0 &&
+             !memcmp(file.MipData(level), texture.mips[level].data(), texture.mips[level].size());
+    }
+    if (!ok) {
+        printf("container round trip failed: %s\n", error.c_str());
+        return false;
+    }
+    printf("%s, %ux%u, %u mips, %u threads, %.2f MB: round trip ok\n", IsSrgb(file.Format()) ? "sRGB" : "linear", file.Width(),
+           file.Height(), file.MipCount(), threads, file.Header().fileSize / 1048576.0);
+    const TextureFormat format = file.Format();
+    file.Close();
+
+    // Flip one byte of the smallest mip: the header still validates, the checksum must not.
+    std::string corruptPath = (dir / "corrupt.gtex").string();
+    std::filesystem::copy_file(texturePath, corruptPath, std::filesystem::copy_options::overwrite_existing);
+    if (FILE* corrupt = std::fopen(corruptPath.c_str(), "r+b")) {
+        std::fseek(corrupt, -1, SEEK_END);
+        int last = std::fgetc(corrupt);
+        std::fseek(corrupt, -1, SEEK_END);
+        std::fputc(last ^ 0xFF, corrupt);
+        std::fclose(corrupt);
+    }
+    bool detected = file.Open(corruptPath.c_str(), &error) && !file.Open(corruptPath.c_str(), &error, true);
+    printf("corrupted mip detected by checksum: %s\n", detected ? "ok" : "FAILED");
+
+    auto convert = [&] {
+        return ConvertImageToTextureFile(tgaPath.c_str(), texturePath.c_str(), pool, {}, &error) &&
+               file.Open(texturePath.c_str(), &error) && file.Format() == format;
+    };
+    bool converted = convert();
+    suite.Run("container/convert_tga", pixels, convert);
+    printf("TGA to %s end to end: %s\n", format == TextureFormat::BC3_UNorm_SRGB ? "BC3 sRGB" : "texture", converted ? "ok" : "FAILED");
+    return detected && converted;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Options options;
+    options.warmup = 1;
+    options.repetitions = 5;
+    std::vector<std::string> args;
+    if (!bench::ParseOptions(argc, argv, options, &args)) return 2;
+    uint32_t size = args.size() > 0 ? static_cast<uint32_t>(atoi(args[0].c_str())) : 2048;
+    uint32_t maxThreads = args.size() > 1 ? static_cast<uint32_t>(atoi(args[1].c_str())) : std::max(1u, std::thread::hardware_concurrency());
+    std::filesystem::path dir = args.size() > 2 ? args[2] : "TextureBench.tmp";
+    std::filesystem::create_directories(dir);
+    size = std::max(size, 4u);
+    maxThreads = std::max(maxThreads, 1u);
+    bench::Suite suite(options);
+
+    std::vector<uint32_t> threadCounts;
+    for (uint32_t t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    Image source = MakeTestImage(size);
+    printf("%ux%u RGBA source, SIMD: %s; items are source pixels\n", size, size, SimdLevelName(BestSimdLevel()));
+    suite.PrintHeader();
+    bool ok = CheckDecoders(suite, source, dir);
+    ok &= BenchMips(suite, source, threadCounts);
+    ok &= BenchCompression(suite, source, threadCounts);
+    ok &= BenchContainer(suite, source, dir, maxThreads);
+
+    printf("checksum %llu\n", static_cast<unsigned long long>(suite.Sink()));
+    ok &= suite.WriteJson({ { "simd", SimdLevelName(BestSimdLevel()) }, { "size", std::to_string(size) },
+                            { "max_threads", std::to_string(maxThreads) } });
+    ok &= suite.CompareWithBaseline();
+    printf("%s\n", ok ? "all checks passed" : "CHECKS FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+// World-matrix propagation over a large transform hierarchy where a small fraction of
+// nodes move each frame: dirty-flag Update against recomputing every node, serial and
+// on the thread pool. Checks that both give identical matrices and that nodes added
+// out of depth order are re-sorted correctly.
+// Usage: TransformBench [nodes] [changedPercent] [frames] [maxThreads]
+
+#include "../TransformHierarchy.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+Float4x4 RandomLocal(std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    Float4x4 m = Multiply(MatrixRotationY(unit(rng) * 3.14159f), MatrixScaling(1.0f + 0.01f * unit(rng), 1.0f, 1.0f));
+    m.m[3][0] = unit(rng);
+    m.m[3][1] = unit(rng);
+    m.m[3][2] = unit(rng);
+    return m;
+}
+
+// Roots plus nodes whose parent is a random earlier node of depth below maxDepth,
+// which gives wide, shallow levels like a scene graph.
+void Build(TransformHierarchy& hierarchy, uint32_t count, uint32_t roots, uint32_t maxDepth, std::mt19937& rng) {
+    hierarchy.Clear();
+    hierarchy.Reserve(count);
+    std::vector<TransformId> parents;
+    for (uint32_t i = 0; i < count; ++i) {
+        TransformId parent = NoTransform;
+        if (i >= roots) {
+            do parent = parents[rng() % parents.size()];
+            while (hierarchy.Depth(parent) + 1 >= maxDepth);
+        }
+        TransformId id = hierarchy.Add(RandomLocal(rng), parent);
+        if (hierarchy.Depth(id) + 1 < maxDepth) parents.push_back(id);
+    }
+}
+
+bool SameWorlds(const TransformHierarchy& a, const TransformHierarchy& b) {
+    for (TransformId id = 0; id < a.Count(); ++id) {
+        if (memcmp(&a.World(id), &b.World(id), sizeof(Float4x4)) != 0) return false;
+    }
+    return true;
+}
+
+// Nodes added children-first must come out the same as a recursive reference.
+bool CheckOutOfOrder() {
+    std::mt19937 rng(3);
+    TransformHierarchy hierarchy;
+    std::vector<Float4x4> locals;
+    std::vector<TransformId> parents;
+    TransformId root = hierarchy.Add(RandomLocal(rng));
+    locals.push_back(hierarchy.Local(root));
+    parents.push_back(NoTransform);
+    for (uint32_t i = 1; i < 2000; ++i) {
+        // Alternate between deepening a chain and adding shallow siblings.
+        TransformId parent = (i % 3 == 0) ? root : static_cast<TransformId>(rng() % i);
+        locals.push_back(RandomLocal(rng));
+        parents.push_back(parent);
+        hierarchy.Add(locals.back(), parent);
+        if (i % 500 == 0) hierarchy.Update();
+    }
+    hierarchy.Update();
+    for (int step = 0; step < 3; ++step) {
+        for (int i = 0; i < 50; ++i) {
+            TransformId id = rng() % locals.size();
+            locals[id] = RandomLocal(rng);
+            hierarchy.SetLocal(id, locals[id]);
+        }
+        hierarchy.Update();
+    }
+
+    std::vector<Float4x4> reference(locals.size());
+    for (TransformId id = 0; id < locals.size(); ++id) {
+        reference[id] = parents[id] == NoTransform ? locals[id] : Multiply(locals[id], reference[parents[id]]);
+    }
+    float maxError = 0.0f;
+    for (TransformId id = 0; id < locals.size(); ++id) {
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 4; ++c) maxError = std::max(maxError, std::fabs(hierarchy.World(id).m[r][c] - reference[id].m[r][c]));
+        }
+        if (hierarchy.Parent(id) != parents[id]) return false;
+    }
+    return maxError < 1e-3f;
+}
+
+double MsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint32_t nodes = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 1000000;
+    double changedPercent = argc > 2 ? atof(argv[2]) : 1.0;
+    uint32_t frames = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 20;
+    uint32_t hardwareThreads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    uint32_t maxThreads = argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : std::max(hardwareThreads, 4u);
+    const uint32_t changedPerFrame = static_cast<uint32_t>(nodes * changedPercent / 100.0);
+
+    bool ok = CheckOutOfOrder();
+    printf("out-of-order insertion: %s\n", ok ? "ok" : "FAILED");
+
+    std::mt19937 rng(11);
+    TransformHierarchy incremental, full;
+    Build(incremental, nodes, nodes / 1000 + 1, 8, rng);
+    rng.seed(11);
+    Build(full, nodes, nodes / 1000 + 1, 8, rng);
+    incremental.Update();
+    full.UpdateAll();
+    printf("%u nodes in %u levels, %u changed per frame (%.2f%%)\n", nodes, incremental.LevelCount(), changedPerFrame, changedPercent);
+
+    // The same edits for every run.
+    std::vector<TransformId> edits(size_t(frames) * changedPerFrame);
+    std::vector<Float4x4> values(edits.size());
+    for (size_t i = 0; i < edits.size(); ++i) {
+        edits[i] = rng() % nodes;
+        values[i] = RandomLocal(rng);
+    }
+
+    printf("%8s %14s %14s %16s %10s\n", "threads", "full ms", "dirty ms", "written/frame", "speedup");
+    for (uint32_t threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool pool(threads);
+        ThreadPool* p = threads > 1 ? &pool : nullptr;
+        double fullMs = 0.0, dirtyMs = 0.0;
+        uint64_t written = 0;
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            for (uint32_t i = 0; i < changedPerFrame; ++i) {
+                size_t e = size_t(frame) * changedPerFrame + i;
+                incremental.SetLocal(edits[e], values[e]);
+                full.SetLocal(edits[e], values[e]);
+            }
+            auto start = std::chrono::steady_clock::now();
+            full.UpdateAll(p);
+            fullMs += MsSince(start);
+            start = std::chrono::steady_clock::now();
+            written += incremental.Update(p);
+            dirtyMs += MsSince(start);
+        }
+        if (!SameWorlds(incremental, full)) {
+            printf("incremental and full results differ at %u threads\n", threads);
+            ok = false;
+        }
+        printf("%8u %14.3f %14.3f %16.0f %9.1fx\n", threads, fullMs / frames, dirtyMs / frames, double(written) / frames,
+               fullMs / dirtyMs);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t idle = incremental.Update();
+    printf("update with nothing changed: %u written in %.3f ms\n", idle, MsSince(start));
+    printf("(%u hardware threads)\n", hardwareThreads);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+// Footprint, encode/decode throughput and measured error of the quantized vertex
+// formats against the 16-byte ColoredVertex layout.
+// Usage: VertexFormatBench [vertices] [repeats]
+
+#include "../VertexQuantization.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+struct Source {
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> texcoords;
+    std::vector<uint32_t> colors;
+};
+
+// SIMD decoders follow the scalar operation order, so every level decodes to the same bits.
+bool SameBits(const Source& a, const Source& b) {
+    return std::memcmp(a.positions.data(), b.positions.data(), a.positions.size() * sizeof(float)) == 0 &&
+           std::memcmp(a.normals.data(), b.normals.data(), a.normals.size() * sizeof(float)) == 0 &&
+           std::memcmp(a.texcoords.data(), b.texcoords.data(), a.texcoords.size() * sizeof(float)) == 0 &&
+           std::memcmp(a.colors.data(), b.colors.data(), a.colors.size() * sizeof(uint32_t)) == 0;
+}
+
+// Points on a bumpy sphere with their normals, spherical texcoords and random colors.
+Source MakeSource(size_t count) {
+    Source s;
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (size_t i = 0; i < count; ++i) {
+        float theta = unit(rng) * 6.2831853f, z = unit(rng) * 2.0f - 1.0f, r = std::sqrt(1.0f - z * z);
+        float n[3] = { r * std::cos(theta), r * std::sin(theta), z };
+        float radius = 25.0f + 0.5f * std::sin(theta * 7.0f);
+        s.positions.insert(s.positions.end(), { n[0] * radius + 3.0f, n[1] * radius, n[2] * radius - 10.0f });
+        s.normals.insert(s.normals.end(), { n[0], n[1], n[2] });
+        s.texcoords.insert(s.texcoords.end(), { theta / 6.2831853f, z * 0.5f + 0.5f });
+        s.colors.push_back(static_cast<uint32_t>(rng()));
+    }
+    return s;
+}
+
+double MsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Errors {
+    double position = 0.0, normalRadians = 0.0, texcoordRelative = 0.0;
+};
+
+Errors Measure(const Source& s, const Source& d, size_t count, const VertexFormat& format) {
+    Errors e;
+    for (size_t i = 0; i < count; ++i) {
+        for (int k = 0; k < 3; ++k) e.position = std::fmax(e.position, std::fabs(s.positions[i * 3 + k] - d.positions[i * 3 + k]));
+        if (format.normal != NormalEncoding::None) {
+            // atan2 of |a x b| and a . b stays accurate for tiny angles, unlike acos.
+            const float* a = &s.normals[i * 3];
+            const float* b = &d.normals[i * 3];
+            double cross[3] = { double(a[1]) * b[2] - double(a[2]) * b[1], double(a[2]) * b[0] - double(a[0]) * b[2],
+                                double(a[0]) * b[1] - double(a[1]) * b[0] };
+            double dot = double(a[0]) * b[0] + double(a[1]) * b[1] + double(a[2]) * b[2];
+            double angle = std::atan2(std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]), dot);
+            e.normalRadians = std::fmax(e.normalRadians, angle);
+        }
+        if (format.texcoord != TexcoordEncoding::None) {
+            for (int k = 0; k < 2; ++k) {
+                float v = s.texcoords[i * 2 + k];
+                double error = std::fabs(v - d.texcoords[i * 2 + k]);
+                e.texcoordRelative = std::fmax(e.texcoordRelative, std::fabs(v) >= 6.103515625e-05f ? error / std::fabs(v) : 0.0);
+            }
+        }
+    }
+    return e;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    int repeats = argc > 2 ? atoi(argv[2]) : 5;
+
+    Source source = MakeSource(count);
+    QuantizationBounds bounds = ComputeQuantizationBounds(source.positions.data(), count);
+    VertexStreams in = { source.positions.data(), source.normals.data(), source.texcoords.data(), source.colors.data() };
+
+    struct Case {
+        const char* name;
+        VertexFormat format;
+    };
+    const Case cases[] = {
+        { "ColoredVertex (float3 + rgba8)", { PositionEncoding::Float3, NormalEncoding::None, TexcoordEncoding::None, true } },
+        { "unorm16 pos + rgba8", { PositionEncoding::UNorm16, NormalEncoding::None, TexcoordEncoding::None, true } },
+        { "float pos/normal/uv + rgba8", { PositionEncoding::Float3, NormalEncoding::Float3, TexcoordEncoding::Float2, true } },
+        { "unorm16 pos, oct16 normal, half uv", { PositionEncoding::UNorm16, NormalEncoding::Octahedral16, TexcoordEncoding::Half2, true } },
+    };
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 };
+
+    printf("%zu vertices, bounds error %.3g, oct16 bound %.3g rad, half bound %.3g relative\n", count,
+           PositionErrorBound(bounds), OctahedralNormalErrorBound, HalfRelativeErrorBound);
+    printf("%-36s %6s %9s %8s %12s %12s %12s %10s %10s %10s\n", "format", "bytes", "MB", "simd", "encode ms", "decode ms",
+           "decode Mv/s", "pos err", "normal err", "uv err");
+    for (const Case& c : cases) {
+        MeshVertexLayout layout = BuildVertexLayout(c.format);
+        std::vector<uint8_t> reference;
+        Source referenceDecoded;
+        for (SimdLevel level : levels) {
+            if (level > BestSimdLevel()) continue;
+            std::vector<uint8_t> encoded(count * layout.stride);
+            Source decoded;
+            decoded.positions.resize(count * 3);
+            decoded.normals.resize(count * 3);
+            decoded.texcoords.resize(count * 2);
+            decoded.colors.resize(count);
+            VertexOutputStreams out = { decoded.positions.data(), decoded.normals.data(), decoded.texcoords.data(), decoded.colors.data() };
+
+            double encodeMs = 1e30, decodeMs = 1e30;
+            for (int r = 0; r < repeats; ++r) {
+                auto start = std::chrono::steady_clock::now();
+                EncodeVertices(in, count, c.format, bounds, encoded.data(), level);
+                encodeMs = std::fmin(encodeMs, MsSince(start));
+                start = std::chrono::steady_clock::now();
+                DecodeVertices(encoded.data(), count, c.format, bounds, out, level);
+                decodeMs = std::fmin(decodeMs, MsSince(start));
+            }
+            if (reference.empty()) reference = encoded;
+            bool same = std::memcmp(reference.data(), encoded.data(), encoded.size()) == 0;
+            if (referenceDecoded.positions.empty()) referenceDecoded = decoded;
+            bool sameDecoded = SameBits(referenceDecoded, decoded);
+
+            Errors e = Measure(source, decoded, count, c.format);
+            printf("%-36s %6u %9.1f %8s %12.2f %12.2f %12.1f %10.3g %10.3g %10.3g%s%s\n", c.name, layout.stride,
+                   encoded.size() / 1048576.0, SimdLevelName(level), encodeMs, decodeMs, count / (decodeMs * 1000.0),
+                   e.position, e.normalRadians, e.texcoordRelative, same ? "" : "  (encoding differs from scalar)",
+                   sameDecoded ? "" : "  (decoding differs from scalar)");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,218 @@
+// Compile-time vertex layouts: checks the generated strides, offsets and mesh
+// layouts, checks every conversion kernel against its scalar version on edge
+// values, then times packing LitVertexFormat (float3 position, SNorm16 normal,
+// half texcoord, RGBA8 color) from separate float streams. A per-vertex packer
+// driven by the runtime MeshVertexLayout is the reference for both speed and
+// output. Each timed run streams the vertex count through one batch-sized buffer.
+// Usage: VertexLayoutBench [harness options] [vertices] [batch]
+
+#include "BenchHarness.h"
+
+#include "../VertexLayout.h"
+
+#include "../ColoredVertex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+static_assert(ColoredVertexFormat::Stride == sizeof(ColoredVertex), "ColoredVertexFormat stride");
+static_assert(LitVertexFormat::Stride == 28 && LitVertexFormat::Offset(2) == 20 && LitVertexFormat::Offset(3) == 24,
+              "LitVertexFormat offsets");
+static_assert(LitVertexFormat::Describe().attributes[1].semantic[0] == 'N', "layout description is a constant expression");
+
+struct Source {
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> texcoords;
+    // COLORREF-style: red in the low byte, zero alpha.
+    std::vector<uint32_t> colors;
+};
+
+Source MakeSource(size_t count) {
+    Source s;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    s.positions.resize(count * 3);
+    s.normals.resize(count * 4);
+    s.texcoords.resize(count * 2);
+    s.colors.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        float theta = unit(rng) * 6.2831853f, z = unit(rng) * 2.0f - 1.0f, r = std::sqrt(1.0f - z * z);
+        float n[3] = { r * std::cos(theta), r * std::sin(theta), z };
+        for (int k = 0; k < 3; ++k) {
+            s.positions[i * 3 + k] = n[k] * 20.0f + 1.0f;
+            s.normals[i * 4 + k] = n[k];
+        }
+        s.normals[i * 4 + 3] = i & 1 ? 1.0f : -1.0f;
+        s.texcoords[i * 2] = theta / 6.2831853f;
+        s.texcoords[i * 2 + 1] = z * 0.5f + 0.5f;
+        s.colors[i] = static_cast<uint32_t>(rng()) & 0xFFFFFF;
+    }
+    return s;
+}
+
+// One vertex at a time, converting each attribute through a switch on the runtime layout.
+void PackGeneric(const MeshVertexLayout& layout, const float* const floatStreams[], const uint32_t* colors, size_t count, uint8_t* out) {
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t* vertex = out + i * layout.stride;
+        for (uint32_t a = 0; a < layout.attributeCount; ++a) {
+            const MeshAttribute& attribute = layout.attributes[a];
+            const uint32_t components = ElementComponents(attribute.format);
+            const float* in = floatStreams[a] ? floatStreams[a] + i * components : nullptr;
+            uint8_t* element = vertex + attribute.offset;
+            switch (attribute.format) {
+            case ElementFormat::R8G8B8A8_UNorm: {
+                uint32_t color = colors[i] | 0xFF000000u;
+                std::memcpy(element, &color, 4);
+                break;
+            }
+            case ElementFormat::R16G16B16A16_SNorm:
+            case ElementFormat::R16G16_SNorm:
+                for (uint32_t c = 0; c < components; ++c) {
+                    int16_t v = FloatToSNorm16(in[c]);
+                    std::memcpy(element + c * 2, &v, 2);
+                }
+                break;
+            case ElementFormat::R16G16B16A16_Float:
+            case ElementFormat::R16G16_Float:
+                for (uint32_t c = 0; c < components; ++c) {
+                    uint16_t v = FloatToHalf(in[c]);
+                    std::memcpy(element + c * 2, &v, 2);
+                }
+                break;
+            default: std::memcpy(element, in, ElementSize(attribute.format)); break;
+            }
+        }
+    }
+}
+
+// Values around every rounding and clamping boundary, plus random ones.
+std::vector<float> EdgeValues() {
+    std::vector<float> values = { 0.0f, -0.0f, 1.0f, -1.0f, 0.5f / 255.0f, 1.5f / 255.0f, 0.5f / 32767.0f, -0.5f / 32767.0f,
+                                  1.5f / 32767.0f, 0.5f / 65535.0f, 2.5f / 65535.0f, 1.0001f, -1.0001f, 1e30f, -1e30f,
+                                  std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+                                  std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::denorm_min() };
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> range(-1.5f, 1.5f);
+    while (values.size() < 4099) values.push_back(range(rng));
+    return values;
+}
+
+template<typename T, typename Fn>
+bool SameForEveryLevel(size_t count, const Fn& convert) {
+    std::vector<T> expected(count), actual(count);
+    convert(expected.data(), SimdLevel::Scalar);
+    for (SimdLevel level : { SimdLevel::SSE, SimdLevel::AVX2 }) {
+        if (level > BestSimdLevel()) break;
+        std::fill(actual.begin(), actual.end(), T(0x5A));
+        convert(actual.data(), level);
+        if (std::memcmp(expected.data(), actual.data(), count * sizeof(T)) != 0) return false;
+    }
+    return true;
+}
+
+bool CheckKernels() {
+    const std::vector<float> values = EdgeValues();
+    std::vector<uint32_t> colors(values.size());
+    std::memcpy(colors.data(), values.data(), colors.size() * 4);
+    bool ok = true;
+    auto report = [&](const char* name, bool same) {
+        printf("%-28s %s\n", name, same ? "ok" : "FAILED");
+        ok &= same;
+    };
+    report("UNorm8 levels agree:", SameForEveryLevel<uint8_t>(values.size(), [&](uint8_t* out, SimdLevel level) {
+        ConvertToUNorm8(values.data(), values.size(), out, level);
+    }));
+    report("UNorm16 levels agree:", SameForEveryLevel<uint16_t>(values.size(), [&](uint16_t* out, SimdLevel level) {
+        ConvertToUNorm16(values.data(), values.size(), out, level);
+    }));
+    report("SNorm16 levels agree:", SameForEveryLevel<int16_t>(values.size(), [&](int16_t* out, SimdLevel level) {
+        ConvertToSNorm16(values.data(), values.size(), out, level);
+    }));
+    report("swizzle levels agree:", SameForEveryLevel<uint32_t>(colors.size(), [&](uint32_t* out, SimdLevel level) {
+        SwizzleColors(colors.data(), colors.size(), SwizzleBGRA, 0x80000000u, out, level);
+    }));
+
+    // A few exact values of the D3D conversion rules.
+    bool exact = FloatToUNorm8(1.0f) == 255 && FloatToUNorm8(0.5f / 255.0f) == 1 && FloatToSNorm16(-1.0f) == -32767 &&
+                 FloatToSNorm16(1e30f) == 32767 && FloatToUNorm16(1.0f) == 65535;
+    uint32_t bgra = 0xFF112233u, rgba = 0;
+    SwizzleColors(&bgra, 1, SwizzleBGRA, 0, &rgba, SimdLevel::Scalar);
+    exact &= rgba == PackRGBA8(uint8_t(0x11), uint8_t(0x22), uint8_t(0x33), uint8_t(0xFF));
+    report("conversion rules:", exact);
+
+    MeshVertexLayout colored = {};
+    AppendAttribute(colored, "POSITION", ElementFormat::R32G32B32_Float);
+    AppendAttribute(colored, "COLOR", ElementFormat::R8G8B8A8_UNorm);
+    report("ColoredVertexFormat layout:", SameLayout(ColoredVertexFormat::Describe(), colored));
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Options options;
+    std::vector<std::string> args;
+    if (!bench::ParseOptions(argc, argv, options, &args)) return 2;
+    const uint64_t total = args.size() > 0 ? std::strtoull(args[0].c_str(), nullptr, 10) : 8000000ull;
+    const size_t batch = args.size() > 1 ? static_cast<size_t>(std::max(atoi(args[1].c_str()), 1)) : size_t(1) << 20;
+    bench::Suite suite(options);
+
+    bool ok = CheckKernels();
+
+    const Source source = MakeSource(batch);
+    const MeshVertexLayout layout = LitVertexFormat::Describe();
+    const float* const floatStreams[] = { source.positions.data(), source.normals.data(), source.texcoords.data(), nullptr };
+    AttributeStream streams[LitVertexFormat::AttributeCount];
+    streams[0].data = source.positions.data();
+    streams[1].data = source.normals.data();
+    streams[2].data = source.texcoords.data();
+    streams[3].data = source.colors.data();
+    streams[3].type = AttributeStream::Packed;
+    streams[3].setBits = 0xFF000000u;
+
+    std::vector<uint8_t> expected(batch * LitVertexFormat::Stride), out(expected.size());
+    PackGeneric(layout, floatStreams, source.colors.data(), batch, expected.data());
+
+    printf("\n%llu vertices in batches of %zu per run, %u-byte LitVertexFormat\n", static_cast<unsigned long long>(total), batch,
+           LitVertexFormat::Stride);
+    suite.PrintHeader();
+    auto run = [&](const char* name, SimdLevel level, bool generic) {
+        std::fill(out.begin(), out.end(), uint8_t(0));
+        const bench::Result* result = suite.Run(name, total, [&] {
+            for (uint64_t done = 0; done < total; done += batch) {
+                size_t n = static_cast<size_t>(std::min<uint64_t>(batch, total - done));
+                if (generic) PackGeneric(layout, floatStreams, source.colors.data(), n, out.data());
+                else LitVertexFormat::Pack(streams, n, out.data(), level);
+            }
+            return out[out.size() / 2];
+        });
+        if (!result) return;
+        bool same = !std::memcmp(out.data(), expected.data(), std::min<uint64_t>(total, batch) * LitVertexFormat::Stride);
+        if (!same) printf("%s output differs from the runtime layout: FAILED\n", name);
+        ok &= same;
+    };
+    run("pack/runtime_layout", SimdLevel::Scalar, true);
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 }) {
+        if (level > BestSimdLevel()) break;
+        run((std::string("pack/lit/") + SimdLevelName(level)).c_str(), level, false);
+    }
+
+    printf("checksum %llu\n", static_cast<unsigned long long>(suite.Sink()));
+    ok &= suite.WriteJson({ { "simd", SimdLevelName(BestSimdLevel()) }, { "vertices", std::to_string(total) },
+                            { "batch", std::to_string(batch) } });
+    ok &= suite.CompareWithBaseline();
+    printf("%s\n", ok ? "all checks passed" : "CHECKS FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// Throughput of the SoA TransformPositions kernels against a per-vertex AoS loop.
+// Usage: VertexTransformBench [vertexCount] [repetitions]
+
+#include "../VertexTransform.h"
+
+#if defined(_WIN32)
+#include <DirectXMath.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+template<typename Fn>
+double BestSeconds(int repetitions, Fn&& fn) {
+    double best = 1e30;
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : (4u << 20);
+    int repetitions = argc > 2 ? atoi(argv[2]) : 5;
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<Float3> aos(count);
+    std::vector<float> x(count), y(count), z(count);
+    for (size_t i = 0; i < count; ++i) {
+        aos[i] = { dist(rng), dist(rng), dist(rng) };
+        x[i] = aos[i].x;
+        y[i] = aos[i].y;
+        z[i] = aos[i].z;
+    }
+
+    // The matrices Lab3.cpp builds on the first frame.
+    Float4x4 model = MatrixRotationY(0.5f);
+    Float4x4 view = MatrixLookAtLH({ 3.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+    Float4x4 viewProj = Multiply(view, MatrixPerspectiveFovLH(3.14159265f / 4.0f, 800.0f / 600.0f, 0.1f, 100.0f));
+    Float4x4 mvp = Multiply(model, viewProj);
+
+    std::vector<Float4> reference(count);
+    std::vector<float> ox(count), oy(count), oz(count), ow(count);
+    ClipStreams out = { ox.data(), oy.data(), oz.data(), ow.data() };
+
+#if defined(_WIN32)
+    const char* referenceName = "XMVector3Transform";
+    double referenceSeconds = BestSeconds(repetitions, [&] {
+        DirectX::XMMATRIX m = DirectX::XMLoadFloat4x4(reinterpret_cast<const DirectX::XMFLOAT4X4*>(&mvp));
+        for (size_t i = 0; i < count; ++i) {
+            DirectX::XMVECTOR p = DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(&aos[i]));
+            DirectX::XMStoreFloat4(reinterpret_cast<DirectX::XMFLOAT4*>(&reference[i]), DirectX::XMVector3Transform(p, m));
+        }
+    });
+#else
+    const char* referenceName = "AoS TransformPoint";
+    double referenceSeconds = BestSeconds(repetitions, [&] {
+        for (size_t i = 0; i < count; ++i) reference[i] = TransformPoint(aos[i], mvp);
+    });
+#endif
+
+    printf("%zu vertices, best of %d\n", count, repetitions);
+    printf("%-20s %10.2f Mverts/s\n", referenceName, count / referenceSeconds * 1e-6);
+
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 };
+    for (SimdLevel level : levels) {
+        if (level > BestSimdLevel()) continue;
+        double seconds = BestSeconds(repetitions, [&] {
+            TransformPositions({ x.data(), y.data(), z.data() }, count, mvp, out, level);
+        });
+        float maxError = 0.0f;
+        for (size_t i = 0; i < count; ++i) {
+            maxError = std::max(maxError, std::fabs(ox[i] - reference[i].x));
+            maxError = std::max(maxError, std::fabs(ow[i] - reference[i].w));
+        }
+        printf("SoA %-16s %10.2f Mverts/s  %5.2fx  max error %g\n", SimdLevelName(level),
+               count / seconds * 1e-6, referenceSeconds / seconds, maxError);
+    }
+    return 0;
+}
@@ -0,0 +1,369 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+namespace {
+
+// Below this many blocks a band is not worth a hand-off to the pool.
+constexpr uint64_t MinBlocksPerBand = 256;
+
+inline uint32_t Expand5(uint32_t v) noexcept { return (v << 3) | (v >> 2); }
+inline uint32_t Expand6(uint32_t v) noexcept { return (v << 2) | (v >> 4); }
+
+inline void Unpack565(uint32_t c, int32_t rgb[3]) noexcept {
+    rgb[0] = static_cast<int32_t>(Expand5((c >> 11) & 31));
+    rgb[1] = static_cast<int32_t>(Expand6((c >> 5) & 63));
+    rgb[2] = static_cast<int32_t>(Expand5(c & 31));
+}
+
+inline uint32_t Quantize565(const float rgb[3]) noexcept {
+    auto quantize = [](float v, float scale, int32_t max) noexcept {
+        int32_t q = static_cast<int32_t>(std::lround(v * scale));
+        return static_cast<uint32_t>(std::min(std::max(q, 0), max));
+    };
+    return (quantize(rgb[0], 31.0f / 255.0f, 31) << 11) | (quantize(rgb[1], 63.0f / 255.0f, 63) << 5) | quantize(rgb[2], 31.0f / 255.0f, 31);
+}
+
+// Four-color palette of endpoints c0 > c1, as the decoder computes it.
+void FourColorPalette(uint32_t c0, uint32_t c1, int32_t palette[4][3]) noexcept {
+    Unpack565(c0, palette[0]);
+    Unpack565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+}
+
+inline uint32_t ColorDistance(const int32_t a[3], const int32_t b[3]) noexcept {
+    int32_t dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+    return static_cast<uint32_t>(dr * dr + dg * dg + db * db);
+}
+
+struct ColorFit {
+    uint32_t c0 = 0;
+    uint32_t c1 = 0;
+    uint32_t indices = 0;
+    uint32_t error = 0;
+};
+
+// Orders the endpoints for four-color mode and picks the nearest palette entry per
+// pixel. Equal endpoints decode to a single color at index 0 in either mode.
+ColorFit FitEndpoints(const int32_t pixels[16][3], uint32_t a, uint32_t b) noexcept {
+    ColorFit fit;
+    fit.c0 = std::max(a, b);
+    fit.c1 = std::min(a, b);
+    int32_t palette[4][3];
+    FourColorPalette(fit.c0, fit.c1, palette);
+    const uint32_t entries = fit.c0 == fit.c1 ? 1 : 4;
+    for (uint32_t i = 0; i < 16; ++i) {
+        uint32_t best = 0, bestError = ColorDistance(pixels[i], palette[0]);
+        for (uint32_t k = 1; k < entries; ++k) {
+            uint32_t error = ColorDistance(pixels[i], palette[k]);
+            if (error < bestError) {
+                best = k;
+                bestError = error;
+            }
+        }
+        fit.indices |= best << (i * 2);
+        fit.error += bestError;
+    }
+    return fit;
+}
+
+// Endpoints minimizing the squared error for fixed indices; false when the indices
+// do not determine them (all pixels on one endpoint).
+bool SolveEndpoints(const int32_t pixels[16][3], uint32_t indices, float e0[3], float e1[3]) noexcept {
+    static const float weight0[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = {}, bx[3] = {};
+    for (uint32_t i = 0; i < 16; ++i) {
+        float a = weight0[(indices >> (i * 2)) & 3], b = 1.0f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < 3; ++c) {
+            ax[c] += a * static_cast<float>(pixels[i][c]);
+            bx[c] += b * static_cast<float>(pixels[i][c]);
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f) return false;
+    float inv = 1.0f / det;
+    for (int c = 0; c < 3; ++c) {
+        e0[c] = (ax[c] * bb - bx[c] * ab) * inv;
+        e1[c] = (bx[c] * aa - ax[c] * ab) * inv;
+    }
+    return true;
+}
+
+// Endpoint pairs whose index-2 color, (2a + b) / 3, is closest to each 8-bit value.
+struct SingleColorTables {
+    uint8_t r5[256][2];
+    uint8_t g6[256][2];
+
+    SingleColorTables() noexcept {
+        Build(r5, 31, Expand5);
+        Build(g6, 63, Expand6);
+    }
+
+    static void Build(uint8_t table[256][2], uint32_t max, uint32_t (*expand)(uint32_t)) noexcept {
+        for (int32_t v = 0; v < 256; ++v) {
+            int32_t bestError = 256;
+            for (uint32_t a = 0; a <= max; ++a) {
+                for (uint32_t b = 0; b <= max; ++b) {
+                    int32_t error = std::abs(static_cast<int32_t>((2 * expand(a) + expand(b)) / 3) - v);
+                    if (error < bestError) {
+                        bestError = error;
+                        table[v][0] = static_cast<uint8_t>(a);
+                        table[v][1] = static_cast<uint8_t>(b);
+                    }
+                }
+            }
+        }
+    }
+};
+
+const SingleColorTables& GetSingleColorTables() noexcept {
+    static const SingleColorTables tables;
+    return tables;
+}
+
+ColorFit FitSingleColor(const int32_t rgb[3]) noexcept {
+    const SingleColorTables& tables = GetSingleColorTables();
+    const uint8_t* r = tables.r5[rgb[0]];
+    const uint8_t* g = tables.g6[rgb[1]];
+    const uint8_t* b = tables.r5[rgb[2]];
+    ColorFit fit;
+    fit.c0 = (uint32_t(r[0]) << 11) | (uint32_t(g[0]) << 5) | b[0];
+    fit.c1 = (uint32_t(r[1]) << 11) | (uint32_t(g[1]) << 5) | b[1];
+    // Index 2 is (2 c0 + c1) / 3; with the endpoints swapped the same color is index 3.
+    if (fit.c0 > fit.c1) {
+        fit.indices = 0xAAAAAAAAu;
+    } else if (fit.c0 < fit.c1) {
+        std::swap(fit.c0, fit.c1);
+        fit.indices = 0xFFFFFFFFu;
+    }
+    return fit;
+}
+
+void EncodeColorBlock(const uint32_t rgba[16], uint8_t out[8]) noexcept {
+    int32_t pixels[16][3];
+    bool solid = true;
+    for (uint32_t i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) pixels[i][c] = static_cast<int32_t>((rgba[i] >> (c * 8)) & 0xFF);
+        solid = solid && ((rgba[i] ^ rgba[0]) & 0xFFFFFF) == 0;
+    }
+
+    ColorFit fit;
+    if (solid) {
+        fit = FitSingleColor(pixels[0]);
+    } else {
+        float mean[3] = {};
+        for (uint32_t i = 0; i < 16; ++i) {
+            for (int c = 0; c < 3; ++c) mean[c] += static_cast<float>(pixels[i][c]);
+        }
+        for (int c = 0; c < 3; ++c) mean[c] *= 1.0f / 16.0f;
+        float cov[6] = {};
+        for (uint32_t i = 0; i < 16; ++i) {
+            float d[3] = { pixels[i][0] - mean[0], pixels[i][1] - mean[1], pixels[i][2] - mean[2] };
+            cov[0] += d[0] * d[0];
+            cov[1] += d[0] * d[1];
+            cov[2] += d[0] * d[2];
+            cov[3] += d[1] * d[1];
+            cov[4] += d[1] * d[2];
+            cov[5] += d[2] * d[2];
+        }
+
+        // Principal axis by power iteration, starting from the covariance column of
+        // the channel with the largest variance.
+        const int start = cov[0] >= cov[3] && cov[0] >= cov[5] ? 0 : (cov[3] >= cov[5] ? 1 : 2);
+        const int column[3][3] = { { 0, 1, 2 }, { 1, 3, 4 }, { 2, 4, 5 } };
+        float axis[3] = { cov[column[start][0]], cov[column[start][1]], cov[column[start][2]] };
+        for (int iteration = 0; iteration < 8; ++iteration) {
+            float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+            float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+            float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+            float length = std::max({ std::fabs(x), std::fabs(y), std::fabs(z) });
+            if (length < 1e-12f) break;
+            axis[0] = x / length;
+            axis[1] = y / length;
+            axis[2] = z / length;
+        }
+        float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        for (int c = 0; c < 3; ++c) axis[c] /= length;
+
+        float minT = 0.0f, maxT = 0.0f;
+        for (uint32_t i = 0; i < 16; ++i) {
+            float t = (pixels[i][0] - mean[0]) * axis[0] + (pixels[i][1] - mean[1]) * axis[1] + (pixels[i][2] - mean[2]) * axis[2];
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        // Pulling the extremes in by 1/16 of the range centres the palette on the
+        // bulk of the pixels rather than on outliers.
+        float inset = (maxT - minT) / 16.0f;
+        float e0[3], e1[3];
+        for (int c = 0; c < 3; ++c) {
+            e0[c] = mean[c] + axis[c] * (maxT - inset);
+            e1[c] = mean[c] + axis[c] * (minT + inset);
+        }
+        fit = FitEndpoints(pixels, Quantize565(e0), Quantize565(e1));
+
+        if (fit.c0 != fit.c1 && SolveEndpoints(pixels, fit.indices, e0, e1)) {
+            ColorFit refined = FitEndpoints(pixels, Quantize565(e0), Quantize565(e1));
+            if (refined.error < fit.error) fit = refined;
+        }
+    }
+
+    out[0] = static_cast<uint8_t>(fit.c0);
+    out[1] = static_cast<uint8_t>(fit.c0 >> 8);
+    out[2] = static_cast<uint8_t>(fit.c1);
+    out[3] = static_cast<uint8_t>(fit.c1 >> 8);
+    for (int i = 0; i < 4; ++i) out[4 + i] = static_cast<uint8_t>(fit.indices >> (i * 8));
+}
+
+void AlphaPalette(uint32_t a0, uint32_t a1, uint32_t palette[8]) noexcept {
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1) {
+        for (uint32_t k = 1; k < 7; ++k) palette[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+    } else {
+        for (uint32_t k = 1; k < 5; ++k) palette[k + 1] = ((5 - k) * a0 + k * a1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+void EncodeAlphaBlock(const uint32_t rgba[16], uint8_t out[8]) noexcept {
+    uint32_t a0 = 0, a1 = 255;
+    for (uint32_t i = 0; i < 16; ++i) {
+        a0 = std::max(a0, rgba[i] >> 24);
+        a1 = std::min(a1, rgba[i] >> 24);
+    }
+    uint64_t bits = 0;
+    if (a0 > a1) {
+        uint32_t palette[8];
+        AlphaPalette(a0, a1, palette);
+        for (uint32_t i = 0; i < 16; ++i) {
+            int32_t alpha = static_cast<int32_t>(rgba[i] >> 24);
+            uint64_t best = 0;
+            int32_t bestError = 256;
+            for (uint32_t k = 0; k < 8; ++k) {
+                int32_t error = std::abs(alpha - static_cast<int32_t>(palette[k]));
+                if (error < bestError) {
+                    best = k;
+                    bestError = error;
+                }
+            }
+            bits |= best << (i * 3);
+        }
+    }
+    out[0] = static_cast<uint8_t>(a0);
+    out[1] = static_cast<uint8_t>(a1);
+    for (int i = 0; i < 6; ++i) out[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+}
+
+void DecodeColorBlock(const uint8_t block[8], bool allowThreeColor, uint32_t pixels[16]) noexcept {
+    const uint32_t c0 = block[0] | (uint32_t(block[1]) << 8);
+    const uint32_t c1 = block[2] | (uint32_t(block[3]) << 8);
+    int32_t palette[4][3];
+    FourColorPalette(c0, c1, palette);
+    uint32_t colors[4];
+    for (int k = 0; k < 4; ++k) colors[k] = uint32_t(palette[k][0]) | (uint32_t(palette[k][1]) << 8) | (uint32_t(palette[k][2]) << 16) | 0xFF000000u;
+    if (allowThreeColor && c0 <= c1) {
+        colors[2] = 0xFF000000u;
+        for (int c = 0; c < 3; ++c) colors[2] |= uint32_t((palette[0][c] + palette[1][c]) / 2) << (c * 8);
+        colors[3] = 0;
+    }
+    const uint32_t indices = block[4] | (uint32_t(block[5]) << 8) | (uint32_t(block[6]) << 16) | (uint32_t(block[7]) << 24);
+    for (uint32_t i = 0; i < 16; ++i) pixels[i] = colors[(indices >> (i * 2)) & 3];
+}
+
+template<typename Fn>
+void ForEachBlockRowBand(ThreadPool* pool, uint32_t blockRows, uint32_t blocksPerRow, const Fn& fn) {
+    uint64_t bandLimit = (uint64_t(blockRows) * blocksPerRow) / MinBlocksPerBand;
+    uint32_t bands = pool ? static_cast<uint32_t>(std::min<uint64_t>({ blockRows, pool->ThreadCount() * 4ull, bandLimit })) : 1;
+    if (bands <= 1) {
+        fn(0u, blockRows);
+        return;
+    }
+    pool->Run(bands, [&](uint32_t band, uint32_t) {
+        fn(static_cast<uint32_t>(uint64_t(blockRows) * band / bands), static_cast<uint32_t>(uint64_t(blockRows) * (band + 1) / bands));
+    });
+}
+
+} // namespace
+
+void EncodeBC1Block(const uint32_t pixels[16], uint8_t out[8]) noexcept {
+    EncodeColorBlock(pixels, out);
+}
+
+void EncodeBC3Block(const uint32_t pixels[16], uint8_t out[16]) noexcept {
+    EncodeAlphaBlock(pixels, out);
+    EncodeColorBlock(pixels, out + 8);
+}
+
+void DecodeBC1Block(const uint8_t block[8], uint32_t pixels[16]) noexcept {
+    DecodeColorBlock(block, true, pixels);
+}
+
+void DecodeBC3Block(const uint8_t block[16], uint32_t pixels[16]) noexcept {
+    // The color half of BC2/BC3 is always four-color.
+    DecodeColorBlock(block + 8, false, pixels);
+    uint32_t palette[8];
+    AlphaPalette(block[0], block[1], palette);
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i) bits |= uint64_t(block[2 + i]) << (i * 8);
+    for (uint32_t i = 0; i < 16; ++i) pixels[i] = (pixels[i] & 0xFFFFFF) | (palette[(bits >> (i * 3)) & 7] << 24);
+}
+
+size_t CompressedSize(TextureFormat format, uint32_t width, uint32_t height) noexcept {
+    return size_t(TextureRowPitch(format, width)) * TextureRowCount(format, height);
+}
+
+bool CompressImage(const Image& image, TextureFormat format, std::vector<uint8_t>& out, ThreadPool* pool) {
+    if (!IsBlockCompressed(format)) return false;
+    const uint32_t blockBytes = TexelBlockSize(format);
+    const uint32_t blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+    out.resize(CompressedSize(format, image.width, image.height));
+    if (out.empty()) return true;
+
+    ForEachBlockRowBand(pool, blocksY, blocksX, [&](uint32_t begin, uint32_t end) {
+        uint32_t pixels[16];
+        for (uint32_t by = begin; by < end; ++by) {
+            for (uint32_t bx = 0; bx < blocksX; ++bx) {
+                for (uint32_t i = 0; i < 16; ++i) {
+                    uint32_t x = std::min(bx * 4 + (i & 3), image.width - 1), y = std::min(by * 4 + (i >> 2), image.height - 1);
+                    pixels[i] = image.pixels[size_t(y) * image.width + x];
+                }
+                uint8_t* block = out.data() + (size_t(by) * blocksX + bx) * blockBytes;
+                if (blockBytes == 16) EncodeBC3Block(pixels, block);
+                else EncodeBC1Block(pixels, block);
+            }
+        }
+    });
+    return true;
+}
+
+bool DecompressImage(const uint8_t* data, TextureFormat format, uint32_t width, uint32_t height, Image& out) {
+    if (!IsBlockCompressed(format)) return false;
+    const uint32_t blockBytes = TexelBlockSize(format);
+    const uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    out.Resize(width, height);
+    uint32_t pixels[16];
+    for (uint32_t by = 0; by < blocksY; ++by) {
+        for (uint32_t bx = 0; bx < blocksX; ++bx) {
+            const uint8_t* block = data + (size_t(by) * blocksX + bx) * blockBytes;
+            if (blockBytes == 16) DecodeBC3Block(block, pixels);
+            else DecodeBC1Block(block, pixels);
+            for (uint32_t i = 0; i < 16; ++i) {
+                uint32_t x = bx * 4 + (i & 3), y = by * 4 + (i >> 2);
+                if (x < width && y < height) out.pixels[size_t(y) * width + x] = pixels[i];
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace gfx
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Image.h"
+#include "RenderTypes.h"
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+// 4x4 blocks of RGBA8 pixels in row order. BC1 blocks are always written in the
+// opaque four-color mode, so alpha is dropped; BC3 adds an 8-value alpha block.
+// Endpoints come from the principal axis of the block colors, refined once by
+// least squares; single-color blocks use exact per-value endpoint tables.
+void EncodeBC1Block(const uint32_t pixels[16], uint8_t out[8]) noexcept;
+void EncodeBC3Block(const uint32_t pixels[16], uint8_t out[16]) noexcept;
+
+// Decodes both BC1 modes; the interpolated colors use integer (2a + b) / 3.
+void DecodeBC1Block(const uint8_t block[8], uint32_t pixels[16]) noexcept;
+void DecodeBC3Block(const uint8_t block[16], uint32_t pixels[16]) noexcept;
+
+// Bytes of one compressed level, rows of blocks packed at TextureRowPitch.
+size_t CompressedSize(TextureFormat format, uint32_t width, uint32_t height) noexcept;
+
+// Encodes image into a BC1 or BC3 format (either color space; the block data is the
+// same), splitting block rows across the pool. Partial edge blocks repeat the last
+// row and column. Returns false for formats that are not block-compressed.
+bool CompressImage(const Image& image, TextureFormat format, std::vector<uint8_t>& out, ThreadPool* pool = nullptr);
+
+// Expands CompressedSize(format, width, height) bytes back to RGBA8.
+bool DecompressImage(const uint8_t* data, TextureFormat format, uint32_t width, uint32_t height, Image& out);
+
+} // namespace gfx
@@ -0,0 +1,899 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+constexpr float Infinity = std::numeric_limits<float>::infinity();
+constexpr uint32_t BinCount = 16;
+// Below this depth splits fall back to the object median, which bounds the tree
+// depth and with it the traversal stack.
+constexpr uint32_t MaxSahDepth = 48;
+constexpr uint32_t StackSize = 256;
+constexpr uint32_t ParallelBinBlock = 1u << 15;
+constexpr uint32_t GeometryBlock = 1u << 14;
+// Widens the far slab distance by 2 * gamma(3), so rounding cannot make a ray
+// miss a box it touches (Ize, "Robust BVH Ray Traversal", 2013).
+constexpr float FarScale = 1.0000004f;
+
+// The fourth lane is padding, so Grow is two SSE operations.
+struct alignas(16) Box {
+    float min[4];
+    float max[4];
+};
+
+constexpr Box EmptyBox = { { Infinity, Infinity, Infinity }, { -Infinity, -Infinity, -Infinity } };
+
+inline void Grow(Box& box, const Box& other) noexcept {
+#if GFX_X86
+    _mm_store_ps(box.min, _mm_min_ps(_mm_load_ps(box.min), _mm_load_ps(other.min)));
+    _mm_store_ps(box.max, _mm_max_ps(_mm_load_ps(box.max), _mm_load_ps(other.max)));
+#else
+    for (int k = 0; k < 3; ++k) {
+        box.min[k] = std::min(box.min[k], other.min[k]);
+        box.max[k] = std::max(box.max[k], other.max[k]);
+    }
+#endif
+}
+
+inline void GrowPoint(Box& box, const float p[3]) noexcept {
+    for (int k = 0; k < 3; ++k) {
+        box.min[k] = std::min(box.min[k], p[k]);
+        box.max[k] = std::max(box.max[k], p[k]);
+    }
+}
+
+inline float HalfArea(const Box& box) noexcept {
+    const float dx = box.max[0] - box.min[0], dy = box.max[1] - box.min[1], dz = box.max[2] - box.min[2];
+    return dx * dy + dy * dz + dz * dx;
+}
+
+inline void Centroid(const Box& box, float c[3]) noexcept {
+    for (int k = 0; k < 3; ++k) c[k] = (box.min[k] + box.max[k]) * 0.5f;
+}
+
+inline bool SameBox(const Box& a, const Box& b) noexcept {
+    return !std::memcmp(a.min, b.min, 3 * sizeof(float)) && !std::memcmp(a.max, b.max, 3 * sizeof(float));
+}
+
+inline const float* Position(const TriangleMesh& mesh, uint32_t vertex) noexcept {
+    return reinterpret_cast<const float*>(static_cast<const uint8_t*>(mesh.vertices) + size_t(vertex) * mesh.stride);
+}
+
+Box TriangleBox(const TriangleMesh& mesh, uint32_t triangle) noexcept {
+    Box box = EmptyBox;
+    for (uint32_t k = 0; k < 3; ++k) GrowPoint(box, Position(mesh, mesh.indices[size_t(triangle) * 3 + k]));
+    return box;
+}
+
+template<typename Fn>
+void ForBlocks(ThreadPool* pool, uint32_t count, uint32_t blockSize, const Fn& fn) {
+    const uint32_t blocks = (count + blockSize - 1) / blockSize;
+    auto run = [&](uint32_t block, uint32_t) {
+        const uint32_t begin = block * blockSize;
+        fn(begin, std::min(begin + blockSize, count));
+    };
+    if (pool) {
+        pool->Run(blocks, run);
+    } else {
+        for (uint32_t block = 0; block < blocks; ++block) run(block, 0);
+    }
+}
+
+// Binary SAH tree over primitive boxes; leaves cover order[first, first + count).
+
+struct BinaryNode {
+    Box bounds;
+    uint32_t left, right;
+    uint32_t first, count;
+};
+
+// Primitives are moved rather than indexed while splitting, so every pass over a
+// node reads memory in order.
+struct Primitive {
+    Box bounds;
+    float centroid[3];
+    uint32_t index;
+};
+
+struct BinaryTree {
+    std::vector<BinaryNode> nodes;
+    std::vector<uint32_t> order;
+};
+
+struct BuildItem {
+    uint32_t node;
+    uint32_t first;
+    uint32_t count;
+    uint32_t depth;
+    Box centroids;
+};
+
+struct Bin {
+    Box bounds;
+    uint32_t count;
+};
+
+struct BinSet {
+    Bin bins[3][BinCount];
+};
+
+inline uint32_t BinIndex(float c, float low, float scale) noexcept {
+    const float b = (c - low) * scale;
+    return b <= 0.0f ? 0 : std::min(static_cast<uint32_t>(b), BinCount - 1);
+}
+
+void ClearBins(BinSet& set) noexcept {
+    for (auto& axis : set.bins) {
+        for (Bin& bin : axis) bin = { EmptyBox, 0 };
+    }
+}
+
+void FillBins(const Primitive* prims, uint32_t count, const Box& centroids, const float scale[3], BinSet& set) noexcept {
+    for (uint32_t i = 0; i < count; ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            if (scale[axis] == 0.0f) continue;
+            Bin& bin = set.bins[axis][BinIndex(prims[i].centroid[axis], centroids.min[axis], scale[axis])];
+            Grow(bin.bounds, prims[i].bounds);
+            ++bin.count;
+        }
+    }
+}
+
+struct SplitPlane {
+    int axis = -1;
+    uint32_t bin = 0;
+    float cost = Infinity;
+};
+
+SplitPlane BestPlane(const BinSet& set, const float scale[3]) noexcept {
+    SplitPlane best;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (scale[axis] == 0.0f) continue;
+        const Bin* bins = set.bins[axis];
+        // Right-to-left sweep first, then test every plane on the way back.
+        float rightCost[BinCount];
+        Box right = EmptyBox;
+        uint32_t rightCount = 0;
+        for (uint32_t b = BinCount - 1; b > 0; --b) {
+            Grow(right, bins[b].bounds);
+            rightCount += bins[b].count;
+            rightCost[b] = rightCount ? HalfArea(right) * static_cast<float>(rightCount) : 0.0f;
+        }
+        Box left = EmptyBox;
+        uint32_t leftCount = 0;
+        for (uint32_t b = 1; b < BinCount; ++b) {
+            Grow(left, bins[b - 1].bounds);
+            leftCount += bins[b - 1].count;
+            if (leftCount == 0 || rightCost[b] == 0.0f) continue;
+            const float cost = HalfArea(left) * static_cast<float>(leftCount) + rightCost[b];
+            if (cost < best.cost) best = { axis, b, cost };
+        }
+    }
+    return best;
+}
+
+// Makes the item's node a leaf, or splits it and pushes both children onto stack.
+// A leaf costs one packet test however full it is, so every node that fits one
+// becomes a leaf. Bins in parallel on the pool when one is given.
+void SplitNode(std::vector<BinaryNode>& nodes, Primitive* prims, const BuildItem& item, uint32_t maxLeaf, ThreadPool* pool,
+               std::vector<BuildItem>& stack) {
+    Primitive* range = prims + item.first;
+    const uint32_t count = item.count;
+    if (count <= maxLeaf) {
+        nodes[item.node].first = item.first;
+        nodes[item.node].count = count;
+        return;
+    }
+
+    float scale[3];
+    bool flat = true;
+    for (int k = 0; k < 3; ++k) {
+        const float extent = item.centroids.max[k] - item.centroids.min[k];
+        scale[k] = extent > 0.0f ? static_cast<float>(BinCount) / extent : 0.0f;
+        flat &= scale[k] == 0.0f;
+    }
+
+    SplitPlane plane;
+    if (!flat && item.depth < MaxSahDepth) {
+        BinSet set;
+        if (pool && count >= 2 * ParallelBinBlock) {
+            std::vector<BinSet> partial((count + ParallelBinBlock - 1) / ParallelBinBlock);
+            pool->Run(static_cast<uint32_t>(partial.size()), [&](uint32_t block, uint32_t) {
+                const uint32_t begin = block * ParallelBinBlock;
+                ClearBins(partial[block]);
+                FillBins(range + begin, std::min(ParallelBinBlock, count - begin), item.centroids, scale, partial[block]);
+            });
+            set = partial[0];
+            for (size_t p = 1; p < partial.size(); ++p) {
+                for (int axis = 0; axis < 3; ++axis) {
+                    for (uint32_t b = 0; b < BinCount; ++b) {
+                        Grow(set.bins[axis][b].bounds, partial[p].bins[axis][b].bounds);
+                        set.bins[axis][b].count += partial[p].bins[axis][b].count;
+                    }
+                }
+            }
+        } else {
+            ClearBins(set);
+            FillBins(range, count, item.centroids, scale, set);
+        }
+        plane = BestPlane(set, scale);
+    }
+
+    Box leftBounds = EmptyBox, leftCentroids = EmptyBox, rightBounds = EmptyBox, rightCentroids = EmptyBox;
+    auto addLeft = [&](const Primitive& prim) {
+        Grow(leftBounds, prim.bounds);
+        GrowPoint(leftCentroids, prim.centroid);
+    };
+    auto addRight = [&](const Primitive& prim) {
+        Grow(rightBounds, prim.bounds);
+        GrowPoint(rightCentroids, prim.centroid);
+    };
+    uint32_t leftCount;
+    if (plane.axis >= 0) {
+        // Two-ended partition that gathers both children's boxes in the same pass.
+        const int axis = plane.axis;
+        const float low = item.centroids.min[axis], s = scale[axis];
+        auto isLeft = [&](const Primitive& prim) { return BinIndex(prim.centroid[axis], low, s) < plane.bin; };
+        uint32_t i = 0, j = count;
+        for (;;) {
+            for (; i < j && isLeft(range[i]); ++i) addLeft(range[i]);
+            for (; i < j && !isLeft(range[j - 1]); --j) addRight(range[j - 1]);
+            if (i == j) break;
+            std::swap(range[i], range[j - 1]);
+            addLeft(range[i++]);
+            addRight(range[--j]);
+        }
+        leftCount = i;
+    } else {
+        // Identical centroids or too deep for SAH: halve along the widest centroid axis.
+        int axis = 0;
+        for (int k = 1; k < 3; ++k) {
+            if (item.centroids.max[k] - item.centroids.min[k] > item.centroids.max[axis] - item.centroids.min[axis]) axis = k;
+        }
+        leftCount = count / 2;
+        std::nth_element(range, range + leftCount, range + count, [&](const Primitive& a, const Primitive& b) {
+            return a.centroid[axis] < b.centroid[axis] || (a.centroid[axis] == b.centroid[axis] && a.index < b.index);
+        });
+        for (uint32_t i = 0; i < leftCount; ++i) addLeft(range[i]);
+        for (uint32_t i = leftCount; i < count; ++i) addRight(range[i]);
+    }
+
+    const uint32_t left = static_cast<uint32_t>(nodes.size());
+    nodes.push_back({ leftBounds, 0, 0, 0, 0 });
+    nodes.push_back({ rightBounds, 0, 0, 0, 0 });
+    nodes[item.node].left = left;
+    nodes[item.node].right = left + 1;
+    stack.push_back({ left + 1, item.first + leftCount, count - leftCount, item.depth + 1, rightCentroids });
+    stack.push_back({ left, item.first, leftCount, item.depth + 1, leftCentroids });
+}
+
+void BuildSubtree(std::vector<BinaryNode>& nodes, Primitive* prims, const BuildItem& root, uint32_t maxLeaf) {
+    std::vector<BuildItem> stack = { root };
+    while (!stack.empty()) {
+        const BuildItem item = stack.back();
+        stack.pop_back();
+        SplitNode(nodes, prims, item, maxLeaf, nullptr, stack);
+    }
+}
+
+// With a pool, nodes above a size threshold are split here (binning in parallel)
+// and the subtrees below it build on the workers into their own arrays, which
+// are then appended with their child indices moved.
+void BuildBinaryTree(const std::vector<Box>& boxes, uint32_t maxLeaf, ThreadPool* pool, BinaryTree& tree) {
+    const uint32_t count = static_cast<uint32_t>(boxes.size());
+    tree.nodes.clear();
+    tree.order.resize(count);
+    if (count == 0) return;
+
+    std::vector<Primitive> prims(count);
+    ForBlocks(pool, count, GeometryBlock, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            prims[i].bounds = boxes[i];
+            Centroid(boxes[i], prims[i].centroid);
+            prims[i].index = i;
+        }
+    });
+    BuildItem root = { 0, 0, count, 0, EmptyBox };
+    Box bounds = EmptyBox;
+    for (const Primitive& prim : prims) {
+        Grow(bounds, prim.bounds);
+        GrowPoint(root.centroids, prim.centroid);
+    }
+    tree.nodes.push_back({ bounds, 0, 0, 0, 0 });
+
+    const uint32_t threads = pool ? pool->ThreadCount() : 1;
+    if (threads == 1) {
+        BuildSubtree(tree.nodes, prims.data(), root, maxLeaf);
+    } else {
+        const uint32_t subtreeSize = std::max(count / (threads * 8), 4096u);
+        std::vector<BuildItem> stack = { root }, subtrees;
+        while (!stack.empty()) {
+            const BuildItem item = stack.back();
+            stack.pop_back();
+            if (item.count <= subtreeSize) {
+                subtrees.push_back(item);
+            } else {
+                SplitNode(tree.nodes, prims.data(), item, maxLeaf, pool, stack);
+            }
+        }
+
+        std::vector<std::vector<BinaryNode>> local(subtrees.size());
+        pool->Run(static_cast<uint32_t>(subtrees.size()), [&](uint32_t task, uint32_t) {
+            BuildItem item = subtrees[task];
+            local[task].push_back(tree.nodes[item.node]);
+            item.node = 0;
+            BuildSubtree(local[task], prims.data(), item, maxLeaf);
+        });
+        // Local node 0 is the subtree root, already in place; the rest are appended.
+        for (size_t task = 0; task < subtrees.size(); ++task) {
+            const uint32_t base = static_cast<uint32_t>(tree.nodes.size()) - 1;
+            for (size_t i = 0; i < local[task].size(); ++i) {
+                BinaryNode node = local[task][i];
+                if (node.count == 0) {
+                    node.left += base;
+                    node.right += base;
+                }
+                if (i == 0) {
+                    tree.nodes[subtrees[task].node] = node;
+                } else {
+                    tree.nodes.push_back(node);
+                }
+            }
+        }
+    }
+    for (uint32_t i = 0; i < count; ++i) tree.order[i] = prims[i].index;
+}
+
+inline void SetSlot(BvhNode& node, uint32_t slot, const Box& box) noexcept {
+    node.minX[slot] = box.min[0];
+    node.minY[slot] = box.min[1];
+    node.minZ[slot] = box.min[2];
+    node.maxX[slot] = box.max[0];
+    node.maxY[slot] = box.max[1];
+    node.maxZ[slot] = box.max[2];
+}
+
+inline Box GetSlot(const BvhNode& node, uint32_t slot) noexcept {
+    return { { node.minX[slot], node.minY[slot], node.minZ[slot] }, { node.maxX[slot], node.maxY[slot], node.maxZ[slot] } };
+}
+
+// Union of the used slots.
+Box NodeBox(const BvhNode& node) noexcept {
+    Box box = EmptyBox;
+    for (uint32_t slot = 0; slot < 4; ++slot) {
+        if (node.child[slot] != BvhEmpty) Grow(box, GetSlot(node, slot));
+    }
+    return box;
+}
+
+// Collapses the binary tree into four-wide nodes, preorder. Each node takes its
+// binary children and keeps opening the interior one with the largest surface
+// until it holds four. makeLeaf(binaryLeaf, node, slot) returns the leaf payload.
+template<typename MakeLeaf>
+void CollapseTree(const BinaryTree& tree, std::vector<BvhNode>& nodes, std::vector<uint32_t>* parents, const MakeLeaf& makeLeaf) {
+    nodes.clear();
+    if (parents) parents->clear();
+    if (tree.nodes.empty()) return;
+    // A full binary tree of n nodes has (n + 1) / 2 leaves and at most that many wide nodes.
+    nodes.reserve((tree.nodes.size() + 1) / 2);
+
+    // Empty slots get a degenerate box at +infinity; traversal skips them by child.
+    BvhNode empty;
+    for (uint32_t slot = 0; slot < 4; ++slot) {
+        SetSlot(empty, slot, { { Infinity, Infinity, Infinity }, { Infinity, Infinity, Infinity } });
+        empty.child[slot] = BvhEmpty;
+    }
+    nodes.push_back(empty);
+    if (parents) parents->push_back(NoHit);
+
+    struct Pending {
+        uint32_t binary;
+        uint32_t wide;
+    };
+    std::vector<Pending> stack = { { 0, 0 } };
+    while (!stack.empty()) {
+        const Pending pending = stack.back();
+        stack.pop_back();
+
+        uint32_t children[4] = { pending.binary };
+        uint32_t childCount = 1;
+        const BinaryNode& root = tree.nodes[pending.binary];
+        if (root.count == 0) {
+            children[0] = root.left;
+            children[1] = root.right;
+            childCount = 2;
+            while (childCount < 4) {
+                int open = -1;
+                float openArea = -1.0f;
+                for (uint32_t c = 0; c < childCount; ++c) {
+                    const BinaryNode& child = tree.nodes[children[c]];
+                    if (child.count == 0 && HalfArea(child.bounds) > openArea) {
+                        open = static_cast<int>(c);
+                        openArea = HalfArea(child.bounds);
+                    }
+                }
+                if (open < 0) break;
+                const BinaryNode& opened = tree.nodes[children[open]];
+                children[open] = opened.left;
+                children[childCount++] = opened.right;
+            }
+        }
+
+        BvhNode node = empty;
+        for (uint32_t slot = 0; slot < childCount; ++slot) {
+            const BinaryNode& child = tree.nodes[children[slot]];
+            SetSlot(node, slot, child.bounds);
+            if (child.count > 0) {
+                node.child[slot] = BvhLeaf | makeLeaf(child, pending.wide, slot);
+            } else {
+                const uint32_t index = static_cast<uint32_t>(nodes.size());
+                nodes.push_back(empty);
+                if (parents) parents->push_back(pending.wide << 2 | slot);
+                node.child[slot] = index;
+                stack.push_back({ children[slot], index });
+            }
+        }
+        nodes[pending.wide] = node;
+    }
+}
+
+// Traversal. The scalar and SSE versions evaluate the same expressions in the
+// same order, and min/max pick the second operand on NaN as minps/maxps do.
+
+struct RayData {
+    float origin[3];
+    float direction[3];
+    float inverse[3];
+    float tMin;
+};
+
+RayData PrepareRay(const Ray& ray) noexcept {
+    RayData r;
+    const float o[3] = { ray.origin.x, ray.origin.y, ray.origin.z }, d[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+    for (int k = 0; k < 3; ++k) {
+        r.origin[k] = o[k];
+        r.direction[k] = d[k];
+        r.inverse[k] = 1.0f / d[k];
+    }
+    r.tMin = ray.tMin;
+    return r;
+}
+
+inline float Min(float a, float b) noexcept { return a < b ? a : b; }
+inline float Max(float a, float b) noexcept { return a > b ? a : b; }
+
+uint32_t SlotsScalar(const BvhNode& node, const RayData& r, float tMax, float tNear[4]) noexcept {
+    uint32_t mask = 0;
+    for (uint32_t k = 0; k < 4; ++k) {
+        const float x0 = (node.minX[k] - r.origin[0]) * r.inverse[0], x1 = (node.maxX[k] - r.origin[0]) * r.inverse[0];
+        const float y0 = (node.minY[k] - r.origin[1]) * r.inverse[1], y1 = (node.maxY[k] - r.origin[1]) * r.inverse[1];
+        const float z0 = (node.minZ[k] - r.origin[2]) * r.inverse[2], z1 = (node.maxZ[k] - r.origin[2]) * r.inverse[2];
+        const float nearT = Max(Max(Min(x0, x1), Min(y0, y1)), Max(Min(z0, z1), r.tMin));
+        const float farT = Min(Min(Max(x0, x1), Max(y0, y1)), Min(Max(z0, z1), tMax));
+        tNear[k] = nearT;
+        if (nearT <= farT * FarScale) mask |= 1u << k;
+    }
+    return mask;
+}
+
+// Moller-Trumbore on four lanes; returns the lanes hit in [tMin, tMax].
+uint32_t PacketScalar(const BvhTrianglePacket& p, const RayData& r, float tMax, float t[4], float u[4], float v[4]) noexcept {
+    const float* d = r.direction;
+    uint32_t mask = 0;
+    for (uint32_t k = 0; k < 4; ++k) {
+        const float px = d[1] * p.e2z[k] - d[2] * p.e2y[k];
+        const float py = d[2] * p.e2x[k] - d[0] * p.e2z[k];
+        const float pz = d[0] * p.e2y[k] - d[1] * p.e2x[k];
+        const float det = p.e1x[k] * px + p.e1y[k] * py + p.e1z[k] * pz;
+        const float sx = r.origin[0] - p.v0x[k], sy = r.origin[1] - p.v0y[k], sz = r.origin[2] - p.v0z[k];
+        const float inv = 1.0f / det;
+        u[k] = (sx * px + sy * py + sz * pz) * inv;
+        const float qx = sy * p.e1z[k] - sz * p.e1y[k];
+        const float qy = sz * p.e1x[k] - sx * p.e1z[k];
+        const float qz = sx * p.e1y[k] - sy * p.e1x[k];
+        v[k] = (d[0] * qx + d[1] * qy + d[2] * qz) * inv;
+        t[k] = (p.e2x[k] * qx + p.e2y[k] * qy + p.e2z[k] * qz) * inv;
+        if (det != 0.0f && u[k] >= 0.0f && v[k] >= 0.0f && u[k] + v[k] <= 1.0f && t[k] >= r.tMin && t[k] <= tMax) mask |= 1u << k;
+    }
+    return mask;
+}
+
+#if GFX_X86
+uint32_t SlotsSSE(const BvhNode& node, const RayData& r, float tMax, float tNear[4]) noexcept {
+    const __m128 ox = _mm_set1_ps(r.origin[0]), oy = _mm_set1_ps(r.origin[1]), oz = _mm_set1_ps(r.origin[2]);
+    const __m128 ix = _mm_set1_ps(r.inverse[0]), iy = _mm_set1_ps(r.inverse[1]), iz = _mm_set1_ps(r.inverse[2]);
+    const __m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), ox), ix), x1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), ox), ix);
+    const __m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), oy), iy), y1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), oy), iy);
+    const __m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), oz), iz), z1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), oz), iz);
+    // _mm_min_ps(a, b) is a < b ? a : b, the scalar Min.
+    const __m128 nearT = _mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)), _mm_max_ps(_mm_min_ps(z0, z1), _mm_set1_ps(r.tMin)));
+    const __m128 farT = _mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)), _mm_min_ps(_mm_max_ps(z0, z1), _mm_set1_ps(tMax)));
+    _mm_storeu_ps(tNear, nearT);
+    return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(nearT, _mm_mul_ps(farT, _mm_set1_ps(FarScale)))));
+}
+
+uint32_t PacketSSE(const BvhTrianglePacket& p, const RayData& r, float tMax, float t[4], float u[4], float v[4]) noexcept {
+    const __m128 dx = _mm_set1_ps(r.direction[0]), dy = _mm_set1_ps(r.direction[1]), dz = _mm_set1_ps(r.direction[2]);
+    const __m128 e1x = _mm_load_ps(p.e1x), e1y = _mm_load_ps(p.e1y), e1z = _mm_load_ps(p.e1z);
+    const __m128 e2x = _mm_load_ps(p.e2x), e2y = _mm_load_ps(p.e2y), e2z = _mm_load_ps(p.e2z);
+    const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+    const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+    const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+    const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    const __m128 sx = _mm_sub_ps(_mm_set1_ps(r.origin[0]), _mm_load_ps(p.v0x));
+    const __m128 sy = _mm_sub_ps(_mm_set1_ps(r.origin[1]), _mm_load_ps(p.v0y));
+    const __m128 sz = _mm_sub_ps(_mm_set1_ps(r.origin[2]), _mm_load_ps(p.v0z));
+    const __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), det);
+    const __m128 uu = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inv);
+    const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+    const __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+    const __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+    const __m128 vv = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv);
+    const __m128 tt = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 hit = _mm_cmpneq_ps(det, zero);
+    hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(uu, zero), _mm_cmpge_ps(vv, zero)));
+    hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(uu, vv), _mm_set1_ps(1.0f)));
+    hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(tt, _mm_set1_ps(r.tMin)), _mm_cmple_ps(tt, _mm_set1_ps(tMax))));
+    _mm_storeu_ps(t, tt);
+    _mm_storeu_ps(u, uu);
+    _mm_storeu_ps(v, vv);
+    return static_cast<uint32_t>(_mm_movemask_ps(hit));
+}
+#endif
+
+inline bool UseSSE(SimdLevel level) noexcept {
+#if GFX_X86
+    return level != SimdLevel::Scalar;
+#else
+    (void)level;
+    return false;
+#endif
+}
+
+// Nearest-first depth-first walk. leaf(payload, tMax) tests a leaf, lowers tMax
+// on a closer hit and returns whether it hit; anyHit returns on the first one.
+template<typename Leaf>
+bool WalkNodes(const BvhNode* nodes, const RayData& ray, float tMax, bool sse, bool anyHit, const Leaf& leaf) noexcept {
+    struct Entry {
+        uint32_t child;
+        float tNear;
+    };
+    // Each level leaves at most three siblings on the stack, and the depth is at most
+    // MaxSahDepth plus 32 median splits, which stays below StackSize / 3.
+    Entry stack[StackSize];
+    uint32_t size = 0;
+    stack[size++] = { 0, ray.tMin };
+    bool found = false;
+    while (size > 0) {
+        const Entry entry = stack[--size];
+        if (entry.tNear > tMax) continue;
+        if (entry.child & BvhLeaf) {
+            if (leaf(entry.child & ~BvhLeaf, tMax)) {
+                found = true;
+                if (anyHit) return true;
+            }
+            continue;
+        }
+
+        const BvhNode& node = nodes[entry.child];
+        float tNear[4];
+#if GFX_X86
+        const uint32_t mask = sse ? SlotsSSE(node, ray, tMax, tNear) : SlotsScalar(node, ray, tMax, tNear);
+#else
+        (void)sse;
+        const uint32_t mask = SlotsScalar(node, ray, tMax, tNear);
+#endif
+        // Sorted far to near, so the nearest child is popped first.
+        Entry hits[4];
+        uint32_t count = 0;
+        for (uint32_t slot = 0; slot < 4; ++slot) {
+            if (!(mask & (1u << slot)) || node.child[slot] == BvhEmpty) continue;
+            uint32_t i = count++;
+            for (; i > 0 && hits[i - 1].tNear < tNear[slot]; --i) hits[i] = hits[i - 1];
+            hits[i] = { node.child[slot], tNear[slot] };
+        }
+        for (uint32_t i = 0; i < count; ++i) stack[size++] = hits[i];
+    }
+    return found;
+}
+
+inline Float3 TransformDirection(const Float3& d, const Float4x4& m) noexcept {
+    return { d.x * m.m[0][0] + d.y * m.m[1][0] + d.z * m.m[2][0], d.x * m.m[0][1] + d.y * m.m[1][1] + d.z * m.m[2][1],
+             d.x * m.m[0][2] + d.y * m.m[1][2] + d.z * m.m[2][2] };
+}
+
+// Inverse of a row-vector affine matrix (last column 0, 0, 0, 1).
+Float4x4 InverseAffine(const Float4x4& m) noexcept {
+    const float (*a)[4] = m.m;
+    const float c00 = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+    const float c01 = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+    const float c02 = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+    const float det = a[0][0] * c00 + a[0][1] * c01 + a[0][2] * c02;
+    const float s = det != 0.0f ? 1.0f / det : 0.0f;
+    Float4x4 r = MatrixIdentity();
+    r.m[0][0] = c00 * s;
+    r.m[1][0] = c01 * s;
+    r.m[2][0] = c02 * s;
+    r.m[0][1] = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) * s;
+    r.m[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * s;
+    r.m[2][1] = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * s;
+    r.m[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) * s;
+    r.m[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * s;
+    r.m[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * s;
+    for (int j = 0; j < 3; ++j) r.m[3][j] = -(a[3][0] * r.m[0][j] + a[3][1] * r.m[1][j] + a[3][2] * r.m[2][j]);
+    return r;
+}
+
+template<typename Query>
+void ForRayBlocks(ThreadPool* pool, uint32_t count, const Query& query) {
+    ForBlocks(pool, count, MeshBvh::BatchSize, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) query(i);
+    });
+}
+
+} // namespace
+
+void MeshBvh::Build(const TriangleMesh& mesh, ThreadPool* pool) {
+    Clear();
+    m_triangleCount = mesh.triangleCount;
+    if (mesh.triangleCount == 0) return;
+
+    std::vector<Box> boxes(mesh.triangleCount);
+    ForBlocks(pool, mesh.triangleCount, GeometryBlock, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) boxes[i] = TriangleBox(mesh, i);
+    });
+
+    BinaryTree tree;
+    BuildBinaryTree(boxes, MaxLeafTriangles, pool, tree);
+    m_packets.reserve((tree.nodes.size() + 1) / 2);
+    CollapseTree(tree, m_nodes, nullptr, [&](const BinaryNode& leaf, uint32_t, uint32_t) {
+        BvhTrianglePacket packet = {};
+        for (uint32_t k = 0; k < 4; ++k) packet.triangle[k] = k < leaf.count ? tree.order[leaf.first + k] : NoHit;
+        m_packets.push_back(packet);
+        return static_cast<uint32_t>(m_packets.size() - 1);
+    });
+    Refit(mesh, pool);
+}
+
+void MeshBvh::Refit(const TriangleMesh& mesh, ThreadPool* pool) {
+    if (mesh.triangleCount != m_triangleCount || m_nodes.empty()) {
+        if (mesh.triangleCount != m_triangleCount) Build(mesh, pool);
+        return;
+    }
+
+    std::vector<Box> leafBoxes(m_packets.size());
+    ForBlocks(pool, static_cast<uint32_t>(m_packets.size()), GeometryBlock, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            BvhTrianglePacket& p = m_packets[i];
+            leafBoxes[i] = EmptyBox;
+            for (uint32_t k = 0; k < 4; ++k) {
+                if (p.triangle[k] == NoHit) continue;
+                const uint32_t* index = mesh.indices + size_t(p.triangle[k]) * 3;
+                const float *v0 = Position(mesh, index[0]), *v1 = Position(mesh, index[1]), *v2 = Position(mesh, index[2]);
+                p.v0x[k] = v0[0];
+                p.v0y[k] = v0[1];
+                p.v0z[k] = v0[2];
+                p.e1x[k] = v1[0] - v0[0];
+                p.e1y[k] = v1[1] - v0[1];
+                p.e1z[k] = v1[2] - v0[2];
+                p.e2x[k] = v2[0] - v0[0];
+                p.e2y[k] = v2[1] - v0[1];
+                p.e2z[k] = v2[2] - v0[2];
+                Grow(leafBoxes[i], TriangleBox(mesh, p.triangle[k]));
+            }
+        }
+    });
+
+    // Children follow their parents, so a backward pass sees every child box first.
+    std::vector<Box> nodeBoxes(m_nodes.size());
+    for (size_t i = m_nodes.size(); i-- > 0;) {
+        BvhNode& node = m_nodes[i];
+        for (uint32_t slot = 0; slot < 4; ++slot) {
+            const uint32_t child = node.child[slot];
+            if (child == BvhEmpty) continue;
+            SetSlot(node, slot, child & BvhLeaf ? leafBoxes[child & ~BvhLeaf] : nodeBoxes[child]);
+        }
+        nodeBoxes[i] = NodeBox(node);
+    }
+    m_boundsMin = { nodeBoxes[0].min[0], nodeBoxes[0].min[1], nodeBoxes[0].min[2] };
+    m_boundsMax = { nodeBoxes[0].max[0], nodeBoxes[0].max[1], nodeBoxes[0].max[2] };
+}
+
+void MeshBvh::Clear() noexcept {
+    m_nodes.clear();
+    m_packets.clear();
+    m_triangleCount = 0;
+    m_boundsMin = m_boundsMax = {};
+}
+
+bool MeshBvh::Traverse(const Ray& ray, RayHit* hit, SimdLevel level) const noexcept {
+    if (m_nodes.empty()) return false;
+    const RayData data = PrepareRay(ray);
+    const bool sse = UseSSE(level);
+    RayHit best;
+    best.t = ray.tMax;
+    auto leaf = [&](uint32_t packetIndex, float& tMax) noexcept {
+        const BvhTrianglePacket& p = m_packets[packetIndex];
+        float t[4], u[4], v[4];
+#if GFX_X86
+        const uint32_t mask = sse ? PacketSSE(p, data, tMax, t, u, v) : PacketScalar(p, data, tMax, t, u, v);
+#else
+        const uint32_t mask = PacketScalar(p, data, tMax, t, u, v);
+#endif
+        if (!hit) return mask != 0;
+        bool closer = false;
+        for (uint32_t k = 0; k < 4; ++k) {
+            if (!(mask & (1u << k))) continue;
+            // Equal distances (shared edges) go to the lower index, whatever the visiting order.
+            if (t[k] < best.t || (t[k] == best.t && p.triangle[k] < best.triangle)) {
+                best.t = t[k];
+                best.u = u[k];
+                best.v = v[k];
+                best.triangle = p.triangle[k];
+                closer = true;
+            }
+        }
+        tMax = best.t;
+        return closer;
+    };
+    const bool found = WalkNodes(m_nodes.data(), data, ray.tMax, sse, hit == nullptr, leaf);
+    if (found && hit) *hit = best;
+    return found;
+}
+
+bool MeshBvh::Intersect(const Ray& ray, RayHit& hit, SimdLevel level) const noexcept {
+    return Traverse(ray, &hit, level);
+}
+
+bool MeshBvh::Occluded(const Ray& ray, SimdLevel level) const noexcept {
+    return Traverse(ray, nullptr, level);
+}
+
+void MeshBvh::IntersectBatch(const Ray* rays, uint32_t count, RayHit* hits, ThreadPool* pool, SimdLevel level) const {
+    ForRayBlocks(pool, count, [&](uint32_t i) {
+        hits[i] = RayHit();
+        Intersect(rays[i], hits[i], level);
+    });
+}
+
+void MeshBvh::OccludedBatch(const Ray* rays, uint32_t count, uint8_t* occluded, ThreadPool* pool, SimdLevel level) const {
+    ForRayBlocks(pool, count, [&](uint32_t i) { occluded[i] = Occluded(rays[i], level) ? 1 : 0; });
+}
+
+uint32_t InstanceBvh::AddInstance(const MeshBvh& mesh, const Float4x4& world) {
+    Instance instance = {};
+    instance.mesh = &mesh;
+    instance.world = world;
+    instance.location = NoHit;
+    UpdateInstance(instance);
+    m_instances.push_back(instance);
+    return static_cast<uint32_t>(m_instances.size() - 1);
+}
+
+void InstanceBvh::SetTransform(uint32_t instanceIndex, const Float4x4& world) noexcept {
+    Instance& instance = m_instances[instanceIndex];
+    instance.world = world;
+    UpdateInstance(instance);
+    if (!instance.dirty && instance.location != NoHit) {
+        instance.dirty = true;
+        m_dirty.push_back(instanceIndex);
+    }
+}
+
+void InstanceBvh::Clear() noexcept {
+    m_instances.clear();
+    m_nodes.clear();
+    m_parents.clear();
+    m_dirty.clear();
+}
+
+// Arvo's transformed box: each output axis takes the smaller and larger of every
+// row's contribution. Also picks up new mesh bounds after MeshBvh::Refit.
+void InstanceBvh::UpdateInstance(Instance& instance) noexcept {
+    const float low[3] = { instance.mesh->BoundsMin().x, instance.mesh->BoundsMin().y, instance.mesh->BoundsMin().z };
+    const float high[3] = { instance.mesh->BoundsMax().x, instance.mesh->BoundsMax().y, instance.mesh->BoundsMax().z };
+    float outLow[3], outHigh[3];
+    for (int j = 0; j < 3; ++j) {
+        outLow[j] = outHigh[j] = instance.world.m[3][j];
+        for (int i = 0; i < 3; ++i) {
+            const float a = instance.world.m[i][j] * low[i], b = instance.world.m[i][j] * high[i];
+            outLow[j] += std::min(a, b);
+            outHigh[j] += std::max(a, b);
+        }
+    }
+    instance.boundsMin = { outLow[0], outLow[1], outLow[2] };
+    instance.boundsMax = { outHigh[0], outHigh[1], outHigh[2] };
+    instance.inverse = InverseAffine(instance.world);
+}
+
+void InstanceBvh::Build(ThreadPool* pool) {
+    std::vector<Box> boxes(m_instances.size());
+    for (size_t i = 0; i < m_instances.size(); ++i) {
+        const Instance& instance = m_instances[i];
+        boxes[i] = { { instance.boundsMin.x, instance.boundsMin.y, instance.boundsMin.z },
+                     { instance.boundsMax.x, instance.boundsMax.y, instance.boundsMax.z } };
+    }
+    BinaryTree tree;
+    BuildBinaryTree(boxes, 1, pool, tree);
+    CollapseTree(tree, m_nodes, &m_parents, [&](const BinaryNode& leaf, uint32_t node, uint32_t slot) {
+        const uint32_t instance = tree.order[leaf.first];
+        m_instances[instance].location = node << 2 | slot;
+        return instance;
+    });
+    for (Instance& instance : m_instances) instance.dirty = false;
+    m_dirty.clear();
+}
+
+void InstanceBvh::Refit() noexcept {
+    for (uint32_t index : m_dirty) {
+        Instance& instance = m_instances[index];
+        instance.dirty = false;
+        Box box = { { instance.boundsMin.x, instance.boundsMin.y, instance.boundsMin.z },
+                    { instance.boundsMax.x, instance.boundsMax.y, instance.boundsMax.z } };
+        for (uint32_t location = instance.location; location != NoHit;) {
+            BvhNode& node = m_nodes[location >> 2];
+            const uint32_t slot = location & 3;
+            if (SameBox(GetSlot(node, slot), box)) break;
+            SetSlot(node, slot, box);
+            box = NodeBox(node);
+            location = m_parents[location >> 2];
+        }
+    }
+    m_dirty.clear();
+}
+
+bool InstanceBvh::Traverse(const Ray& ray, RayHit* hit, SimdLevel level) const noexcept {
+    if (m_nodes.empty()) return false;
+    const RayData data = PrepareRay(ray);
+    RayHit best;
+    best.t = ray.tMax;
+    auto leaf = [&](uint32_t index, float& tMax) noexcept {
+        const Instance& instance = m_instances[index];
+        const Float4 origin = TransformPoint(ray.origin, instance.inverse);
+        Ray local;
+        local.origin = { origin.x, origin.y, origin.z };
+        local.direction = TransformDirection(ray.direction, instance.inverse);
+        local.tMin = ray.tMin;
+        local.tMax = tMax;
+        if (!hit) return instance.mesh->Occluded(local, level);
+
+        RayHit candidate;
+        if (!instance.mesh->Intersect(local, candidate, level)) return false;
+        if (candidate.t < best.t || (candidate.t == best.t && index < best.instance)) {
+            best = candidate;
+            best.instance = index;
+            tMax = best.t;
+            return true;
+        }
+        return false;
+    };
+    const bool found = WalkNodes(m_nodes.data(), data, ray.tMax, UseSSE(level), hit == nullptr, leaf);
+    if (found && hit) *hit = best;
+    return found;
+}
+
+bool InstanceBvh::Intersect(const Ray& ray, RayHit& hit, SimdLevel level) const noexcept {
+    return Traverse(ray, &hit, level);
+}
+
+bool InstanceBvh::Occluded(const Ray& ray, SimdLevel level) const noexcept {
+    return Traverse(ray, nullptr, level);
+}
+
+void InstanceBvh::IntersectBatch(const Ray* rays, uint32_t count, RayHit* hits, ThreadPool* pool, SimdLevel level) const {
+    ForRayBlocks(pool, count, [&](uint32_t i) {
+        hits[i] = RayHit();
+        Intersect(rays[i], hits[i], level);
+    });
+}
+
+void InstanceBvh::OccludedBatch(const Ray* rays, uint32_t count, uint8_t* occluded, ThreadPool* pool, SimdLevel level) const {
+    ForRayBlocks(pool, count, [&](uint32_t i) { occluded[i] = Occluded(rays[i], level) ? 1 : 0; });
+}
+
+} // namespace gfx
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "MathTypes.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace gfx {
+
+constexpr uint32_t NoHit = ~0u;
+
+// Points at origin + t * direction for t in [tMin, tMax]. direction need not be
+// normalized; hit distances are in its units.
+struct Ray {
+    Float3 origin;
+    Float3 direction;
+    float tMin = 0.0f;
+    float tMax = std::numeric_limits<float>::infinity();
+};
+
+// Closest hit: the triangle (index / 3 in the source index buffer), barycentrics
+// of its second and third vertices, and the instance for InstanceBvh queries.
+// triangle is NoHit on a miss.
+struct RayHit {
+    float t = std::numeric_limits<float>::infinity();
+    float u = 0.0f;
+    float v = 0.0f;
+    uint32_t triangle = NoHit;
+    uint32_t instance = NoHit;
+};
+
+// Triangle list whose positions are three floats at the start of every
+// stride-byte vertex, e.g. ColoredVertex arrays or a mapped MeshFile.
+struct TriangleMesh {
+    const void* vertices;
+    uint32_t stride;
+    uint32_t vertexCount;
+    const uint32_t* indices;
+    uint32_t triangleCount;
+};
+
+// Four child boxes in SoA form, tested against one ray with one SSE compare.
+// child is a node index, BvhLeaf | leaf payload, or BvhEmpty for unused slots.
+// Children always come after their parent in the node array.
+struct alignas(16) BvhNode {
+    float minX[4], minY[4], minZ[4];
+    float maxX[4], maxY[4], maxZ[4];
+    uint32_t child[4];
+};
+
+constexpr uint32_t BvhLeaf = 0x80000000u;
+constexpr uint32_t BvhEmpty = ~0u;
+
+// Up to four triangles as a vertex and two edges each; unused lanes have zero
+// edges, which no ray hits, and triangle NoHit.
+struct alignas(16) BvhTrianglePacket {
+    float v0x[4], v0y[4], v0z[4];
+    float e1x[4], e1y[4], e1z[4];
+    float e2x[4], e2y[4], e2z[4];
+    uint32_t triangle[4];
+};
+
+// Four-wide BVH over the triangles of one mesh. Build bins triangle centroids
+// for the surface area heuristic (SAH), splits a binary tree top-down and then
+// collapses it to four children per node, with every leaf one packet of up to
+// four triangles stored as v0, e1, e2 in SoA form. With a pool, the upper levels
+// bin in parallel and the subtrees below them build on separate threads; the tree
+// does not depend on the thread count. Queries at every SIMD level return the
+// same hits: traversal is scalar or SSE (AVX2 uses the SSE path, as nodes and
+// packets are four wide), and ties in t go to the lower triangle index.
+class MeshBvh {
+public:
+    static constexpr uint32_t MaxLeafTriangles = 4;
+
+    void Build(const TriangleMesh& mesh, ThreadPool* pool = nullptr);
+    // Updates boxes and packets for moved vertices with the same topology. Cheaper
+    // than Build, but the tree keeps its old shape, so large motions degrade it.
+    void Refit(const TriangleMesh& mesh, ThreadPool* pool = nullptr);
+    void Clear() noexcept;
+
+    bool Intersect(const Ray& ray, RayHit& hit, SimdLevel level = BestSimdLevel()) const noexcept;
+    // True if any triangle is hit in [tMin, tMax]; stops at the first one found.
+    bool Occluded(const Ray& ray, SimdLevel level = BestSimdLevel()) const noexcept;
+
+    // One query per ray, split over the pool in blocks of BatchSize rays.
+    static constexpr uint32_t BatchSize = 1024;
+    void IntersectBatch(const Ray* rays, uint32_t count, RayHit* hits, ThreadPool* pool = nullptr,
+                        SimdLevel level = BestSimdLevel()) const;
+    void OccludedBatch(const Ray* rays, uint32_t count, uint8_t* occluded, ThreadPool* pool = nullptr,
+                       SimdLevel level = BestSimdLevel()) const;
+
+    bool Empty() const noexcept { return m_nodes.empty(); }
+    uint32_t TriangleCount() const noexcept { return m_triangleCount; }
+    uint32_t NodeCount() const noexcept { return static_cast<uint32_t>(m_nodes.size()); }
+    const Float3& BoundsMin() const noexcept { return m_boundsMin; }
+    const Float3& BoundsMax() const noexcept { return m_boundsMax; }
+
+private:
+    bool Traverse(const Ray& ray, RayHit* hit, SimdLevel level) const noexcept;
+
+    std::vector<BvhNode> m_nodes;
+    std::vector<BvhTrianglePacket> m_packets;
+    uint32_t m_triangleCount = 0;
+    Float3 m_boundsMin = {};
+    Float3 m_boundsMax = {};
+};
+
+// Two-level BVH over instances of MeshBvh with affine world transforms; rays are
+// moved into each instance's space instead of transforming triangles. Build runs
+// the SAH build over the instances' world boxes. SetTransform only records the
+// change; Refit then rewrites the boxes on the path from each changed instance to
+// the root and stops early where a box did not change. Refit keeps the tree shape,
+// so rebuild after large rearrangements.
+class InstanceBvh {
+public:
+    uint32_t AddInstance(const MeshBvh& mesh, const Float4x4& world);
+    void SetTransform(uint32_t instance, const Float4x4& world) noexcept;
+    void Clear() noexcept;
+
+    void Build(ThreadPool* pool = nullptr);
+    void Refit() noexcept;
+
+    bool Intersect(const Ray& ray, RayHit& hit, SimdLevel level = BestSimdLevel()) const noexcept;
+    bool Occluded(const Ray& ray, SimdLevel level = BestSimdLevel()) const noexcept;
+    void IntersectBatch(const Ray* rays, uint32_t count, RayHit* hits, ThreadPool* pool = nullptr,
+                        SimdLevel level = BestSimdLevel()) const;
+    void OccludedBatch(const Ray* rays, uint32_t count, uint8_t* occluded, ThreadPool* pool = nullptr,
+                       SimdLevel level = BestSimdLevel()) const;
+
+    uint32_t InstanceCount() const noexcept { return static_cast<uint32_t>(m_instances.size()); }
+    uint32_t NodeCount() const noexcept { return static_cast<uint32_t>(m_nodes.size()); }
+
+private:
+    struct Instance {
+        const MeshBvh* mesh;
+        Float4x4 world;
+        Float4x4 inverse;
+        Float3 boundsMin;
+        Float3 boundsMax;
+        // Node << 2 | slot holding the instance, NoHit before Build.
+        uint32_t location;
+        bool dirty;
+    };
+
+    void UpdateInstance(Instance& instance) noexcept;
+    bool Traverse(const Ray& ray, RayHit* hit, SimdLevel level) const noexcept;
+
+    std::vector<Instance> m_instances;
+    std::vector<BvhNode> m_nodes;
+    // Node << 2 | slot of each node in its parent; NoHit for the root.
+    std::vector<uint32_t> m_parents;
+    std::vector<uint32_t> m_dirty;
+};
+
+} // namespace gfx
@@ -0,0 +1,87 @@
+#include "Camera.h"
+
+#include <cmath>
+
+namespace gfx {
+
+namespace {
+
+bool Same(const Float3& a, const Float3& b) noexcept { return a.x == b.x && a.y == b.y && a.z == b.z; }
+
+} // namespace
+
+void CachedCamera::SetOrbit(const Float3& target, float phi, float theta, float distance) noexcept {
+    if (m_useOrbit && Same(target, m_orbit.target) && phi == m_orbit.phi && theta == m_orbit.theta && distance == m_orbit.distance) return;
+    m_orbit = { target, phi, theta, distance };
+    m_useOrbit = true;
+    m_viewDirty = m_viewProjDirty = true;
+    ++m_version;
+}
+
+void CachedCamera::SetLookAt(const Float3& eye, const Float3& target, const Float3& up) noexcept {
+    if (!m_useOrbit && Same(eye, m_eye) && Same(target, m_target) && Same(up, m_up)) return;
+    m_eye = eye;
+    m_target = target;
+    m_up = up;
+    m_useOrbit = false;
+    m_viewDirty = m_viewProjDirty = true;
+    ++m_version;
+}
+
+void CachedCamera::SetPerspective(float fovY, float aspect, float nearZ, float farZ) noexcept {
+    if (!m_projectionDirty && fovY == m_fovY && aspect == m_aspect && nearZ == m_nearZ && farZ == m_farZ) return;
+    m_fovY = fovY;
+    m_aspect = aspect;
+    m_nearZ = nearZ;
+    m_farZ = farZ;
+    m_projectionDirty = m_viewProjDirty = true;
+    ++m_version;
+}
+
+Float3 CachedCamera::Eye() noexcept {
+    View();
+    return m_eye;
+}
+
+Float3 CachedCamera::RayDirection(float ndcX, float ndcY) noexcept {
+    const Float4x4& v = View();
+    const Float4x4& p = Projection();
+    const float x = ndcX / p.m[0][0], y = ndcY / p.m[1][1];
+    // The view matrix columns are the camera axes in world space.
+    return Normalize({ v.m[0][0] * x + v.m[0][1] * y + v.m[0][2],
+                       v.m[1][0] * x + v.m[1][1] * y + v.m[1][2],
+                       v.m[2][0] * x + v.m[2][1] * y + v.m[2][2] });
+}
+
+const Float4x4& CachedCamera::View() noexcept {
+    if (m_viewDirty) {
+        if (m_useOrbit) {
+            const Orbit& o = m_orbit;
+            float s = std::sin(o.theta);
+            m_eye = o.target + Float3{ s * std::sin(o.phi), std::cos(o.theta), s * std::cos(o.phi) } * o.distance;
+            m_target = o.target;
+            m_up = { 0.0f, 1.0f, 0.0f };
+        }
+        m_view = MatrixLookAtLH(m_eye, m_target, m_up);
+        m_viewDirty = false;
+    }
+    return m_view;
+}
+
+const Float4x4& CachedCamera::Projection() noexcept {
+    if (m_projectionDirty) {
+        m_projection = MatrixPerspectiveFovLH(m_fovY, m_aspect, m_nearZ, m_farZ);
+        m_projectionDirty = false;
+    }
+    return m_projection;
+}
+
+const Float4x4& CachedCamera::ViewProj() noexcept {
+    if (m_viewProjDirty) {
+        m_viewProj = Multiply(View(), Projection());
+        m_viewProjDirty = false;
+    }
+    return m_viewProj;
+}
+
+} // namespace gfx
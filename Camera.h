@@ -0,0 +1,51 @@
+#pragma once
+
+#include "MathTypes.h"
+
+#include <cstdint>
+
+namespace gfx {
+
+// View and projection inputs with the matrices derived from them. Setters only
+// mark a matrix stale when a value actually differs, and the matrices are rebuilt
+// on first use, so a camera that did not move costs nothing per frame.
+class CachedCamera {
+public:
+    // Orbit around target: theta from +Y, phi around Y starting at +Z, Y up.
+    void SetOrbit(const Float3& target, float phi, float theta, float distance) noexcept;
+    void SetLookAt(const Float3& eye, const Float3& target, const Float3& up) noexcept;
+    void SetPerspective(float fovY, float aspect, float nearZ, float farZ) noexcept;
+
+    const Float4x4& View() noexcept;
+    const Float4x4& Projection() noexcept;
+    // View * Projection, as uploaded to the shaders.
+    const Float4x4& ViewProj() noexcept;
+    Float3 Eye() noexcept;
+    // Unit world-space direction from the eye through an NDC point (x right, y up).
+    Float3 RayDirection(float ndcX, float ndcY) noexcept;
+
+    // Bumped whenever an input changes; consumers compare it to skip their own work.
+    uint64_t Version() const noexcept { return m_version; }
+
+private:
+    struct Orbit {
+        Float3 target;
+        float phi, theta, distance;
+    };
+
+    Orbit m_orbit = {};
+    Float3 m_eye = { 0.0f, 0.0f, -1.0f };
+    Float3 m_target = {};
+    Float3 m_up = { 0.0f, 1.0f, 0.0f };
+    float m_fovY = 0.785398f, m_aspect = 1.0f, m_nearZ = 0.1f, m_farZ = 100.0f;
+    Float4x4 m_view = MatrixIdentity();
+    Float4x4 m_projection = MatrixIdentity();
+    Float4x4 m_viewProj = MatrixIdentity();
+    uint64_t m_version = 0;
+    bool m_useOrbit = false;
+    bool m_viewDirty = true;
+    bool m_projectionDirty = true;
+    bool m_viewProjDirty = true;
+};
+
+} // namespace gfx
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+// Vertex layout shared by Lab3.cpp and the CPU-side modules:
+// POSITION R32G32B32_FLOAT at offset 0, COLOR R8G8B8A8_UNORM at offset 12.
+struct ColoredVertex {
+    float position[3];
+    uint32_t rgba;
+};
+
+static_assert(sizeof(ColoredVertex) == 16, "ColoredVertex must match the 16-byte input layout");
+
+namespace gfx {
+
+// R8G8B8A8_UNORM keeps red in the lowest byte.
+inline uint32_t PackRGBA8(uint8_t r, uint8_t g, uint8_t b, uint8_t a) noexcept {
+    return uint32_t(r) | (uint32_t(g) << 8) | (uint32_t(b) << 16) | (uint32_t(a) << 24);
+}
+
+inline uint32_t PackRGBA8(float r, float g, float b, float a) noexcept {
+    auto toByte = [](float v) noexcept {
+        v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+        return static_cast<uint8_t>(v * 255.0f + 0.5f);
+    };
+    return PackRGBA8(toByte(r), toByte(g), toByte(b), toByte(a));
+}
+
+inline void UnpackRGBA8(uint32_t rgba, float out[4]) noexcept {
+    constexpr float scale = 1.0f / 255.0f;
+    out[0] = static_cast<float>(rgba & 0xFF) * scale;
+    out[1] = static_cast<float>((rgba >> 8) & 0xFF) * scale;
+    out[2] = static_cast<float>((rgba >> 16) & 0xFF) * scale;
+    out[3] = static_cast<float>(rgba >> 24) * scale;
+}
+
+} // namespace gfx
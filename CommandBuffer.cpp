@@ -0,0 +1,142 @@
+#include "CommandBuffer.h"
+
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+inline bool SamePass(const PassState& a, const PassState& b) noexcept {
+    return std::memcmp(&a, &b, sizeof(PassState)) == 0;
+}
+
+} // namespace
+
+uint64_t MakeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth) noexcept {
+    // NaN fails both comparisons of a plain clamp; it sorts as far instead of reaching
+    // the conversion, where it would be undefined.
+    if (!(depth >= 0.0f)) depth = depth < 0.0f ? 0.0f : 1.0f;
+    else if (depth > 1.0f) depth = 1.0f;
+    uint64_t depthBits = static_cast<uint64_t>(depth * 16777215.0f);
+    return (uint64_t(pass & 0xFF) << 56) | (uint64_t(pipeline & 0xFFFF) << 40) | (uint64_t(material & 0xFFFF) << 24) | depthBits;
+}
+
+void CommandBuffer::Reset() noexcept {
+    m_draws.clear();
+    m_sorted.clear();
+    m_passSet.assign(m_passSet.size(), false);
+}
+
+void CommandBuffer::SetPass(uint32_t pass, const PassState& state) {
+    if (m_passes.size() <= pass) {
+        m_passes.resize(pass + 1, PassState{});
+        m_passSet.resize(pass + 1, false);
+    }
+    m_passes[pass] = state;
+    m_passSet[pass] = true;
+}
+
+void CommandBuffer::Draw(uint64_t sortKey, const DrawCommand& command) {
+    uint32_t pass = SortKeyPass(sortKey);
+    if (m_passes.size() <= pass) {
+        m_passes.resize(pass + 1, PassState{});
+        m_passSet.resize(pass + 1, false);
+    }
+    m_sorted.push_back({ sortKey, static_cast<uint32_t>(m_draws.size()) });
+    m_draws.push_back(command);
+}
+
+void CommandBuffer::Append(const CommandBuffer& other) {
+    uint32_t base = static_cast<uint32_t>(m_draws.size());
+    m_draws.insert(m_draws.end(), other.m_draws.begin(), other.m_draws.end());
+    for (const KeyIndex& item : other.m_sorted) m_sorted.push_back({ item.key, base + item.index });
+    if (m_passes.size() < other.m_passes.size()) {
+        m_passes.resize(other.m_passes.size(), PassState{});
+        m_passSet.resize(other.m_passes.size(), false);
+    }
+    for (size_t pass = 0; pass < other.m_passes.size(); ++pass) {
+        if (other.m_passSet[pass]) {
+            m_passes[pass] = other.m_passes[pass];
+            m_passSet[pass] = true;
+        }
+    }
+}
+
+void CommandBuffer::Sort() {
+    const size_t count = m_sorted.size();
+    if (count < 2) return;
+
+    uint32_t histograms[8][256] = {};
+    for (const KeyIndex& item : m_sorted) {
+        for (int digit = 0; digit < 8; ++digit) ++histograms[digit][(item.key >> (digit * 8)) & 0xFF];
+    }
+
+    m_scratch.resize(count);
+    for (int digit = 0; digit < 8; ++digit) {
+        uint32_t* histogram = histograms[digit];
+        if (histogram[(m_sorted[0].key >> (digit * 8)) & 0xFF] == count) continue;
+
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            uint32_t n = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += n;
+        }
+        for (const KeyIndex& item : m_sorted) {
+            m_scratch[histogram[(item.key >> (digit * 8)) & 0xFF]++] = item;
+        }
+        m_sorted.swap(m_scratch);
+    }
+}
+
+void CommandReplayer::Replay(const CommandBuffer& commands, CommandDevice& device) {
+    uint32_t currentPass = ~0u;
+    for (size_t i = 0; i < commands.DrawCount(); ++i) {
+        uint32_t pass = SortKeyPass(commands.KeyAt(i));
+        if (pass != currentPass) {
+            const PassState& state = commands.Pass(pass);
+            if (!m_valid || !SamePass(state, m_pass)) {
+                device.SetPass(state);
+                m_pass = state;
+            }
+            currentPass = pass;
+        }
+
+        const DrawCommand& draw = commands.DrawAt(i);
+        if (!m_valid || draw.pipeline != m_bound.pipeline) {
+            device.SetPipeline(draw.pipeline);
+        }
+        if (!m_valid || draw.vertexBuffer != m_bound.vertexBuffer || draw.vertexStride != m_bound.vertexStride) {
+            device.SetVertexBuffer(draw.vertexBuffer, draw.vertexStride);
+        }
+        if (!m_valid || draw.indexBuffer != m_bound.indexBuffer || draw.indexFormat != m_bound.indexFormat) {
+            device.SetIndexBuffer(draw.indexBuffer, draw.indexFormat);
+        }
+        for (uint32_t slot = 0; slot < MaxConstantBuffers; ++slot) {
+            if (!m_valid || draw.constantBuffers[slot] != m_bound.constantBuffers[slot] ||
+                draw.constantOffsets[slot] != m_bound.constantOffsets[slot] || draw.constantSizes[slot] != m_bound.constantSizes[slot]) {
+                device.SetConstantBuffer(slot, draw.constantBuffers[slot], draw.constantOffsets[slot], draw.constantSizes[slot]);
+            }
+        }
+        device.DrawIndexed(draw.indexCount, draw.startIndex, draw.baseVertex);
+        m_bound = draw;
+        m_valid = true;
+    }
+}
+
+void CommandReplayer::ReplayNaive(const CommandBuffer& commands, CommandDevice& device) {
+    for (size_t i = 0; i < commands.DrawCount(); ++i) {
+        const DrawCommand& draw = commands.DrawAt(i);
+        device.SetPass(commands.Pass(SortKeyPass(commands.KeyAt(i))));
+        device.SetPipeline(draw.pipeline);
+        device.SetVertexBuffer(draw.vertexBuffer, draw.vertexStride);
+        device.SetIndexBuffer(draw.indexBuffer, draw.indexFormat);
+        for (uint32_t slot = 0; slot < MaxConstantBuffers; ++slot) {
+            device.SetConstantBuffer(slot, draw.constantBuffers[slot], draw.constantOffsets[slot], draw.constantSizes[slot]);
+        }
+        device.DrawIndexed(draw.indexCount, draw.startIndex, draw.baseVertex);
+    }
+    m_valid = false;
+}
+
+} // namespace gfx
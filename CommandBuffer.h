@@ -0,0 +1,146 @@
+#pragma once
+
+#include "RenderTypes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+// Backend-defined handle of a GPU object; 0 means "nothing bound".
+using ResourceId = uint32_t;
+constexpr ResourceId NullResource = 0;
+constexpr uint32_t MaxConstantBuffers = 4;
+
+// Render target and rasterizer state shared by every draw of a pass.
+struct PassState {
+    ResourceId renderTarget;
+    ResourceId depthTarget;
+    Viewport viewport;
+    ScissorRect scissor;
+};
+
+// Everything RenderFrame binds for one DrawIndexed. A pipeline id stands for
+// the VS/PS/input layout/topology combination the backend registered.
+struct DrawCommand {
+    ResourceId pipeline;
+    ResourceId vertexBuffer;
+    uint32_t vertexStride;
+    ResourceId indexBuffer;
+    IndexFormat indexFormat;
+    ResourceId constantBuffers[MaxConstantBuffers];
+    // Bound byte range of each constant buffer; a zero size binds the whole buffer.
+    uint32_t constantOffsets[MaxConstantBuffers];
+    uint32_t constantSizes[MaxConstantBuffers];
+    uint32_t indexCount;
+    uint32_t startIndex;
+    int32_t baseVertex;
+};
+
+// Sort key layout, most significant first: pass:8 | pipeline:16 | material:16 | depth:24.
+// Depth is clamped to [0, 1] and quantized so that ascending keys draw front to back;
+// NaN sorts as the far plane.
+uint64_t MakeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth) noexcept;
+
+inline uint32_t SortKeyPass(uint64_t key) noexcept { return static_cast<uint32_t>(key >> 56); }
+
+// Receives the state changes and draws that survive elision.
+class CommandDevice {
+public:
+    virtual ~CommandDevice() = default;
+
+    virtual void SetPass(const PassState& pass) = 0;
+    virtual void SetPipeline(ResourceId pipeline) = 0;
+    virtual void SetVertexBuffer(ResourceId buffer, uint32_t stride) = 0;
+    virtual void SetIndexBuffer(ResourceId buffer, IndexFormat format) = 0;
+    virtual void SetConstantBuffer(uint32_t slot, ResourceId buffer, uint32_t offset, uint32_t size) = 0;
+    virtual void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) = 0;
+};
+
+struct DeviceCounters {
+    uint64_t passChanges = 0;
+    uint64_t pipelineChanges = 0;
+    uint64_t vertexBufferChanges = 0;
+    uint64_t indexBufferChanges = 0;
+    uint64_t constantBufferChanges = 0;
+    uint64_t draws = 0;
+
+    uint64_t StateChanges() const noexcept {
+        return passChanges + pipelineChanges + vertexBufferChanges + indexBufferChanges + constantBufferChanges;
+    }
+};
+
+// Backend that only counts what it is asked to do.
+class NullCommandDevice final : public CommandDevice {
+public:
+    void SetPass(const PassState&) override { ++m_counters.passChanges; }
+    void SetPipeline(ResourceId) override { ++m_counters.pipelineChanges; }
+    void SetVertexBuffer(ResourceId, uint32_t) override { ++m_counters.vertexBufferChanges; }
+    void SetIndexBuffer(ResourceId, IndexFormat) override { ++m_counters.indexBufferChanges; }
+    void SetConstantBuffer(uint32_t, ResourceId, uint32_t, uint32_t) override { ++m_counters.constantBufferChanges; }
+    void DrawIndexed(uint32_t, uint32_t, int32_t) override { ++m_counters.draws; }
+
+    const DeviceCounters& Counters() const noexcept { return m_counters; }
+    void ResetCounters() noexcept { m_counters = {}; }
+
+private:
+    DeviceCounters m_counters;
+};
+
+// Per-frame list of keyed draws.
+class CommandBuffer {
+public:
+    void Reset() noexcept;
+
+    // Pass state applies to every draw whose key carries this pass number.
+    // States persist across Reset(); only the draws are cleared.
+    void SetPass(uint32_t pass, const PassState& state);
+    void Draw(uint64_t sortKey, const DrawCommand& command);
+
+    // Adds another list's draws after this one's, in their recorded order.
+    // Pass states set by the appended list replace this list's.
+    void Append(const CommandBuffer& other);
+
+    // Stable LSD radix sort on the keys, skipping bytes that are equal in every key.
+    void Sort();
+
+    size_t DrawCount() const noexcept { return m_draws.size(); }
+    const DrawCommand& DrawAt(size_t order) const noexcept { return m_draws[m_sorted[order].index]; }
+    uint64_t KeyAt(size_t order) const noexcept { return m_sorted[order].key; }
+    const PassState& Pass(uint32_t pass) const noexcept { return m_passes[pass]; }
+
+private:
+    friend class ParallelCommandRecorder;
+
+    struct KeyIndex {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::vector<DrawCommand> m_draws;
+    std::vector<KeyIndex> m_sorted;
+    std::vector<KeyIndex> m_scratch;
+    std::vector<PassState> m_passes;
+    std::vector<bool> m_passSet;
+};
+
+// Replays a sorted buffer, forwarding only state that differs from what the
+// device already has bound. The bound state persists across frames until
+// Invalidate() is called (device reset, resize, foreign state changes).
+class CommandReplayer {
+public:
+    void Replay(const CommandBuffer& commands, CommandDevice& device);
+
+    // Rebinds everything for every draw, the way RenderFrame does; for comparison.
+    void ReplayNaive(const CommandBuffer& commands, CommandDevice& device);
+
+    void Invalidate() noexcept { m_valid = false; }
+
+private:
+    bool m_valid = false;
+    PassState m_pass = {};
+    DrawCommand m_bound = {};
+};
+
+} // namespace gfx
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "ColoredVertex.h"
+
+static const ColoredVertex g_CubeVertices[] = {
+    { { -0.5f, -0.5f, -0.5f }, 0x00FF0000 }, 
+    { {  0.5f, -0.5f, -0.5f }, 0x0000FF00 }, 
+    { {  0.5f,  0.5f, -0.5f }, 0x000000FF }, 
+    { { -0.5f,  0.5f, -0.5f }, 0x00FFFF00 }, 
+    { { -0.5f, -0.5f,  0.5f }, 0x00FF00FF }, 
+    { {  0.5f, -0.5f,  0.5f }, 0x0000FFFF }, 
+    { {  0.5f,  0.5f,  0.5f }, 0x00FFFFFF }, 
+    { { -0.5f,  0.5f,  0.5f }, 0x00000000 }  
+};
+
+static const uint16_t g_CubeIndices[] = {
+    0, 1, 2,  0, 2, 3,
+    4, 6, 5,  4, 7, 6,
+    0, 3, 7,  0, 7, 4,
+    1, 5, 6,  1, 6, 2,
+    3, 2, 6,  3, 6, 7,
+    0, 4, 5,  0, 5, 1 
+};
@@ -0,0 +1,104 @@
+#include "D3D11CommandDevice.h"
+
+void D3D11CommandDevice::Initialize(ID3D11DeviceContext* context) noexcept {
+    m_context = context;
+    if (m_context1) m_context1->Release();
+    m_context1 = nullptr;
+    context->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&m_context1));
+}
+
+void D3D11CommandDevice::Clear() noexcept {
+    m_context = nullptr;
+    if (m_context1) m_context1->Release();
+    m_context1 = nullptr;
+    m_upload = nullptr;
+    m_uploadId = gfx::NullResource;
+    m_pipelines.clear();
+    m_buffers.clear();
+    m_renderTargets.clear();
+    m_depthTargets.clear();
+}
+
+gfx::ResourceId D3D11CommandDevice::AddPipeline(ID3D11VertexShader* vs, ID3D11PixelShader* ps, ID3D11InputLayout* layout, D3D11_PRIMITIVE_TOPOLOGY topology) {
+    m_pipelines.push_back({ vs, ps, layout, topology });
+    return static_cast<gfx::ResourceId>(m_pipelines.size());
+}
+
+gfx::ResourceId D3D11CommandDevice::AddBuffer(ID3D11Buffer* buffer) {
+    m_buffers.push_back(buffer);
+    return static_cast<gfx::ResourceId>(m_buffers.size());
+}
+
+gfx::ResourceId D3D11CommandDevice::AddUploadBuffer(D3D11UploadBuffer* upload) {
+    m_upload = upload;
+    m_uploadId = AddBuffer(upload->Buffer());
+    return m_uploadId;
+}
+
+gfx::ResourceId D3D11CommandDevice::AddRenderTarget(ID3D11RenderTargetView* view) {
+    m_renderTargets.push_back(view);
+    return static_cast<gfx::ResourceId>(m_renderTargets.size());
+}
+
+gfx::ResourceId D3D11CommandDevice::AddDepthTarget(ID3D11DepthStencilView* view) {
+    m_depthTargets.push_back(view);
+    return static_cast<gfx::ResourceId>(m_depthTargets.size());
+}
+
+void D3D11CommandDevice::ReplaceRenderTarget(gfx::ResourceId id, ID3D11RenderTargetView* view) noexcept {
+    if (id != gfx::NullResource && id <= m_renderTargets.size()) m_renderTargets[id - 1] = view;
+}
+
+void D3D11CommandDevice::ReplaceDepthTarget(gfx::ResourceId id, ID3D11DepthStencilView* view) noexcept {
+    if (id != gfx::NullResource && id <= m_depthTargets.size()) m_depthTargets[id - 1] = view;
+}
+
+void D3D11CommandDevice::SetPass(const gfx::PassState& pass) {
+    ID3D11RenderTargetView* rtv = Lookup(m_renderTargets, pass.renderTarget);
+    m_context->OMSetRenderTargets(rtv ? 1 : 0, rtv ? &rtv : nullptr, Lookup(m_depthTargets, pass.depthTarget));
+
+    static_assert(sizeof(gfx::Viewport) == sizeof(D3D11_VIEWPORT), "Viewport must mirror D3D11_VIEWPORT");
+    m_context->RSSetViewports(1, reinterpret_cast<const D3D11_VIEWPORT*>(&pass.viewport));
+
+    D3D11_RECT rect = { pass.scissor.left, pass.scissor.top, pass.scissor.right, pass.scissor.bottom };
+    m_context->RSSetScissorRects(1, &rect);
+}
+
+void D3D11CommandDevice::SetPipeline(gfx::ResourceId pipeline) {
+    Pipeline p = Lookup(m_pipelines, pipeline);
+    m_context->IASetInputLayout(p.layout);
+    m_context->IASetPrimitiveTopology(p.topology);
+    m_context->VSSetShader(p.vs, nullptr, 0);
+    m_context->PSSetShader(p.ps, nullptr, 0);
+}
+
+void D3D11CommandDevice::SetVertexBuffer(gfx::ResourceId buffer, uint32_t stride) {
+    ID3D11Buffer* vb = Lookup(m_buffers, buffer);
+    UINT offset = 0;
+    m_context->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
+}
+
+void D3D11CommandDevice::SetIndexBuffer(gfx::ResourceId buffer, gfx::IndexFormat format) {
+    DXGI_FORMAT dxgiFormat = format == gfx::IndexFormat::UInt16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    m_context->IASetIndexBuffer(Lookup(m_buffers, buffer), dxgiFormat, 0);
+}
+
+void D3D11CommandDevice::SetConstantBuffer(uint32_t slot, gfx::ResourceId buffer, uint32_t offset, uint32_t size) {
+    if (size != 0 && buffer == m_uploadId && m_upload && !m_upload->UsesOffsets()) {
+        m_upload->Bind(slot, offset);
+        return;
+    }
+    ID3D11Buffer* cb = Lookup(m_buffers, buffer);
+    if (size == 0 || !m_context1) {
+        m_context->VSSetConstantBuffers(slot, 1, &cb);
+        return;
+    }
+    // Ranges are given in 16-byte constants and must cover multiples of 16 of them.
+    UINT firstConstant = offset / 16;
+    UINT numConstants = ((size + 255) & ~255u) / 16;
+    m_context1->VSSetConstantBuffers1(slot, 1, &cb, &firstConstant, &numConstants);
+}
+
+void D3D11CommandDevice::DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) {
+    m_context->DrawIndexed(indexCount, startIndex, baseVertex);
+}
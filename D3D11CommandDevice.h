@@ -0,0 +1,57 @@
+#pragma once
+
+#include "CommandBuffer.h"
+#include "D3D11UploadBuffer.h"
+
+#include <d3d11_1.h>
+#include <vector>
+
+// CommandDevice that forwards to an ID3D11DeviceContext. Ids index into tables
+// of non-owning pointers; the caller keeps the objects alive while registered.
+class D3D11CommandDevice final : public gfx::CommandDevice {
+public:
+    // Constant buffer ranges need an ID3D11DeviceContext1; without one only whole
+    // buffers can be bound.
+    void Initialize(ID3D11DeviceContext* context) noexcept;
+    void Clear() noexcept;
+
+    gfx::ResourceId AddPipeline(ID3D11VertexShader* vs, ID3D11PixelShader* ps, ID3D11InputLayout* layout, D3D11_PRIMITIVE_TOPOLOGY topology);
+    gfx::ResourceId AddBuffer(ID3D11Buffer* buffer);
+    // Constant ranges of this id go through upload->Bind when the driver has no
+    // constant buffer offsetting.
+    gfx::ResourceId AddUploadBuffer(D3D11UploadBuffer* upload);
+    gfx::ResourceId AddRenderTarget(ID3D11RenderTargetView* view);
+    gfx::ResourceId AddDepthTarget(ID3D11DepthStencilView* view);
+    // Points an id at a recreated view, e.g. after a swap chain resize.
+    void ReplaceRenderTarget(gfx::ResourceId id, ID3D11RenderTargetView* view) noexcept;
+    void ReplaceDepthTarget(gfx::ResourceId id, ID3D11DepthStencilView* view) noexcept;
+
+    void SetPass(const gfx::PassState& pass) override;
+    void SetPipeline(gfx::ResourceId pipeline) override;
+    void SetVertexBuffer(gfx::ResourceId buffer, uint32_t stride) override;
+    void SetIndexBuffer(gfx::ResourceId buffer, gfx::IndexFormat format) override;
+    void SetConstantBuffer(uint32_t slot, gfx::ResourceId buffer, uint32_t offset, uint32_t size) override;
+    void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) override;
+
+private:
+    struct Pipeline {
+        ID3D11VertexShader* vs;
+        ID3D11PixelShader* ps;
+        ID3D11InputLayout* layout;
+        D3D11_PRIMITIVE_TOPOLOGY topology;
+    };
+
+    template<typename T>
+    static T Lookup(const std::vector<T>& table, gfx::ResourceId id) noexcept {
+        return id == gfx::NullResource || id > table.size() ? T{} : table[id - 1];
+    }
+
+    ID3D11DeviceContext* m_context = nullptr;
+    ID3D11DeviceContext1* m_context1 = nullptr;
+    D3D11UploadBuffer* m_upload = nullptr;
+    gfx::ResourceId m_uploadId = gfx::NullResource;
+    std::vector<Pipeline> m_pipelines;
+    std::vector<ID3D11Buffer*> m_buffers;
+    std::vector<ID3D11RenderTargetView*> m_renderTargets;
+    std::vector<ID3D11DepthStencilView*> m_depthTargets;
+};
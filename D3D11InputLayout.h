@@ -0,0 +1,37 @@
+#pragma once
+
+#include "MeshFile.h"
+#include "VertexLayout.h"
+
+#include <d3d11.h>
+
+#include <array>
+#include <utility>
+
+// Input elements for a mesh vertex layout; ElementFormat values are DXGI_FORMAT values.
+// The semantic names point into layout, which must outlive CreateInputLayout.
+inline UINT MakeInputElements(const gfx::MeshVertexLayout& layout, D3D11_INPUT_ELEMENT_DESC (&elements)[gfx::MaxMeshAttributes],
+                              UINT inputSlot = 0) noexcept {
+    for (UINT i = 0; i < layout.attributeCount; ++i) {
+        const gfx::MeshAttribute& attribute = layout.attributes[i];
+        elements[i] = { attribute.semantic, attribute.semanticIndex, static_cast<DXGI_FORMAT>(attribute.format),
+                        inputSlot, attribute.offset, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+    }
+    return layout.attributeCount;
+}
+
+template<typename Layout, size_t... Index>
+constexpr std::array<D3D11_INPUT_ELEMENT_DESC, Layout::AttributeCount> MakeInputElements(UINT inputSlot, D3D11_INPUT_CLASSIFICATION classification,
+                                                                                          UINT instanceStepRate, std::index_sequence<Index...>) noexcept {
+    return { { { gfx::SemanticName(Layout::template Attribute<Index>::semantic), Layout::template Attribute<Index>::semanticIndex,
+                 static_cast<DXGI_FORMAT>(Layout::template Attribute<Index>::format), inputSlot, Layout::Offset(Index), classification,
+                 instanceStepRate }... } };
+}
+
+// Input elements of a compile-time gfx::VertexLayout, e.g.
+// constexpr auto elements = MakeInputElements<gfx::ColoredVertexFormat>();
+template<typename Layout>
+constexpr std::array<D3D11_INPUT_ELEMENT_DESC, Layout::AttributeCount> MakeInputElements(
+    UINT inputSlot = 0, D3D11_INPUT_CLASSIFICATION classification = D3D11_INPUT_PER_VERTEX_DATA, UINT instanceStepRate = 0) noexcept {
+    return MakeInputElements<Layout>(inputSlot, classification, instanceStepRate, std::make_index_sequence<Layout::AttributeCount>{});
+}
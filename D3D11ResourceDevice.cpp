@@ -0,0 +1,66 @@
+#include "D3D11ResourceDevice.h"
+#include "D3D11InputLayout.h"
+
+namespace {
+
+D3D11_USAGE ToD3D11(gfx::BufferUsage usage) noexcept {
+    switch (usage) {
+    case gfx::BufferUsage::Immutable: return D3D11_USAGE_IMMUTABLE;
+    case gfx::BufferUsage::Dynamic: return D3D11_USAGE_DYNAMIC;
+    default: return D3D11_USAGE_DEFAULT;
+    }
+}
+
+UINT ToD3D11BindFlags(uint32_t flags) noexcept {
+    UINT result = 0;
+    if (flags & gfx::BindVertexBuffer) result |= D3D11_BIND_VERTEX_BUFFER;
+    if (flags & gfx::BindIndexBuffer) result |= D3D11_BIND_INDEX_BUFFER;
+    if (flags & gfx::BindConstantBuffer) result |= D3D11_BIND_CONSTANT_BUFFER;
+    return result;
+}
+
+} // namespace
+
+gfx::NativeResource D3D11ResourceDevice::CreateBuffer(const gfx::BufferDesc& desc, const void* initialData) {
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.ByteWidth = desc.size;
+    bufferDesc.Usage = ToD3D11(desc.usage);
+    bufferDesc.BindFlags = ToD3D11BindFlags(desc.bindFlags);
+    bufferDesc.CPUAccessFlags = desc.usage == gfx::BufferUsage::Dynamic ? D3D11_CPU_ACCESS_WRITE : 0;
+    D3D11_SUBRESOURCE_DATA data = {};
+    data.pSysMem = initialData;
+
+    ID3D11Buffer* buffer = nullptr;
+    HRESULT hr = m_device->CreateBuffer(&bufferDesc, initialData ? &data : nullptr, &buffer);
+    if (FAILED(hr)) m_lastError = hr;
+    return buffer;
+}
+
+gfx::NativeResource D3D11ResourceDevice::CreateShader(gfx::ShaderStage stage, const void* bytecode, size_t size) {
+    HRESULT hr;
+    gfx::NativeResource shader = nullptr;
+    if (stage == gfx::ShaderStage::Vertex) {
+        ID3D11VertexShader* vs = nullptr;
+        hr = m_device->CreateVertexShader(bytecode, size, nullptr, &vs);
+        shader = vs;
+    } else {
+        ID3D11PixelShader* ps = nullptr;
+        hr = m_device->CreatePixelShader(bytecode, size, nullptr, &ps);
+        shader = ps;
+    }
+    if (FAILED(hr)) m_lastError = hr;
+    return shader;
+}
+
+gfx::NativeResource D3D11ResourceDevice::CreateInputLayout(const gfx::MeshVertexLayout& layout, const void* vsBytecode, size_t size) {
+    D3D11_INPUT_ELEMENT_DESC elements[gfx::MaxMeshAttributes];
+    UINT elementCount = MakeInputElements(layout, elements);
+    ID3D11InputLayout* inputLayout = nullptr;
+    HRESULT hr = m_device->CreateInputLayout(elements, elementCount, vsBytecode, size, &inputLayout);
+    if (FAILED(hr)) m_lastError = hr;
+    return inputLayout;
+}
+
+void D3D11ResourceDevice::Release(gfx::NativeResource object) {
+    if (object) static_cast<ID3D11DeviceChild*>(object)->Release();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ResourceRegistry.h"
+
+#include <d3d11.h>
+
+// ResourceDevice that creates D3D11 objects. Every native object is an
+// ID3D11DeviceChild, so one Release covers all resource types.
+class D3D11ResourceDevice final : public gfx::ResourceDevice {
+public:
+    void Initialize(ID3D11Device* device) noexcept { m_device = device; }
+
+    gfx::NativeResource CreateBuffer(const gfx::BufferDesc& desc, const void* initialData) override;
+    gfx::NativeResource CreateShader(gfx::ShaderStage stage, const void* bytecode, size_t size) override;
+    gfx::NativeResource CreateInputLayout(const gfx::MeshVertexLayout& layout, const void* vsBytecode, size_t size) override;
+    void Release(gfx::NativeResource object) override;
+
+    // Result of the last failed create, for callers that report HRESULTs.
+    HRESULT LastError() const noexcept { return m_lastError; }
+
+private:
+    ID3D11Device* m_device = nullptr;
+    HRESULT m_lastError = S_OK;
+};
+
+inline ID3D11Buffer* GetD3D11Buffer(const gfx::ResourceRegistry& registry, gfx::BufferHandle handle) noexcept {
+    return static_cast<ID3D11Buffer*>(registry.Native(handle));
+}
+
+inline ID3D11VertexShader* GetD3D11VertexShader(const gfx::ResourceRegistry& registry, gfx::ShaderHandle handle) noexcept {
+    const gfx::ShaderRecord* record = registry.Get(handle);
+    return record && record->stage == gfx::ShaderStage::Vertex ? static_cast<ID3D11VertexShader*>(record->native) : nullptr;
+}
+
+inline ID3D11PixelShader* GetD3D11PixelShader(const gfx::ResourceRegistry& registry, gfx::ShaderHandle handle) noexcept {
+    const gfx::ShaderRecord* record = registry.Get(handle);
+    return record && record->stage == gfx::ShaderStage::Pixel ? static_cast<ID3D11PixelShader*>(record->native) : nullptr;
+}
+
+inline ID3D11InputLayout* GetD3D11InputLayout(const gfx::ResourceRegistry& registry, gfx::InputLayoutHandle handle) noexcept {
+    return static_cast<ID3D11InputLayout*>(registry.Native(handle));
+}
@@ -0,0 +1,33 @@
+#include "D3D11Texture.h"
+
+HRESULT CreateD3D11Texture(ID3D11Device* device, const gfx::TextureFile& file, ID3D11Texture2D** texture,
+                           ID3D11ShaderResourceView** view) {
+    if (texture) *texture = nullptr;
+    if (view) *view = nullptr;
+    if (!device || !file.IsOpen()) return E_INVALIDARG;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = file.Width();
+    desc.Height = file.Height();
+    desc.MipLevels = file.MipCount();
+    desc.ArraySize = 1;
+    desc.Format = static_cast<DXGI_FORMAT>(file.Format());
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    D3D11_SUBRESOURCE_DATA data[gfx::MaxTextureMips] = {};
+    for (uint32_t level = 0; level < file.MipCount(); ++level) {
+        data[level].pSysMem = file.MipData(level);
+        data[level].SysMemPitch = file.Mip(level).rowPitch;
+        data[level].SysMemSlicePitch = static_cast<UINT>(file.Mip(level).size);
+    }
+
+    ID3D11Texture2D* created = nullptr;
+    HRESULT hr = device->CreateTexture2D(&desc, data, &created);
+    if (FAILED(hr)) return hr;
+    if (view) hr = device->CreateShaderResourceView(created, nullptr, view);
+    if (SUCCEEDED(hr) && texture) *texture = created;
+    else created->Release();
+    return hr;
+}
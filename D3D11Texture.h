@@ -0,0 +1,11 @@
+#pragma once
+
+#include "TextureFile.h"
+
+#include <d3d11.h>
+
+// Creates an immutable shader-resource texture with every mip of the file as
+// initial data, read straight from the mapping. The format enum values are the
+// DXGI_FORMAT values. Either output may be null.
+HRESULT CreateD3D11Texture(ID3D11Device* device, const gfx::TextureFile& file, ID3D11Texture2D** texture,
+                           ID3D11ShaderResourceView** view);
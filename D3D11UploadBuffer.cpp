@@ -0,0 +1,86 @@
+#include "D3D11UploadBuffer.h"
+
+HRESULT D3D11UploadBuffer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, uint32_t capacity, uint32_t framesInFlight) {
+    Release();
+
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+    HRESULT hr = device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+    if (FAILED(hr)) return hr;
+    if (!options.ConstantBufferOffsetting) {
+        // One frame in flight is enough: every draw gets its own copy of its block.
+        m_ring.Reset(capacity, 1);
+        m_shadow.assign(size_t(m_ring.Capacity()) + FallbackBlockSize, 0);
+        D3D11_BUFFER_DESC desc = {};
+        desc.ByteWidth = FallbackBlockSize;
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        for (ID3D11Buffer*& buffer : m_slotBuffers) {
+            hr = device->CreateBuffer(&desc, nullptr, &buffer);
+            if (FAILED(hr)) {
+                Release();
+                return hr;
+            }
+        }
+        m_context = context;
+        return S_OK;
+    }
+    m_noOverwrite = options.MapNoOverwriteOnDynamicConstantBuffer != FALSE;
+
+    m_ring.Reset(capacity, m_noOverwrite ? framesInFlight : 1);
+    D3D11_BUFFER_DESC desc = {};
+    desc.ByteWidth = m_ring.Capacity();
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    hr = device->CreateBuffer(&desc, nullptr, &m_buffer);
+    if (FAILED(hr)) return hr;
+
+    m_context = context;
+    return S_OK;
+}
+
+void D3D11UploadBuffer::Release() noexcept {
+    if (m_mapped) EndFrame();
+    if (m_buffer) m_buffer->Release();
+    m_buffer = nullptr;
+    for (ID3D11Buffer*& buffer : m_slotBuffers) {
+        if (buffer) buffer->Release();
+        buffer = nullptr;
+    }
+    m_shadow.clear();
+    m_context = nullptr;
+}
+
+bool D3D11UploadBuffer::BeginFrame() noexcept {
+    if (!m_context) return false;
+    if (!UsesOffsets()) {
+        m_mapped = m_shadow.data();
+        m_ring.BeginFrame();
+        return true;
+    }
+    // The first map always discards, so the buffer never starts out in use.
+    D3D11_MAP mapType = m_noOverwrite && m_ring.FrameIndex() > 0 ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD;
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(m_context->Map(m_buffer, 0, mapType, 0, &mapped))) return false;
+    m_mapped = static_cast<uint8_t*>(mapped.pData);
+    m_ring.BeginFrame();
+    return true;
+}
+
+void* D3D11UploadBuffer::Allocate(uint32_t size, gfx::UploadAllocation& out) noexcept {
+    if (!m_mapped || (!UsesOffsets() && size > FallbackBlockSize) || !m_ring.Allocate(size, out)) return nullptr;
+    return m_mapped + out.offset;
+}
+
+void D3D11UploadBuffer::EndFrame() noexcept {
+    if (!m_mapped) return;
+    if (UsesOffsets()) m_context->Unmap(m_buffer, 0);
+    m_mapped = nullptr;
+    m_ring.EndFrame();
+}
+
+void D3D11UploadBuffer::Bind(uint32_t slot, uint32_t offset) noexcept {
+    if (UsesOffsets() || slot >= gfx::MaxConstantBuffers || offset >= m_ring.Capacity()) return;
+    m_context->UpdateSubresource(m_slotBuffers[slot], 0, nullptr, m_shadow.data() + offset, 0, 0);
+    m_context->VSSetConstantBuffers(slot, 1, &m_slotBuffers[slot]);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CommandBuffer.h"
+#include "UploadRing.h"
+
+#include <d3d11_1.h>
+#include <vector>
+
+// Dynamic constant buffer shared by every object of a frame. It is mapped once
+// per frame with WRITE_NO_OVERWRITE and carved into 256-byte blocks by an
+// UploadRing; draws bind their block through D3D11CommandDevice ranges. The
+// swap chain's maximum frame latency must stay below framesInFlight.
+// Drivers without constant buffer offsetting get blocks in system memory instead;
+// D3D11CommandDevice then calls Bind before each draw, which copies the block into
+// a per-slot buffer with UpdateSubresource.
+class D3D11UploadBuffer {
+public:
+    D3D11UploadBuffer() = default;
+    ~D3D11UploadBuffer() { Release(); }
+
+    D3D11UploadBuffer(const D3D11UploadBuffer&) = delete;
+    D3D11UploadBuffer& operator=(const D3D11UploadBuffer&) = delete;
+
+    HRESULT Initialize(ID3D11Device* device, ID3D11DeviceContext* context, uint32_t capacity, uint32_t framesInFlight);
+    void Release() noexcept;
+
+    bool BeginFrame() noexcept;
+    // Returns where to write size bytes, or nullptr when the ring is full. Without
+    // offsetting, blocks larger than FallbackBlockSize fail too.
+    void* Allocate(uint32_t size, gfx::UploadAllocation& out) noexcept;
+    void EndFrame() noexcept;
+
+    // False when draws must go through Bind instead of binding ranges of Buffer().
+    bool UsesOffsets() const noexcept { return m_shadow.empty(); }
+    // Fallback only: uploads the block at offset to slot's buffer and binds it to
+    // the vertex shader. Blocks stay valid until the next BeginFrame.
+    void Bind(uint32_t slot, uint32_t offset) noexcept;
+
+    static constexpr uint32_t FallbackBlockSize = 4096;
+
+    ID3D11Buffer* Buffer() const noexcept { return m_buffer; }
+    const gfx::UploadRing& Ring() const noexcept { return m_ring; }
+
+private:
+    ID3D11DeviceContext* m_context = nullptr;
+    ID3D11Buffer* m_buffer = nullptr;
+    uint8_t* m_mapped = nullptr;
+    gfx::UploadRing m_ring;
+    // Without NO_OVERWRITE support every frame discards, and the driver renames the buffer.
+    bool m_noOverwrite = false;
+    // Fallback storage; padded by FallbackBlockSize because UpdateSubresource
+    // copies whole constant buffers.
+    std::vector<uint8_t> m_shadow;
+    ID3D11Buffer* m_slotBuffers[gfx::MaxConstantBuffers] = {};
+};
@@ -0,0 +1,34 @@
+#include "D3DShaderCompiler.h"
+
+#include <d3dcompiler.h>
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+uint64_t D3DShaderCompiler::VersionHash() const noexcept {
+    return D3D_COMPILER_VERSION;
+}
+
+bool D3DShaderCompiler::Compile(const gfx::ShaderCompileRequest& request, std::vector<uint8_t>& bytecode, std::string& errors) {
+    static_assert(sizeof(gfx::ShaderDefine) == sizeof(D3D_SHADER_MACRO), "ShaderDefine must mirror D3D_SHADER_MACRO");
+    std::vector<D3D_SHADER_MACRO> macros(request.defineCount + 1, D3D_SHADER_MACRO{ nullptr, nullptr });
+    for (uint32_t i = 0; i < request.defineCount; ++i) {
+        macros[i] = { request.defines[i].name, request.defines[i].value };
+    }
+
+    ID3DBlob* code = nullptr;
+    ID3DBlob* messages = nullptr;
+    HRESULT hr = D3DCompile(request.source, request.sourceSize, request.debugName, macros.data(), nullptr,
+                            request.entryPoint, request.profile, request.flags, 0, &code, &messages);
+    if (messages) {
+        errors.assign(static_cast<const char*>(messages->GetBufferPointer()), messages->GetBufferSize());
+        messages->Release();
+    }
+    if (FAILED(hr)) {
+        if (code) code->Release();
+        return false;
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(code->GetBufferPointer());
+    bytecode.assign(data, data + code->GetBufferSize());
+    code->Release();
+    return true;
+}
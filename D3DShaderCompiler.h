@@ -0,0 +1,10 @@
+#pragma once
+
+#include "ShaderCache.h"
+
+// ShaderCompiler backed by D3DCompile from d3dcompiler_47.
+class D3DShaderCompiler final : public gfx::ShaderCompiler {
+public:
+    uint64_t VersionHash() const noexcept override;
+    bool Compile(const gfx::ShaderCompileRequest& request, std::vector<uint8_t>& bytecode, std::string& errors) override;
+};
@@ -0,0 +1,71 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+DynamicResolution::DynamicResolution(const DynamicResolutionSettings& settings) noexcept : m_settings(settings) {
+    Reset();
+}
+
+void DynamicResolution::SetSettings(const DynamicResolutionSettings& settings) noexcept {
+    m_settings = settings;
+    m_scale = std::min(std::max(m_scale, m_settings.minScale), m_settings.maxScale);
+}
+
+void DynamicResolution::Reset() noexcept {
+    m_scale = m_settings.maxScale;
+    m_smoothedMs = 0.0f;
+    m_above = m_below = m_settle = 0;
+    m_changes = 0;
+}
+
+float DynamicResolution::Quantize(float scale) const noexcept {
+    if (m_settings.scaleStep > 0.0f) scale = std::round(scale / m_settings.scaleStep) * m_settings.scaleStep;
+    return std::min(std::max(scale, m_settings.minScale), m_settings.maxScale);
+}
+
+bool DynamicResolution::Update(float frameMs) noexcept {
+    const DynamicResolutionSettings& s = m_settings;
+    if (m_smoothedMs == 0.0f) m_smoothedMs = frameMs;
+    else m_smoothedMs += (std::min(frameMs, m_smoothedMs * s.spikeLimit) - m_smoothedMs) * s.smoothing;
+    if (m_settle > 0) {
+        --m_settle;
+        return false;
+    }
+
+    const float upper = s.targetFrameMs * s.upperBound;
+    const float lower = s.targetFrameMs * s.lowerBound;
+    m_above = m_smoothedMs > upper ? m_above + 1 : 0;
+    m_below = m_smoothedMs < lower ? m_below + 1 : 0;
+
+    float scale = m_scale;
+    const float aim = s.targetFrameMs * 0.5f * (s.upperBound + s.lowerBound);
+    if (m_above >= s.framesAbove && m_scale > s.minScale) {
+        // Round down so that one drop is enough to get back under the budget.
+        float wanted = m_scale * std::sqrt(aim / m_smoothedMs);
+        scale = s.scaleStep > 0.0f ? std::floor(wanted / s.scaleStep) * s.scaleStep : wanted;
+        scale = std::min(std::max(scale, s.minScale), m_scale - s.scaleStep);
+    } else if (m_below >= s.framesBelow && m_scale < s.maxScale) {
+        float wanted = m_scale * std::sqrt(aim / m_smoothedMs);
+        scale = std::min(wanted, m_scale + s.maxIncrease);
+    }
+    scale = Quantize(scale);
+    if (scale == m_scale) return false;
+
+    // The smoothed time is rescaled by the predicted cost so it does not keep pushing
+    // the next decision with frames from the old resolution.
+    m_smoothedMs *= (scale * scale) / (m_scale * m_scale);
+    m_scale = scale;
+    m_above = m_below = 0;
+    m_settle = s.settleFrames;
+    ++m_changes;
+    return true;
+}
+
+uint32_t DynamicResolution::RenderSize(uint32_t outputSize) const noexcept {
+    return std::max(1u, static_cast<uint32_t>(outputSize * m_scale + 0.5f));
+}
+
+} // namespace gfx
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+
+namespace gfx {
+
+// Collects window size changes between frames. WM_SIZE arrives many times per second
+// while a window edge is dragged; the render loop rebuilds its targets only for the
+// last size seen, at most once per frame. Zero sizes (minimized) are ignored.
+class ResizeCoalescer {
+public:
+    void Request(uint32_t width, uint32_t height) noexcept {
+        if (width == 0 || height == 0) return;
+        m_width = width;
+        m_height = height;
+        m_pending = m_width != m_appliedWidth || m_height != m_appliedHeight;
+    }
+
+    // Returns true once per change, with the size to apply.
+    bool Consume(uint32_t& width, uint32_t& height) noexcept {
+        if (!m_pending) return false;
+        m_pending = false;
+        width = m_appliedWidth = m_width;
+        height = m_appliedHeight = m_height;
+        return true;
+    }
+
+    // Size the targets were created with, so resizing back to it is not a change.
+    void SetApplied(uint32_t width, uint32_t height) noexcept {
+        m_width = m_appliedWidth = width;
+        m_height = m_appliedHeight = height;
+        m_pending = false;
+    }
+
+private:
+    uint32_t m_width = 0, m_height = 0;
+    uint32_t m_appliedWidth = 0, m_appliedHeight = 0;
+    bool m_pending = false;
+};
+
+struct DynamicResolutionSettings {
+    float targetFrameMs = 1000.0f / 60.0f;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    // Scale changes are multiples of this.
+    float scaleStep = 1.0f / 32.0f;
+    // Hysteresis band as fractions of the target: the scale drops when the smoothed
+    // frame time stays above the upper bound and rises when it stays below the lower.
+    float upperBound = 1.0f;
+    float lowerBound = 0.8f;
+    uint32_t framesAbove = 3;
+    uint32_t framesBelow = 30;
+    // Frames ignored after a change, while work at the old resolution drains.
+    uint32_t settleFrames = 4;
+    // Weight of the newest frame in the smoothed frame time. A single frame counts as
+    // at most spikeLimit times the smoothed time, so hitches such as shader compiles
+    // or page faults do not cost resolution; a sustained rise still gets through.
+    float smoothing = 0.25f;
+    float spikeLimit = 2.0f;
+    float maxIncrease = 0.1f;
+};
+
+// Keeps the frame time near a budget by scaling the internal render resolution.
+// GPU cost is taken to follow the pixel count, so a frame that is too slow by a
+// factor k scales by 1/sqrt(k) towards the middle of the hysteresis band. Drops
+// react within a few frames; increases are delayed and capped, because
+// overshooting costs a visible hitch while undershooting only costs sharpness.
+class DynamicResolution {
+public:
+    explicit DynamicResolution(const DynamicResolutionSettings& settings = {}) noexcept;
+
+    void SetSettings(const DynamicResolutionSettings& settings) noexcept;
+    const DynamicResolutionSettings& Settings() const noexcept { return m_settings; }
+
+    // Feeds the duration of the last frame; returns true when the scale changed.
+    bool Update(float frameMs) noexcept;
+    void Reset() noexcept;
+
+    // Fraction of the output size per axis.
+    float Scale() const noexcept { return m_scale; }
+    float SmoothedFrameMs() const noexcept { return m_smoothedMs; }
+    uint32_t ScaleChanges() const noexcept { return m_changes; }
+
+    uint32_t RenderSize(uint32_t outputSize) const noexcept;
+
+private:
+    float Quantize(float scale) const noexcept;
+
+    DynamicResolutionSettings m_settings;
+    float m_scale;
+    float m_smoothedMs = 0.0f;
+    uint32_t m_above = 0;
+    uint32_t m_below = 0;
+    uint32_t m_settle = 0;
+    uint32_t m_changes = 0;
+};
+
+} // namespace gfx
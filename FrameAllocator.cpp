@@ -0,0 +1,172 @@
+#include "FrameAllocator.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+constexpr size_t GuardSize = 16;
+constexpr uint8_t GuardByte = 0xFD;
+constexpr uint8_t ResetByte = 0xDD;
+constexpr uint8_t FreedByte = 0xDF;
+constexpr uint64_t FreeMarker = 0xF4EEB10CF4EEB10Cull;
+
+uint8_t* AlignUp(uint8_t* pointer, size_t alignment) noexcept {
+    return reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(pointer) + alignment - 1) & ~uintptr_t(alignment - 1));
+}
+
+} // namespace
+
+LinearArena::LinearArena(size_t initialCapacity) {
+    AddBlock(initialCapacity);
+}
+
+void LinearArena::AddBlock(size_t minimumSize) {
+    size_t size = std::max(minimumSize, m_blocks.empty() ? size_t(0) : m_blocks.back().size * 2);
+    m_blocks.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[size]), size });
+    m_current = m_blocks.size() - 1;
+    m_cursor = m_blocks.back().memory.get();
+    m_end = m_cursor + size;
+    ++m_stats.blockAllocations;
+}
+
+void* LinearArena::Allocate(size_t size, size_t alignment) {
+    const size_t guard = GFX_ALLOCATOR_DEBUG ? GuardSize : 0;
+    uint8_t* result = AlignUp(m_cursor, alignment);
+    if (result + size + guard > m_end) {
+        AddBlock(size + guard + alignment);
+        result = AlignUp(m_cursor, alignment);
+    }
+    m_cursor = result + size + guard;
+#if GFX_ALLOCATOR_DEBUG
+    memset(result + size, GuardByte, GuardSize);
+    m_guards.push_back(result + size);
+#endif
+    ++m_stats.allocations;
+    m_stats.bytesUsed += size;
+    m_stats.peakBytes = std::max(m_stats.peakBytes, m_stats.bytesUsed);
+    return result;
+}
+
+uint64_t LinearArena::CheckGuards() noexcept {
+    uint64_t found = 0;
+#if GFX_ALLOCATOR_DEBUG
+    for (uint8_t* guard : m_guards) {
+        for (size_t i = 0; i < GuardSize; ++i) {
+            if (guard[i] != GuardByte) {
+                ++found;
+                memset(guard, GuardByte, GuardSize);
+                break;
+            }
+        }
+    }
+    m_debug.overruns += found;
+#endif
+    return found;
+}
+
+void LinearArena::Reset() {
+#if GFX_ALLOCATOR_DEBUG
+    CheckGuards();
+    m_guards.clear();
+    // Stale pointers into the arena now read a recognizable pattern.
+    for (size_t i = 0; i < m_current; ++i) memset(m_blocks[i].memory.get(), ResetByte, m_blocks[i].size);
+    memset(m_blocks[m_current].memory.get(), ResetByte, m_cursor - m_blocks[m_current].memory.get());
+#endif
+    if (m_blocks.size() > 1) {
+        size_t total = Capacity();
+        m_blocks.clear();
+        AddBlock(total);
+    }
+    m_current = 0;
+    m_cursor = m_blocks[0].memory.get();
+    m_end = m_cursor + m_blocks[0].size;
+    m_stats.bytesUsed = 0;
+    ++m_generation;
+}
+
+size_t LinearArena::Capacity() const noexcept {
+    size_t total = 0;
+    for (const Block& block : m_blocks) total += block.size;
+    return total;
+}
+
+ThreadArenas::ThreadArenas(uint32_t threadCount, size_t initialCapacity) {
+    m_slots.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i) m_slots.push_back(std::make_unique<Slot>(initialCapacity));
+}
+
+void ThreadArenas::ResetAll() {
+    for (std::unique_ptr<Slot>& slot : m_slots) slot->arena.Reset();
+}
+
+FixedPool::FixedPool(size_t blockSize, size_t blocksPerChunk, size_t alignment)
+    : m_alignment(std::max(alignment, alignof(FreeBlock))), m_blocksPerChunk(blocksPerChunk ? blocksPerChunk : 1) {
+    m_blockSize = (std::max(blockSize, sizeof(FreeBlock)) + m_alignment - 1) & ~(m_alignment - 1);
+}
+
+void FixedPool::AddChunk() {
+    m_chunks.emplace_back(new uint8_t[m_blockSize * m_blocksPerChunk + m_alignment]);
+    uint8_t* base = AlignUp(m_chunks.back().get(), m_alignment);
+    // Linked back to front so blocks are handed out in address order.
+    for (size_t i = m_blocksPerChunk; i-- > 0;) {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(base + i * m_blockSize);
+#if GFX_ALLOCATOR_DEBUG
+        memset(block, FreedByte, m_blockSize);
+#endif
+        block->next = m_free;
+        block->marker = FreeMarker;
+        m_free = block;
+    }
+    ++m_stats.chunkAllocations;
+}
+
+void* FixedPool::Allocate() {
+    if (!m_free) AddChunk();
+    FreeBlock* block = m_free;
+    m_free = block->next;
+#if GFX_ALLOCATOR_DEBUG
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(block);
+    bool written = block->marker != FreeMarker;
+    for (size_t i = sizeof(FreeBlock); i < m_blockSize && !written; ++i) written = bytes[i] != FreedByte;
+    if (written) ++m_debug.useAfterFree;
+#endif
+    block->marker = 0;
+    m_stats.peakBlocks = std::max(m_stats.peakBlocks, ++m_stats.liveBlocks);
+    return block;
+}
+
+void FixedPool::Free(void* pointer) noexcept {
+    if (!pointer) return;
+    FreeBlock* block = static_cast<FreeBlock*>(pointer);
+#if GFX_ALLOCATOR_DEBUG
+    const uint8_t* address = static_cast<const uint8_t*>(pointer);
+    bool owned = false;
+    for (const std::unique_ptr<uint8_t[]>& chunk : m_chunks) {
+        const uint8_t* base = AlignUp(chunk.get(), m_alignment);
+        if (address >= base && address < base + m_blockSize * m_blocksPerChunk) {
+            owned = (address - base) % m_blockSize == 0;
+            break;
+        }
+    }
+    if (!owned || block->marker == FreeMarker) {
+        ++m_debug.invalidFrees;
+        return;
+    }
+    memset(block, FreedByte, m_blockSize);
+#endif
+    block->next = m_free;
+    block->marker = FreeMarker;
+    m_free = block;
+    --m_stats.liveBlocks;
+}
+
+void FixedPool::Clear() noexcept {
+    m_chunks.clear();
+    m_free = nullptr;
+    m_stats.liveBlocks = 0;
+}
+
+} // namespace gfx
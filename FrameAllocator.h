@@ -0,0 +1,259 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Guard bytes after every arena allocation, poisoning of reset or freed memory and
+// allocator generation checks. On by default unless NDEBUG is defined. Every
+// translation unit must agree on it, so set it project-wide (the CMake cache
+// variable of the same name); class layouts do not depend on it.
+#ifndef GFX_ALLOCATOR_DEBUG
+#ifdef NDEBUG
+#define GFX_ALLOCATOR_DEBUG 0
+#else
+#define GFX_ALLOCATOR_DEBUG 1
+#endif
+#endif
+
+namespace gfx {
+
+// Misuse found by the debug checks; always zero when GFX_ALLOCATOR_DEBUG is 0.
+struct AllocatorDebugStats {
+    uint64_t overruns = 0;
+    // Containers used after their arena's Reset(), or pool blocks written after Free().
+    uint64_t useAfterFree = 0;
+    uint64_t invalidFrees = 0;
+};
+
+struct ArenaStats {
+    uint64_t allocations = 0;
+    uint64_t bytesUsed = 0;
+    uint64_t peakBytes = 0;
+    // Blocks taken from the heap; stays flat once the arena has reached its working size.
+    uint64_t blockAllocations = 0;
+};
+
+// Bump allocator for data that lives until the next Reset(), typically one frame.
+// Allocation is a pointer increment; when the current block is full a larger one
+// is chained on, and Reset() folds all blocks into a single one big enough for the
+// whole frame, so a steady workload stops touching the heap after a frame or two.
+// Destructors are never run. Not thread-safe: give each thread its own arena.
+class LinearArena {
+public:
+    explicit LinearArena(size_t initialCapacity = 64 * 1024);
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    // alignment must be a power of two. Never returns nullptr.
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template<typename T>
+    T* AllocateArray(size_t count) {
+        return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    template<typename T, typename... Args>
+    T* New(Args&&... args) {
+        return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Invalidates everything allocated since the last Reset().
+    void Reset();
+
+    // Counts guard bytes that were written past an allocation. Reset() runs it too.
+    uint64_t CheckGuards() noexcept;
+
+    // Bumped by Reset(); adapters compare it to catch containers kept across a reset.
+    uint64_t Generation() const noexcept { return m_generation; }
+    size_t Capacity() const noexcept;
+    const ArenaStats& Stats() const noexcept { return m_stats; }
+    const AllocatorDebugStats& DebugStats() const noexcept { return m_debug; }
+    void ReportUseAfterReset() noexcept { ++m_debug.useAfterFree; }
+
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> memory;
+        size_t size;
+    };
+
+    void AddBlock(size_t minimumSize);
+
+    std::vector<Block> m_blocks;
+    size_t m_current = 0;
+    uint8_t* m_cursor = nullptr;
+    uint8_t* m_end = nullptr;
+    uint64_t m_generation = 0;
+    ArenaStats m_stats;
+    AllocatorDebugStats m_debug;
+    // Only filled with debug checks on; always present so the layout stays the same.
+    std::vector<uint8_t*> m_guards;
+};
+
+// One arena per ThreadPool thread index, each on its own cache lines.
+class ThreadArenas {
+public:
+    ThreadArenas(uint32_t threadCount, size_t initialCapacity = 64 * 1024);
+
+    LinearArena& operator[](uint32_t threadIndex) noexcept { return m_slots[threadIndex]->arena; }
+    uint32_t Count() const noexcept { return static_cast<uint32_t>(m_slots.size()); }
+    void ResetAll();
+
+private:
+    struct alignas(64) Slot {
+        explicit Slot(size_t capacity) : arena(capacity) {}
+        LinearArena arena;
+    };
+
+    std::vector<std::unique_ptr<Slot>> m_slots;
+};
+
+struct PoolStats {
+    uint64_t liveBlocks = 0;
+    uint64_t peakBlocks = 0;
+    uint64_t chunkAllocations = 0;
+};
+
+// Free list of equally sized blocks carved from chunks that are kept until Clear().
+// Allocate and Free are O(1) and never return memory to the heap in between.
+class FixedPool {
+public:
+    FixedPool(size_t blockSize, size_t blocksPerChunk = 256, size_t alignment = alignof(std::max_align_t));
+
+    FixedPool(const FixedPool&) = delete;
+    FixedPool& operator=(const FixedPool&) = delete;
+
+    void* Allocate();
+    void Free(void* block) noexcept;
+    // Drops every block; pointers handed out before become invalid.
+    void Clear() noexcept;
+
+    size_t BlockSize() const noexcept { return m_blockSize; }
+    size_t Alignment() const noexcept { return m_alignment; }
+    const PoolStats& Stats() const noexcept { return m_stats; }
+    const AllocatorDebugStats& DebugStats() const noexcept { return m_debug; }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+        uint64_t marker;
+    };
+
+    void AddChunk();
+
+    size_t m_blockSize;
+    size_t m_alignment;
+    size_t m_blocksPerChunk;
+    std::vector<std::unique_ptr<uint8_t[]>> m_chunks;
+    FreeBlock* m_free = nullptr;
+    PoolStats m_stats;
+    AllocatorDebugStats m_debug;
+};
+
+// Typed front end over a FixedPool sized for T.
+template<typename T>
+class ObjectPool {
+public:
+    explicit ObjectPool(size_t objectsPerChunk = 256) : m_pool(sizeof(T), objectsPerChunk, alignof(T)) {}
+
+    template<typename... Args>
+    T* Create(Args&&... args) {
+        return new (m_pool.Allocate()) T(std::forward<Args>(args)...);
+    }
+
+    void Destroy(T* object) noexcept {
+        if (!object) return;
+        object->~T();
+        m_pool.Free(object);
+    }
+
+    const FixedPool& Pool() const noexcept { return m_pool; }
+
+private:
+    FixedPool m_pool;
+};
+
+// STL allocator drawing from a LinearArena. deallocate() is a no-op; the memory
+// comes back with the arena's Reset(), so the container must not outlive it.
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(LinearArena& arena) noexcept : m_arena(&arena), m_generation(arena.Generation()) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.m_arena), m_generation(other.m_generation) {}
+
+    T* allocate(size_t count) {
+        Check();
+        return m_arena->AllocateArray<T>(count);
+    }
+
+    void deallocate(T*, size_t) noexcept { Check(); }
+
+    LinearArena& Arena() const noexcept { return *m_arena; }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return m_arena == other.m_arena; }
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept { return m_arena != other.m_arena; }
+
+private:
+    template<typename U>
+    friend class ArenaAllocator;
+
+    void Check() const noexcept {
+#if GFX_ALLOCATOR_DEBUG
+        if (m_arena->Generation() != m_generation) m_arena->ReportUseAfterReset();
+#endif
+    }
+
+    LinearArena* m_arena;
+    uint64_t m_generation;
+};
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// STL allocator for node-based containers: single objects that fit the pool's
+// blocks come from it, anything else (bucket arrays, vectors) from the heap.
+template<typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(FixedPool& pool) noexcept : m_pool(&pool) {}
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : m_pool(other.m_pool) {}
+
+    T* allocate(size_t count) {
+        if (FitsPool(count)) return static_cast<T*>(m_pool->Allocate());
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t count) noexcept {
+        if (FitsPool(count)) m_pool->Free(pointer);
+        else ::operator delete(pointer);
+    }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept { return m_pool == other.m_pool; }
+    template<typename U>
+    bool operator!=(const PoolAllocator<U>& other) const noexcept { return m_pool != other.m_pool; }
+
+private:
+    template<typename U>
+    friend class PoolAllocator;
+
+    bool FitsPool(size_t count) const noexcept {
+        return count == 1 && sizeof(T) <= m_pool->BlockSize() && alignof(T) <= m_pool->Alignment();
+    }
+
+    FixedPool* m_pool;
+};
+
+} // namespace gfx
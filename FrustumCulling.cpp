@@ -0,0 +1,144 @@
+#include "FrustumCulling.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+namespace {
+
+void CullScalar(const AabbStreams& b, uint32_t begin, uint32_t end, const Frustum& f, std::vector<uint32_t>& visible) {
+    for (uint32_t i = begin; i < end; ++i) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; ++p) {
+            const float* pl = f.planes[p];
+            float distance = pl[0] * b.centerX[i] + pl[1] * b.centerY[i] + pl[2] * b.centerZ[i] + pl[3];
+            float radius = std::fabs(pl[0]) * b.extentX[i] + std::fabs(pl[1]) * b.extentY[i] + std::fabs(pl[2]) * b.extentZ[i];
+            inside = distance + radius >= 0.0f;
+        }
+        if (inside) visible.push_back(i);
+    }
+}
+
+#if GFX_X86
+inline void AppendMask(uint32_t mask, uint32_t base, std::vector<uint32_t>& visible) {
+    while (mask) {
+        visible.push_back(base + CountTrailingZeros(mask));
+        mask &= mask - 1;
+    }
+}
+
+uint32_t CullSSE(const AabbStreams& b, uint32_t begin, uint32_t end, const Frustum& f, std::vector<uint32_t>& visible) {
+    __m128 n[6][3], nAbs[6][3], d[6];
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    for (int p = 0; p < 6; ++p) {
+        for (int k = 0; k < 3; ++k) {
+            n[p][k] = _mm_set1_ps(f.planes[p][k]);
+            nAbs[p][k] = _mm_andnot_ps(signMask, n[p][k]);
+        }
+        d[p] = _mm_set1_ps(f.planes[p][3]);
+    }
+    uint32_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 cx = _mm_loadu_ps(b.centerX + i), cy = _mm_loadu_ps(b.centerY + i), cz = _mm_loadu_ps(b.centerZ + i);
+        __m128 ex = _mm_loadu_ps(b.extentX + i), ey = _mm_loadu_ps(b.extentY + i), ez = _mm_loadu_ps(b.extentZ + i);
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; ++p) {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n[p][0], cx), _mm_mul_ps(n[p][1], cy)), _mm_add_ps(_mm_mul_ps(n[p][2], cz), d[p]));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nAbs[p][0], ex), _mm_mul_ps(nAbs[p][1], ey)), _mm_mul_ps(nAbs[p][2], ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+        }
+        AppendMask(~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xF, i, visible);
+    }
+    return i;
+}
+
+GFX_TARGET_AVX2 uint32_t CullAVX2(const AabbStreams& b, uint32_t begin, uint32_t end, const Frustum& f, std::vector<uint32_t>& visible) {
+    __m256 n[6][3], nAbs[6][3], d[6];
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    for (int p = 0; p < 6; ++p) {
+        for (int k = 0; k < 3; ++k) {
+            n[p][k] = _mm256_set1_ps(f.planes[p][k]);
+            nAbs[p][k] = _mm256_andnot_ps(signMask, n[p][k]);
+        }
+        d[p] = _mm256_set1_ps(f.planes[p][3]);
+    }
+    uint32_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 cx = _mm256_loadu_ps(b.centerX + i), cy = _mm256_loadu_ps(b.centerY + i), cz = _mm256_loadu_ps(b.centerZ + i);
+        __m256 ex = _mm256_loadu_ps(b.extentX + i), ey = _mm256_loadu_ps(b.extentY + i), ez = _mm256_loadu_ps(b.extentZ + i);
+        __m256 outside = _mm256_setzero_ps();
+        for (int p = 0; p < 6; ++p) {
+            __m256 dist = _mm256_fmadd_ps(n[p][0], cx, _mm256_fmadd_ps(n[p][1], cy, _mm256_fmadd_ps(n[p][2], cz, d[p])));
+            __m256 sum = _mm256_fmadd_ps(nAbs[p][0], ex, _mm256_fmadd_ps(nAbs[p][1], ey, _mm256_fmadd_ps(nAbs[p][2], ez, dist)));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(sum, _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+        AppendMask(~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFF, i, visible);
+    }
+    return i;
+}
+#endif
+
+} // namespace
+
+Frustum ExtractFrustum(const Float4x4& m) noexcept {
+    auto column = [&](int c) { return Float4{ m.m[0][c], m.m[1][c], m.m[2][c], m.m[3][c] }; };
+    Float4 c0 = column(0), c1 = column(1), c2 = column(2), c3 = column(3);
+    const Float4 raw[6] = {
+        { c3.x + c0.x, c3.y + c0.y, c3.z + c0.z, c3.w + c0.w },
+        { c3.x - c0.x, c3.y - c0.y, c3.z - c0.z, c3.w - c0.w },
+        { c3.x + c1.x, c3.y + c1.y, c3.z + c1.z, c3.w + c1.w },
+        { c3.x - c1.x, c3.y - c1.y, c3.z - c1.z, c3.w - c1.w },
+        c2,
+        { c3.x - c2.x, c3.y - c2.y, c3.z - c2.z, c3.w - c2.w },
+    };
+    Frustum f;
+    for (int p = 0; p < 6; ++p) {
+        float len = std::sqrt(raw[p].x * raw[p].x + raw[p].y * raw[p].y + raw[p].z * raw[p].z);
+        float inv = len > 0.0f ? 1.0f / len : 0.0f;
+        f.planes[p][0] = raw[p].x * inv;
+        f.planes[p][1] = raw[p].y * inv;
+        f.planes[p][2] = raw[p].z * inv;
+        f.planes[p][3] = raw[p].w * inv;
+    }
+    return f;
+}
+
+void CullAabbs(const AabbStreams& bounds, uint32_t begin, uint32_t end, const Frustum& frustum,
+               std::vector<uint32_t>& visible, SimdLevel level) {
+    uint32_t done = begin;
+#if GFX_X86
+    if (level == SimdLevel::AVX2) done = CullAVX2(bounds, begin, end, frustum, visible);
+    else if (level == SimdLevel::SSE) done = CullSSE(bounds, begin, end, frustum, visible);
+#else
+    (void)level;
+#endif
+    CullScalar(bounds, done, end, frustum, visible);
+}
+
+void FrustumCuller::Cull(const Scene& scene, const Frustum& frustum, std::vector<uint32_t>& visible) {
+    Cull(scene.Bounds(), static_cast<uint32_t>(scene.ObjectCount()), frustum, visible);
+}
+
+void FrustumCuller::Cull(const AabbStreams& bounds, uint32_t count, const Frustum& frustum, std::vector<uint32_t>& visible) {
+    uint32_t blocks = (count + BlockSize - 1) / BlockSize;
+    if (m_blockResults.size() < blocks) m_blockResults.resize(blocks);
+
+    m_pool.Run(blocks, [&](uint32_t block, uint32_t) {
+        std::vector<uint32_t>& out = m_blockResults[block];
+        out.clear();
+        uint32_t begin = block * BlockSize;
+        CullAabbs(bounds, begin, std::min(count, begin + BlockSize), frustum, out, m_level);
+    });
+
+    size_t total = 0;
+    for (uint32_t b = 0; b < blocks; ++b) total += m_blockResults[b].size();
+    visible.resize(total);
+    size_t offset = 0;
+    for (uint32_t b = 0; b < blocks; ++b) {
+        std::copy(m_blockResults[b].begin(), m_blockResults[b].end(), visible.begin() + offset);
+        offset += m_blockResults[b].size();
+    }
+}
+
+} // namespace gfx
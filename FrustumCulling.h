@@ -0,0 +1,46 @@
+#pragma once
+
+#include "MathTypes.h"
+#include "Scene.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+// Planes as (a, b, c, d) with a*x + b*y + c*z + d >= 0 inside, normalized.
+// Order: left, right, bottom, top, near, far.
+struct Frustum {
+    float planes[6][4];
+};
+
+// Gribb/Hartmann extraction for row-vector matrices and D3D depth (0 <= z <= w),
+// i.e. the viewProj that UpdateViewProjBuffer uploads.
+Frustum ExtractFrustum(const Float4x4& viewProj) noexcept;
+
+// Single-threaded kernel: appends indices in [begin, end) whose box intersects the frustum.
+void CullAabbs(const AabbStreams& bounds, uint32_t begin, uint32_t end, const Frustum& frustum,
+               std::vector<uint32_t>& visible, SimdLevel level = BestSimdLevel());
+
+// Splits the scene into fixed blocks culled on the pool and concatenates the
+// per-block results in block order, so the visible list is sorted and deterministic.
+class FrustumCuller {
+public:
+    static constexpr uint32_t BlockSize = 8192;
+
+    explicit FrustumCuller(ThreadPool& pool) : m_pool(pool) {}
+
+    void Cull(const Scene& scene, const Frustum& frustum, std::vector<uint32_t>& visible);
+    void Cull(const AabbStreams& bounds, uint32_t count, const Frustum& frustum, std::vector<uint32_t>& visible);
+
+    void SetSimdLevel(SimdLevel level) noexcept { m_level = level; }
+
+private:
+    ThreadPool& m_pool;
+    SimdLevel m_level = BestSimdLevel();
+    std::vector<std::vector<uint32_t>> m_blockResults;
+};
+
+} // namespace gfx
@@ -4,6 +4,12 @@
 #include <d3dcompiler.h> 
 #include <assert.h>
 
+#include "ColoredVertex.h"
+#include "D3D11ResourceDevice.h"
+#include "D3DShaderCompiler.h"
+#include "DynamicResolution.h"
+#include "VertexLayout.h"
+
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d3dcompiler.lib") 
@@ -13,19 +19,20 @@ ID3D11DeviceContext* m_pDeviceContext = nullptr;
 IDXGISwapChain* m_pSwapChain = nullptr;
 ID3D11RenderTargetView* m_pBackBufferRTV = nullptr;
 
-ID3D11Buffer* m_pVertexBuffer = nullptr;
-ID3D11Buffer* m_pIndexBuffer = nullptr;
-ID3D11InputLayout* m_pInputLayout = nullptr;
-ID3D11VertexShader* m_pVertexShader = nullptr;
-ID3D11PixelShader* m_pPixelShader = nullptr;
+D3D11ResourceDevice m_resourceDevice;
+gfx::ResourceRegistry m_resources;
+gfx::BufferHandle m_vertexBuffer;
+gfx::BufferHandle m_indexBuffer;
+gfx::InputLayoutHandle m_inputLayout;
+gfx::ShaderHandle m_vertexShader;
+gfx::ShaderHandle m_pixelShader;
+
+D3DShaderCompiler m_shaderCompiler;
+gfx::ShaderCache m_shaderCache("ShaderCache", m_shaderCompiler);
 
 int m_width = 1280;
 int m_height = 720;
-
-struct Vertex {
-    float x, y, z;
-    COLORREF color;
-};
+gfx::ResizeCoalescer m_resize;
 
 const char* shaderCode =
 "struct VSInput { float3 pos : POSITION; float4 color : COLOR; };\n"
@@ -51,54 +58,56 @@ HRESULT CreateBackBuffer() {
     return result;
 }
 
-HRESULT InitScene() {
-    HRESULT result;
+// The context still holds the RTV of the last frame, and ResizeBuffers fails while
+// any reference to the old buffers is alive.
+HRESULT ResizeBackBuffer(uint32_t width, uint32_t height) {
+    m_pDeviceContext->OMSetRenderTargets(0, nullptr, nullptr);
+    if (m_pBackBufferRTV) {
+        m_pBackBufferRTV->Release();
+        m_pBackBufferRTV = nullptr;
+    }
+    m_width = static_cast<int>(width);
+    m_height = static_cast<int>(height);
+    HRESULT result = m_pSwapChain->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN, 0);
+    if (FAILED(result)) return result;
+    return CreateBackBuffer();
+}
 
-    static const Vertex Vertices[] = {
-        {-0.5f, -0.5f, 0.0f, RGB(255, 0, 0)},
-        { 0.5f, -0.5f, 0.0f, RGB(0, 255, 0)},
-        { 0.0f,  0.5f, 0.0f, RGB(0, 0, 255)}
+HRESULT InitScene() {
+    m_resourceDevice.Initialize(m_pDevice);
+    m_resources.Initialize(&m_resourceDevice, 2);
+
+    // Opaque colors; a COLORREF would have left alpha at zero.
+    static const ColoredVertex Vertices[] = {
+        { {-0.5f, -0.5f, 0.0f}, gfx::PackRGBA8(uint8_t(255), uint8_t(0), uint8_t(0), uint8_t(255)) },
+        { { 0.5f, -0.5f, 0.0f}, gfx::PackRGBA8(uint8_t(0), uint8_t(255), uint8_t(0), uint8_t(255)) },
+        { { 0.0f,  0.5f, 0.0f}, gfx::PackRGBA8(uint8_t(0), uint8_t(0), uint8_t(255), uint8_t(255)) }
     };
     static const USHORT Indices[] = { 0, 2, 1 };
 
-    D3D11_BUFFER_DESC vertexDesc = {};
-    vertexDesc.ByteWidth = sizeof(Vertices);
-    vertexDesc.Usage = D3D11_USAGE_IMMUTABLE;
-    vertexDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    D3D11_SUBRESOURCE_DATA vertexData = { Vertices };
-    result = m_pDevice->CreateBuffer(&vertexDesc, &vertexData, &m_pVertexBuffer);
-    if (FAILED(result)) return result;
+    m_vertexBuffer = m_resources.CreateBuffer({ sizeof(Vertices), gfx::BufferUsage::Immutable, gfx::BindVertexBuffer }, Vertices);
+    if (!m_vertexBuffer) return m_resourceDevice.LastError();
 
-    D3D11_BUFFER_DESC indexDesc = {};
-    indexDesc.ByteWidth = sizeof(Indices);
-    indexDesc.Usage = D3D11_USAGE_IMMUTABLE;
-    indexDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-    D3D11_SUBRESOURCE_DATA indexData = { Indices };
-    result = m_pDevice->CreateBuffer(&indexDesc, &indexData, &m_pIndexBuffer);
-    if (FAILED(result)) return result;
+    m_indexBuffer = m_resources.CreateBuffer({ sizeof(Indices), gfx::BufferUsage::Immutable, gfx::BindIndexBuffer }, Indices);
+    if (!m_indexBuffer) return m_resourceDevice.LastError();
 
-    ID3DBlob* pVSBlob = nullptr;
-    result = D3DCompile(shaderCode, strlen(shaderCode), NULL, NULL, NULL, "vs", "vs_5_0", 0, 0, &pVSBlob, NULL);
-    if (SUCCEEDED(result)) {
-        result = m_pDevice->CreateVertexShader(pVSBlob->GetBufferPointer(), pVSBlob->GetBufferSize(), NULL, &m_pVertexShader);
-    }
+    gfx::ShaderCompileRequest request = { shaderCode, strlen(shaderCode), "vs", "vs_5_0", NULL, 0, 0, NULL };
+    gfx::ShaderBytecode vsCode;
+    if (!m_shaderCache.Load(request, vsCode)) return E_FAIL;
+    m_vertexShader = m_resources.CreateShader(gfx::ShaderStage::Vertex, vsCode.Data(), vsCode.Size());
+    if (!m_vertexShader) return m_resourceDevice.LastError();
 
-    ID3DBlob* pPSBlob = nullptr;
-    result = D3DCompile(shaderCode, strlen(shaderCode), NULL, NULL, NULL, "ps", "ps_5_0", 0, 0, &pPSBlob, NULL);
-    if (SUCCEEDED(result)) {
-        result = m_pDevice->CreatePixelShader(pPSBlob->GetBufferPointer(), pPSBlob->GetBufferSize(), NULL, &m_pPixelShader);
-    }
+    request.entryPoint = "ps";
+    request.profile = "ps_5_0";
+    gfx::ShaderBytecode psCode;
+    if (!m_shaderCache.Load(request, psCode)) return E_FAIL;
+    m_pixelShader = m_resources.CreateShader(gfx::ShaderStage::Pixel, psCode.Data(), psCode.Size());
+    if (!m_pixelShader) return m_resourceDevice.LastError();
 
-    D3D11_INPUT_ELEMENT_DESC inputDesc[] = {
-        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0}
-    };
-    result = m_pDevice->CreateInputLayout(inputDesc, 2, pVSBlob->GetBufferPointer(), pVSBlob->GetBufferSize(), &m_pInputLayout);
+    m_inputLayout = m_resources.CreateInputLayout(gfx::ColoredVertexFormat::Describe(), vsCode.Data(), vsCode.Size());
+    if (!m_inputLayout) return m_resourceDevice.LastError();
 
-    if (pVSBlob) pVSBlob->Release();
-    if (pPSBlob) pPSBlob->Release();
-
-    return result;
+    return S_OK;
 }
 
 HRESULT InitDirectX(HWND hWnd) {
@@ -155,7 +164,11 @@ HRESULT InitDirectX(HWND hWnd) {
 }
 
 void Render() {
-    if (!m_pDeviceContext || !m_pBackBufferRTV) return;
+    if (!m_pDeviceContext || !m_pSwapChain) return;
+    // WM_SIZE only records the size; the buffers are rebuilt once per frame at most.
+    uint32_t width, height;
+    if (m_resize.Consume(width, height) && FAILED(ResizeBackBuffer(width, height))) return;
+    if (!m_pBackBufferRTV) return;
 
     static const FLOAT BackColor[4] = { 0.25f, 0.25f, 0.25f, 1.0f };
     //static const FLOAT BackColor[4] = { 0.25f, 0.25f, 1.0f };
@@ -169,16 +182,18 @@ void Render() {
     D3D11_RECT rect = { 0, 0, m_width, m_height };
     m_pDeviceContext->RSSetScissorRects(1, &rect);
 
-    m_pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
-    ID3D11Buffer* vertexBuffers[] = { m_pVertexBuffer };
-    UINT strides[] = { 16 };
+    m_resources.BeginFrame();
+
+    m_pDeviceContext->IASetIndexBuffer(GetD3D11Buffer(m_resources, m_indexBuffer), DXGI_FORMAT_R16_UINT, 0);
+    ID3D11Buffer* vertexBuffers[] = { GetD3D11Buffer(m_resources, m_vertexBuffer) };
+    UINT strides[] = { gfx::ColoredVertexFormat::Stride };
     UINT offsets[] = { 0 };
     m_pDeviceContext->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
-    m_pDeviceContext->IASetInputLayout(m_pInputLayout);
+    m_pDeviceContext->IASetInputLayout(GetD3D11InputLayout(m_resources, m_inputLayout));
     m_pDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-    m_pDeviceContext->VSSetShader(m_pVertexShader, nullptr, 0);
-    m_pDeviceContext->PSSetShader(m_pPixelShader, nullptr, 0);
+    m_pDeviceContext->VSSetShader(GetD3D11VertexShader(m_resources, m_vertexShader), nullptr, 0);
+    m_pDeviceContext->PSSetShader(GetD3D11PixelShader(m_resources, m_pixelShader), nullptr, 0);
 
     m_pDeviceContext->DrawIndexed(3, 0, 0);
 
@@ -188,13 +203,7 @@ void Render() {
 LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
     switch (message) {
     case WM_SIZE:
-        if (m_pSwapChain && m_pDevice) {
-            if (m_pBackBufferRTV) m_pBackBufferRTV->Release();
-            m_width = LOWORD(lParam);
-            m_height = HIWORD(lParam);
-            m_pSwapChain->ResizeBuffers(0, m_width, m_height, DXGI_FORMAT_UNKNOWN, 0);
-            CreateBackBuffer();
-        }
+        m_resize.Request(LOWORD(lParam), HIWORD(lParam));
         return 0;
     case WM_DESTROY:
         PostQuitMessage(0);
@@ -233,11 +242,7 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int nCmdShow) {
         }
     }
 
-    if (m_pVertexBuffer) m_pVertexBuffer->Release();
-    if (m_pIndexBuffer) m_pIndexBuffer->Release();
-    if (m_pInputLayout) m_pInputLayout->Release();
-    if (m_pVertexShader) m_pVertexShader->Release();
-    if (m_pPixelShader) m_pPixelShader->Release();
+    m_resources.Clear();
     if (m_pBackBufferRTV) m_pBackBufferRTV->Release();
     
     if (m_pSwapChain) m_pSwapChain->Release();
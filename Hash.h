@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace gfx {
+
+// Finalizer from MurmurHash3.
+inline uint64_t Mix64(uint64_t x) noexcept {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+// Fast non-cryptographic 64-bit hash for cache keys and integrity checks.
+inline uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0) noexcept {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t h = seed ^ (uint64_t(size) * 0x9e3779b97f4a7c15ull);
+    while (size >= 8) {
+        uint64_t k;
+        std::memcpy(&k, p, 8);
+        h = (h ^ Mix64(k)) * 0x9e3779b97f4a7c15ull;
+        h = (h << 31) | (h >> 33);
+        p += 8;
+        size -= 8;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, p, size);
+    h ^= Mix64(tail ^ size);
+    return Mix64(h);
+}
+
+inline uint64_t HashCombine(uint64_t seed, uint64_t value) noexcept {
+    return Mix64(seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)));
+}
+
+} // namespace gfx
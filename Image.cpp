@@ -0,0 +1,213 @@
+#include "Image.h"
+
+#include "ColoredVertex.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace gfx {
+
+namespace {
+
+bool Fail(std::string* error, const char* message) {
+    if (error) *error = message;
+    return false;
+}
+
+uint32_t ReadU16(const uint8_t* p) noexcept {
+    return p[0] | (uint32_t(p[1]) << 8);
+}
+
+// Reads one whitespace-separated header number of a PNM, skipping # comments.
+bool ReadPnmNumber(const uint8_t* data, size_t size, size_t& at, uint32_t& value) noexcept {
+    while (at < size) {
+        if (data[at] == '#') {
+            while (at < size && data[at] != '\n') ++at;
+        } else if (data[at] == ' ' || data[at] == '\t' || data[at] == '\r' || data[at] == '\n') {
+            ++at;
+        } else {
+            break;
+        }
+    }
+    if (at >= size || data[at] < '0' || data[at] > '9') return false;
+    uint64_t number = 0;
+    while (at < size && data[at] >= '0' && data[at] <= '9' && number <= 0xFFFFFFFFull) number = number * 10 + (data[at++] - '0');
+    value = static_cast<uint32_t>(number);
+    return number <= 0xFFFFFFFFull;
+}
+
+// Keeps decoded images within what a 32-bit pixel count and D3D11 textures allow.
+constexpr uint32_t MaxImageSize = 16384;
+
+} // namespace
+
+bool DecodeTga(const uint8_t* data, size_t size, Image& out, std::string* error) {
+    if (size < 18) return Fail(error, "truncated TGA header");
+    const uint32_t idLength = data[0];
+    const uint32_t colorMapType = data[1];
+    const uint32_t imageType = data[2];
+    const uint32_t colorMapLength = ReadU16(data + 5);
+    const uint32_t colorMapBits = data[7];
+    const uint32_t width = ReadU16(data + 12);
+    const uint32_t height = ReadU16(data + 14);
+    const uint32_t bits = data[16];
+    const uint32_t descriptor = data[17];
+
+    const bool rle = imageType == 10 || imageType == 11;
+    const bool gray = imageType == 3 || imageType == 11;
+    const bool color = imageType == 2 || imageType == 10;
+    if (colorMapType > 1 || !(gray || color) || (gray && bits != 8) || (color && bits != 24 && bits != 32)) {
+        return Fail(error, "unsupported TGA format");
+    }
+    if (width == 0 || height == 0 || width > MaxImageSize || height > MaxImageSize) return Fail(error, "unsupported TGA size");
+
+    size_t at = 18 + idLength + (colorMapType ? colorMapLength * ((colorMapBits + 7) / 8) : 0);
+    const uint32_t pixelBytes = bits / 8;
+    const size_t count = size_t(width) * height;
+    // RLE packets cover at most 128 pixels with at least one header and one pixel each.
+    const size_t minPayload = rle ? (count + 127) / 128 * (1 + pixelBytes) : count * pixelBytes;
+    if (at > size || size - at < minPayload) return Fail(error, "truncated TGA pixel data");
+    out.Resize(width, height);
+
+    auto readPixel = [&](const uint8_t* p) noexcept {
+        if (gray) return PackRGBA8(p[0], p[0], p[0], uint8_t(255));
+        return PackRGBA8(p[2], p[1], p[0], pixelBytes == 4 ? p[3] : uint8_t(255));
+    };
+    if (!rle) {
+        for (size_t i = 0; i < count; ++i) out.pixels[i] = readPixel(data + at + i * pixelBytes);
+    } else {
+        for (size_t i = 0; i < count;) {
+            if (at >= size) return Fail(error, "truncated TGA pixel data");
+            const uint32_t header = data[at++];
+            const size_t run = std::min<size_t>((header & 0x7F) + 1, count - i);
+            if (header & 0x80) {
+                if (size - at < pixelBytes) return Fail(error, "truncated TGA pixel data");
+                std::fill_n(out.pixels.begin() + i, run, readPixel(data + at));
+                at += pixelBytes;
+            } else {
+                if ((size - at) / pixelBytes < run) return Fail(error, "truncated TGA pixel data");
+                for (size_t k = 0; k < run; ++k) out.pixels[i + k] = readPixel(data + at + k * pixelBytes);
+                at += run * pixelBytes;
+            }
+            i += run;
+        }
+    }
+
+    // Descriptor bit 5 means rows are stored top first, bit 4 right to left.
+    if (!(descriptor & 0x20)) {
+        for (uint32_t y = 0; y < height / 2; ++y) {
+            std::swap_ranges(out.pixels.begin() + size_t(y) * width, out.pixels.begin() + size_t(y + 1) * width,
+                             out.pixels.begin() + size_t(height - 1 - y) * width);
+        }
+    }
+    if (descriptor & 0x10) {
+        for (uint32_t y = 0; y < height; ++y) std::reverse(out.pixels.begin() + size_t(y) * width, out.pixels.begin() + size_t(y + 1) * width);
+    }
+    return true;
+}
+
+bool DecodePnm(const uint8_t* data, size_t size, Image& out, std::string* error) {
+    if (size < 2 || data[0] != 'P' || (data[1] != '5' && data[1] != '6')) return Fail(error, "not a binary PGM/PPM file");
+    const uint32_t channels = data[1] == '6' ? 3 : 1;
+    size_t at = 2;
+    uint32_t width = 0, height = 0, maxValue = 0;
+    if (!ReadPnmNumber(data, size, at, width) || !ReadPnmNumber(data, size, at, height) ||
+        !ReadPnmNumber(data, size, at, maxValue) || at >= size) {
+        return Fail(error, "bad PNM header");
+    }
+    ++at; // single whitespace before the samples
+    if (width == 0 || height == 0 || width > MaxImageSize || height > MaxImageSize || maxValue == 0 || maxValue > 65535) {
+        return Fail(error, "unsupported PNM size or depth");
+    }
+
+    const uint32_t sampleBytes = maxValue > 255 ? 2 : 1;
+    const size_t count = size_t(width) * height;
+    if (at > size || (size - at) / (sampleBytes * channels) < count) return Fail(error, "truncated PNM pixel data");
+    out.Resize(width, height);
+
+    const uint8_t* p = data + at;
+    auto sample = [&](size_t index) noexcept {
+        uint32_t v = sampleBytes == 2 ? (uint32_t(p[index * 2]) << 8) | p[index * 2 + 1] : p[index];
+        return static_cast<uint8_t>(maxValue == 255 ? v : (std::min(v, maxValue) * 255 + maxValue / 2) / maxValue);
+    };
+    for (size_t i = 0; i < count; ++i) {
+        if (channels == 3) out.pixels[i] = PackRGBA8(sample(i * 3), sample(i * 3 + 1), sample(i * 3 + 2), uint8_t(255));
+        else {
+            uint8_t v = sample(i);
+            out.pixels[i] = PackRGBA8(v, v, v, uint8_t(255));
+        }
+    }
+    return true;
+}
+
+bool LoadImage(const char* path, Image& out, std::string* error) {
+    MappedFile file;
+    if (!file.Open(path)) return Fail(error, "cannot map image file");
+    if (file.Size() >= 2 && file.Data()[0] == 'P' && (file.Data()[1] == '5' || file.Data()[1] == '6')) {
+        return DecodePnm(file.Data(), file.Size(), out, error);
+    }
+    return DecodeTga(file.Data(), file.Size(), out, error);
+}
+
+bool WriteTga(const char* path, const Image& image, std::string* error) {
+    if (image.width == 0 || image.width > 0xFFFF || image.height == 0 || image.height > 0xFFFF) return Fail(error, "image size not representable in TGA");
+    uint8_t header[18] = {};
+    header[2] = 2;
+    header[12] = static_cast<uint8_t>(image.width);
+    header[13] = static_cast<uint8_t>(image.width >> 8);
+    header[14] = static_cast<uint8_t>(image.height);
+    header[15] = static_cast<uint8_t>(image.height >> 8);
+    header[16] = 32;
+    header[17] = 0x20 | 8;
+
+    std::vector<uint8_t> bgra(image.pixels.size() * 4);
+    for (size_t i = 0; i < image.pixels.size(); ++i) {
+        uint32_t p = image.pixels[i];
+        bgra[i * 4 + 0] = static_cast<uint8_t>(p >> 16);
+        bgra[i * 4 + 1] = static_cast<uint8_t>(p >> 8);
+        bgra[i * 4 + 2] = static_cast<uint8_t>(p);
+        bgra[i * 4 + 3] = static_cast<uint8_t>(p >> 24);
+    }
+    FILE* file = std::fopen(path, "wb");
+    if (!file) return Fail(error, "cannot create image file");
+    bool written = std::fwrite(header, sizeof(header), 1, file) == 1 && std::fwrite(bgra.data(), bgra.size(), 1, file) == 1;
+    written = std::fclose(file) == 0 && written;
+    return written || Fail(error, "cannot write image file");
+}
+
+bool WritePpm(const char* path, const Image& image, std::string* error) {
+    std::vector<uint8_t> rgb(image.pixels.size() * 3);
+    for (size_t i = 0; i < image.pixels.size(); ++i) {
+        uint32_t p = image.pixels[i];
+        rgb[i * 3 + 0] = static_cast<uint8_t>(p);
+        rgb[i * 3 + 1] = static_cast<uint8_t>(p >> 8);
+        rgb[i * 3 + 2] = static_cast<uint8_t>(p >> 16);
+    }
+    FILE* file = std::fopen(path, "wb");
+    if (!file) return Fail(error, "cannot create image file");
+    bool written = std::fprintf(file, "P6\n%u %u\n255\n", image.width, image.height) > 0 &&
+                   (rgb.empty() || std::fwrite(rgb.data(), rgb.size(), 1, file) == 1);
+    written = std::fclose(file) == 0 && written;
+    return written || Fail(error, "cannot write image file");
+}
+
+double ComputePsnr(const uint32_t* a, const uint32_t* b, size_t count, uint32_t channels) noexcept {
+    uint64_t squared = 0, samples = 0;
+    for (uint32_t c = 0; c < 4; ++c) {
+        if (!(channels & (1u << c))) continue;
+        const uint32_t shift = c * 8;
+        for (size_t i = 0; i < count; ++i) {
+            int32_t d = int32_t((a[i] >> shift) & 0xFF) - int32_t((b[i] >> shift) & 0xFF);
+            squared += uint64_t(d * d);
+        }
+        samples += count;
+    }
+    if (squared == 0 || samples == 0) return std::numeric_limits<double>::infinity();
+    double mse = double(squared) / double(samples);
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+} // namespace gfx
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gfx {
+
+// RGBA8 pixels, rows top to bottom, packed like ColoredVertex::rgba (red in the
+// lowest byte).
+struct Image {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint32_t> pixels;
+
+    void Resize(uint32_t w, uint32_t h) {
+        width = w;
+        height = h;
+        pixels.assign(static_cast<size_t>(w) * h, 0);
+    }
+};
+
+// Decodes TGA (truecolor 24/32-bit or 8-bit grayscale, raw or RLE) and binary PNM
+// (P5 grayscale, P6 RGB). The format is recognized from the content; missing alpha
+// becomes 255.
+bool DecodeTga(const uint8_t* data, size_t size, Image& out, std::string* error = nullptr);
+bool DecodePnm(const uint8_t* data, size_t size, Image& out, std::string* error = nullptr);
+
+// Maps the file and decodes it with DecodePnm or DecodeTga.
+bool LoadImage(const char* path, Image& out, std::string* error = nullptr);
+
+// Uncompressed 32-bit top-down TGA, and P6 PPM without alpha.
+bool WriteTga(const char* path, const Image& image, std::string* error = nullptr);
+bool WritePpm(const char* path, const Image& image, std::string* error = nullptr);
+
+// Channel bits for ComputePsnr, in the RGBA8 byte order.
+constexpr uint32_t PsnrRed = 1, PsnrGreen = 2, PsnrBlue = 4, PsnrAlpha = 8;
+constexpr uint32_t PsnrRgb = PsnrRed | PsnrGreen | PsnrBlue;
+
+// Peak signal-to-noise ratio in dB over the selected channels; infinite when the
+// images are identical.
+double ComputePsnr(const uint32_t* a, const uint32_t* b, size_t count, uint32_t channels = PsnrRgb) noexcept;
+
+} // namespace gfx
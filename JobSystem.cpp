@@ -0,0 +1,378 @@
+#include "JobSystem.h"
+
+#include "Profiler.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace gfx {
+
+namespace {
+
+// Spins before a worker yields, and yields before it sleeps.
+constexpr uint32_t IdleSpins = 64;
+constexpr uint32_t IdleYields = 64;
+constexpr uint32_t JobBlockSize = 256;
+
+struct ThreadSlot {
+    const JobSystem* system = nullptr;
+    uint32_t index = 0;
+};
+
+thread_local ThreadSlot t_slot;
+
+inline void CpuRelax() noexcept {
+#if GFX_X86
+    _mm_pause();
+#endif
+}
+
+inline uint32_t NextRandom(uint32_t& state) noexcept {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+void RunFunction(Job& job, uint32_t) {
+    job.fn();
+}
+
+} // namespace
+
+WorkStealingDeque::WorkStealingDeque(uint32_t capacity) {
+    int64_t size = 2;
+    while (size < capacity) size *= 2;
+    m_rings.emplace_back(new Ring(size));
+    m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+}
+
+WorkStealingDeque::~WorkStealingDeque() = default;
+
+void WorkStealingDeque::Push(Job* job) {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    const int64_t top = m_top.load(std::memory_order_acquire);
+    Ring* ring = m_ring.load(std::memory_order_relaxed);
+    if (bottom - top > ring->mask) ring = Grow(ring, top, bottom);
+    ring->Put(bottom, job);
+    m_bottom.store(bottom + 1, std::memory_order_release);
+}
+
+Job* WorkStealingDeque::Pop() noexcept {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    Ring* ring = m_ring.load(std::memory_order_relaxed);
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_relaxed);
+    if (top > bottom) {
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Job* job = ring->Get(bottom);
+    if (top == bottom) {
+        // Last job: race the thieves for it.
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* WorkStealingDeque::Steal() noexcept {
+    int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+    if (top >= bottom) return nullptr;
+    Job* job = m_ring.load(std::memory_order_acquire)->Get(top);
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+    return job;
+}
+
+WorkStealingDeque::Ring* WorkStealingDeque::Grow(Ring* ring, int64_t top, int64_t bottom) {
+    Ring* grown = new Ring((ring->mask + 1) * 2);
+    for (int64_t i = top; i < bottom; ++i) grown->Put(i, ring->Get(i));
+    m_rings.emplace_back(grown);
+    m_ring.store(grown, std::memory_order_release);
+    return grown;
+}
+
+struct JobSystem::Worker {
+    WorkStealingDeque deque;
+    // Jobs allocated by this thread: free ones it owns, and ones other threads
+    // finished and handed back (a lock-free stack the owner empties at once).
+    std::vector<Job*> freeJobs;
+    std::atomic<Job*> returned{ nullptr };
+    std::vector<std::unique_ptr<Job[]>> blocks;
+    uint32_t random = 0;
+};
+
+JobSystem::JobSystem(uint32_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) threadCount = 1;
+    }
+    m_threadCount = threadCount;
+    m_workers.reset(new Worker[threadCount]);
+    for (uint32_t i = 0; i < threadCount; ++i) m_workers[i].random = 0x9E3779B9u * (i + 1);
+
+    t_slot = { this, 0 };
+    m_threads.reserve(threadCount - 1);
+    for (uint32_t i = 1; i < threadCount; ++i) {
+        m_threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+    if (t_slot.system == this) t_slot = {};
+}
+
+uint32_t JobSystem::CurrentThread() const noexcept {
+    return t_slot.system == this ? t_slot.index : 0;
+}
+
+void JobSystem::Spawn(JobCounter& counter, std::function<void()> fn) {
+    const uint32_t thread = CurrentThread();
+    Job* job = Allocate(thread);
+    job->run = &RunFunction;
+    job->fn = std::move(fn);
+    Submit(job, &counter, thread);
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+    const uint32_t thread = CurrentThread();
+    uint32_t idle = 0;
+    while (!counter.Done()) {
+        if (Job* job = FindJob(thread)) {
+            Execute(job, thread);
+            idle = 0;
+        } else if (++idle < IdleSpins) {
+            CpuRelax();
+        } else {
+            // The jobs left are running elsewhere.
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grain, RangeFn fn, const void* userFn) {
+    if (count == 0) return;
+    const uint32_t thread = CurrentThread();
+    if (grain == 0) grain = std::max(1u, count / (m_threadCount * 8));
+    if (m_threadCount == 1 || count <= grain) {
+        fn(userFn, 0, count, thread);
+        return;
+    }
+    JobCounter counter;
+    const RangeContext context = { this, fn, userFn, grain, &counter };
+    SplitRange(context, 0, count, thread);
+    Wait(counter);
+}
+
+void JobSystem::RunRange(Job& job, uint32_t thread) {
+    const RangeContext& context = *static_cast<const RangeContext*>(job.context);
+    context.system->SplitRange(context, job.begin, job.end, thread);
+}
+
+void JobSystem::SplitRange(const RangeContext& context, uint32_t begin, uint32_t end, uint32_t thread) {
+    // The upper half is pushed first, so thieves find the largest piece at the top.
+    while (end - begin > context.grain) {
+        const uint32_t middle = begin + (end - begin) / 2;
+        Job* job = Allocate(thread);
+        job->run = &RunRange;
+        job->context = &context;
+        job->begin = middle;
+        job->end = end;
+        Submit(job, context.counter, thread);
+        end = middle;
+    }
+    context.fn(context.userFn, begin, end, thread);
+}
+
+Job* JobSystem::Allocate(uint32_t thread) {
+    Worker& worker = m_workers[thread];
+    if (worker.freeJobs.empty()) {
+        for (Job* job = worker.returned.exchange(nullptr, std::memory_order_acquire); job; job = job->next) {
+            worker.freeJobs.push_back(job);
+        }
+    }
+    if (worker.freeJobs.empty()) {
+        worker.blocks.emplace_back(new Job[JobBlockSize]);
+        Job* block = worker.blocks.back().get();
+        for (uint32_t i = 0; i < JobBlockSize; ++i) {
+            block[i].owner = thread;
+            worker.freeJobs.push_back(&block[i]);
+        }
+    }
+    Job* job = worker.freeJobs.back();
+    worker.freeJobs.pop_back();
+    return job;
+}
+
+void JobSystem::Submit(Job* job, JobCounter* counter, uint32_t thread) {
+    job->counter = counter;
+    if (counter) counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    m_workers[thread].deque.Push(job);
+
+    // Pairs with the fence in WorkerLoop: either the sleeper sees this job or we see the sleeper.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleepers.load(std::memory_order_relaxed) > 0) {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            ++m_wakeEpoch;
+        }
+        m_wake.notify_one();
+    }
+}
+
+void JobSystem::Execute(Job* job, uint32_t thread) {
+    job->run(*job, thread);
+    JobCounter* counter = job->counter;
+    job->fn = nullptr;
+
+    if (job->owner == thread) {
+        m_workers[thread].freeJobs.push_back(job);
+    } else {
+        std::atomic<Job*>& returned = m_workers[job->owner].returned;
+        job->next = returned.load(std::memory_order_relaxed);
+        while (!returned.compare_exchange_weak(job->next, job, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+    // Last: a finished counter may be destroyed by its waiter right away.
+    if (counter) counter->m_pending.fetch_sub(1, std::memory_order_release);
+}
+
+Job* JobSystem::FindJob(uint32_t thread) noexcept {
+    Worker& worker = m_workers[thread];
+    if (Job* job = worker.deque.Pop()) return job;
+    if (m_threadCount == 1) return nullptr;
+    const uint32_t start = NextRandom(worker.random) % m_threadCount;
+    for (uint32_t i = 0; i < m_threadCount; ++i) {
+        const uint32_t victim = (start + i) % m_threadCount;
+        if (victim == thread) continue;
+        if (Job* job = m_workers[victim].deque.Steal()) return job;
+    }
+    return nullptr;
+}
+
+bool JobSystem::AnyWork() const noexcept {
+    for (uint32_t i = 0; i < m_threadCount; ++i) {
+        if (!m_workers[i].deque.LooksEmpty()) return true;
+    }
+    return false;
+}
+
+void JobSystem::WorkerLoop(uint32_t thread) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "Job Worker %u", thread);
+    GetProfiler().SetThreadName(name);
+    t_slot = { this, thread };
+
+    uint32_t idle = 0;
+    for (;;) {
+        if (Job* job = FindJob(thread)) {
+            Execute(job, thread);
+            idle = 0;
+            continue;
+        }
+        if (++idle < IdleSpins) {
+            CpuRelax();
+            continue;
+        }
+        if (idle < IdleSpins + IdleYields) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        if (m_stop) return;
+        const uint64_t epoch = m_wakeEpoch;
+        m_sleepers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!AnyWork()) {
+            m_wake.wait(lock, [&] { return m_stop || m_wakeEpoch != epoch; });
+        }
+        m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        idle = 0;
+    }
+}
+
+TaskGraph::TaskId TaskGraph::Add(const char* name, std::function<void()> fn, std::initializer_list<TaskId> dependencies) {
+    const TaskId id = static_cast<TaskId>(m_tasks.size());
+    Task task;
+    task.name = name;
+    task.fn = std::move(fn);
+    task.dependencyCount = 0;
+    m_tasks.push_back(std::move(task));
+    for (TaskId dependency : dependencies) DependsOn(id, dependency);
+    return id;
+}
+
+bool TaskGraph::DependsOn(TaskId task, TaskId dependency) {
+    if (task >= m_tasks.size() || dependency >= task) return false;
+    m_tasks[dependency].successors.push_back(task);
+    ++m_tasks[task].dependencyCount;
+    return true;
+}
+
+void TaskGraph::Clear() noexcept {
+    m_tasks.clear();
+}
+
+void TaskGraph::Run(JobSystem& jobs) {
+    const uint32_t count = TaskCount();
+    if (count == 0) return;
+    if (m_remainingSize < count) {
+        m_remaining.reset(new std::atomic<uint32_t>[count]);
+        m_remainingSize = count;
+    }
+    for (uint32_t i = 0; i < count; ++i) m_remaining[i].store(m_tasks[i].dependencyCount, std::memory_order_relaxed);
+    m_done.m_pending.store(count, std::memory_order_relaxed);
+    m_running = &jobs;
+
+    const uint32_t thread = jobs.CurrentThread();
+    for (TaskId task = 0; task < count; ++task) {
+        if (m_tasks[task].dependencyCount == 0) Start(task, thread);
+    }
+    jobs.Wait(m_done);
+    m_running = nullptr;
+}
+
+void TaskGraph::Start(TaskId task, uint32_t thread) {
+    Job* job = m_running->Allocate(thread);
+    job->run = &RunTask;
+    job->context = this;
+    job->begin = task;
+    m_running->Submit(job, nullptr, thread);
+}
+
+void TaskGraph::RunTask(Job& job, uint32_t thread) {
+    TaskGraph& graph = *static_cast<TaskGraph*>(const_cast<void*>(job.context));
+    TaskId task = job.begin;
+    while (task != NoTask) {
+        const Task& current = graph.m_tasks[task];
+        {
+            GFX_PROFILE_SCOPE(current.name);
+            current.fn();
+        }
+        // Keep one ready successor for this thread and hand out the rest.
+        TaskId next = NoTask;
+        for (TaskId successor : current.successors) {
+            if (graph.m_remaining[successor].fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+            if (next != NoTask) graph.Start(next, thread);
+            next = successor;
+        }
+        // The graph may be gone once the count reaches zero, and it only can when next is NoTask.
+        graph.m_done.m_pending.fetch_sub(1, std::memory_order_release);
+        task = next;
+    }
+}
+
+} // namespace gfx
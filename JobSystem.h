@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gfx {
+
+// Number of jobs of a group that have not finished; Wait on it to join them.
+class JobCounter {
+public:
+    bool Done() const noexcept { return m_pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    friend class TaskGraph;
+    std::atomic<uint32_t> m_pending{ 0 };
+};
+
+// Unit of work in the deques. Jobs come from per-thread pools of the JobSystem;
+// run receives the job itself, so ranges and graph tasks need no allocation.
+struct Job {
+    void (*run)(Job& job, uint32_t thread);
+    const void* context;
+    uint32_t begin;
+    uint32_t end;
+    std::function<void()> fn;
+    JobCounter* counter;
+    Job* next;
+    uint32_t owner;
+};
+
+// Chase-Lev work-stealing deque (with the C11 orderings of Le et al. 2013). The
+// owning thread pushes and pops at the bottom; any thread steals from the top.
+// The ring doubles when full; outgrown rings stay alive until the deque is
+// destroyed because a thief may still be reading one.
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(uint32_t capacity = 1024);
+    ~WorkStealingDeque();
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Owner only.
+    void Push(Job* job);
+    Job* Pop() noexcept;
+    // Any thread; returns nullptr when empty or when another thread won the race.
+    Job* Steal() noexcept;
+
+    bool LooksEmpty() const noexcept {
+        return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Ring {
+        int64_t mask;
+        std::unique_ptr<std::atomic<Job*>[]> slots;
+
+        explicit Ring(int64_t capacity) : mask(capacity - 1), slots(new std::atomic<Job*>[static_cast<size_t>(capacity)]) {}
+        Job* Get(int64_t i) const noexcept { return slots[static_cast<size_t>(i & mask)].load(std::memory_order_relaxed); }
+        void Put(int64_t i, Job* job) noexcept { slots[static_cast<size_t>(i & mask)].store(job, std::memory_order_relaxed); }
+    };
+
+    Ring* Grow(Ring* ring, int64_t top, int64_t bottom);
+
+    alignas(64) std::atomic<int64_t> m_top{ 0 };
+    alignas(64) std::atomic<int64_t> m_bottom{ 0 };
+    std::atomic<Ring*> m_ring;
+    std::vector<std::unique_ptr<Ring>> m_rings;
+};
+
+// Work-stealing scheduler. Every thread owns a deque: spawned jobs go to the
+// spawning thread's deque, where they run LIFO, and idle threads steal the oldest
+// job of a random victim. The thread that creates the system is thread 0 and
+// runs jobs while it waits; idle workers spin briefly, then sleep until new work
+// is pushed. Spawn, Wait and ParallelFor may be called from thread 0 or from
+// inside jobs.
+class JobSystem {
+public:
+    // threadCount includes the caller; 0 picks std::thread::hardware_concurrency().
+    explicit JobSystem(uint32_t threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    uint32_t ThreadCount() const noexcept { return m_threadCount; }
+    // Index of the calling thread (0 for threads that are not workers).
+    uint32_t CurrentThread() const noexcept;
+
+    void Spawn(JobCounter& counter, std::function<void()> fn);
+    // Runs other jobs until every job spawned with counter has finished.
+    void Wait(JobCounter& counter);
+
+    // Calls fn(begin, end, thread) over sub-ranges of [0, count). The range is split
+    // in halves down to grain items, and the halves are left for thieves, so idle
+    // threads pick up large pieces first. grain 0 aims at about eight pieces per
+    // thread.
+    template<typename Fn>
+    void ParallelFor(uint32_t count, const Fn& fn, uint32_t grain = 0) {
+        ParallelFor(count, grain, &CallRange<Fn>, &fn);
+    }
+
+private:
+    struct Worker;
+    using RangeFn = void (*)(const void* fn, uint32_t begin, uint32_t end, uint32_t thread);
+
+    template<typename Fn>
+    static void CallRange(const void* fn, uint32_t begin, uint32_t end, uint32_t thread) {
+        (*static_cast<const Fn*>(fn))(begin, end, thread);
+    }
+
+    struct RangeContext {
+        JobSystem* system;
+        RangeFn fn;
+        const void* userFn;
+        uint32_t grain;
+        JobCounter* counter;
+    };
+
+    void ParallelFor(uint32_t count, uint32_t grain, RangeFn fn, const void* userFn);
+    static void RunRange(Job& job, uint32_t thread);
+    void SplitRange(const RangeContext& context, uint32_t begin, uint32_t end, uint32_t thread);
+
+    friend class TaskGraph;
+    Job* Allocate(uint32_t thread);
+    void Submit(Job* job, JobCounter* counter, uint32_t thread);
+    void Execute(Job* job, uint32_t thread);
+    Job* FindJob(uint32_t thread) noexcept;
+    void WorkerLoop(uint32_t thread);
+    bool AnyWork() const noexcept;
+
+    uint32_t m_threadCount = 1;
+    std::unique_ptr<Worker[]> m_workers;
+    std::vector<std::thread> m_threads;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::atomic<uint32_t> m_sleepers{ 0 };
+    uint64_t m_wakeEpoch = 0;
+    bool m_stop = false;
+};
+
+// Dependency graph of named tasks, built once and run every frame. A task starts
+// once every task it depends on has finished; the thread that finishes the last
+// dependency runs it directly and spawns any other successors that became ready.
+// Dependencies must be added before their dependents, so the graph cannot cycle.
+// Task names label profiler scopes and must be string literals.
+class TaskGraph {
+public:
+    using TaskId = uint32_t;
+
+    TaskId Add(const char* name, std::function<void()> fn, std::initializer_list<TaskId> dependencies = {});
+    // Makes task wait for dependency; false unless dependency was added before task.
+    bool DependsOn(TaskId task, TaskId dependency);
+    void Clear() noexcept;
+
+    uint32_t TaskCount() const noexcept { return static_cast<uint32_t>(m_tasks.size()); }
+    const char* Name(TaskId task) const noexcept { return m_tasks[task].name; }
+
+    // Runs every task once and returns when all have finished. The caller helps.
+    void Run(JobSystem& jobs);
+
+private:
+    struct Task {
+        const char* name;
+        std::function<void()> fn;
+        std::vector<TaskId> successors;
+        uint32_t dependencyCount;
+    };
+
+    static constexpr TaskId NoTask = ~0u;
+
+    static void RunTask(Job& job, uint32_t thread);
+    void Start(TaskId task, uint32_t thread);
+
+    std::vector<Task> m_tasks;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_remaining;
+    uint32_t m_remainingSize = 0;
+    JobSystem* m_running = nullptr;
+    JobCounter m_done;
+};
+
+} // namespace gfx
@@ -3,9 +3,32 @@
 #include <dxgi.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
+#include <algorithm>
+#include <exception>
 #include <vector>
+#include <string>
 #include <cassert>
 
+#include "Bvh.h"
+#include "Camera.h"
+#include "CubeMesh.h"
+#include "D3D11CommandDevice.h"
+#include "D3D11InputLayout.h"
+#include "D3D11ResourceDevice.h"
+#include "D3D11UploadBuffer.h"
+#include "D3DShaderCompiler.h"
+#include "DynamicResolution.h"
+#include "JobSystem.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "ParticleSystem.h"
+#include "Profiler.h"
+#include "Skinning.h"
+#include "ThreadPool.h"
+#include "TransformHierarchy.h"
+#include "VertexLayout.h"
+
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d3dcompiler.lib")
@@ -17,18 +40,107 @@ ID3D11Device* g_D3DDevice = nullptr;
 ID3D11DeviceContext* g_ImmediateContext = nullptr;
 IDXGISwapChain* g_SwapChain = nullptr;
 ID3D11RenderTargetView* g_RenderTarget = nullptr;
-
-ID3D11VertexShader* g_VS = nullptr;
-ID3D11PixelShader* g_PS = nullptr;
-ID3D11InputLayout* g_InputLayout = nullptr;
-ID3D11Buffer* g_VertexBuffer = nullptr;
-ID3D11Buffer* g_IndexBuffer = nullptr;
-
-ID3D11Buffer* g_ModelBuffer = nullptr;
-ID3D11Buffer* g_ViewProjBuffer = nullptr;
+ID3D11Texture2D* g_DepthBuffer = nullptr;
+ID3D11DepthStencilView* g_DepthStencil = nullptr;
+
+// The scene is drawn into the top-left corner of an output-sized texture at the
+// dynamic resolution, then stretched onto the back buffer.
+ID3D11Texture2D* g_SceneColor = nullptr;
+ID3D11RenderTargetView* g_SceneTarget = nullptr;
+ID3D11ShaderResourceView* g_SceneView = nullptr;
+ID3D11SamplerState* g_LinearSampler = nullptr;
+UINT g_OutputWidth = 0;
+UINT g_OutputHeight = 0;
+gfx::ResizeCoalescer g_Resize;
+gfx::DynamicResolution g_DynamicResolution;
+
+// Owns the scene's buffers, shaders and layouts; destroyed handles are released once
+// the frames that may still use them have retired.
+D3D11ResourceDevice g_ResourceDevice;
+gfx::ResourceRegistry g_Resources;
+gfx::ShaderHandle g_VS;
+gfx::ShaderHandle g_PS;
+gfx::InputLayoutHandle g_InputLayout;
+gfx::BufferHandle g_VertexBuffer;
+gfx::BufferHandle g_IndexBuffer;
+gfx::ShaderHandle g_UpscaleVS;
+gfx::ShaderHandle g_UpscalePS;
+gfx::BufferHandle g_UpscaleParams;
+gfx::ShaderHandle g_ParticleVS;
+gfx::ShaderHandle g_ParticlePS;
+gfx::BufferHandle g_ParticleParams;
+// Per-instance ParticleInstance data, rewritten every frame with WRITE_DISCARD.
+gfx::BufferHandle g_ParticleInstances;
+ID3D11InputLayout* g_ParticleLayout = nullptr;
+ID3D11BlendState* g_ParticleBlend = nullptr;
+ID3D11DepthStencilState* g_ParticleDepth = nullptr;
+using ParticleInstanceFormat = gfx::VertexLayout<gfx::VertexAttribute<gfx::VertexSemantic::Position, gfx::ElementFormat::R32G32B32_Float>,
+                                                 gfx::VertexAttribute<gfx::VertexSemantic::PointSize, gfx::ElementFormat::R32_Float>,
+                                                 gfx::VertexAttribute<gfx::VertexSemantic::Color, gfx::ElementFormat::R8G8B8A8_UNorm>>;
+static_assert(ParticleInstanceFormat::Stride == sizeof(gfx::ParticleInstance), "ParticleInstance layout");
+
+// Per-object model matrices and the frame's viewProj share one ring of 256-byte blocks.
+D3D11UploadBuffer g_ConstantUpload;
+
+D3D11CommandDevice g_CommandDevice;
+gfx::CommandBuffer g_CommandBuffer;
+gfx::CommandReplayer g_CommandReplayer;
+gfx::PassState g_MainPass = {};
+gfx::DrawCommand g_CubeDraw = {};
+// Skinned tentacles in world space, rewritten every frame with WRITE_DISCARD and
+// drawn once per tentacle with the cube's shaders, an identity model block and
+// each tentacle's base vertex.
+gfx::BufferHandle g_TentacleVertices;
+gfx::BufferHandle g_TentacleIndices;
+gfx::DrawCommand g_TentacleDraw = {};
+gfx::MeshFile g_Mesh;
+gfx::LodChain g_MeshLods;
+float g_MeshRadius = 0.0f;
+uint32_t g_CurrentLod = 0;
+gfx::TransformHierarchy g_Transforms;
+gfx::TransformId g_ModelNode = gfx::NoTransform;
+gfx::CachedCamera g_Camera;
+// Full-detail model triangles for mouse picking; the scene BVH follows the model's
+// world transform with a refit every frame. A click is stored by WM_LBUTTONDOWN and
+// resolved after the frame graph, once the camera is current.
+gfx::MeshBvh g_MeshBvh;
+gfx::InstanceBvh g_SceneBvh;
+uint32_t g_ModelInstance = 0;
+bool g_PickPending = false;
+int g_PickX = 0, g_PickY = 0;
+uint32_t g_PickedTriangle = gfx::NoHit;
+
+D3DShaderCompiler g_ShaderCompiler;
+gfx::ShaderCache g_ShaderCache("ShaderCache", g_ShaderCompiler);
 
 constexpr int WINDOW_WIDTH = 800;
 constexpr int WINDOW_HEIGHT = 600;
+constexpr UINT FRAMES_IN_FLIGHT = 3;
+constexpr UINT CONSTANT_UPLOAD_BYTES = 256 * 1024;
+constexpr float LOD_MAX_ERROR = 0.005f;
+constexpr float LOD_MAX_PIXELS = 1.0f;
+constexpr UINT PARTICLE_CAPACITY = 1u << 20;
+constexpr UINT TENTACLE_COUNT = 8;
+
+// CPU part of the frame; see BuildFrameGraph. g_WorkerPool hands the batches of
+// the particle, skinning and BVH code to g_Jobs, so one set of workers runs it all.
+gfx::JobSystem g_Jobs;
+gfx::TaskGraph g_FrameGraph;
+gfx::ThreadPool g_WorkerPool(g_Jobs);
+gfx::ParticleSystem g_Particles(PARTICLE_CAPACITY);
+gfx::ParticleEmitter g_ParticleEmitter;
+UINT g_ParticleCount = 0;
+gfx::Skeleton g_TentacleSkeleton;
+gfx::SkinnedMesh g_TentacleMesh;
+gfx::AnimationClip g_TentacleSway;
+gfx::AnimationClip g_TentacleCurl;
+gfx::CrowdAnimator g_Tentacles(g_TentacleSkeleton, g_TentacleMesh);
+
+float g_FrameDt = 0.0f;
+// False when the constant ring could not be mapped; the frame then skips the draws that read it.
+bool g_ConstantsMapped = false;
+gfx::ParticleInstance* g_MappedParticles = nullptr;
+ColoredVertex* g_MappedTentacles = nullptr;
 
 float g_CamPhi = 0.0f;
 float g_CamTheta = XM_PIDIV2;
@@ -36,6 +148,7 @@ float g_CamDist = 3.0f;
 
 LARGE_INTEGER g_StartTime, g_Freq;
 float g_TotalTime = 0.0f;
+float g_StatsTimer = 0.0f;
 
 LRESULT CALLBACK WindowProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -88,49 +201,166 @@ float4 main(PS_INPUT input) : SV_Target {
 }
 )";
 
-struct ColoredVertex {
-    float position[3];
-    uint32_t rgba;
+// Full-screen triangle that samples the rendered corner of the scene texture.
+static const char* g_Upscale_Source = R"(
+cbuffer UpscaleBuffer : register(b0)
+{
+    float2 uvScale;
+    float2 uvMax;
 };
-
-
-static const ColoredVertex g_Vertices[] = {
-    { { -0.5f, -0.5f, -0.5f }, 0x00FF0000 }, 
-    { {  0.5f, -0.5f, -0.5f }, 0x0000FF00 }, 
-    { {  0.5f,  0.5f, -0.5f }, 0x000000FF }, 
-    { { -0.5f,  0.5f, -0.5f }, 0x00FFFF00 }, 
-    { { -0.5f, -0.5f,  0.5f }, 0x00FF00FF }, 
-    { {  0.5f, -0.5f,  0.5f }, 0x0000FFFF }, 
-    { {  0.5f,  0.5f,  0.5f }, 0x00FFFFFF }, 
-    { { -0.5f,  0.5f,  0.5f }, 0x00000000 }  
+Texture2D sceneColor : register(t0);
+SamplerState linearSampler : register(s0);
+struct VS_OUTPUT {
+    float4 pos : SV_Position;
+    float2 uv : TEXCOORD0;
 };
+VS_OUTPUT vs_main(uint id : SV_VertexID) {
+    VS_OUTPUT output;
+    float2 uv = float2((id << 1) & 2, id & 2);
+    output.pos = float4(uv * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+    output.uv = uv;
+    return output;
+}
+float4 ps_main(VS_OUTPUT input) : SV_Target {
+    return sceneColor.Sample(linearSampler, min(input.uv * uvScale, uvMax));
+}
+)";
 
-
-static const uint16_t g_Indices[] = {
-    0, 1, 2,  0, 2, 3,
-    4, 6, 5,  4, 7, 6,
-    0, 3, 7,  0, 7, 4,
-    1, 5, 6,  1, 6, 2,
-    3, 2, 6,  3, 6, 7,
-    0, 4, 5,  0, 5, 1 
+// Camera-facing particle quads, one instance per particle. The corner offset is
+// added in clip space, scaled by the projection, so size is in world units.
+static const char* g_Particle_Source = R"(
+cbuffer ParticleBuffer : register(b0)
+{
+    row_major float4x4 viewProj;
+    float2 clipScale;
 };
+struct VS_INPUT {
+    float3 pos : POSITION;
+    float size : PSIZE;
+    float4 color : COLOR;
+    uint corner : SV_VertexID;
+};
+struct VS_OUTPUT {
+    float4 pos : SV_Position;
+    float4 color : COLOR;
+    float2 offset : TEXCOORD0;
+};
+VS_OUTPUT vs_main(VS_INPUT input) {
+    VS_OUTPUT output;
+    // Corners 0..3 go top-left, top-right, bottom-left, bottom-right, so the strip
+    // winds clockwise and survives the default back-face culling.
+    float2 offset = float2(input.corner & 1, input.corner >> 1) * float2(2.0, -2.0) + float2(-1.0, 1.0);
+    output.pos = mul(float4(input.pos, 1.0), viewProj);
+    output.pos.xy += offset * input.size * clipScale;
+    output.color = input.color;
+    output.offset = offset;
+    return output;
+}
+float4 ps_main(VS_OUTPUT input) : SV_Target {
+    float falloff = saturate(1.0 - dot(input.offset, input.offset));
+    return float4(input.color.rgb, input.color.a * falloff);
+}
+)";
 
-static ID3DBlob* CompileShaderFromString(const char* source, const char* entryPoint, const char* profile, const char* debugName) noexcept {
-    UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
-    ID3DBlob* code = nullptr;
-    ID3DBlob* errors = nullptr;
-    HRESULT hr = D3DCompile(source, strlen(source), debugName, nullptr, nullptr, entryPoint, profile, flags, 0, &code, &errors);
-    if (FAILED(hr)) {
-        if (errors) {
-            const char* msg = static_cast<const char*>(errors->GetBufferPointer());
-            OutputDebugStringA(msg);
-            MessageBoxA(nullptr, msg, "Shader Compilation Error", MB_ICONERROR);
-            utils::SafeRelease(errors);
+static bool CompileShaderFromString(const char* source, const char* entryPoint, const char* profile, const char* debugName, gfx::ShaderBytecode& bytecode) noexcept {
+    gfx::ShaderCompileRequest request = {};
+    request.source = source;
+    request.sourceSize = strlen(source);
+    request.entryPoint = entryPoint;
+    request.profile = profile;
+    request.flags = D3DCOMPILE_ENABLE_STRICTNESS;
+    request.debugName = debugName;
+
+    // The cache allocates and may throw; callers of this noexcept helper only see false.
+    std::string errors;
+    bool loaded = false;
+    try {
+        loaded = g_ShaderCache.Load(request, bytecode, &errors);
+    } catch (const std::exception& e) {
+        errors = e.what();
+    }
+    if (!loaded) {
+        if (!errors.empty()) {
+            OutputDebugStringA(errors.c_str());
+            MessageBoxA(nullptr, errors.c_str(), "Shader Compilation Error", MB_ICONERROR);
         }
-        return nullptr;
+        return false;
     }
-    utils::SafeRelease(errors);
-    return code;
+    return true;
+}
+
+// Back buffer view plus the output-sized scene color and depth targets.
+static HRESULT CreateFrameTargets(UINT width, UINT height) noexcept {
+    ID3D11Texture2D* backBuffer = nullptr;
+    HRESULT hr = g_SwapChain->GetBuffer(0, IID_ID3D11Texture2D, reinterpret_cast<void**>(&backBuffer));
+    if (FAILED(hr)) return hr;
+
+    hr = g_D3DDevice->CreateRenderTargetView(backBuffer, nullptr, &g_RenderTarget);
+    utils::SafeRelease(backBuffer);
+    if (FAILED(hr)) return hr;
+
+    D3D11_TEXTURE2D_DESC colorDesc = {};
+    colorDesc.Width = width;
+    colorDesc.Height = height;
+    colorDesc.MipLevels = 1;
+    colorDesc.ArraySize = 1;
+    colorDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    colorDesc.SampleDesc.Count = 1;
+    colorDesc.Usage = D3D11_USAGE_DEFAULT;
+    colorDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    hr = g_D3DDevice->CreateTexture2D(&colorDesc, nullptr, &g_SceneColor);
+    if (FAILED(hr)) return hr;
+
+    hr = g_D3DDevice->CreateRenderTargetView(g_SceneColor, nullptr, &g_SceneTarget);
+    if (FAILED(hr)) return hr;
+
+    hr = g_D3DDevice->CreateShaderResourceView(g_SceneColor, nullptr, &g_SceneView);
+    if (FAILED(hr)) return hr;
+
+    D3D11_TEXTURE2D_DESC depthDesc = colorDesc;
+    depthDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+    depthDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+    hr = g_D3DDevice->CreateTexture2D(&depthDesc, nullptr, &g_DepthBuffer);
+    if (FAILED(hr)) return hr;
+
+    hr = g_D3DDevice->CreateDepthStencilView(g_DepthBuffer, nullptr, &g_DepthStencil);
+    if (FAILED(hr)) return hr;
+
+    g_OutputWidth = width;
+    g_OutputHeight = height;
+    return S_OK;
+}
+
+static void ReleaseFrameTargets() noexcept {
+    using utils::SafeRelease;
+    SafeRelease(g_DepthStencil);
+    SafeRelease(g_DepthBuffer);
+    SafeRelease(g_SceneView);
+    SafeRelease(g_SceneTarget);
+    SafeRelease(g_SceneColor);
+    SafeRelease(g_RenderTarget);
+}
+
+// Called from the render loop with the last size WM_SIZE reported, at most once per
+// frame. ResizeBuffers fails while any back buffer reference is alive, including the
+// context's own binding.
+static HRESULT ResizeFrameTargets(UINT width, UINT height) noexcept {
+    GFX_PROFILE_SCOPE("ResizeFrameTargets");
+    g_ImmediateContext->OMSetRenderTargets(0, nullptr, nullptr);
+    ID3D11ShaderResourceView* noView = nullptr;
+    g_ImmediateContext->PSSetShaderResources(0, 1, &noView);
+    ReleaseFrameTargets();
+
+    HRESULT hr = g_SwapChain->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN, 0);
+    if (FAILED(hr)) return hr;
+    hr = CreateFrameTargets(width, height);
+    if (FAILED(hr)) return hr;
+
+    g_CommandDevice.ReplaceRenderTarget(g_MainPass.renderTarget, g_SceneTarget);
+    g_CommandDevice.ReplaceDepthTarget(g_MainPass.depthTarget, g_DepthStencil);
+    g_CommandReplayer.Invalidate();
+    g_Camera.SetPerspective(XM_PIDIV4, static_cast<float>(width) / static_cast<float>(height), 0.1f, 100.0f);
+    return S_OK;
 }
 
 static HRESULT CreateD3DResources(HWND hTargetWindow) noexcept {
@@ -155,171 +385,483 @@ static HRESULT CreateD3DResources(HWND hTargetWindow) noexcept {
     hr = D3D11CreateDeviceAndSwapChain(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, 0, &requestedLevel, 1, D3D11_SDK_VERSION, &scDesc, &g_SwapChain, &g_D3DDevice, &obtainedLevel, &g_ImmediateContext);
     if (FAILED(hr)) return hr;
 
-    ID3D11Texture2D* backBuffer = nullptr;
-    hr = g_SwapChain->GetBuffer(0, IID_ID3D11Texture2D, reinterpret_cast<void**>(&backBuffer));
+    hr = CreateFrameTargets(WINDOW_WIDTH, WINDOW_HEIGHT);
     if (FAILED(hr)) return hr;
 
-    hr = g_D3DDevice->CreateRenderTargetView(backBuffer, nullptr, &g_RenderTarget);
-    utils::SafeRelease(backBuffer);
-    if (FAILED(hr)) return hr;
+    // Keeps the CPU close enough behind the GPU for the constant ring's frame fences.
+    IDXGIDevice1* dxgiDevice = nullptr;
+    if (SUCCEEDED(g_D3DDevice->QueryInterface(__uuidof(IDXGIDevice1), reinterpret_cast<void**>(&dxgiDevice)))) {
+        dxgiDevice->SetMaximumFrameLatency(FRAMES_IN_FLIGHT - 1);
+        utils::SafeRelease(dxgiDevice);
+    }
 
-    g_ImmediateContext->OMSetRenderTargets(1, &g_RenderTarget, nullptr);
+    g_ResourceDevice.Initialize(g_D3DDevice);
+    g_Resources.Initialize(&g_ResourceDevice, FRAMES_IN_FLIGHT);
+
+    g_ImmediateContext->OMSetRenderTargets(1, &g_SceneTarget, g_DepthStencil);
     return S_OK;
 }
 
 static HRESULT CreateSceneAssets() noexcept {
     HRESULT hr = S_OK;
 
-    D3D11_BUFFER_DESC vbDesc = {};
-    vbDesc.ByteWidth = sizeof(g_Vertices);
-    vbDesc.Usage = D3D11_USAGE_IMMUTABLE;
-    vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    D3D11_SUBRESOURCE_DATA vbInitData = {};
-    vbInitData.pSysMem = g_Vertices;
-    hr = g_D3DDevice->CreateBuffer(&vbDesc, &vbInitData, &g_VertexBuffer);
-    if (FAILED(hr)) return hr;
+    // Vertices of a mesh file given on the command line are uploaded straight from its
+    // mapping; indices are widened to 32 bits for building the LOD chain.
+    const gfx::MeshVertexLayout vertexLayout = gfx::ColoredVertexLayout();
+    const void* vertexData = g_CubeVertices;
+    UINT vertexBytes = sizeof(g_CubeVertices);
+    UINT vertexCount = _countof(g_CubeVertices);
+    std::vector<uint32_t> indices(g_CubeIndices, g_CubeIndices + _countof(g_CubeIndices));
+    float boundsMin[3] = { -0.5f, -0.5f, -0.5f };
+    float boundsMax[3] = { 0.5f, 0.5f, 0.5f };
+    if (g_Mesh.IsOpen()) {
+        vertexData = g_Mesh.VertexData();
+        vertexBytes = static_cast<UINT>(g_Mesh.VertexBytes());
+        vertexCount = static_cast<UINT>(g_Mesh.VertexCount());
+        indices.resize(g_Mesh.IndexCount());
+        if (g_Mesh.GetIndexFormat() == gfx::IndexFormat::UInt16) {
+            const uint16_t* source = static_cast<const uint16_t*>(g_Mesh.IndexData());
+            std::copy(source, source + indices.size(), indices.begin());
+        } else {
+            memcpy(indices.data(), g_Mesh.IndexData(), g_Mesh.IndexBytes());
+        }
+        memcpy(boundsMin, g_Mesh.Header().boundsMin, sizeof(boundsMin));
+        memcpy(boundsMax, g_Mesh.Header().boundsMax, sizeof(boundsMax));
+    }
 
-    D3D11_BUFFER_DESC ibDesc = {};
-    ibDesc.ByteWidth = sizeof(g_Indices);
-    ibDesc.Usage = D3D11_USAGE_IMMUTABLE;
-    ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-    D3D11_SUBRESOURCE_DATA ibInitData = {};
-    ibInitData.pSysMem = g_Indices;
-    hr = g_D3DDevice->CreateBuffer(&ibDesc, &ibInitData, &g_IndexBuffer);
-    if (FAILED(hr)) return hr;
+    // All levels share the vertex buffer and live one after another in the index buffer.
+    float diagonalSq = 0.0f, centerSq = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+        float e = boundsMax[k] - boundsMin[k], c = 0.5f * (boundsMax[k] + boundsMin[k]);
+        diagonalSq += e * e;
+        centerSq += c * c;
+    }
+    float diagonal = sqrtf(diagonalSq);
+    g_MeshRadius = sqrtf(centerSq) + diagonal * 0.5f;
+    g_MeshBvh.Build({ vertexData, vertexLayout.stride, vertexCount, indices.data(), static_cast<uint32_t>(indices.size() / 3) }, &g_WorkerPool);
+    gfx::BuildLodChain(indices.data(), indices.size(), vertexData, vertexLayout.stride, vertexCount, diagonal * LOD_MAX_ERROR, g_MeshLods);
 
-    ID3DBlob* vsBlob = CompileShaderFromString(g_VS_Source, "main", "vs_5_0", "cube_vs.hlsl");
-    if (!vsBlob) return E_FAIL;
-    hr = g_D3DDevice->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &g_VS);
-    if (FAILED(hr)) { utils::SafeRelease(vsBlob); return hr; }
+    const gfx::IndexFormat indexFormat = gfx::ChooseIndexFormat(vertexCount);
+    std::vector<uint8_t> indexData(g_MeshLods.indices.size() * gfx::IndexSize(indexFormat));
+    gfx::PackIndices(indexData.data(), g_MeshLods.indices.data(), g_MeshLods.indices.size(), indexFormat);
+    const UINT indexBytes = static_cast<UINT>(indexData.size());
 
-    ID3DBlob* psBlob = CompileShaderFromString(g_PS_Source, "main", "ps_5_0", "cube_ps.hlsl");
-    if (!psBlob) { utils::SafeRelease(vsBlob); return E_FAIL; }
-    hr = g_D3DDevice->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &g_PS);
-    if (FAILED(hr)) { utils::SafeRelease(vsBlob); utils::SafeRelease(psBlob); return hr; }
+    g_VertexBuffer = g_Resources.CreateBuffer({ vertexBytes, gfx::BufferUsage::Immutable, gfx::BindVertexBuffer }, vertexData);
+    if (!g_VertexBuffer) return g_ResourceDevice.LastError();
 
-    D3D11_INPUT_ELEMENT_DESC layout[] = {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(ColoredVertex, position), D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "COLOR",    0, DXGI_FORMAT_R8G8B8A8_UNORM,   0, offsetof(ColoredVertex, rgba),      D3D11_INPUT_PER_VERTEX_DATA, 0 }
-    };
-    hr = g_D3DDevice->CreateInputLayout(layout, _countof(layout), vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &g_InputLayout);
-    utils::SafeRelease(vsBlob);
-    utils::SafeRelease(psBlob);
+    g_IndexBuffer = g_Resources.CreateBuffer({ indexBytes, gfx::BufferUsage::Immutable, gfx::BindIndexBuffer }, indexData.data());
+    if (!g_IndexBuffer) return g_ResourceDevice.LastError();
+
+    gfx::ShaderBytecode vsCode;
+    if (!CompileShaderFromString(g_VS_Source, "main", "vs_5_0", "cube_vs.hlsl", vsCode)) return E_FAIL;
+    g_VS = g_Resources.CreateShader(gfx::ShaderStage::Vertex, vsCode.Data(), vsCode.Size());
+    if (!g_VS) return g_ResourceDevice.LastError();
+
+    gfx::ShaderBytecode psCode;
+    if (!CompileShaderFromString(g_PS_Source, "main", "ps_5_0", "cube_ps.hlsl", psCode)) return E_FAIL;
+    g_PS = g_Resources.CreateShader(gfx::ShaderStage::Pixel, psCode.Data(), psCode.Size());
+    if (!g_PS) return g_ResourceDevice.LastError();
+
+    g_InputLayout = g_Resources.CreateInputLayout(vertexLayout, vsCode.Data(), vsCode.Size());
+    if (!g_InputLayout) return g_ResourceDevice.LastError();
+
+    hr = g_ConstantUpload.Initialize(g_D3DDevice, g_ImmediateContext, CONSTANT_UPLOAD_BYTES, FRAMES_IN_FLIGHT);
+    if (FAILED(hr)) return hr;
+
+    g_CommandDevice.Initialize(g_ImmediateContext);
+    g_MainPass.renderTarget = g_CommandDevice.AddRenderTarget(g_SceneTarget);
+    g_MainPass.depthTarget = g_CommandDevice.AddDepthTarget(g_DepthStencil);
+
+    g_CubeDraw.pipeline = g_CommandDevice.AddPipeline(GetD3D11VertexShader(g_Resources, g_VS), GetD3D11PixelShader(g_Resources, g_PS),
+                                                      GetD3D11InputLayout(g_Resources, g_InputLayout), D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    g_CubeDraw.vertexBuffer = g_CommandDevice.AddBuffer(GetD3D11Buffer(g_Resources, g_VertexBuffer));
+    g_CubeDraw.vertexStride = vertexLayout.stride;
+    g_CubeDraw.indexBuffer = g_CommandDevice.AddBuffer(GetD3D11Buffer(g_Resources, g_IndexBuffer));
+    g_CubeDraw.indexFormat = indexFormat;
+    g_CubeDraw.constantBuffers[0] = g_CommandDevice.AddUploadBuffer(&g_ConstantUpload);
+    g_CubeDraw.constantBuffers[1] = g_CubeDraw.constantBuffers[0];
+    g_CubeDraw.indexCount = g_MeshLods.lods[0].indexCount;
+
+    gfx::ShaderBytecode upscaleVsCode;
+    if (!CompileShaderFromString(g_Upscale_Source, "vs_main", "vs_5_0", "upscale.hlsl", upscaleVsCode)) return E_FAIL;
+    g_UpscaleVS = g_Resources.CreateShader(gfx::ShaderStage::Vertex, upscaleVsCode.Data(), upscaleVsCode.Size());
+    if (!g_UpscaleVS) return g_ResourceDevice.LastError();
+
+    gfx::ShaderBytecode upscalePsCode;
+    if (!CompileShaderFromString(g_Upscale_Source, "ps_main", "ps_5_0", "upscale.hlsl", upscalePsCode)) return E_FAIL;
+    g_UpscalePS = g_Resources.CreateShader(gfx::ShaderStage::Pixel, upscalePsCode.Data(), upscalePsCode.Size());
+    if (!g_UpscalePS) return g_ResourceDevice.LastError();
+
+    g_UpscaleParams = g_Resources.CreateBuffer({ 16, gfx::BufferUsage::Default, gfx::BindConstantBuffer }, nullptr);
+    if (!g_UpscaleParams) return g_ResourceDevice.LastError();
+
+    gfx::ShaderBytecode particleVsCode;
+    if (!CompileShaderFromString(g_Particle_Source, "vs_main", "vs_5_0", "particles.hlsl", particleVsCode)) return E_FAIL;
+    g_ParticleVS = g_Resources.CreateShader(gfx::ShaderStage::Vertex, particleVsCode.Data(), particleVsCode.Size());
+    if (!g_ParticleVS) return g_ResourceDevice.LastError();
+
+    gfx::ShaderBytecode particlePsCode;
+    if (!CompileShaderFromString(g_Particle_Source, "ps_main", "ps_5_0", "particles.hlsl", particlePsCode)) return E_FAIL;
+    g_ParticlePS = g_Resources.CreateShader(gfx::ShaderStage::Pixel, particlePsCode.Data(), particlePsCode.Size());
+    if (!g_ParticlePS) return g_ResourceDevice.LastError();
+
+    // The registry's input layouts are per-vertex; this one steps once per instance.
+    constexpr auto particleElements = MakeInputElements<ParticleInstanceFormat>(0, D3D11_INPUT_PER_INSTANCE_DATA, 1);
+    hr = g_D3DDevice->CreateInputLayout(particleElements.data(), static_cast<UINT>(particleElements.size()), particleVsCode.Data(), particleVsCode.Size(), &g_ParticleLayout);
+    if (FAILED(hr)) return hr;
+
+    g_ParticleParams = g_Resources.CreateBuffer({ 80, gfx::BufferUsage::Default, gfx::BindConstantBuffer }, nullptr);
+    if (!g_ParticleParams) return g_ResourceDevice.LastError();
+
+    g_ParticleInstances = g_Resources.CreateBuffer({ PARTICLE_CAPACITY * sizeof(gfx::ParticleInstance), gfx::BufferUsage::Dynamic, gfx::BindVertexBuffer }, nullptr);
+    if (!g_ParticleInstances) return g_ResourceDevice.LastError();
+
+    // Additive, so the unsorted particles blend the same in any order; depth-tested
+    // against the scene without writing depth.
+    D3D11_BLEND_DESC blendDesc = {};
+    blendDesc.RenderTarget[0].BlendEnable = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ZERO;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    hr = g_D3DDevice->CreateBlendState(&blendDesc, &g_ParticleBlend);
     if (FAILED(hr)) return hr;
 
-    D3D11_BUFFER_DESC modelDesc = {};
-    modelDesc.ByteWidth = sizeof(XMFLOAT4X4);
-    modelDesc.Usage = D3D11_USAGE_DEFAULT;
-    modelDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    modelDesc.CPUAccessFlags = 0;
-    hr = g_D3DDevice->CreateBuffer(&modelDesc, nullptr, &g_ModelBuffer);
+    D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+    depthDesc.DepthEnable = TRUE;
+    depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    depthDesc.DepthFunc = D3D11_COMPARISON_LESS;
+    hr = g_D3DDevice->CreateDepthStencilState(&depthDesc, &g_ParticleDepth);
     if (FAILED(hr)) return hr;
 
-    D3D11_BUFFER_DESC vpDesc = {};
-    vpDesc.ByteWidth = sizeof(XMFLOAT4X4);
-    vpDesc.Usage = D3D11_USAGE_DYNAMIC;
-    vpDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    vpDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    hr = g_D3DDevice->CreateBuffer(&vpDesc, nullptr, &g_ViewProjBuffer);
+    gfx::ParticleSettings particleSettings;
+    particleSettings.groundHeight = -1.0f;
+    particleSettings.startSize = 0.02f;
+    particleSettings.endSize = 0.005f;
+    g_Particles.SetSettings(particleSettings);
+    g_ParticleEmitter.position = { 0.0f, 0.9f, 0.0f };
+    g_ParticleEmitter.velocity = { 0.0f, 3.0f, 0.0f };
+    g_ParticleEmitter.velocitySpread = 1.2f;
+    g_ParticleEmitter.rate = 500000.0f;
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    hr = g_D3DDevice->CreateSamplerState(&samplerDesc, &g_LinearSampler);
     if (FAILED(hr)) return hr;
 
+    // A ring of tentacles standing on the particles' ground plane around the model.
+    gfx::BuildTentacle(gfx::TentacleDesc{}, g_TentacleSkeleton, g_TentacleMesh);
+    g_TentacleSway = gfx::MakeSwayClip(g_TentacleSkeleton, 2.0f, { 0.0f, 0.0f, 1.0f }, 0.35f, 0.6f);
+    g_TentacleCurl = gfx::MakeSwayClip(g_TentacleSkeleton, 3.1f, { 1.0f, 0.0f, 0.0f }, 0.25f, 0.3f);
+    for (UINT i = 0; i < TENTACLE_COUNT; ++i) {
+        const float angle = XM_2PI * static_cast<float>(i) / static_cast<float>(TENTACLE_COUNT);
+        gfx::CharacterState state;
+        state.clip = &g_TentacleSway;
+        state.time = 0.25f * static_cast<float>(i);
+        state.blendClip = &g_TentacleCurl;
+        state.blendWeight = 0.5f;
+        state.world = gfx::Multiply(gfx::MatrixRotationY(-angle), gfx::MatrixTranslation(1.5f * cosf(angle), -1.0f, 1.5f * sinf(angle)));
+        g_Tentacles.Add(state);
+    }
+
+    const UINT tentacleVertexBytes = g_Tentacles.VertexCount() * sizeof(ColoredVertex);
+    g_TentacleVertices = g_Resources.CreateBuffer({ tentacleVertexBytes, gfx::BufferUsage::Dynamic, gfx::BindVertexBuffer }, nullptr);
+    if (!g_TentacleVertices) return g_ResourceDevice.LastError();
+
+    const gfx::IndexFormat tentacleIndexFormat = gfx::ChooseIndexFormat(g_TentacleMesh.VertexCount());
+    std::vector<uint8_t> tentacleIndexData(g_TentacleMesh.indices.size() * gfx::IndexSize(tentacleIndexFormat));
+    gfx::PackIndices(tentacleIndexData.data(), g_TentacleMesh.indices.data(), g_TentacleMesh.indices.size(), tentacleIndexFormat);
+    g_TentacleIndices = g_Resources.CreateBuffer({ static_cast<UINT>(tentacleIndexData.size()), gfx::BufferUsage::Immutable, gfx::BindIndexBuffer }, tentacleIndexData.data());
+    if (!g_TentacleIndices) return g_ResourceDevice.LastError();
+
+    g_TentacleDraw = g_CubeDraw;
+    g_TentacleDraw.vertexBuffer = g_CommandDevice.AddBuffer(GetD3D11Buffer(g_Resources, g_TentacleVertices));
+    g_TentacleDraw.vertexStride = gfx::ColoredVertexFormat::Stride;
+    g_TentacleDraw.indexBuffer = g_CommandDevice.AddBuffer(GetD3D11Buffer(g_Resources, g_TentacleIndices));
+    g_TentacleDraw.indexFormat = tentacleIndexFormat;
+    g_TentacleDraw.startIndex = 0;
+    g_TentacleDraw.indexCount = static_cast<uint32_t>(g_TentacleMesh.indices.size());
+
+    g_ModelNode = g_Transforms.Add(gfx::MatrixIdentity());
+    g_ModelInstance = g_SceneBvh.AddInstance(g_MeshBvh, gfx::MatrixIdentity());
+    g_SceneBvh.Build();
+    g_Camera.SetPerspective(XM_PIDIV4, static_cast<float>(g_OutputWidth) / static_cast<float>(g_OutputHeight), 0.1f, 100.0f);
+
     return S_OK;
 }
 
 static void DestroyD3DResources() noexcept {
     using utils::SafeRelease;
-    SafeRelease(g_ModelBuffer);
-    SafeRelease(g_ViewProjBuffer);
-    SafeRelease(g_InputLayout);
-    SafeRelease(g_PS);
-    SafeRelease(g_VS);
-    SafeRelease(g_IndexBuffer);
-    SafeRelease(g_VertexBuffer);
-    SafeRelease(g_RenderTarget);
+    g_CommandReplayer.Invalidate();
+    g_CommandDevice.Clear();
+    g_ConstantUpload.Release();
+    g_Resources.Clear();
+    SafeRelease(g_LinearSampler);
+    SafeRelease(g_ParticleLayout);
+    SafeRelease(g_ParticleBlend);
+    SafeRelease(g_ParticleDepth);
+    ReleaseFrameTargets();
     SafeRelease(g_SwapChain);
     SafeRelease(g_ImmediateContext);
     SafeRelease(g_D3DDevice);
 }
 
 static void UpdateModelBuffer(float dt) {
+    GFX_PROFILE_SCOPE("UpdateModelBuffer");
     static float angle = 0.0f;
     angle += dt * 0.5f;
 
-    XMMATRIX model = XMMatrixRotationY(angle);
-    XMFLOAT4X4 modelData;
-    XMStoreFloat4x4(&modelData, model);
-
-    g_ImmediateContext->UpdateSubresource(g_ModelBuffer, 0, nullptr, &modelData, 0, 0);
+    g_Transforms.SetLocal(g_ModelNode, gfx::MatrixRotationY(angle));
+    g_Transforms.Update();
+    const gfx::Float4x4& modelData = g_Transforms.World(g_ModelNode);
+    g_SceneBvh.SetTransform(g_ModelInstance, modelData);
+    g_SceneBvh.Refit();
+
+    gfx::UploadAllocation block;
+    void* data = g_ConstantUpload.Allocate(sizeof(modelData), block);
+    if (!data) return;
+    memcpy(data, &modelData, sizeof(modelData));
+    g_CubeDraw.constantOffsets[0] = block.offset;
+    g_CubeDraw.constantSizes[0] = block.size;
+
+    // Skinned vertices are already in world space.
+    const gfx::Float4x4 identity = gfx::MatrixIdentity();
+    data = g_ConstantUpload.Allocate(sizeof(identity), block);
+    if (!data) return;
+    memcpy(data, &identity, sizeof(identity));
+    g_TentacleDraw.constantOffsets[0] = block.offset;
+    g_TentacleDraw.constantSizes[0] = block.size;
 }
 
 static void UpdateViewProjBuffer() {
-    float x = g_CamDist * sinf(g_CamTheta) * sinf(g_CamPhi);
-    float y = g_CamDist * cosf(g_CamTheta);
-    float z = g_CamDist * sinf(g_CamTheta) * cosf(g_CamPhi);
+    GFX_PROFILE_SCOPE("UpdateViewProjBuffer");
+    // The matrices are only rebuilt after WM_KEYDOWN moved the camera; the block
+    // itself is rewritten every frame because the ring recycles it.
+    g_Camera.SetOrbit({ 0.0f, 0.0f, 0.0f }, g_CamPhi, g_CamTheta, g_CamDist);
+    const gfx::Float4x4& vpData = g_Camera.ViewProj();
+
+    gfx::UploadAllocation block;
+    void* data = g_ConstantUpload.Allocate(sizeof(vpData), block);
+    if (!data) return;
+    memcpy(data, &vpData, sizeof(vpData));
+    g_CubeDraw.constantOffsets[1] = block.offset;
+    g_CubeDraw.constantSizes[1] = block.size;
+    g_TentacleDraw.constantOffsets[1] = block.offset;
+    g_TentacleDraw.constantSizes[1] = block.size;
+}
 
-    XMVECTOR eye = XMVectorSet(x, y, z, 0.0f);
-    XMVECTOR target = XMVectorZero();
-    XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+// Particles and skinned tentacles are written straight into these mappings.
+static void MapDynamicBuffers() noexcept {
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    ID3D11Buffer* instanceBuffer = GetD3D11Buffer(g_Resources, g_ParticleInstances);
+    g_MappedParticles = SUCCEEDED(g_ImmediateContext->Map(instanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))
+        ? static_cast<gfx::ParticleInstance*>(mapped.pData) : nullptr;
+    ID3D11Buffer* vertexBuffer = GetD3D11Buffer(g_Resources, g_TentacleVertices);
+    g_MappedTentacles = SUCCEEDED(g_ImmediateContext->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))
+        ? static_cast<ColoredVertex*>(mapped.pData) : nullptr;
+}
 
-    XMMATRIX view = XMMatrixLookAtLH(eye, target, up);
+static void UnmapDynamicBuffers() noexcept {
+    if (g_MappedParticles) g_ImmediateContext->Unmap(GetD3D11Buffer(g_Resources, g_ParticleInstances), 0);
+    if (g_MappedTentacles) g_ImmediateContext->Unmap(GetD3D11Buffer(g_Resources, g_TentacleVertices), 0);
+    g_MappedParticles = nullptr;
+    g_MappedTentacles = nullptr;
+}
 
-    float aspect = static_cast<float>(WINDOW_WIDTH) / static_cast<float>(WINDOW_HEIGHT);
-    float fov = XM_PIDIV4;
-    float nearZ = 0.1f;
-    float farZ = 100.0f;
-    XMMATRIX proj = XMMatrixPerspectiveFovLH(fov, aspect, nearZ, farZ);
+// A long stall (window drag, breakpoint) would launch every particle at once.
+static float SimulationStep() noexcept {
+    return (std::min)(g_FrameDt, 0.1f);
+}
 
-    XMMATRIX viewProj = view * proj;
-    XMFLOAT4X4 vpData;
-    XMStoreFloat4x4(&vpData, viewProj);
+static void UpdateParticles() noexcept {
+    g_ParticleCount = g_MappedParticles ? g_Particles.Update(SimulationStep(), g_MappedParticles, &g_WorkerPool) : 0;
+}
 
-    D3D11_MAPPED_SUBRESOURCE mapped;
-    HRESULT hr = g_ImmediateContext->Map(g_ViewProjBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-    if (SUCCEEDED(hr)) {
-        memcpy(mapped.pData, &vpData, sizeof(vpData));
-        g_ImmediateContext->Unmap(g_ViewProjBuffer, 0);
-    }
+static void AnimateTentacles() noexcept {
+    g_Tentacles.Advance(SimulationStep());
+    g_Tentacles.UpdatePoses(&g_WorkerPool);
 }
 
-static void RenderFrame() noexcept {
-    const float clearColor[4] = { 0.0f, 0.15f, 0.3f, 1.0f };
-    g_ImmediateContext->ClearRenderTargetView(g_RenderTarget, clearColor);
-
-    D3D11_VIEWPORT viewport = {};
-    viewport.TopLeftX = 0.0f;
-    viewport.TopLeftY = 0.0f;
-    viewport.Width = static_cast<float>(WINDOW_WIDTH);
-    viewport.Height = static_cast<float>(WINDOW_HEIGHT);
-    viewport.MinDepth = 0.0f;
-    viewport.MaxDepth = 1.0f;
-    g_ImmediateContext->RSSetViewports(1, &viewport);
+static void SkinTentacles() noexcept {
+    if (g_MappedTentacles) g_Tentacles.Skin(g_MappedTentacles, &g_WorkerPool);
+}
+
+// The immediate context and the constant ring are not thread-safe, so the stages
+// that use them form one chain: constants, Map, Unmap. Emission and animation run
+// beside that chain, and the stages that fill the mapped buffers between Map and
+// Unmap. Each stage splits its own work over g_WorkerPool, whose batches are
+// ParallelFors on g_Jobs, so concurrent stages share the workers instead of
+// queueing for them. RenderFrame stays on the main thread after the graph,
+// because Present must not run while the window thread is blocked in a wait.
+static void BuildFrameGraph() {
+    const auto constants = g_FrameGraph.Add("UpdateConstants", [] {
+        g_ConstantsMapped = g_ConstantUpload.BeginFrame();
+        if (!g_ConstantsMapped) return;
+        UpdateModelBuffer(g_FrameDt);
+        UpdateViewProjBuffer();
+        g_ConstantUpload.EndFrame();
+    });
+    const auto map = g_FrameGraph.Add("MapDynamicBuffers", MapDynamicBuffers, { constants });
+    const auto emit = g_FrameGraph.Add("EmitParticles", [] { g_Particles.Emit(g_ParticleEmitter, SimulationStep(), &g_WorkerPool); });
+    const auto animate = g_FrameGraph.Add("AnimateTentacles", AnimateTentacles);
+    const auto particles = g_FrameGraph.Add("UpdateParticles", UpdateParticles, { map, emit });
+    const auto skin = g_FrameGraph.Add("SkinTentacles", SkinTentacles, { map, animate });
+    g_FrameGraph.Add("UnmapDynamicBuffers", UnmapDynamicBuffers, { particles, skin });
+}
 
-    D3D11_RECT scissorRect = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
-    g_ImmediateContext->RSSetScissorRects(1, &scissorRect);
+static void DrawParticles() noexcept {
+    GFX_PROFILE_SCOPE("DrawParticles");
+    if (g_ParticleCount == 0) return;
+
+    float params[20];
+    memcpy(params, &g_Camera.ViewProj(), sizeof(gfx::Float4x4));
+    params[16] = g_Camera.Projection().m[0][0];
+    params[17] = g_Camera.Projection().m[1][1];
+    params[18] = params[19] = 0.0f;
+    ID3D11Buffer* paramBuffer = GetD3D11Buffer(g_Resources, g_ParticleParams);
+    g_ImmediateContext->UpdateSubresource(paramBuffer, 0, nullptr, params, 0, 0);
+
+    // Render target, depth and viewport are still those of the main pass.
+    ID3D11Buffer* instanceBuffer = GetD3D11Buffer(g_Resources, g_ParticleInstances);
+    const UINT stride = ParticleInstanceFormat::Stride, offset = 0;
+    g_ImmediateContext->IASetInputLayout(g_ParticleLayout);
+    g_ImmediateContext->IASetVertexBuffers(0, 1, &instanceBuffer, &stride, &offset);
+    g_ImmediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+    g_ImmediateContext->VSSetShader(GetD3D11VertexShader(g_Resources, g_ParticleVS), nullptr, 0);
+    g_ImmediateContext->VSSetConstantBuffers(0, 1, &paramBuffer);
+    g_ImmediateContext->PSSetShader(GetD3D11PixelShader(g_Resources, g_ParticlePS), nullptr, 0);
+    g_ImmediateContext->OMSetBlendState(g_ParticleBlend, nullptr, 0xFFFFFFFF);
+    g_ImmediateContext->OMSetDepthStencilState(g_ParticleDepth, 0);
+    g_ImmediateContext->DrawInstanced(4, g_ParticleCount, 0, 0);
+
+    g_ImmediateContext->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
+    g_ImmediateContext->OMSetDepthStencilState(nullptr, 0);
+    // The replayer believes the cube's buffers and pipeline are still bound.
+    g_CommandReplayer.Invalidate();
+}
+
+static void UpscaleToBackBuffer(UINT renderWidth, UINT renderHeight) noexcept {
+    GFX_PROFILE_SCOPE("Upscale");
+    // uvMax stops bilinear taps half a texel inside the rendered corner.
+    const float params[4] = {
+        static_cast<float>(renderWidth) / static_cast<float>(g_OutputWidth),
+        static_cast<float>(renderHeight) / static_cast<float>(g_OutputHeight),
+        (static_cast<float>(renderWidth) - 0.5f) / static_cast<float>(g_OutputWidth),
+        (static_cast<float>(renderHeight) - 0.5f) / static_cast<float>(g_OutputHeight),
+    };
+    ID3D11Buffer* paramBuffer = GetD3D11Buffer(g_Resources, g_UpscaleParams);
+    g_ImmediateContext->UpdateSubresource(paramBuffer, 0, nullptr, params, 0, 0);
 
-    UINT stride = sizeof(ColoredVertex);
-    UINT offset = 0;
-    ID3D11Buffer* vbs[] = { g_VertexBuffer };
-    g_ImmediateContext->IASetVertexBuffers(0, 1, vbs, &stride, &offset);
-    g_ImmediateContext->IASetIndexBuffer(g_IndexBuffer, DXGI_FORMAT_R16_UINT, 0);
-    g_ImmediateContext->IASetInputLayout(g_InputLayout);
+    g_ImmediateContext->OMSetRenderTargets(1, &g_RenderTarget, nullptr);
+    const D3D11_VIEWPORT viewport = { 0.0f, 0.0f, static_cast<float>(g_OutputWidth), static_cast<float>(g_OutputHeight), 0.0f, 1.0f };
+    g_ImmediateContext->RSSetViewports(1, &viewport);
+    const D3D11_RECT scissor = { 0, 0, static_cast<LONG>(g_OutputWidth), static_cast<LONG>(g_OutputHeight) };
+    g_ImmediateContext->RSSetScissorRects(1, &scissor);
+    g_ImmediateContext->IASetInputLayout(nullptr);
     g_ImmediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    g_ImmediateContext->VSSetShader(GetD3D11VertexShader(g_Resources, g_UpscaleVS), nullptr, 0);
+    g_ImmediateContext->PSSetShader(GetD3D11PixelShader(g_Resources, g_UpscalePS), nullptr, 0);
+    g_ImmediateContext->PSSetConstantBuffers(0, 1, &paramBuffer);
+    g_ImmediateContext->PSSetShaderResources(0, 1, &g_SceneView);
+    g_ImmediateContext->PSSetSamplers(0, 1, &g_LinearSampler);
+    g_ImmediateContext->Draw(3, 0);
+
+    // The scene texture is a render target again next frame.
+    ID3D11ShaderResourceView* noView = nullptr;
+    g_ImmediateContext->PSSetShaderResources(0, 1, &noView);
+    // Pass and pipeline state were changed behind the replayer's back.
+    g_CommandReplayer.Invalidate();
+}
+
+static void RenderFrame() noexcept {
+    GFX_PROFILE_SCOPE("RenderFrame");
+    const UINT renderWidth = g_DynamicResolution.RenderSize(g_OutputWidth);
+    const UINT renderHeight = g_DynamicResolution.RenderSize(g_OutputHeight);
+    g_MainPass.viewport = { 0.0f, 0.0f, static_cast<float>(renderWidth), static_cast<float>(renderHeight), 0.0f, 1.0f };
+    g_MainPass.scissor = { 0, 0, static_cast<int32_t>(renderWidth), static_cast<int32_t>(renderHeight) };
 
-    ID3D11Buffer* vsConstantBuffers[] = { g_ModelBuffer, g_ViewProjBuffer };
-    g_ImmediateContext->VSSetConstantBuffers(0, 2, vsConstantBuffers);
-    g_ImmediateContext->VSSetShader(g_VS, nullptr, 0);
-    g_ImmediateContext->PSSetShader(g_PS, nullptr, 0);
+    const float clearColor[4] = { 0.0f, 0.15f, 0.3f, 1.0f };
+    g_ImmediateContext->ClearRenderTargetView(g_SceneTarget, clearColor);
+    g_ImmediateContext->ClearDepthStencilView(g_DepthStencil, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
-    g_ImmediateContext->DrawIndexed(36, 0, 0);
+    {
+        GFX_PROFILE_SCOPE("Record");
+        // The model only rotates about the origin, so a sphere there bounds it in any pose.
+        gfx::LodProjection projection = gfx::MakeLodProjection(g_Camera.ViewProj(), static_cast<float>(renderHeight));
+        g_CurrentLod = gfx::SelectLod(projection, g_MeshLods.lods.data(), static_cast<uint32_t>(g_MeshLods.lods.size()), { 0.0f, 0.0f, 0.0f }, g_MeshRadius, 1.0f, LOD_MAX_PIXELS);
+        g_CubeDraw.startIndex = g_MeshLods.lods[g_CurrentLod].indexOffset;
+        g_CubeDraw.indexCount = g_MeshLods.lods[g_CurrentLod].indexCount;
+
+        g_CommandBuffer.Reset();
+        g_CommandBuffer.SetPass(0, g_MainPass);
+        if (g_ConstantsMapped) {
+            g_CommandBuffer.Draw(gfx::MakeSortKey(0, g_CubeDraw.pipeline, 0, 0.0f), g_CubeDraw);
+            for (UINT i = 0; i < TENTACLE_COUNT; ++i) {
+                g_TentacleDraw.baseVertex = static_cast<int32_t>(i * g_TentacleMesh.VertexCount());
+                g_CommandBuffer.Draw(gfx::MakeSortKey(0, g_TentacleDraw.pipeline, 1, 0.0f), g_TentacleDraw);
+            }
+        }
+        g_CommandBuffer.Sort();
+    }
+    {
+        // State that is already bound from the previous frame is not set again. The
+        // constant fallback reuses the same offsets every frame, so it binds afresh.
+        GFX_PROFILE_SCOPE("Replay");
+        if (!g_ConstantUpload.UsesOffsets()) g_CommandReplayer.Invalidate();
+        g_CommandReplayer.Replay(g_CommandBuffer, g_CommandDevice);
+    }
+    DrawParticles();
+    UpscaleToBackBuffer(renderWidth, renderHeight);
 
+    GFX_PROFILE_SCOPE("Present");
     g_SwapChain->Present(0, 0);
 }
 
+// Casts the stored click through the pixel centre into the scene BVH.
+static void ResolvePick() {
+    GFX_PROFILE_SCOPE("ResolvePick");
+    g_PickPending = false;
+    if (g_OutputWidth == 0 || g_OutputHeight == 0) return;
+    const float ndcX = (static_cast<float>(g_PickX) + 0.5f) / static_cast<float>(g_OutputWidth) * 2.0f - 1.0f;
+    const float ndcY = 1.0f - (static_cast<float>(g_PickY) + 0.5f) / static_cast<float>(g_OutputHeight) * 2.0f;
+    gfx::Ray ray;
+    ray.origin = g_Camera.Eye();
+    ray.direction = g_Camera.RayDirection(ndcX, ndcY);
+    gfx::RayHit hit;
+    g_PickedTriangle = g_SceneBvh.Intersect(ray, hit) ? hit.triangle : gfx::NoHit;
+}
+
+static void UpdateFrameStatsTitle(HWND hWnd) {
+    gfx::FrameStats stats = gfx::GetProfiler().GetFrameStats();
+    wchar_t picked[32] = L"none";
+    if (g_PickedTriangle != gfx::NoHit) swprintf_s(picked, L"triangle %u", g_PickedTriangle);
+    wchar_t title[256];
+    swprintf_s(title, L"4 - Rotating Cube | frame p50 %.2f ms, p95 %.2f ms, p99 %.2f ms | LOD %u | %ux%u | %u particles | picked %ls", stats.p50Ms, stats.p95Ms, stats.p99Ms,
+               g_CurrentLod, g_DynamicResolution.RenderSize(g_OutputWidth), g_DynamicResolution.RenderSize(g_OutputHeight), g_ParticleCount, picked);
+    SetWindowText(hWnd, title);
+}
+
 LRESULT CALLBACK WindowProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     switch (msg) {
     case WM_DESTROY:
         PostQuitMessage(0);
         return 0;
+    case WM_SIZE:
+        // Applied by the render loop; dragging a window edge sends many of these per frame.
+        g_Resize.Request(LOWORD(lParam), HIWORD(lParam));
+        return 0;
+    case WM_LBUTTONDOWN:
+        g_PickX = static_cast<short>(LOWORD(lParam));
+        g_PickY = static_cast<short>(HIWORD(lParam));
+        g_PickPending = true;
+        return 0;
     case WM_KEYDOWN:
     {
         const float deltaPhi = 0.1f;
@@ -339,6 +881,15 @@ LRESULT CALLBACK WindowProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             g_CamTheta += deltaTheta;
             if (g_CamTheta > XM_PI - 0.1f) g_CamTheta = XM_PI - 0.1f;
             break;
+        case VK_PRIOR:
+            g_CamDist = (std::max)(g_CamDist * 0.8f, 1.0f);
+            break;
+        case VK_NEXT:
+            g_CamDist = (std::min)(g_CamDist * 1.25f, 80.0f);
+            break;
+        case VK_F9:
+            gfx::GetProfiler().WriteChromeTrace("frame_trace.json");
+            break;
         }
     }
     return 0;
@@ -346,7 +897,21 @@ LRESULT CALLBACK WindowProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     return DefWindowProc(hWnd, msg, wParam, lParam);
 }
 
-int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ int nCmdShow) {
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR lpCmdLine, _In_ int nCmdShow) {
+    gfx::GetProfiler().SetThreadName("Main");
+
+    if (lpCmdLine && *lpCmdLine) {
+        std::string meshPath(lpCmdLine);
+        if (meshPath.size() >= 2 && meshPath.front() == '"' && meshPath.back() == '"') meshPath = meshPath.substr(1, meshPath.size() - 2);
+        // The LOD chain, vertex cache optimizer and BVH index vertex arrays with the
+        // file's indices, so they are range-checked before anything uses them.
+        if (!g_Mesh.Open(meshPath.c_str()) || !gfx::SameLayout(g_Mesh.Layout(), gfx::ColoredVertexLayout()) ||
+            !g_Mesh.ValidateIndices()) {
+            MessageBox(nullptr, L"Mesh file could not be loaded", L"Error", MB_ICONERROR);
+            return -1;
+        }
+    }
+
     WNDCLASSEX wc = {};
     wc.cbSize = sizeof(WNDCLASSEX);
     wc.style = CS_HREDRAW | CS_VREDRAW;
@@ -387,6 +952,8 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In
         return -1;
     }
 
+    BuildFrameGraph();
+
     QueryPerformanceFrequency(&g_Freq);
     QueryPerformanceCounter(&g_StartTime);
 
@@ -402,9 +969,29 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In
             float dt = static_cast<float>(currentTime.QuadPart - g_StartTime.QuadPart) / static_cast<float>(g_Freq.QuadPart);
             g_StartTime = currentTime;
 
-            UpdateModelBuffer(dt);
-            UpdateViewProjBuffer();
+            uint32_t width, height;
+            if (g_Resize.Consume(width, height) && FAILED(ResizeFrameTargets(width, height))) {
+                MessageBox(nullptr, L"Swap chain resize failed", L"Error", MB_ICONERROR);
+                break;
+            }
+            // Scales the scene resolution for the next frame to keep dt within budget.
+            g_DynamicResolution.Update(dt * 1000.0f);
+
+            g_Resources.BeginFrame();
+            g_FrameDt = dt;
+            g_FrameGraph.Run(g_Jobs);
+            if (g_PickPending) {
+                ResolvePick();
+                UpdateFrameStatsTitle(hMainWindow);
+            }
             RenderFrame();
+
+            gfx::GetProfiler().EndFrame();
+            g_StatsTimer += dt;
+            if (g_StatsTimer >= 1.0f) {
+                g_StatsTimer = 0.0f;
+                UpdateFrameStatsTitle(hMainWindow);
+            }
         }
     }
 
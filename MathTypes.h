@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cmath>
+
+// Portable counterparts of the DirectXMath types used by Lab3.cpp.
+// Float4x4 has the same layout as XMFLOAT4X4 and follows the same
+// row-vector convention as the shaders' mul(v, M) with row_major matrices.
+namespace gfx {
+
+struct Float3 {
+    float x, y, z;
+};
+
+struct Float4 {
+    float x, y, z, w;
+};
+
+struct Float4x4 {
+    float m[4][4];
+};
+
+inline Float3 operator+(const Float3& a, const Float3& b) noexcept { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline Float3 operator-(const Float3& a, const Float3& b) noexcept { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline Float3 operator*(const Float3& a, float s) noexcept { return { a.x * s, a.y * s, a.z * s }; }
+
+inline float Dot(const Float3& a, const Float3& b) noexcept {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Float3 Cross(const Float3& a, const Float3& b) noexcept {
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+inline Float3 Normalize(const Float3& v) noexcept {
+    float len = std::sqrt(Dot(v, v));
+    return len > 0.0f ? v * (1.0f / len) : v;
+}
+
+inline Float4x4 MatrixIdentity() noexcept {
+    return { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } } };
+}
+
+inline Float4x4 Multiply(const Float4x4& a, const Float4x4& b) noexcept {
+    Float4x4 r;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+        }
+    }
+    return r;
+}
+
+inline Float4 TransformPoint(const Float3& p, const Float4x4& m) noexcept {
+    return {
+        p.x * m.m[0][0] + p.y * m.m[1][0] + p.z * m.m[2][0] + m.m[3][0],
+        p.x * m.m[0][1] + p.y * m.m[1][1] + p.z * m.m[2][1] + m.m[3][1],
+        p.x * m.m[0][2] + p.y * m.m[1][2] + p.z * m.m[2][2] + m.m[3][2],
+        p.x * m.m[0][3] + p.y * m.m[1][3] + p.z * m.m[2][3] + m.m[3][3]
+    };
+}
+
+inline Float4x4 MatrixTranslation(float x, float y, float z) noexcept {
+    return { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { x, y, z, 1 } } };
+}
+
+inline Float4x4 MatrixScaling(float x, float y, float z) noexcept {
+    return { { { x, 0, 0, 0 }, { 0, y, 0, 0 }, { 0, 0, z, 0 }, { 0, 0, 0, 1 } } };
+}
+
+// Same as XMMatrixRotationY.
+inline Float4x4 MatrixRotationY(float angle) noexcept {
+    float s = std::sin(angle);
+    float c = std::cos(angle);
+    return { { { c, 0, -s, 0 }, { 0, 1, 0, 0 }, { s, 0, c, 0 }, { 0, 0, 0, 1 } } };
+}
+
+// Same as XMMatrixLookAtLH.
+inline Float4x4 MatrixLookAtLH(const Float3& eye, const Float3& target, const Float3& up) noexcept {
+    Float3 zAxis = Normalize(target - eye);
+    Float3 xAxis = Normalize(Cross(up, zAxis));
+    Float3 yAxis = Cross(zAxis, xAxis);
+    return { {
+        { xAxis.x, yAxis.x, zAxis.x, 0.0f },
+        { xAxis.y, yAxis.y, zAxis.y, 0.0f },
+        { xAxis.z, yAxis.z, zAxis.z, 0.0f },
+        { -Dot(xAxis, eye), -Dot(yAxis, eye), -Dot(zAxis, eye), 1.0f }
+    } };
+}
+
+// Same as XMMatrixPerspectiveFovLH.
+inline Float4x4 MatrixPerspectiveFovLH(float fovY, float aspect, float nearZ, float farZ) noexcept {
+    float h = std::cos(0.5f * fovY) / std::sin(0.5f * fovY);
+    float w = h / aspect;
+    float range = farZ / (farZ - nearZ);
+    return { {
+        { w, 0.0f, 0.0f, 0.0f },
+        { 0.0f, h, 0.0f, 0.0f },
+        { 0.0f, 0.0f, range, 1.0f },
+        { 0.0f, 0.0f, -range * nearZ, 0.0f }
+    } };
+}
+
+} // namespace gfx
@@ -0,0 +1,180 @@
+#include "MeshFile.h"
+
+#include "ColoredVertex.h"
+#include "Hash.h"
+#include "VertexLayout.h"
+
+#include <cfloat>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+namespace gfx {
+
+namespace {
+
+static_assert(sizeof(MeshFileHeader) == 320, "mesh file header layout");
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) noexcept {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+uint64_t HashBlobs(const void* vertices, uint64_t vertexBytes, const void* indices, uint64_t indexBytes) noexcept {
+    return HashCombine(Hash64(vertices, static_cast<size_t>(vertexBytes)), Hash64(indices, static_cast<size_t>(indexBytes)));
+}
+
+template<typename Index>
+bool IndicesBelow(const void* data, uint64_t count, uint64_t limit) noexcept {
+    const Index* indices = static_cast<const Index*>(data);
+    Index largest = 0;
+    for (uint64_t i = 0; i < count; ++i) largest = indices[i] > largest ? indices[i] : largest;
+    return count == 0 || largest < limit;
+}
+
+bool Fail(std::string* error, const char* message) {
+    if (error) *error = message;
+    return false;
+}
+
+} // namespace
+
+uint32_t AppendAttribute(MeshVertexLayout& layout, const char* semantic, ElementFormat format, uint32_t semanticIndex) noexcept {
+    MeshAttribute& attribute = layout.attributes[layout.attributeCount++];
+    std::memset(&attribute, 0, sizeof(attribute));
+    std::strncpy(attribute.semantic, semantic, sizeof(attribute.semantic) - 1);
+    attribute.semanticIndex = semanticIndex;
+    attribute.format = format;
+    attribute.offset = layout.stride;
+    layout.stride += ElementSize(format);
+    return attribute.offset;
+}
+
+MeshVertexLayout ColoredVertexLayout() noexcept {
+    static_assert(offsetof(ColoredVertex, rgba) == ColoredVertexFormat::Offset(1) && sizeof(ColoredVertex) == ColoredVertexFormat::Stride,
+                  "ColoredVertex layout");
+    return ColoredVertexFormat::Describe();
+}
+
+bool SameLayout(const MeshVertexLayout& a, const MeshVertexLayout& b) noexcept {
+    if (a.stride != b.stride || a.attributeCount != b.attributeCount) return false;
+    for (uint32_t i = 0; i < a.attributeCount; ++i) {
+        const MeshAttribute& x = a.attributes[i];
+        const MeshAttribute& y = b.attributes[i];
+        if (std::strncmp(x.semantic, y.semantic, sizeof(x.semantic)) != 0 || x.semanticIndex != y.semanticIndex ||
+            x.format != y.format || x.offset != y.offset) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WriteMeshFile(const char* path, const MeshSource& mesh, std::string* error) {
+    const MeshVertexLayout& layout = mesh.layout;
+    if (layout.attributeCount > MaxMeshAttributes) return Fail(error, "too many vertex attributes");
+
+    const MeshAttribute* position = nullptr;
+    for (uint32_t i = 0; i < layout.attributeCount; ++i) {
+        const MeshAttribute& attribute = layout.attributes[i];
+        if (attribute.offset + ElementSize(attribute.format) > layout.stride) return Fail(error, "attribute outside vertex stride");
+        if (!position && std::strncmp(attribute.semantic, "POSITION", sizeof(attribute.semantic)) == 0) position = &attribute;
+    }
+    if (!position || position->format != ElementFormat::R32G32B32_Float) return Fail(error, "layout needs a float3 POSITION");
+
+    MeshFileHeader header = {};
+    header.magic = MeshFileMagic;
+    header.versionMajor = MeshFileVersionMajor;
+    header.versionMinor = MeshFileVersionMinor;
+    header.headerSize = sizeof(MeshFileHeader);
+    header.indexFormat = static_cast<uint32_t>(mesh.indexFormat);
+    std::memcpy(&header.layout, &layout, sizeof(layout));
+    header.vertexCount = mesh.vertexCount;
+    header.indexCount = mesh.indexCount;
+
+    const uint64_t vertexBytes = mesh.vertexCount * layout.stride;
+    const uint64_t indexBytes = mesh.indexCount * IndexSize(mesh.indexFormat);
+    header.vertexOffset = AlignUp(sizeof(header), MeshFileBlobAlignment);
+    header.indexOffset = AlignUp(header.vertexOffset + vertexBytes, MeshFileBlobAlignment);
+    header.fileSize = header.indexOffset + indexBytes;
+    header.blobHash = HashBlobs(mesh.vertices, vertexBytes, mesh.indices, indexBytes);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        header.boundsMin[axis] = mesh.vertexCount ? FLT_MAX : 0.0f;
+        header.boundsMax[axis] = mesh.vertexCount ? -FLT_MAX : 0.0f;
+    }
+    const uint8_t* vertices = static_cast<const uint8_t*>(mesh.vertices);
+    for (uint64_t v = 0; v < mesh.vertexCount; ++v) {
+        float p[3];
+        std::memcpy(p, vertices + v * layout.stride + position->offset, sizeof(p));
+        for (int axis = 0; axis < 3; ++axis) {
+            header.boundsMin[axis] = p[axis] < header.boundsMin[axis] ? p[axis] : header.boundsMin[axis];
+            header.boundsMax[axis] = p[axis] > header.boundsMax[axis] ? p[axis] : header.boundsMax[axis];
+        }
+    }
+
+    std::string tempPath = std::string(path) + ".tmp";
+    FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) return Fail(error, "cannot create mesh file");
+
+    static const uint8_t padding[MeshFileBlobAlignment] = {};
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   (header.vertexOffset == sizeof(header) || std::fwrite(padding, header.vertexOffset - sizeof(header), 1, file) == 1) &&
+                   (vertexBytes == 0 || std::fwrite(mesh.vertices, static_cast<size_t>(vertexBytes), 1, file) == 1);
+    uint64_t gap = header.indexOffset - header.vertexOffset - vertexBytes;
+    written = written && (gap == 0 || std::fwrite(padding, static_cast<size_t>(gap), 1, file) == 1) &&
+              (indexBytes == 0 || std::fwrite(mesh.indices, static_cast<size_t>(indexBytes), 1, file) == 1);
+    written = std::fclose(file) == 0 && written;
+
+    std::error_code ec;
+    if (written) std::filesystem::rename(tempPath, path, ec);
+    if (!written || ec) {
+        std::filesystem::remove(tempPath, ec);
+        return Fail(error, "cannot write mesh file");
+    }
+    return true;
+}
+
+bool MeshFile::Open(const char* path, std::string* error, bool verifyChecksum) {
+    Close();
+    if (!m_file.Open(path)) return Fail(error, "cannot map mesh file");
+
+    const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(m_file.Data());
+    const char* problem = nullptr;
+    if (m_file.Size() < sizeof(MeshFileHeader) || header->magic != MeshFileMagic) {
+        problem = "not a mesh file";
+    } else if (header->versionMajor != MeshFileVersionMajor || header->headerSize < sizeof(MeshFileHeader)) {
+        problem = "unsupported mesh file version";
+    } else if (header->layout.attributeCount > MaxMeshAttributes || header->layout.stride == 0 ||
+               header->indexFormat > static_cast<uint32_t>(IndexFormat::UInt32)) {
+        problem = "bad vertex layout";
+    } else if (header->fileSize != m_file.Size() || header->vertexOffset % MeshFileBlobAlignment != 0 ||
+               header->indexOffset % MeshFileBlobAlignment != 0 || header->vertexOffset < header->headerSize ||
+               // Offsets are ordered before any subtraction, so nothing wraps around.
+               header->vertexOffset > header->indexOffset || header->indexOffset > m_file.Size() ||
+               header->vertexCount > (header->indexOffset - header->vertexOffset) / header->layout.stride ||
+               header->indexCount > (m_file.Size() - header->indexOffset) / IndexSize(static_cast<IndexFormat>(header->indexFormat))) {
+        problem = "truncated mesh file";
+    }
+    if (!problem) {
+        m_header = header;
+        if (verifyChecksum && header->blobHash != HashBlobs(VertexData(), VertexBytes(), IndexData(), IndexBytes())) {
+            problem = "mesh file checksum mismatch";
+        }
+    }
+    if (problem) {
+        Close();
+        return Fail(error, problem);
+    }
+    return true;
+}
+
+bool MeshFile::ValidateIndices(std::string* error) const {
+    if (!m_header) return Fail(error, "mesh file not open");
+    if (IndexCount() % 3 != 0) return Fail(error, "index count is not a multiple of 3");
+    const bool inRange = GetIndexFormat() == IndexFormat::UInt16 ? IndicesBelow<uint16_t>(IndexData(), IndexCount(), VertexCount())
+                                                                 : IndicesBelow<uint32_t>(IndexData(), IndexCount(), VertexCount());
+    return inRange || Fail(error, "index out of vertex range");
+}
+
+} // namespace gfx
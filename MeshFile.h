@@ -0,0 +1,100 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "RenderTypes.h"
+
+#include <cstdint>
+#include <string>
+
+namespace gfx {
+
+constexpr uint32_t MaxMeshAttributes = 8;
+
+struct MeshAttribute {
+    char semantic[16];
+    uint32_t semanticIndex;
+    ElementFormat format;
+    uint32_t offset;
+};
+
+struct MeshVertexLayout {
+    uint32_t stride;
+    uint32_t attributeCount;
+    MeshAttribute attributes[MaxMeshAttributes];
+};
+
+// Adds an attribute at the end of the vertex and returns its offset; the caller
+// keeps attributeCount below MaxMeshAttributes.
+uint32_t AppendAttribute(MeshVertexLayout& layout, const char* semantic, ElementFormat format, uint32_t semanticIndex = 0) noexcept;
+
+// POSITION + COLOR, the ColoredVertex layout Lab3.cpp draws with.
+MeshVertexLayout ColoredVertexLayout() noexcept;
+
+bool SameLayout(const MeshVertexLayout& a, const MeshVertexLayout& b) noexcept;
+
+// On-disk header. Vertex and index blobs start at BlobAlignment-aligned offsets
+// so a mapped file can be passed to CreateBuffer as-is.
+struct MeshFileHeader {
+    uint32_t magic;
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    uint32_t headerSize;
+    uint32_t indexFormat;
+    MeshVertexLayout layout;
+    uint64_t vertexCount;
+    uint64_t vertexOffset;
+    uint64_t indexCount;
+    uint64_t indexOffset;
+    uint64_t fileSize;
+    uint64_t blobHash;
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+constexpr uint32_t MeshFileMagic = 0x48534d47; // "GMSH"
+constexpr uint16_t MeshFileVersionMajor = 1;
+constexpr uint16_t MeshFileVersionMinor = 0;
+constexpr uint64_t MeshFileBlobAlignment = 64;
+
+struct MeshSource {
+    MeshVertexLayout layout;
+    const void* vertices;
+    uint64_t vertexCount;
+    const void* indices;
+    IndexFormat indexFormat;
+    uint64_t indexCount;
+};
+
+// Computes bounds from the POSITION attribute and writes the file atomically.
+bool WriteMeshFile(const char* path, const MeshSource& mesh, std::string* error = nullptr);
+
+// Read-only view of a mapped mesh file; the blob pointers stay valid while it is open.
+class MeshFile {
+public:
+    // Header, version and sizes are always validated; the blob checksum only when asked,
+    // since it touches every page of the file.
+    bool Open(const char* path, std::string* error = nullptr, bool verifyChecksum = false);
+    void Close() noexcept { m_file.Close(); m_header = nullptr; }
+    // Open leaves the index values alone. Call this before CPU code indexes vertex
+    // arrays with them: a triangle list whose every index is below VertexCount().
+    // Like the checksum it reads the whole index blob.
+    bool ValidateIndices(std::string* error = nullptr) const;
+    bool IsOpen() const noexcept { return m_header != nullptr; }
+
+    const MeshFileHeader& Header() const noexcept { return *m_header; }
+    const MeshVertexLayout& Layout() const noexcept { return m_header->layout; }
+    uint64_t VertexCount() const noexcept { return m_header->vertexCount; }
+    uint64_t IndexCount() const noexcept { return m_header->indexCount; }
+    IndexFormat GetIndexFormat() const noexcept { return static_cast<IndexFormat>(m_header->indexFormat); }
+
+    const void* VertexData() const noexcept { return m_file.Data() + m_header->vertexOffset; }
+    uint64_t VertexBytes() const noexcept { return m_header->vertexCount * m_header->layout.stride; }
+    const void* IndexData() const noexcept { return m_file.Data() + m_header->indexOffset; }
+    uint64_t IndexBytes() const noexcept { return m_header->indexCount * IndexSize(GetIndexFormat()); }
+
+private:
+    MappedFile m_file;
+    const MeshFileHeader* m_header = nullptr;
+};
+
+} // namespace gfx
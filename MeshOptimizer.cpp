@@ -0,0 +1,237 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace gfx {
+
+namespace {
+
+constexpr uint32_t Missing = ~0u;
+
+// Timestamped FIFO: a vertex is cached while fewer than cacheSize misses happened since it entered.
+class FifoCache {
+public:
+    FifoCache(uint32_t vertexCount, uint32_t cacheSize) : m_entered(vertexCount, 0), m_cacheSize(cacheSize), m_time(cacheSize + 1) {}
+
+    bool Access(uint32_t v) noexcept {
+        if (m_time - m_entered[v] <= m_cacheSize) return true;
+        m_entered[v] = m_time++;
+        return false;
+    }
+
+    void Flush() noexcept { m_time += m_cacheSize + 1; }
+
+private:
+    std::vector<uint32_t> m_entered;
+    uint32_t m_cacheSize;
+    uint32_t m_time;
+};
+
+struct Cluster {
+    uint32_t begin;
+    uint32_t end;
+    float sortKey;
+};
+
+inline void LoadPosition(const uint8_t* positions, size_t stride, uint32_t v, float out[3]) noexcept {
+    std::memcpy(out, positions + v * stride, sizeof(float) * 3);
+}
+
+} // namespace
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize) {
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<bool> referenced(vertexCount, false);
+    uint64_t transformed = 0, unique = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t v = indices[i];
+        if (!referenced[v]) {
+            referenced[v] = true;
+            ++unique;
+        }
+        transformed += !cache.Access(v);
+    }
+    size_t triangleCount = indexCount / 3;
+    return { transformed, triangleCount ? double(transformed) / triangleCount : 0.0, unique ? double(transformed) / unique : 0.0 };
+}
+
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize) {
+    const size_t triangleCount = indexCount / 3;
+    std::vector<uint32_t> source;
+    if (destination == indices) {
+        source.assign(indices, indices + triangleCount * 3);
+        indices = source.data();
+    }
+
+    // Vertex -> triangle adjacency; live counts the triangles not yet emitted.
+    std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) ++adjacencyStart[indices[i] + 1];
+    for (uint32_t v = 0; v < vertexCount; ++v) adjacencyStart[v + 1] += adjacencyStart[v];
+    std::vector<uint32_t> live(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v) live[v] = adjacencyStart[v + 1] - adjacencyStart[v];
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; ++i) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<uint32_t> entered(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    uint32_t time = cacheSize + 1;
+    uint32_t scan = 0;
+    size_t written = 0;
+
+    uint32_t fanning = 0;
+    while (fanning < vertexCount && live[fanning] == 0) ++fanning;
+    while (fanning < vertexCount) {
+        candidates.clear();
+        for (uint32_t a = adjacencyStart[fanning]; a < adjacencyStart[fanning + 1]; ++a) {
+            uint32_t triangle = adjacency[a];
+            if (emitted[triangle]) continue;
+            emitted[triangle] = true;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = indices[triangle * 3 + k];
+                destination[written++] = v;
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - entered[v] > cacheSize) entered[v] = time++;
+            }
+        }
+
+        // Prefer the candidate that entered the cache longest ago but will still
+        // be cached after all of its remaining triangles are emitted.
+        uint32_t next = Missing;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) continue;
+            int64_t age = time - entered[v];
+            int64_t priority = age + 2 * int64_t(live[v]) <= cacheSize ? age : 0;
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+        while (next == Missing && !deadEnd.empty()) {
+            uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v]) next = v;
+        }
+        while (next == Missing && scan < vertexCount) {
+            if (live[scan]) next = scan;
+            ++scan;
+        }
+        fanning = next == Missing ? vertexCount : next;
+    }
+}
+
+void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+                      const void* positions, size_t vertexStride, uint32_t vertexCount,
+                      float threshold, uint32_t cacheSize) {
+    const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+    const uint8_t* positionBytes = static_cast<const uint8_t*>(positions);
+    std::vector<uint32_t> source(indices, indices + size_t(triangleCount) * 3);
+    const double meshAcmr = AnalyzeVertexCache(source.data(), source.size(), vertexCount, cacheSize).acmr;
+
+    // Hard boundaries where the cache restarts (all three vertices miss); soft
+    // ones once the running cluster is already as cache-friendly as allowed.
+    std::vector<Cluster> clusters;
+    FifoCache cache(vertexCount, cacheSize);
+    uint32_t clusterBegin = 0, clusterMisses = 0;
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        uint32_t misses = 0;
+        for (int k = 0; k < 3; ++k) misses += !cache.Access(source[t * 3 + k]);
+        if (misses == 3 && t > clusterBegin) {
+            clusters.push_back({ clusterBegin, t, 0.0f });
+            clusterBegin = t;
+            clusterMisses = 0;
+        }
+        clusterMisses += misses;
+        if (clusterMisses <= (t + 1 - clusterBegin) * threshold * meshAcmr) {
+            clusters.push_back({ clusterBegin, t + 1, 0.0f });
+            clusterBegin = t + 1;
+            clusterMisses = 0;
+            cache.Flush();
+        }
+    }
+    if (clusterBegin < triangleCount) clusters.push_back({ clusterBegin, triangleCount, 0.0f });
+
+    // Sort key: how far the cluster centroid lies along its own average normal,
+    // measured from the mesh centroid.
+    std::vector<float> centroids(clusters.size() * 3), normals(clusters.size() * 3);
+    double meshCentroid[3] = {};
+    double meshArea = 0.0;
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        double centroid[3] = {}, normal[3] = {}, area = 0.0;
+        for (uint32_t t = clusters[c].begin; t < clusters[c].end; ++t) {
+            float a[3], b[3], d[3];
+            LoadPosition(positionBytes, vertexStride, source[t * 3 + 0], a);
+            LoadPosition(positionBytes, vertexStride, source[t * 3 + 1], b);
+            LoadPosition(positionBytes, vertexStride, source[t * 3 + 2], d);
+            float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            float e2[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+            double n[3] = { double(e1[1]) * e2[2] - double(e1[2]) * e2[1], double(e1[2]) * e2[0] - double(e1[0]) * e2[2],
+                            double(e1[0]) * e2[1] - double(e1[1]) * e2[0] };
+            double w = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; ++k) {
+                centroid[k] += w * (a[k] + b[k] + d[k]) / 3.0;
+                normal[k] += n[k];
+            }
+            area += w;
+        }
+        for (int k = 0; k < 3; ++k) {
+            meshCentroid[k] += centroid[k];
+            centroids[c * 3 + k] = static_cast<float>(area > 0.0 ? centroid[k] / area : 0.0);
+        }
+        meshArea += area;
+        double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        for (int k = 0; k < 3; ++k) normals[c * 3 + k] = static_cast<float>(length > 0.0 ? normal[k] / length : 0.0);
+    }
+    for (int k = 0; k < 3; ++k) meshCentroid[k] = meshArea > 0.0 ? meshCentroid[k] / meshArea : 0.0;
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        float key = 0.0f;
+        for (int k = 0; k < 3; ++k) key += static_cast<float>((centroids[c * 3 + k] - meshCentroid[k]) * normals[c * 3 + k]);
+        clusters[c].sortKey = key;
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+    size_t written = 0;
+    for (const Cluster& cluster : clusters) {
+        size_t count = size_t(cluster.end - cluster.begin) * 3;
+        std::memcpy(destination + written, source.data() + size_t(cluster.begin) * 3, count * sizeof(uint32_t));
+        written += count;
+    }
+}
+
+uint32_t OptimizeVertexFetch(void* destinationVertices, uint32_t* indices, size_t indexCount,
+                             const void* vertices, uint32_t vertexCount, size_t vertexStride) {
+    const uint8_t* source = static_cast<const uint8_t*>(vertices);
+    uint8_t* destination = static_cast<uint8_t*>(destinationVertices);
+    std::vector<uint32_t> remap(vertexCount, Missing);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t& id = remap[indices[i]];
+        if (id == Missing) {
+            std::memcpy(destination + size_t(next) * vertexStride, source + size_t(indices[i]) * vertexStride, vertexStride);
+            id = next++;
+        }
+        indices[i] = id;
+    }
+    return next;
+}
+
+void PackIndices(void* destination, const uint32_t* indices, size_t count, IndexFormat format) noexcept {
+    if (format == IndexFormat::UInt32) {
+        std::memcpy(destination, indices, count * sizeof(uint32_t));
+        return;
+    }
+    uint16_t* out = static_cast<uint16_t*>(destination);
+    for (size_t i = 0; i < count; ++i) out[i] = static_cast<uint16_t>(indices[i]);
+}
+
+} // namespace gfx
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "RenderTypes.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gfx {
+
+constexpr uint32_t DefaultVertexCacheSize = 16;
+
+// FIFO post-transform cache simulation. ACMR is transformed vertices per
+// triangle (0.5 is ideal for large grids), ATVR per referenced vertex (1.0 is ideal).
+struct VertexCacheStats {
+    uint64_t transformedVertices;
+    double acmr;
+    double atvr;
+};
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount,
+                                    uint32_t cacheSize = DefaultVertexCacheSize);
+
+// Tipsify (Sander, Nehab, Barczak 2007): fans around the most recently cached
+// vertex, in linear time. destination may equal indices.
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, uint32_t vertexCount,
+                         uint32_t cacheSize = DefaultVertexCacheSize);
+
+// Splits a cache-optimized list into clusters at cache restarts and where the
+// cluster ACMR stays below threshold * overall ACMR, then orders clusters
+// outward-facing first. A threshold of 1.05 trades up to 5% ACMR for less overdraw.
+// positions points at float3 positions vertexStride bytes apart.
+void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+                      const void* positions, size_t vertexStride, uint32_t vertexCount,
+                      float threshold = 1.05f, uint32_t cacheSize = DefaultVertexCacheSize);
+
+// Reorders vertices by first use and rewrites indices to match; unreferenced
+// vertices are dropped. Returns the new vertex count.
+uint32_t OptimizeVertexFetch(void* destinationVertices, uint32_t* indices, size_t indexCount,
+                             const void* vertices, uint32_t vertexCount, size_t vertexStride);
+
+inline IndexFormat ChooseIndexFormat(uint32_t vertexCount) noexcept {
+    return vertexCount <= 0x10000 ? IndexFormat::UInt16 : IndexFormat::UInt32;
+}
+
+// Writes indices in the given format; destination needs count * IndexSize(format) bytes.
+void PackIndices(void* destination, const uint32_t* indices, size_t count, IndexFormat format) noexcept;
+
+} // namespace gfx
@@ -0,0 +1,411 @@
+#include "MeshSimplifier.h"
+
+#include "Hash.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+constexpr uint32_t Missing = ~0u;
+
+// Border planes keep open edges in place; weighted like a triangle of that edge length.
+constexpr double BorderWeight = 10.0;
+
+enum class VertexKind : uint8_t { Manifold, Border, Locked };
+
+struct Quadric {
+    double a00, a11, a22, a10, a20, a21;
+    double b0, b1, b2;
+    double c;
+    double weight;
+
+    void AddPlane(const double n[3], double d, double w) noexcept {
+        a00 += w * n[0] * n[0];
+        a11 += w * n[1] * n[1];
+        a22 += w * n[2] * n[2];
+        a10 += w * n[1] * n[0];
+        a20 += w * n[2] * n[0];
+        a21 += w * n[2] * n[1];
+        b0 += w * n[0] * d;
+        b1 += w * n[1] * d;
+        b2 += w * n[2] * d;
+        c += w * d * d;
+        weight += w;
+    }
+
+    void Add(const Quadric& q) noexcept {
+        a00 += q.a00; a11 += q.a11; a22 += q.a22;
+        a10 += q.a10; a20 += q.a20; a21 += q.a21;
+        b0 += q.b0; b1 += q.b1; b2 += q.b2;
+        c += q.c;
+        weight += q.weight;
+    }
+
+    // Weighted mean squared distance of p to the accumulated planes.
+    double Error(const float p[3]) const noexcept {
+        double x = p[0], y = p[1], z = p[2];
+        double e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a10 * x * y + a20 * x * z + a21 * y * z) +
+                   2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return weight > 0.0 ? std::fabs(e) / weight : 0.0;
+    }
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    float cost;
+};
+
+inline void Sub(const float a[3], const float b[3], double out[3]) noexcept {
+    out[0] = double(a[0]) - b[0];
+    out[1] = double(a[1]) - b[1];
+    out[2] = double(a[2]) - b[2];
+}
+
+inline void Cross(const double a[3], const double b[3], double out[3]) noexcept {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+inline double Dot(const double a[3], const double b[3]) noexcept { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+inline uint32_t TableSize(size_t count) noexcept {
+    uint32_t size = 16;
+    while (size < count * 2) size *= 2;
+    return size;
+}
+
+class Simplifier {
+public:
+    Simplifier(const uint32_t* indices, size_t indexCount, const void* positions, size_t stride, uint32_t vertexCount)
+        : m_indices(indices, indices + indexCount), m_vertexCount(vertexCount) {
+        m_positions.resize(size_t(vertexCount) * 3);
+        const uint8_t* source = static_cast<const uint8_t*>(positions);
+        for (uint32_t v = 0; v < vertexCount; ++v) std::memcpy(&m_positions[size_t(v) * 3], source + v * stride, sizeof(float) * 3);
+        WeldPositions();
+        ClassifyVertices();
+        ComputeQuadrics();
+        m_remap.resize(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; ++v) m_remap[v] = v;
+        m_locked.assign(vertexCount, 0);
+    }
+
+    const std::vector<uint32_t>& Indices() const noexcept { return m_indices; }
+    double Error() const noexcept { return m_error; }
+
+    // Collapses the cheapest edges in passes until the target or the error limit is reached.
+    void Run(size_t targetIndexCount, double maxErrorSquared) {
+        while (m_indices.size() > targetIndexCount) {
+            BuildAdjacency();
+            GatherCollapses(maxErrorSquared);
+            if (m_collapses.empty()) break;
+            std::sort(m_collapses.begin(), m_collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+            if (!ApplyCollapses((m_indices.size() - targetIndexCount) / 3)) break;
+            Compact();
+        }
+    }
+
+private:
+    const float* Position(uint32_t v) const noexcept { return &m_positions[size_t(v) * 3]; }
+
+    // Vertices at bit-identical positions share one canonical vertex (the first of them).
+    void WeldPositions() {
+        m_canonical.resize(m_vertexCount);
+        m_groupSize.assign(m_vertexCount, 0);
+        uint32_t size = TableSize(m_vertexCount);
+        std::vector<uint32_t> table(size, Missing);
+        for (uint32_t v = 0; v < m_vertexCount; ++v) {
+            uint32_t slot = static_cast<uint32_t>(Hash64(Position(v), sizeof(float) * 3)) & (size - 1);
+            while (table[slot] != Missing && std::memcmp(Position(table[slot]), Position(v), sizeof(float) * 3) != 0) {
+                slot = (slot + 1) & (size - 1);
+            }
+            if (table[slot] == Missing) table[slot] = v;
+            m_canonical[v] = table[slot];
+            ++m_groupSize[table[slot]];
+        }
+    }
+
+    // A half-edge without a twin lies on an open border. Border vertices need exactly one
+    // border edge in and one out; seams and anything more complex are locked.
+    void ClassifyVertices() {
+        const size_t halfEdges = m_indices.size();
+        uint32_t size = TableSize(halfEdges);
+        std::vector<uint64_t> table(size, ~0ull);
+        auto key = [this](size_t i, size_t j) { return (uint64_t(m_canonical[m_indices[i]]) << 32) | m_canonical[m_indices[j]]; };
+        auto find = [&](uint64_t k) {
+            uint32_t slot = static_cast<uint32_t>(Mix64(k)) & (size - 1);
+            while (table[slot] != ~0ull && table[slot] != k) slot = (slot + 1) & (size - 1);
+            return slot;
+        };
+        for (size_t t = 0; t < halfEdges; t += 3) {
+            for (size_t e = 0; e < 3; ++e) {
+                uint64_t k = key(t + e, t + (e + 1) % 3);
+                table[find(k)] = k;
+            }
+        }
+
+        std::vector<uint8_t> borderOut(m_vertexCount, 0), borderIn(m_vertexCount, 0);
+        m_borderNext.assign(m_vertexCount, Missing);
+        m_borderPrev.assign(m_vertexCount, Missing);
+        m_borderEdges.clear();
+        for (size_t t = 0; t < halfEdges; t += 3) {
+            for (size_t e = 0; e < 3; ++e) {
+                uint32_t a = m_canonical[m_indices[t + e]], b = m_canonical[m_indices[t + (e + 1) % 3]];
+                uint64_t twin = (uint64_t(b) << 32) | a;
+                if (table[find(twin)] == twin) continue;
+                ++borderOut[a];
+                ++borderIn[b];
+                m_borderNext[a] = b;
+                m_borderPrev[b] = a;
+                m_borderEdges.push_back(t + e);
+            }
+        }
+
+        m_kind.assign(m_vertexCount, VertexKind::Manifold);
+        for (uint32_t v = 0; v < m_vertexCount; ++v) {
+            if (m_canonical[v] != v) continue;
+            if (m_groupSize[v] > 1) m_kind[v] = VertexKind::Locked;
+            else if (borderOut[v] == 1 && borderIn[v] == 1) m_kind[v] = VertexKind::Border;
+            else if (borderOut[v] || borderIn[v]) m_kind[v] = VertexKind::Locked;
+        }
+    }
+
+    void ComputeQuadrics() {
+        m_quadrics.assign(m_vertexCount, Quadric{});
+        for (size_t t = 0; t < m_indices.size(); t += 3) {
+            uint32_t v[3] = { m_canonical[m_indices[t]], m_canonical[m_indices[t + 1]], m_canonical[m_indices[t + 2]] };
+            double n[3];
+            double area = TriangleNormal(v[0], v[1], v[2], n);
+            if (area == 0.0) continue;
+            double d = -(n[0] * Position(v[0])[0] + n[1] * Position(v[0])[1] + n[2] * Position(v[0])[2]);
+            for (uint32_t k : v) m_quadrics[k].AddPlane(n, d, area);
+        }
+        for (size_t halfEdge : m_borderEdges) {
+            size_t t = halfEdge - halfEdge % 3;
+            uint32_t a = m_canonical[m_indices[halfEdge]];
+            uint32_t b = m_canonical[m_indices[t + (halfEdge - t + 1) % 3]];
+            double n[3];
+            if (TriangleNormal(m_canonical[m_indices[t]], m_canonical[m_indices[t + 1]], m_canonical[m_indices[t + 2]], n) == 0.0) continue;
+            double edge[3], m[3];
+            Sub(Position(b), Position(a), edge);
+            Cross(edge, n, m);
+            double length = std::sqrt(Dot(m, m));
+            if (length == 0.0) continue;
+            for (double& x : m) x /= length;
+            double d = -(m[0] * Position(a)[0] + m[1] * Position(a)[1] + m[2] * Position(a)[2]);
+            double weight = Dot(edge, edge) * BorderWeight;
+            m_quadrics[a].AddPlane(m, d, weight);
+            m_quadrics[b].AddPlane(m, d, weight);
+        }
+    }
+
+    // Unit normal in n; returns the triangle area.
+    double TriangleNormal(uint32_t a, uint32_t b, uint32_t c, double n[3]) const noexcept {
+        double e0[3], e1[3];
+        Sub(Position(b), Position(a), e0);
+        Sub(Position(c), Position(a), e1);
+        Cross(e0, e1, n);
+        double length = std::sqrt(Dot(n, n));
+        if (length == 0.0) return 0.0;
+        for (int k = 0; k < 3; ++k) n[k] /= length;
+        return length * 0.5;
+    }
+
+    void BuildAdjacency() {
+        m_adjacencyOffsets.assign(size_t(m_vertexCount) + 1, 0);
+        for (uint32_t index : m_indices) ++m_adjacencyOffsets[m_canonical[index] + 1];
+        for (uint32_t v = 0; v < m_vertexCount; ++v) m_adjacencyOffsets[v + 1] += m_adjacencyOffsets[v];
+        m_adjacency.resize(m_indices.size());
+        std::vector<uint32_t> fill(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < m_indices.size(); ++i) m_adjacency[fill[m_canonical[m_indices[i]]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    bool CanCollapse(uint32_t from, uint32_t to) const noexcept {
+        switch (m_kind[from]) {
+        case VertexKind::Manifold: return true;
+        case VertexKind::Border: return m_kind[to] == VertexKind::Border && (m_borderNext[from] == to || m_borderPrev[from] == to);
+        default: return false;
+        }
+    }
+
+    double Cost(uint32_t from, uint32_t to) const noexcept {
+        Quadric q = m_quadrics[from];
+        q.Add(m_quadrics[to]);
+        return q.Error(Position(to));
+    }
+
+    // One candidate per edge, in the cheaper allowed direction.
+    void GatherCollapses(double maxErrorSquared) {
+        m_collapses.clear();
+        for (size_t t = 0; t < m_indices.size(); t += 3) {
+            for (size_t e = 0; e < 3; ++e) {
+                uint32_t a = m_indices[t + e], b = m_indices[t + (e + 1) % 3];
+                uint32_t ca = m_canonical[a], cb = m_canonical[b];
+                // Interior edges appear as (a, b) and (b, a); take the first. Border edges appear once.
+                if (ca > cb && m_borderNext[ca] != cb) continue;
+                double costAB = CanCollapse(ca, cb) ? Cost(ca, cb) : HUGE_VAL;
+                double costBA = CanCollapse(cb, ca) ? Cost(cb, ca) : HUGE_VAL;
+                double cost = std::min(costAB, costBA);
+                if (cost > maxErrorSquared) continue;
+                if (costAB <= costBA) m_collapses.push_back({ a, b, static_cast<float>(cost) });
+                else m_collapses.push_back({ b, a, static_cast<float>(cost) });
+            }
+        }
+    }
+
+    // Moving from onto to must not turn any remaining triangle of from's fan over.
+    bool Flips(uint32_t from, uint32_t to) const noexcept {
+        for (uint32_t i = m_adjacencyOffsets[from]; i < m_adjacencyOffsets[from + 1]; ++i) {
+            size_t t = size_t(m_adjacency[i]) * 3;
+            uint32_t v[3] = { m_canonical[m_indices[t]], m_canonical[m_indices[t + 1]], m_canonical[m_indices[t + 2]] };
+            if (v[0] == to || v[1] == to || v[2] == to) continue;
+            double before[3], after[3];
+            if (TriangleNormal(v[0], v[1], v[2], before) == 0.0) continue;
+            for (uint32_t& k : v) k = k == from ? to : k;
+            if (TriangleNormal(v[0], v[1], v[2], after) == 0.0 || Dot(before, after) < 0.2) return true;
+        }
+        return false;
+    }
+
+    // Applies sorted collapses whose neighbourhoods do not overlap. Returns false if none applied.
+    bool ApplyCollapses(size_t trianglesToRemove) {
+        std::fill(m_locked.begin(), m_locked.end(), 0);
+        m_collapsed.clear();
+        size_t removed = 0;
+        for (const Collapse& collapse : m_collapses) {
+            uint32_t from = m_canonical[collapse.from], to = m_canonical[collapse.to];
+            if (m_locked[from] || m_locked[to] || Flips(from, to)) continue;
+
+            for (uint32_t i = m_adjacencyOffsets[from]; i < m_adjacencyOffsets[from + 1]; ++i) {
+                size_t t = size_t(m_adjacency[i]) * 3;
+                bool shared = false;
+                for (size_t k = 0; k < 3; ++k) {
+                    uint32_t c = m_canonical[m_indices[t + k]];
+                    m_locked[c] = 1;
+                    shared |= c == to;
+                }
+                removed += shared;
+            }
+            m_locked[to] = 1;
+            m_remap[collapse.from] = collapse.to;
+            m_collapsed.push_back(collapse.from);
+            m_quadrics[to].Add(m_quadrics[from]);
+            m_error = std::max(m_error, double(collapse.cost));
+
+            if (m_kind[from] == VertexKind::Border) {
+                if (m_borderNext[from] == to) {
+                    m_borderNext[m_borderPrev[from]] = to;
+                    m_borderPrev[to] = m_borderPrev[from];
+                } else {
+                    m_borderPrev[m_borderNext[from]] = to;
+                    m_borderNext[to] = m_borderNext[from];
+                }
+            }
+            if (removed >= trianglesToRemove) break;
+        }
+        return !m_collapsed.empty();
+    }
+
+    void Compact() {
+        size_t write = 0;
+        for (size_t t = 0; t < m_indices.size(); t += 3) {
+            uint32_t a = m_remap[m_indices[t]], b = m_remap[m_indices[t + 1]], c = m_remap[m_indices[t + 2]];
+            uint32_t ca = m_canonical[a], cb = m_canonical[b], cc = m_canonical[c];
+            if (ca == cb || cb == cc || ca == cc) continue;
+            m_indices[write++] = a;
+            m_indices[write++] = b;
+            m_indices[write++] = c;
+        }
+        m_indices.resize(write);
+        for (uint32_t v : m_collapsed) m_remap[v] = v;
+    }
+
+    std::vector<uint32_t> m_indices;
+    uint32_t m_vertexCount;
+    std::vector<float> m_positions;
+    std::vector<uint32_t> m_canonical;
+    std::vector<uint32_t> m_groupSize;
+    std::vector<VertexKind> m_kind;
+    std::vector<uint32_t> m_borderNext;
+    std::vector<uint32_t> m_borderPrev;
+    std::vector<size_t> m_borderEdges;
+    std::vector<Quadric> m_quadrics;
+    std::vector<uint32_t> m_adjacencyOffsets;
+    std::vector<uint32_t> m_adjacency;
+    std::vector<Collapse> m_collapses;
+    std::vector<uint32_t> m_remap;
+    std::vector<uint32_t> m_collapsed;
+    std::vector<uint8_t> m_locked;
+    double m_error = 0.0;
+};
+
+} // namespace
+
+size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const void* positions,
+                    size_t vertexStride, uint32_t vertexCount, size_t targetIndexCount, float maxError, float* resultError) {
+    Simplifier simplifier(indices, indexCount, positions, vertexStride, vertexCount);
+    simplifier.Run(targetIndexCount, double(maxError) * maxError);
+    const std::vector<uint32_t>& result = simplifier.Indices();
+    std::copy(result.begin(), result.end(), destination);
+    if (resultError) *resultError = static_cast<float>(std::sqrt(simplifier.Error()));
+    return result.size();
+}
+
+void BuildLodChain(const uint32_t* indices, size_t indexCount, const void* positions, size_t vertexStride,
+                   uint32_t vertexCount, float maxError, LodChain& out, const float* ratios, uint32_t ratioCount) {
+    out.indices.assign(indices, indices + indexCount);
+    OptimizeVertexCache(out.indices.data(), out.indices.data(), indexCount, vertexCount);
+    out.lods.assign(1, { 0, static_cast<uint32_t>(indexCount), 0.0f });
+
+    Simplifier simplifier(indices, indexCount, positions, vertexStride, vertexCount);
+    for (uint32_t level = 0; level < ratioCount; ++level) {
+        size_t target = static_cast<size_t>(indexCount / 3 * ratios[level]) * 3;
+        simplifier.Run(target, double(maxError) * maxError);
+        const std::vector<uint32_t>& result = simplifier.Indices();
+        // A level that barely shrank means the error limit was hit; stop the chain there.
+        if (result.empty() || result.size() * 10 > size_t(out.lods.back().indexCount) * 9) break;
+
+        uint32_t offset = static_cast<uint32_t>(out.indices.size());
+        out.indices.resize(offset + result.size());
+        OptimizeVertexCache(out.indices.data() + offset, result.data(), result.size(), vertexCount);
+        out.lods.push_back({ offset, static_cast<uint32_t>(result.size()), static_cast<float>(std::sqrt(simplifier.Error())) });
+    }
+}
+
+// With row vectors, clip w is the dot product with column 3 (view depth for a
+// perspective projection), and column 1 of the upper 3x3 carries the vertical scale.
+LodProjection MakeLodProjection(const Float4x4& viewProj, float viewportHeight) noexcept {
+    const auto& m = viewProj.m;
+    float yScale = std::sqrt(m[0][1] * m[0][1] + m[1][1] * m[1][1] + m[2][1] * m[2][1]);
+    return { { m[0][3], m[1][3], m[2][3], m[3][3] }, yScale * viewportHeight * 0.5f };
+}
+
+uint32_t SelectLod(const LodProjection& projection, const MeshLod* lods, uint32_t lodCount, const Float3& center,
+                   float radius, float worldScale, float maxPixels) noexcept {
+    const float* d = projection.depth;
+    float nearest = center.x * d[0] + center.y * d[1] + center.z * d[2] + d[3] - radius;
+    if (nearest <= 0.0f || lodCount == 0) return 0;
+    float pixelsPerError = worldScale * projection.pixelsPerUnit / nearest;
+    for (uint32_t lod = lodCount - 1; lod > 0; --lod) {
+        if (lods[lod].error * pixelsPerError <= maxPixels) return lod;
+    }
+    return 0;
+}
+
+void SelectLods(const LodProjection& projection, const MeshLod* lods, uint32_t lodCount, const AabbStreams& bounds,
+                uint32_t objectCount, float worldScale, float maxPixels, uint8_t* lodIndices) noexcept {
+    for (uint32_t i = 0; i < objectCount; ++i) {
+        float radius = std::sqrt(bounds.extentX[i] * bounds.extentX[i] + bounds.extentY[i] * bounds.extentY[i] +
+                                 bounds.extentZ[i] * bounds.extentZ[i]);
+        Float3 center = { bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i] };
+        lodIndices[i] = static_cast<uint8_t>(SelectLod(projection, lods, lodCount, center, radius, worldScale, maxPixels));
+    }
+}
+
+} // namespace gfx
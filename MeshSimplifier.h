@@ -0,0 +1,60 @@
+#pragma once
+
+#include "MathTypes.h"
+#include "Scene.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+// Quadric edge collapse (Garland-Heckbert) that only moves vertices onto existing
+// neighbours, so every LOD indexes the original vertex buffer. Vertices shared by
+// several attribute sets (colour or UV seams) are kept, open borders only collapse
+// along themselves, and collapses that would flip a triangle are rejected.
+// The returned error is the RMS distance to the original surface planes, in
+// position units. destination may equal indices. Returns the new index count.
+size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const void* positions,
+                    size_t vertexStride, uint32_t vertexCount, size_t targetIndexCount, float maxError,
+                    float* resultError = nullptr);
+
+struct MeshLod {
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    float error;
+};
+
+// Level 0 is the input; each further level keeps the given fraction of the input's
+// triangles, simplifying from the previous level. The chain ends early once
+// maxError stops the simplifier. Every level is vertex cache optimized.
+struct LodChain {
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+};
+
+constexpr float DefaultLodRatios[] = { 0.5f, 0.25f, 0.125f, 0.0625f };
+
+void BuildLodChain(const uint32_t* indices, size_t indexCount, const void* positions, size_t vertexStride,
+                   uint32_t vertexCount, float maxError, LodChain& out, const float* ratios = DefaultLodRatios,
+                   uint32_t ratioCount = 4);
+
+// Converts an object-space error at a world position into pixels for one view.
+struct LodProjection {
+    float depth[4];
+    float pixelsPerUnit;
+};
+
+// viewProj as uploaded by UpdateViewProjBuffer (row vectors, perspective).
+LodProjection MakeLodProjection(const Float4x4& viewProj, float viewportHeight) noexcept;
+
+// Coarsest level whose error, scaled by worldScale and projected at the point of the
+// bounding sphere closest to the camera, stays within maxPixels.
+uint32_t SelectLod(const LodProjection& projection, const MeshLod* lods, uint32_t lodCount, const Float3& center,
+                   float radius, float worldScale, float maxPixels) noexcept;
+
+// SelectLod for every object of a scene, with its AABB as the bounding volume.
+void SelectLods(const LodProjection& projection, const MeshLod* lods, uint32_t lodCount, const AabbStreams& bounds,
+                uint32_t objectCount, float worldScale, float maxPixels, uint8_t* lodIndices) noexcept;
+
+} // namespace gfx
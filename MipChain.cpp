@@ -0,0 +1,315 @@
+#include "MipChain.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+namespace {
+
+constexpr uint32_t MaxTaps = 8;
+// Horizontally filtered rows kept per band; at least MaxTaps so that the rows of one
+// destination row never evict each other.
+constexpr uint32_t RingRows = 16;
+
+// Below this much filter work (taps times output floats) a band is not worth a
+// hand-off to the pool.
+constexpr uint64_t MinWorkPerBand = 65536;
+
+template<typename Fn>
+void ForEachRowBand(ThreadPool* pool, uint32_t rowCount, uint64_t workPerRow, const Fn& fn) {
+    uint64_t bandLimit = (uint64_t(rowCount) * workPerRow) / MinWorkPerBand;
+    uint32_t bands = pool ? static_cast<uint32_t>(std::min<uint64_t>({ rowCount, pool->ThreadCount() * 4ull, bandLimit })) : 1;
+    if (bands <= 1) {
+        fn(0u, rowCount);
+        return;
+    }
+    pool->Run(bands, [&](uint32_t band, uint32_t) {
+        fn(static_cast<uint32_t>(uint64_t(rowCount) * band / bands), static_cast<uint32_t>(uint64_t(rowCount) * (band + 1) / bands));
+    });
+}
+
+double SrgbToLinear(double v) noexcept {
+    return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+}
+
+struct SrgbTables {
+    float toLinear[256];
+    // thresholds[i] is the linear value halfway, in sRGB space, between bytes i and
+    // i + 1, so the byte of a linear value is the number of thresholds at or below it.
+    float thresholds[255];
+    // Byte of linear value i / EncodeBins, a starting point that is at most a step or
+    // two from the exact byte.
+    static constexpr uint32_t EncodeBins = 4096;
+    uint8_t nearest[EncodeBins + 1];
+
+    SrgbTables() noexcept {
+        for (int i = 0; i < 256; ++i) toLinear[i] = static_cast<float>(SrgbToLinear(i / 255.0));
+        for (int i = 0; i < 255; ++i) thresholds[i] = static_cast<float>(SrgbToLinear((i + 0.5) / 255.0));
+        for (uint32_t i = 0; i <= EncodeBins; ++i) {
+            float v = static_cast<float>(i) / EncodeBins;
+            nearest[i] = static_cast<uint8_t>(std::upper_bound(thresholds, thresholds + 255, v) - thresholds);
+        }
+    }
+};
+
+const SrgbTables& GetSrgbTables() noexcept {
+    static const SrgbTables tables;
+    return tables;
+}
+
+inline uint32_t EncodeUnorm(float v) noexcept {
+    v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    return static_cast<uint32_t>(v * 255.0f + 0.5f);
+}
+
+inline uint32_t EncodeSrgb(const SrgbTables& tables, float v) noexcept {
+    if (!(v > 0.0f)) return 0;
+    if (v >= 1.0f) return 255;
+    uint32_t byte = tables.nearest[static_cast<uint32_t>(v * SrgbTables::EncodeBins)];
+    while (byte < 255 && v >= tables.thresholds[byte]) ++byte;
+    while (byte > 0 && v < tables.thresholds[byte - 1]) --byte;
+    return byte;
+}
+
+double BesselI0(double x) noexcept {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x * 0.5 / k) * (x * 0.5 / k);
+        sum += term;
+    }
+    return sum;
+}
+
+// Source pixels and weights of a 2:1 reduction along one axis. Every destination
+// pixel uses the same weights, centred between source pixels 2x and 2x + 1.
+struct FilterTaps {
+    uint32_t count = 0;
+    // Unwrapped index of tap k for destination x: x * step + first + k.
+    uint32_t step = 2;
+    int32_t first = 0;
+    float weights[MaxTaps] = {};
+    // count source indices per destination pixel, already clamped or wrapped.
+    std::vector<uint32_t> indices;
+};
+
+FilterTaps BuildTaps(MipFilter filter, MipAddress address, uint32_t srcSize, uint32_t dstSize) {
+    FilterTaps taps;
+    int32_t& first = taps.first;
+    if (srcSize == 1) {
+        taps.step = 0;
+        taps.count = 1;
+        taps.weights[0] = 1.0f;
+    } else if (filter == MipFilter::Box) {
+        taps.count = 2;
+        taps.weights[0] = taps.weights[1] = 0.5f;
+    } else {
+        // sinc(d / 2) under a Kaiser window (alpha 4) reaching zero 4 source pixels out.
+        const double pi = 3.14159265358979323846, alpha = 4.0, radius = 4.0;
+        double weights[MaxTaps], sum = 0.0;
+        taps.count = MaxTaps;
+        first = -3;
+        for (uint32_t k = 0; k < MaxTaps; ++k) {
+            double d = static_cast<int32_t>(k) + first - 0.5, x = pi * d * 0.5, r = d / radius;
+            weights[k] = std::sin(x) / x * BesselI0(alpha * std::sqrt(1.0 - r * r)) / BesselI0(alpha);
+            sum += weights[k];
+        }
+        for (uint32_t k = 0; k < MaxTaps; ++k) taps.weights[k] = static_cast<float>(weights[k] / sum);
+    }
+
+    taps.indices.resize(size_t(dstSize) * taps.count);
+    const int32_t size = static_cast<int32_t>(srcSize);
+    for (uint32_t x = 0; x < dstSize; ++x) {
+        for (uint32_t k = 0; k < taps.count; ++k) {
+            int32_t i = static_cast<int32_t>(x * taps.step) + first + static_cast<int32_t>(k);
+            i = address == MipAddress::Wrap ? ((i % size) + size) % size : std::min(std::max(i, 0), size - 1);
+            taps.indices[size_t(x) * taps.count + k] = static_cast<uint32_t>(i);
+        }
+    }
+    return taps;
+}
+
+// Horizontal pass: one RGBA float pixel per destination pixel. The SIMD kernels
+// accumulate the taps in the same order without FMA, so every level gives the same
+// bits; they return how many pixels they wrote and the scalar loop finishes the row.
+void FilterRowScalar(const float* src, float* dst, uint32_t x, uint32_t width, const FilterTaps& taps) noexcept {
+    const uint32_t n = taps.count;
+    for (; x < width; ++x) {
+        const uint32_t* idx = taps.indices.data() + size_t(x) * n;
+        for (uint32_t c = 0; c < 4; ++c) {
+            float acc = taps.weights[0] * src[idx[0] * 4 + c];
+            for (uint32_t k = 1; k < n; ++k) acc = acc + taps.weights[k] * src[idx[k] * 4 + c];
+            dst[x * 4 + c] = acc;
+        }
+    }
+}
+
+#if GFX_X86
+uint32_t FilterRowSSE(const float* src, float* dst, uint32_t width, const FilterTaps& taps) noexcept {
+    const uint32_t n = taps.count;
+    for (uint32_t x = 0; x < width; ++x) {
+        const uint32_t* idx = taps.indices.data() + size_t(x) * n;
+        __m128 acc = _mm_mul_ps(_mm_set1_ps(taps.weights[0]), _mm_loadu_ps(src + idx[0] * 4));
+        for (uint32_t k = 1; k < n; ++k) acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(taps.weights[k]), _mm_loadu_ps(src + idx[k] * 4)));
+        _mm_storeu_ps(dst + x * 4, acc);
+    }
+    return width;
+}
+
+GFX_TARGET_AVX2 inline __m256 LoadPixelPair(const float* low, const float* high) noexcept {
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+}
+
+GFX_TARGET_AVX2 uint32_t FilterRowAVX2(const float* src, float* dst, uint32_t width, const FilterTaps& taps) noexcept {
+    const uint32_t n = taps.count;
+    uint32_t x = 0;
+    for (; x + 2 <= width; x += 2) {
+        const uint32_t* a = taps.indices.data() + size_t(x) * n;
+        const uint32_t* b = a + n;
+        __m256 acc = _mm256_mul_ps(_mm256_set1_ps(taps.weights[0]), LoadPixelPair(src + a[0] * 4, src + b[0] * 4));
+        for (uint32_t k = 1; k < n; ++k) {
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(taps.weights[k]), LoadPixelPair(src + a[k] * 4, src + b[k] * 4)));
+        }
+        _mm256_storeu_ps(dst + x * 4, acc);
+    }
+    return x;
+}
+#endif
+
+// Vertical pass over whole rows of floats: dst = sum of weights[k] * rows[k].
+void BlendRowsScalar(const float* const* rows, const float* weights, uint32_t n, float* dst, uint32_t i, uint32_t count) noexcept {
+    for (; i < count; ++i) {
+        float acc = weights[0] * rows[0][i];
+        for (uint32_t k = 1; k < n; ++k) acc = acc + weights[k] * rows[k][i];
+        dst[i] = acc;
+    }
+}
+
+#if GFX_X86
+uint32_t BlendRowsSSE(const float* const* rows, const float* weights, uint32_t n, float* dst, uint32_t count) noexcept {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 acc = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(rows[0] + i));
+        for (uint32_t k = 1; k < n; ++k) acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i)));
+        _mm_storeu_ps(dst + i, acc);
+    }
+    return i;
+}
+
+GFX_TARGET_AVX2 uint32_t BlendRowsAVX2(const float* const* rows, const float* weights, uint32_t n, float* dst, uint32_t count) noexcept {
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 acc = _mm256_mul_ps(_mm256_set1_ps(weights[0]), _mm256_loadu_ps(rows[0] + i));
+        for (uint32_t k = 1; k < n; ++k) acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows[k] + i)));
+        _mm256_storeu_ps(dst + i, acc);
+    }
+    return i;
+}
+#endif
+
+void FilterRow(const float* src, float* dst, uint32_t width, const FilterTaps& taps, SimdLevel level) noexcept {
+    uint32_t x = 0;
+#if GFX_X86
+    if (level == SimdLevel::AVX2) x = FilterRowAVX2(src, dst, width, taps);
+    else if (level == SimdLevel::SSE) x = FilterRowSSE(src, dst, width, taps);
+#else
+    (void)level;
+#endif
+    FilterRowScalar(src, dst, x, width, taps);
+}
+
+void BlendRows(const float* const* rows, const float* weights, uint32_t n, float* dst, uint32_t count, SimdLevel level) noexcept {
+    uint32_t i = 0;
+#if GFX_X86
+    if (level == SimdLevel::AVX2) i = BlendRowsAVX2(rows, weights, n, dst, count);
+    else if (level == SimdLevel::SSE) i = BlendRowsSSE(rows, weights, n, dst, count);
+#else
+    (void)level;
+#endif
+    BlendRowsScalar(rows, weights, n, dst, i, count);
+}
+
+} // namespace
+
+uint32_t MipLevelCount(uint32_t width, uint32_t height) noexcept {
+    uint32_t size = std::max(width, height), levels = 0;
+    for (; size; size >>= 1) ++levels;
+    return levels;
+}
+
+void GenerateMips(const Image& base, const MipOptions& options, std::vector<Image>& levels, ThreadPool* pool, SimdLevel level) {
+    levels.clear();
+    if (base.width == 0 || base.height == 0) return;
+    uint32_t levelCount = MipLevelCount(base.width, base.height);
+    if (options.maxLevels) levelCount = std::min(levelCount, options.maxLevels);
+    levels.resize(levelCount);
+    levels[0] = base;
+
+    const SrgbTables& srgb = GetSrgbTables();
+    const bool linearize = options.srgb;
+    std::vector<float> current, next;
+    uint32_t srcWidth = base.width, srcHeight = base.height;
+    for (uint32_t l = 1; l < levelCount; ++l) {
+        const uint32_t width = std::max(srcWidth / 2, 1u), height = std::max(srcHeight / 2, 1u);
+        const FilterTaps horizontal = BuildTaps(options.filter, options.address, srcWidth, width);
+        const FilterTaps vertical = BuildTaps(options.filter, options.address, srcHeight, height);
+        const uint32_t rowFloats = width * 4;
+
+        Image& out = levels[l];
+        out.Resize(width, height);
+        next.resize(size_t(height) * rowFloats);
+        // Each band filters the source rows it needs horizontally into a small ring and
+        // blends them vertically, so the intermediate image never leaves the cache. Rows
+        // shared by neighbouring bands are filtered twice, with the same result.
+        const uint64_t workPerRow = uint64_t(rowFloats) * (vertical.count + 2 * horizontal.count);
+        ForEachRowBand(pool, height, workPerRow, [&](uint32_t begin, uint32_t end) {
+            std::vector<float> ring(size_t(RingRows) * rowFloats);
+            std::vector<float> decoded(l == 1 ? size_t(srcWidth) * 4 : 0);
+            int32_t ringRow[RingRows];
+            std::fill_n(ringRow, RingRows, INT32_MIN);
+            const float* rows[MaxTaps];
+            for (uint32_t y = begin; y < end; ++y) {
+                for (uint32_t k = 0; k < vertical.count; ++k) {
+                    const int32_t virtualRow = static_cast<int32_t>(y * vertical.step) + vertical.first + static_cast<int32_t>(k);
+                    const uint32_t slot = static_cast<uint32_t>(virtualRow + 4 * RingRows) % RingRows;
+                    float* row = ring.data() + size_t(slot) * rowFloats;
+                    if (ringRow[slot] != virtualRow) {
+                        const uint32_t sourceRow = vertical.indices[size_t(y) * vertical.count + k];
+                        const float* source = current.data() + size_t(sourceRow) * srcWidth * 4;
+                        if (l == 1) {
+                            // The base level is read as bytes and linearized on the fly.
+                            const uint32_t* pixels = base.pixels.data() + size_t(sourceRow) * srcWidth;
+                            for (uint32_t x = 0; x < srcWidth; ++x) {
+                                for (uint32_t c = 0; c < 3; ++c) {
+                                    uint32_t v = (pixels[x] >> (c * 8)) & 0xFF;
+                                    decoded[x * 4 + c] = linearize ? srgb.toLinear[v] : static_cast<float>(v) * (1.0f / 255.0f);
+                                }
+                                decoded[x * 4 + 3] = static_cast<float>(pixels[x] >> 24) * (1.0f / 255.0f);
+                            }
+                            source = decoded.data();
+                        }
+                        FilterRow(source, row, width, horizontal, level);
+                        ringRow[slot] = virtualRow;
+                    }
+                    rows[k] = row;
+                }
+                float* row = next.data() + size_t(y) * rowFloats;
+                BlendRows(rows, vertical.weights, vertical.count, row, rowFloats, level);
+
+                uint32_t* pixels = out.pixels.data() + size_t(y) * width;
+                for (uint32_t x = 0; x < width; ++x) {
+                    const float* p = row + x * 4;
+                    uint32_t rgba = EncodeUnorm(p[3]) << 24;
+                    for (uint32_t c = 0; c < 3; ++c) rgba |= (linearize ? EncodeSrgb(srgb, p[c]) : EncodeUnorm(p[c])) << (c * 8);
+                    pixels[x] = rgba;
+                }
+            }
+        });
+
+        current.swap(next);
+        srcWidth = width;
+        srcHeight = height;
+    }
+}
+
+} // namespace gfx
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Image.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+enum class MipFilter {
+    // 2x2 average.
+    Box,
+    // 8-tap windowed sinc (Kaiser window), sharper than Box with little ringing.
+    Kaiser,
+};
+
+// How the filter reads past the image edge: repeat the edge pixel, or tile.
+enum class MipAddress { Clamp, Wrap };
+
+struct MipOptions {
+    MipFilter filter = MipFilter::Kaiser;
+    MipAddress address = MipAddress::Clamp;
+    // Color channels are sRGB-encoded and filtered in linear light; alpha is always linear.
+    bool srgb = true;
+    // 0 builds the full chain down to 1x1.
+    uint32_t maxLevels = 0;
+};
+
+// Levels in a full chain: floor(log2(max(width, height))) + 1.
+uint32_t MipLevelCount(uint32_t width, uint32_t height) noexcept;
+
+// Replaces levels with base followed by its downsampled mips, each half the size
+// of the previous one (rounded down, at least 1). Every level is filtered from the
+// previous one kept in float, with a separable filter whose passes run in row bands
+// across the pool. The result is the same for every thread count and SIMD level.
+void GenerateMips(const Image& base, const MipOptions& options, std::vector<Image>& levels, ThreadPool* pool = nullptr,
+                  SimdLevel level = BestSimdLevel());
+
+} // namespace gfx
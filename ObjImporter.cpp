@@ -0,0 +1,476 @@
+#include "ObjImporter.h"
+
+#include "ColoredVertex.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+constexpr size_t ChunkBytes = 1 << 20;
+constexpr uint32_t ShardBits = 6;
+constexpr uint32_t ShardCount = 1u << ShardBits;
+constexpr uint32_t CornerBlock = 1 << 16;
+constexpr uint32_t Missing = ~0u;
+
+// A line-aligned slice of the file. Pass 1 fills the counts, the prefix sum
+// turns them into the chunk's first element of each kind.
+struct Chunk {
+    const char* begin;
+    const char* end;
+    uint64_t line;
+    uint64_t positions;
+    uint64_t texcoords;
+    uint64_t normals;
+    uint64_t corners;
+    const char* error;
+    uint64_t errorLine;
+};
+
+struct Corner {
+    uint32_t v, t, n;
+};
+
+enum class Record { Other, Position, Texcoord, Normal, Face };
+
+inline bool IsSpace(char c) noexcept { return c == ' ' || c == '\t' || c == '\r'; }
+inline bool IsDigit(char c) noexcept { return c >= '0' && c <= '9'; }
+
+inline const char* SkipSpace(const char* p, const char* end) noexcept {
+    while (p < end && IsSpace(*p)) ++p;
+    return p;
+}
+
+// Classifies a line and returns the position just past the keyword.
+Record ClassifyLine(const char*& p, const char* end) noexcept {
+    p = SkipSpace(p, end);
+    if (end - p < 2) return Record::Other;
+    if (p[0] == 'f' && IsSpace(p[1])) {
+        p += 1;
+        return Record::Face;
+    }
+    if (p[0] != 'v') return Record::Other;
+    if (IsSpace(p[1])) {
+        p += 1;
+        return Record::Position;
+    }
+    if (end - p < 3 || !IsSpace(p[2])) return Record::Other;
+    p += 2;
+    return p[-1] == 't' ? Record::Texcoord : (p[-1] == 'n' ? Record::Normal : Record::Other);
+}
+
+uint32_t CountTokens(const char* p, const char* end) noexcept {
+    uint32_t count = 0;
+    while (true) {
+        p = SkipSpace(p, end);
+        if (p == end) return count;
+        ++count;
+        while (p < end && !IsSpace(*p)) ++p;
+    }
+}
+
+double Pow10(int exponent) noexcept {
+    static const double table[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    return exponent <= 22 ? table[exponent] : std::pow(10.0, exponent);
+}
+
+// Decimal float with optional sign, fraction and exponent. Only the first 19
+// significant digits are used, which is plenty for float output.
+bool ParseFloat(const char*& p, const char* end, float& out) noexcept {
+    p = SkipSpace(p, end);
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) ++p;
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+    for (; p < end && IsDigit(*p); ++p) {
+        any = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        } else {
+            ++exponent;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && IsDigit(*p); ++p) {
+            any = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                --exponent;
+            }
+        }
+    }
+    if (!any) return false;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExponent = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) ++p;
+        if (p == end || !IsDigit(*p)) return false;
+        int value = 0;
+        for (; p < end && IsDigit(*p); ++p) value = value < 10000 ? value * 10 + (*p - '0') : value;
+        exponent += negativeExponent ? -value : value;
+    }
+
+    double value = static_cast<double>(mantissa);
+    value = exponent < 0 ? value / Pow10(-exponent) : value * Pow10(exponent);
+    out = static_cast<float>(negative ? -value : value);
+    return p == end || IsSpace(*p);
+}
+
+bool ParseInt(const char*& p, const char* end, int64_t& out) noexcept {
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) ++p;
+    if (p == end || !IsDigit(*p)) return false;
+    int64_t value = 0;
+    for (; p < end && IsDigit(*p); ++p) value = value < (int64_t(1) << 40) ? value * 10 + (*p - '0') : value;
+    out = negative ? -value : value;
+    return true;
+}
+
+// OBJ indices are 1-based; negative ones count back from the last element defined so far.
+bool ResolveIndex(int64_t index, uint64_t definedSoFar, uint64_t total, uint32_t& out) noexcept {
+    int64_t resolved = index > 0 ? index - 1 : static_cast<int64_t>(definedSoFar) + index;
+    if (index == 0 || resolved < 0 || static_cast<uint64_t>(resolved) >= total) return false;
+    out = static_cast<uint32_t>(resolved);
+    return true;
+}
+
+inline uint64_t CornerHash(const Corner& c) noexcept {
+    return Mix64(((uint64_t(c.t) << 32) | c.v) ^ (uint64_t(c.n) * 0x9e3779b97f4a7c15ull));
+}
+
+inline uint32_t CornerShard(const Corner& c) noexcept {
+    return static_cast<uint32_t>(CornerHash(c) >> (64 - ShardBits));
+}
+
+inline bool SameCorner(const Corner& a, const Corner& b) noexcept {
+    return a.v == b.v && a.t == b.t && a.n == b.n;
+}
+
+struct ParsedObj {
+    std::vector<float> positions;
+    std::vector<uint32_t> colors;
+    std::vector<float> texcoords;
+    std::vector<float> normals;
+    std::vector<Corner> corners;
+};
+
+std::vector<Chunk> SplitLines(const char* data, size_t size) {
+    std::vector<Chunk> chunks;
+    const char* begin = data;
+    const char* end = data + size;
+    while (begin < end) {
+        const char* chunkEnd = end;
+        if (static_cast<size_t>(end - begin) > ChunkBytes) {
+            const char* newline = static_cast<const char*>(std::memchr(begin + ChunkBytes, '\n', end - begin - ChunkBytes));
+            chunkEnd = newline ? newline + 1 : end;
+        }
+        chunks.push_back({ begin, chunkEnd, 0, 0, 0, 0, 0, nullptr, 0 });
+        begin = chunkEnd;
+    }
+    return chunks;
+}
+
+void CountChunk(Chunk& chunk) noexcept {
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+        const char* lineEnd = newline ? newline : chunk.end;
+        switch (ClassifyLine(p, lineEnd)) {
+        case Record::Position: ++chunk.positions; break;
+        case Record::Texcoord: ++chunk.texcoords; break;
+        case Record::Normal: ++chunk.normals; break;
+        case Record::Face: {
+            uint32_t n = CountTokens(p, lineEnd);
+            if (n >= 3) chunk.corners += 3 * (n - 2);
+            break;
+        }
+        default: break;
+        }
+        ++chunk.line;
+        p = lineEnd + 1;
+    }
+}
+
+// Parses "v", "v/t", "v//n" or "v/t/n" with every index made absolute.
+bool ParseCorner(const char*& p, const char* end, const Chunk& chunk, const Chunk& totals,
+                 uint64_t positions, uint64_t texcoords, uint64_t normals,
+                 const ObjImportOptions& options, Corner& out) noexcept {
+    int64_t index;
+    out = { Missing, Missing, Missing };
+    if (!ParseInt(p, end, index) || !ResolveIndex(index, chunk.positions + positions, totals.positions, out.v)) return false;
+    if (p < end && *p == '/') {
+        ++p;
+        if (p < end && *p != '/') {
+            uint32_t t;
+            if (!ParseInt(p, end, index) || !ResolveIndex(index, chunk.texcoords + texcoords, totals.texcoords, t)) return false;
+            if (options.keepTexcoords) out.t = t;
+        }
+        if (p < end && *p == '/') {
+            ++p;
+            uint32_t n;
+            if (!ParseInt(p, end, index) || !ResolveIndex(index, chunk.normals + normals, totals.normals, n)) return false;
+            if (options.keepNormals) out.n = n;
+        }
+    }
+    return p == end || IsSpace(*p);
+}
+
+void ParseChunk(Chunk& chunk, const Chunk& totals, const ObjImportOptions& options, ParsedObj& obj) noexcept {
+    uint64_t positions = 0, texcoords = 0, normals = 0, corners = 0, line = 0;
+    const char* p = chunk.begin;
+    while (p < chunk.end && !chunk.error) {
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+        const char* lineEnd = newline ? newline : chunk.end;
+        bool ok = true;
+        switch (ClassifyLine(p, lineEnd)) {
+        case Record::Position: {
+            uint64_t v = chunk.positions + positions++;
+            float* xyz = &obj.positions[v * 3];
+            ok = ParseFloat(p, lineEnd, xyz[0]) && ParseFloat(p, lineEnd, xyz[1]) && ParseFloat(p, lineEnd, xyz[2]);
+            // Three extra values are a vertex colour; a single one is the rarely used w.
+            float extra[3];
+            uint32_t extraCount = 0;
+            while (ok && extraCount < 3 && SkipSpace(p, lineEnd) != lineEnd) ok = ParseFloat(p, lineEnd, extra[extraCount++]);
+            ok = ok && extraCount != 2;
+            obj.colors[v] = extraCount == 3 ? PackRGBA8(extra[0], extra[1], extra[2], 1.0f) : 0xFFFFFFFFu;
+            break;
+        }
+        case Record::Texcoord: {
+            float* uv = &obj.texcoords[(chunk.texcoords + texcoords++) * 2];
+            ok = ParseFloat(p, lineEnd, uv[0]);
+            uv[1] = 0.0f;
+            if (ok && SkipSpace(p, lineEnd) != lineEnd) ok = ParseFloat(p, lineEnd, uv[1]);
+            float w;
+            if (ok && SkipSpace(p, lineEnd) != lineEnd) ok = ParseFloat(p, lineEnd, w);
+            break;
+        }
+        case Record::Normal: {
+            float* n = &obj.normals[(chunk.normals + normals++) * 3];
+            ok = ParseFloat(p, lineEnd, n[0]) && ParseFloat(p, lineEnd, n[1]) && ParseFloat(p, lineEnd, n[2]);
+            break;
+        }
+        case Record::Face: {
+            if (CountTokens(p, lineEnd) < 3) {
+                p = lineEnd;
+                break;
+            }
+            Corner first, previous, current;
+            uint32_t n = 0;
+            for (p = SkipSpace(p, lineEnd); ok && p < lineEnd; p = SkipSpace(p, lineEnd), ++n) {
+                ok = ParseCorner(p, lineEnd, chunk, totals, positions, texcoords, normals, options, current);
+                if (!ok) break;
+                if (n == 0) {
+                    first = current;
+                } else if (n >= 2) {
+                    Corner* out = &obj.corners[chunk.corners + corners];
+                    out[0] = first;
+                    out[1] = previous;
+                    out[2] = current;
+                    corners += 3;
+                }
+                previous = current;
+            }
+            break;
+        }
+        default:
+            p = lineEnd;
+            break;
+        }
+        if (!ok || (p < lineEnd && SkipSpace(p, lineEnd) != lineEnd)) {
+            chunk.error = ok ? "unexpected data at end of line" : "malformed record";
+            chunk.errorLine = chunk.line + line + 1;
+        }
+        ++line;
+        p = lineEnd + 1;
+    }
+}
+
+// Merges identical corners. Corners are bucketed into a fixed number of hash
+// shards that are deduplicated independently, then vertices are renumbered in
+// order of first use so the result does not depend on the thread count.
+uint64_t DedupeCorners(ThreadPool& pool, const std::vector<Corner>& corners, std::vector<uint32_t>& indices,
+                       std::vector<uint32_t>& sourceCorner) {
+    const uint32_t cornerCount = static_cast<uint32_t>(corners.size());
+    const uint32_t blockCount = (cornerCount + CornerBlock - 1) / CornerBlock;
+    std::vector<uint32_t> offsets(size_t(blockCount) * ShardCount, 0);
+    pool.Run(blockCount, [&](uint32_t block, uint32_t) {
+        uint32_t* counts = &offsets[size_t(block) * ShardCount];
+        uint32_t end = block * CornerBlock + CornerBlock < cornerCount ? block * CornerBlock + CornerBlock : cornerCount;
+        for (uint32_t c = block * CornerBlock; c < end; ++c) ++counts[CornerShard(corners[c])];
+    });
+
+    uint32_t shardStart[ShardCount + 1];
+    uint32_t running = 0;
+    for (uint32_t shard = 0; shard < ShardCount; ++shard) {
+        shardStart[shard] = running;
+        for (uint32_t block = 0; block < blockCount; ++block) {
+            uint32_t n = offsets[size_t(block) * ShardCount + shard];
+            offsets[size_t(block) * ShardCount + shard] = running;
+            running += n;
+        }
+    }
+    shardStart[ShardCount] = running;
+
+    std::vector<uint32_t> order(cornerCount);
+    pool.Run(blockCount, [&](uint32_t block, uint32_t) {
+        uint32_t* next = &offsets[size_t(block) * ShardCount];
+        uint32_t end = block * CornerBlock + CornerBlock < cornerCount ? block * CornerBlock + CornerBlock : cornerCount;
+        for (uint32_t c = block * CornerBlock; c < end; ++c) order[next[CornerShard(corners[c])]++] = c;
+    });
+
+    // Open addressing per shard; slots hold the shard-local vertex id + 1.
+    indices.resize(cornerCount);
+    std::vector<uint32_t> shardUnique[ShardCount];
+    pool.Run(ShardCount, [&](uint32_t shard, uint32_t) {
+        uint32_t count = shardStart[shard + 1] - shardStart[shard];
+        uint32_t capacity = 16;
+        while (capacity < count * 2) capacity *= 2;
+        std::vector<uint32_t> table(capacity, 0);
+        std::vector<uint32_t>& unique = shardUnique[shard];
+        for (uint32_t i = shardStart[shard]; i < shardStart[shard + 1]; ++i) {
+            uint32_t c = order[i];
+            uint32_t slot = static_cast<uint32_t>(CornerHash(corners[c])) & (capacity - 1);
+            while (table[slot] && !SameCorner(corners[unique[table[slot] - 1]], corners[c])) slot = (slot + 1) & (capacity - 1);
+            if (!table[slot]) {
+                unique.push_back(c);
+                table[slot] = static_cast<uint32_t>(unique.size());
+            }
+            indices[c] = table[slot] - 1;
+        }
+    });
+
+    uint32_t shardBase[ShardCount];
+    uint32_t vertexCount = 0;
+    for (uint32_t shard = 0; shard < ShardCount; ++shard) {
+        shardBase[shard] = vertexCount;
+        vertexCount += static_cast<uint32_t>(shardUnique[shard].size());
+    }
+
+    pool.Run(blockCount, [&](uint32_t block, uint32_t) {
+        uint32_t end = block * CornerBlock + CornerBlock < cornerCount ? block * CornerBlock + CornerBlock : cornerCount;
+        for (uint32_t c = block * CornerBlock; c < end; ++c) indices[c] += shardBase[CornerShard(corners[c])];
+    });
+
+    std::vector<uint32_t> remap(vertexCount, Missing);
+    sourceCorner.resize(vertexCount);
+    uint32_t next = 0;
+    for (uint32_t c = 0; c < cornerCount; ++c) {
+        uint32_t& id = remap[indices[c]];
+        if (id == Missing) {
+            id = next++;
+            sourceCorner[id] = c;
+        }
+        indices[c] = id;
+    }
+    return vertexCount;
+}
+
+} // namespace
+
+bool ImportObj(const char* path, ThreadPool& pool, ObjMesh& out, const ObjImportOptions& options, std::string* error) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        if (error) *error = std::string(path) + ": cannot open";
+        return false;
+    }
+
+    std::vector<Chunk> chunks = SplitLines(reinterpret_cast<const char*>(file.Data()), file.Size());
+    const uint32_t chunkCount = static_cast<uint32_t>(chunks.size());
+    pool.Run(chunkCount, [&](uint32_t chunk, uint32_t) { CountChunk(chunks[chunk]); });
+
+    Chunk totals = {};
+    for (Chunk& chunk : chunks) {
+        Chunk counts = chunk;
+        chunk.line = totals.line;
+        chunk.positions = totals.positions;
+        chunk.texcoords = totals.texcoords;
+        chunk.normals = totals.normals;
+        chunk.corners = totals.corners;
+        totals.line += counts.line;
+        totals.positions += counts.positions;
+        totals.texcoords += counts.texcoords;
+        totals.normals += counts.normals;
+        totals.corners += counts.corners;
+    }
+    if (totals.corners == 0 || totals.positions >= Missing || totals.corners >= Missing) {
+        if (error) *error = std::string(path) + (totals.corners == 0 ? ": no faces" : ": mesh too large");
+        return false;
+    }
+
+    ParsedObj obj;
+    obj.positions.resize(totals.positions * 3);
+    obj.colors.resize(totals.positions);
+    obj.texcoords.resize(totals.texcoords * 2);
+    obj.normals.resize(totals.normals * 3);
+    obj.corners.resize(totals.corners);
+    pool.Run(chunkCount, [&](uint32_t chunk, uint32_t) { ParseChunk(chunks[chunk], totals, options, obj); });
+    for (const Chunk& chunk : chunks) {
+        if (chunk.error) {
+            if (error) *error = std::string(path) + ":" + std::to_string(chunk.errorLine) + ": " + chunk.error;
+            return false;
+        }
+    }
+
+    std::vector<uint32_t> sourceCorner;
+    out.vertexCount = DedupeCorners(pool, obj.corners, out.indices, sourceCorner);
+
+    // ColoredVertex fields first so the default layout is exactly Lab3's.
+    MeshVertexLayout& layout = out.layout;
+    layout = ColoredVertexLayout();
+    uint32_t normalOffset = 0, texcoordOffset = 0;
+    if (options.keepNormals) normalOffset = AppendAttribute(layout, "NORMAL", ElementFormat::R32G32B32_Float);
+    if (options.keepTexcoords) texcoordOffset = AppendAttribute(layout, "TEXCOORD", ElementFormat::R32G32_Float);
+
+    const uint32_t stride = layout.stride;
+    const uint32_t vertexCount = static_cast<uint32_t>(out.vertexCount);
+    out.vertices.assign(size_t(vertexCount) * stride, 0);
+    pool.Run((vertexCount + CornerBlock - 1) / CornerBlock, [&](uint32_t block, uint32_t) {
+        uint32_t end = block * CornerBlock + CornerBlock < vertexCount ? block * CornerBlock + CornerBlock : vertexCount;
+        for (uint32_t v = block * CornerBlock; v < end; ++v) {
+            const Corner& corner = obj.corners[sourceCorner[v]];
+            uint8_t* vertex = &out.vertices[size_t(v) * stride];
+            std::memcpy(vertex, &obj.positions[size_t(corner.v) * 3], 12);
+            std::memcpy(vertex + 12, &obj.colors[corner.v], 4);
+            if (options.keepNormals && corner.n != Missing) std::memcpy(vertex + normalOffset, &obj.normals[size_t(corner.n) * 3], 12);
+            if (options.keepTexcoords && corner.t != Missing) std::memcpy(vertex + texcoordOffset, &obj.texcoords[size_t(corner.t) * 2], 8);
+        }
+    });
+    return true;
+}
+
+bool ConvertObjToMeshFile(const char* objPath, const char* meshPath, ThreadPool& pool,
+                          const ObjImportOptions& options, std::string* error) {
+    ObjMesh mesh;
+    if (!ImportObj(objPath, pool, mesh, options, error)) return false;
+
+    const uint32_t vertexCount = static_cast<uint32_t>(mesh.vertexCount);
+    if (options.optimize) {
+        OptimizeVertexCache(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(), vertexCount);
+        OptimizeOverdraw(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(),
+                         mesh.layout.stride, vertexCount);
+        std::vector<uint8_t> vertices(mesh.vertices.size());
+        mesh.vertexCount = OptimizeVertexFetch(vertices.data(), mesh.indices.data(), mesh.indices.size(),
+                                               mesh.vertices.data(), vertexCount, mesh.layout.stride);
+        mesh.vertices.swap(vertices);
+    }
+
+    IndexFormat indexFormat = ChooseIndexFormat(static_cast<uint32_t>(mesh.vertexCount));
+    std::vector<uint8_t> packedIndices(mesh.indices.size() * IndexSize(indexFormat));
+    PackIndices(packedIndices.data(), mesh.indices.data(), mesh.indices.size(), indexFormat);
+    MeshSource source = { mesh.layout, mesh.vertices.data(), mesh.vertexCount,
+                          packedIndices.data(), indexFormat, mesh.indices.size() };
+    return WriteMeshFile(meshPath, source, error);
+}
+
+} // namespace gfx
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "MeshFile.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gfx {
+
+struct ObjImportOptions {
+    // Extra attributes appended after the ColoredVertex fields; they also take part in
+    // vertex deduplication, so keeping them usually produces more vertices.
+    bool keepNormals = false;
+    bool keepTexcoords = false;
+    // ConvertObjToMeshFile only: vertex cache, overdraw and vertex fetch reordering.
+    bool optimize = true;
+};
+
+struct ObjMesh {
+    MeshVertexLayout layout;
+    std::vector<uint8_t> vertices;
+    std::vector<uint32_t> indices;
+    uint64_t vertexCount = 0;
+};
+
+// Parses v/vt/vn/f records of a Wavefront OBJ in parallel line-aligned chunks,
+// fan-triangulates polygons and merges identical corners. "v x y z r g b" colours
+// are kept; vertices without one are white. The result is the same for any thread count.
+bool ImportObj(const char* path, ThreadPool& pool, ObjMesh& out,
+               const ObjImportOptions& options = {}, std::string* error = nullptr);
+
+// ImportObj, the MeshOptimizer passes and WriteMeshFile; indices are stored as 16-bit when they fit.
+bool ConvertObjToMeshFile(const char* objPath, const char* meshPath, ThreadPool& pool,
+                          const ObjImportOptions& options = {}, std::string* error = nullptr);
+
+} // namespace gfx
@@ -0,0 +1,377 @@
+#include "OcclusionCulling.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+namespace {
+
+constexpr uint32_t MinTrianglesPerChunk = 64;
+constexpr float GuardBand = 4.0f;
+constexpr float MinClipW = 1e-5f;
+
+// Near plane (0 <= z) and an x/y guard band that keeps the float edge equations small.
+constexpr float ClipPlanes[][4] = {
+    { 0.0f, 0.0f, 1.0f, 0.0f },
+    { 1.0f, 0.0f, 0.0f, GuardBand },
+    { -1.0f, 0.0f, 0.0f, GuardBand },
+    { 0.0f, 1.0f, 0.0f, GuardBand },
+    { 0.0f, -1.0f, 0.0f, GuardBand },
+};
+constexpr int ClipPlaneCount = sizeof(ClipPlanes) / sizeof(ClipPlanes[0]);
+constexpr int MaxClipVertices = 3 + ClipPlaneCount;
+
+inline float PlaneDistance(int plane, const Float4& p) noexcept {
+    const float* c = ClipPlanes[plane];
+    return c[0] * p.x + c[1] * p.y + c[2] * p.z + c[3] * p.w;
+}
+
+inline uint32_t OutCode(const Float4& p) noexcept {
+    uint32_t code = 0;
+    for (int i = 0; i < ClipPlaneCount; ++i) {
+        if (PlaneDistance(i, p) < 0.0f) code |= 1u << i;
+    }
+    return code;
+}
+
+inline uint32_t Log2(uint32_t value) noexcept {
+    uint32_t log = 0;
+    while ((1u << (log + 1)) <= value) ++log;
+    return log;
+}
+
+} // namespace
+
+OcclusionCuller::OcclusionCuller(ThreadPool& pool, uint32_t width, uint32_t height) : m_pool(pool) {
+    m_width = std::max(1u, (width + TileSize - 1) / TileSize) * TileSize;
+    m_height = std::max(1u, (height + TileSize - 1) / TileSize) * TileSize;
+    m_tilesX = m_width / TileSize;
+    m_tilesY = m_height / TileSize;
+    m_tileLevels = Log2(TileSize);
+
+    uint32_t w = m_width, h = m_height;
+    for (;;) {
+        m_levels.push_back({ w, h, std::vector<float>(size_t(w) * h, 1.0f) });
+        if (w == 1 && h == 1) break;
+        // Rounded up, so the last row and column of an odd level still have a parent.
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+}
+
+void OcclusionCuller::BeginFrame(const Float4x4& viewProj) noexcept {
+    m_viewProj = viewProj;
+    m_occluders.clear();
+    m_triangleCount = 0;
+    m_rendered = false;
+}
+
+void OcclusionCuller::AddOccluder(const void* positions, size_t stride, const uint32_t* indices, size_t indexCount,
+                                  const Float4x4& world) {
+    uint32_t triangles = static_cast<uint32_t>(indexCount / 3);
+    if (!positions || !indices || triangles == 0) return;
+    m_occluders.push_back({ static_cast<const uint8_t*>(positions), stride, indices, m_triangleCount, Multiply(world, m_viewProj) });
+    m_triangleCount += triangles;
+}
+
+void OcclusionCuller::RenderOccluders() {
+    // Setup and binning in chunks of the flattened triangle list, so one large
+    // occluder is spread over the pool as well as many small ones.
+    uint32_t threads = m_pool.ThreadCount();
+    uint32_t perChunk = std::max(MinTrianglesPerChunk, (m_triangleCount + threads * 4 - 1) / (threads * 4));
+    m_activeChunks = (m_triangleCount + perChunk - 1) / perChunk;
+    if (m_chunks.size() < m_activeChunks) m_chunks.resize(m_activeChunks);
+
+    uint32_t tileCount = m_tilesX * m_tilesY;
+    for (uint32_t c = 0; c < m_activeChunks; ++c) {
+        Chunk& chunk = m_chunks[c];
+        chunk.firstTriangle = c * perChunk;
+        chunk.triangleCount = std::min(perChunk, m_triangleCount - chunk.firstTriangle);
+        if (chunk.bins.size() != tileCount) chunk.bins.assign(tileCount, {});
+    }
+    m_pool.Run(m_activeChunks, [this](uint32_t c, uint32_t) { SetupChunk(m_chunks[c]); });
+
+    m_pool.Run(tileCount, [this](uint32_t tile, uint32_t) { RasterizeTile(tile); });
+
+    for (uint32_t level = m_tileLevels + 1; level < m_levels.size(); ++level) {
+        const Level& src = m_levels[level - 1];
+        Level& dst = m_levels[level];
+        for (uint32_t y = 0; y < dst.height; ++y) {
+            const float* row0 = src.depth.data() + size_t(std::min(y * 2, src.height - 1)) * src.width;
+            const float* row1 = src.depth.data() + size_t(std::min(y * 2 + 1, src.height - 1)) * src.width;
+            for (uint32_t x = 0; x < dst.width; ++x) {
+                uint32_t x0 = std::min(x * 2, src.width - 1), x1 = std::min(x * 2 + 1, src.width - 1);
+                dst.depth[size_t(y) * dst.width + x] = std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+            }
+        }
+    }
+
+    m_stats.occluderTriangles += m_triangleCount;
+    for (uint32_t c = 0; c < m_activeChunks; ++c) m_stats.trianglesRasterized += m_chunks[c].triangles.size();
+    m_rendered = true;
+}
+
+void OcclusionCuller::SetupChunk(Chunk& chunk) {
+    chunk.triangles.clear();
+    for (std::vector<uint32_t>& bin : chunk.bins) bin.clear();
+
+    // First occluder whose triangles reach into this chunk.
+    auto occluder = std::upper_bound(m_occluders.begin(), m_occluders.end(), chunk.firstTriangle,
+                                     [](uint32_t t, const Occluder& o) { return t < o.firstTriangle; }) - 1;
+    const uint32_t end = chunk.firstTriangle + chunk.triangleCount;
+    for (uint32_t t = chunk.firstTriangle; t < end; ++t) {
+        while (occluder + 1 != m_occluders.end() && (occluder + 1)->firstTriangle <= t) ++occluder;
+        const uint32_t* index = occluder->indices + size_t(t - occluder->firstTriangle) * 3;
+        Float4 clip[3];
+        for (int i = 0; i < 3; ++i) {
+            const float* p = reinterpret_cast<const float*>(occluder->positions + occluder->stride * index[i]);
+            clip[i] = TransformPoint({ p[0], p[1], p[2] }, occluder->worldViewProj);
+        }
+
+        uint32_t c0 = OutCode(clip[0]), c1 = OutCode(clip[1]), c2 = OutCode(clip[2]);
+        if (c0 & c1 & c2) continue;
+        if ((c0 | c1 | c2) == 0) {
+            EmitTriangle(chunk, clip[0], clip[1], clip[2]);
+            continue;
+        }
+
+        Float4 bufferA[MaxClipVertices], bufferB[MaxClipVertices];
+        Float4* in = bufferA;
+        Float4* out = bufferB;
+        int count = 3;
+        std::copy(clip, clip + 3, in);
+        uint32_t planes = c0 | c1 | c2;
+        for (int p = 0; p < ClipPlaneCount && count >= 3; ++p) {
+            if (!(planes & (1u << p))) continue;
+            int outCount = 0;
+            for (int i = 0; i < count; ++i) {
+                const Float4& a = in[i];
+                const Float4& b = in[(i + 1) % count];
+                float da = PlaneDistance(p, a);
+                float db = PlaneDistance(p, b);
+                if (da >= 0.0f) out[outCount++] = a;
+                if ((da >= 0.0f) != (db >= 0.0f)) {
+                    float s = da / (da - db);
+                    out[outCount++] = { a.x + (b.x - a.x) * s, a.y + (b.y - a.y) * s, a.z + (b.z - a.z) * s, a.w + (b.w - a.w) * s };
+                }
+            }
+            std::swap(in, out);
+            count = outCount;
+        }
+        for (int i = 1; i + 1 < count; ++i) EmitTriangle(chunk, in[0], in[i], in[i + 1]);
+    }
+
+    for (uint32_t i = 0; i < chunk.triangles.size(); ++i) {
+        const Triangle& tri = chunk.triangles[i];
+        for (uint32_t ty = uint32_t(tri.minY) / TileSize; ty <= uint32_t(tri.maxY) / TileSize; ++ty) {
+            for (uint32_t tx = uint32_t(tri.minX) / TileSize; tx <= uint32_t(tri.maxX) / TileSize; ++tx) {
+                chunk.bins[ty * m_tilesX + tx].push_back(i);
+            }
+        }
+    }
+}
+
+void OcclusionCuller::EmitTriangle(Chunk& chunk, const Float4& a, const Float4& b, const Float4& c) {
+    const Float4* v[3] = { &a, &b, &c };
+    float sx[3], sy[3], sz[3];
+    for (int i = 0; i < 3; ++i) {
+        float invW = 1.0f / std::max(v[i]->w, MinClipW);
+        sx[i] = (v[i]->x * invW + 1.0f) * 0.5f * m_width;
+        sy[i] = (1.0f - v[i]->y * invW) * 0.5f * m_height;
+        sz[i] = v[i]->z * invW;
+    }
+
+    // Both windings are kept: the nearest depth wins anyway, so occluders need not be
+    // closed or consistently wound. Counter-clockwise triangles are flipped.
+    float area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sy[1] - sy[0]) * (sx[2] - sx[0]);
+    if (area < 0.0f) {
+        std::swap(sx[1], sx[2]);
+        std::swap(sy[1], sy[2]);
+        std::swap(sz[1], sz[2]);
+        area = -area;
+    }
+    if (!(area > 0.0f)) return;
+
+    Triangle tri;
+    tri.minX = std::max(0, static_cast<int32_t>(std::floor(std::min({ sx[0], sx[1], sx[2] }) - 0.5f)));
+    tri.minY = std::max(0, static_cast<int32_t>(std::floor(std::min({ sy[0], sy[1], sy[2] }) - 0.5f)));
+    tri.maxX = std::min(static_cast<int32_t>(m_width) - 1, static_cast<int32_t>(std::ceil(std::max({ sx[0], sx[1], sx[2] }) - 0.5f)));
+    tri.maxY = std::min(static_cast<int32_t>(m_height) - 1, static_cast<int32_t>(std::ceil(std::max({ sy[0], sy[1], sy[2] }) - 0.5f)));
+    if (tri.minX > tri.maxX || tri.minY > tri.maxY) return;
+
+    // Edge e runs between the other two vertices; its value is vertex e's barycentric weight times area.
+    const int next[3] = { 1, 2, 0 };
+    float weight[3][3];
+    for (int e = 0; e < 3; ++e) {
+        int i = next[e], j = next[i];
+        tri.edge[e][0] = -(sy[j] - sy[i]);
+        tri.edge[e][1] = sx[j] - sx[i];
+        tri.edge[e][2] = (sy[j] - sy[i]) * sx[i] - (sx[j] - sx[i]) * sy[i];
+        for (int k = 0; k < 3; ++k) weight[e][k] = tri.edge[e][k] / area;
+    }
+    for (int k = 0; k < 3; ++k) tri.depth[k] = weight[0][k] * sz[0] + weight[1][k] * sz[1] + weight[2][k] * sz[2];
+    chunk.triangles.push_back(tri);
+}
+
+void OcclusionCuller::RasterizeTile(uint32_t tile) {
+    const int32_t x0 = static_cast<int32_t>((tile % m_tilesX) * TileSize);
+    const int32_t y0 = static_cast<int32_t>((tile / m_tilesX) * TileSize);
+    const int32_t x1 = x0 + static_cast<int32_t>(TileSize) - 1;
+    const int32_t y1 = y0 + static_cast<int32_t>(TileSize) - 1;
+    float* depth = m_levels[0].depth.data();
+    const size_t pitch = m_width;
+
+    for (int32_t y = y0; y <= y1; ++y) std::fill(depth + y * pitch + x0, depth + y * pitch + x1 + 1, 1.0f);
+
+    for (uint32_t c = 0; c < m_activeChunks; ++c) {
+        const Chunk& chunk = m_chunks[c];
+        for (uint32_t triIndex : chunk.bins[tile]) {
+            const Triangle& tri = chunk.triangles[triIndex];
+            int32_t minY = std::max(tri.minY, y0), maxY = std::min(tri.maxY, y1);
+            int32_t minX = std::max(tri.minX, x0), maxX = std::min(tri.maxX, x1);
+            if (minX > maxX || minY > maxY) continue;
+#if GFX_X86
+            if (m_level != SimdLevel::Scalar) {
+                // Four pixels per step from a 4-aligned start; lanes outside the
+                // triangle fail an edge test, and tiles are a multiple of 4 wide.
+                minX &= ~3;
+                const __m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+                const __m128 a0 = _mm_set1_ps(tri.edge[0][0]), a1 = _mm_set1_ps(tri.edge[1][0]), a2 = _mm_set1_ps(tri.edge[2][0]);
+                const __m128 az = _mm_set1_ps(tri.depth[0]);
+                const __m128 zero = _mm_setzero_ps();
+                for (int32_t y = minY; y <= maxY; ++y) {
+                    float py = y + 0.5f;
+                    __m128 b0 = _mm_set1_ps(tri.edge[0][1] * py + tri.edge[0][2]);
+                    __m128 b1 = _mm_set1_ps(tri.edge[1][1] * py + tri.edge[1][2]);
+                    __m128 b2 = _mm_set1_ps(tri.edge[2][1] * py + tri.edge[2][2]);
+                    __m128 bz = _mm_set1_ps(tri.depth[1] * py + tri.depth[2]);
+                    float* row = depth + y * pitch;
+                    for (int32_t x = minX; x <= maxX; x += 4) {
+                        __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane);
+                        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), b0), zero),
+                                                              _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), b1), zero)),
+                                                   _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), b2), zero));
+                        if (_mm_movemask_ps(inside) == 0) continue;
+                        __m128 old = _mm_loadu_ps(row + x);
+                        __m128 z = _mm_min_ps(old, _mm_add_ps(_mm_mul_ps(az, px), bz));
+                        _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, z), _mm_andnot_ps(inside, old)));
+                    }
+                }
+                continue;
+            }
+#endif
+            for (int32_t y = minY; y <= maxY; ++y) {
+                float py = y + 0.5f;
+                float* row = depth + y * pitch;
+                for (int32_t x = minX; x <= maxX; ++x) {
+                    float px = x + 0.5f;
+                    // Same evaluation order as the SSE path, so both give identical buffers.
+                    if (tri.edge[0][0] * px + (tri.edge[0][1] * py + tri.edge[0][2]) < 0.0f ||
+                        tri.edge[1][0] * px + (tri.edge[1][1] * py + tri.edge[1][2]) < 0.0f ||
+                        tri.edge[2][0] * px + (tri.edge[2][1] * py + tri.edge[2][2]) < 0.0f) continue;
+                    row[x] = std::min(row[x], tri.depth[0] * px + (tri.depth[1] * py + tri.depth[2]));
+                }
+            }
+        }
+    }
+
+    // The pyramid levels that lie entirely inside this tile.
+    for (uint32_t level = 1; level <= m_tileLevels; ++level) {
+        const Level& src = m_levels[level - 1];
+        Level& dst = m_levels[level];
+        uint32_t size = TileSize >> level;
+        uint32_t dx = static_cast<uint32_t>(x0) >> level, dy = static_cast<uint32_t>(y0) >> level;
+        for (uint32_t y = dy; y < dy + size; ++y) {
+            const float* row0 = src.depth.data() + size_t(y * 2) * src.width;
+            const float* row1 = row0 + src.width;
+            float* out = dst.depth.data() + size_t(y) * dst.width;
+            for (uint32_t x = dx; x < dx + size; ++x) {
+                out[x] = std::max(std::max(row0[x * 2], row0[x * 2 + 1]), std::max(row1[x * 2], row1[x * 2 + 1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::TestBox(const Float3& center, const Float3& extent) const noexcept {
+    // The corners are center +- the three scaled matrix rows.
+    const Float4x4& m = m_viewProj;
+    Float4 c = TransformPoint(center, m);
+    Float4 axis[3];
+    for (int i = 0; i < 3; ++i) {
+        float e = i == 0 ? extent.x : (i == 1 ? extent.y : extent.z);
+        axis[i] = { m.m[i][0] * e, m.m[i][1] * e, m.m[i][2] * e, m.m[i][3] * e };
+    }
+
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, minZ = 1e30f;
+    int nearCorners = 0;
+    for (int corner = 0; corner < 8; ++corner) {
+        float sx = (corner & 1) ? 1.0f : -1.0f, sy = (corner & 2) ? 1.0f : -1.0f, sz = (corner & 4) ? 1.0f : -1.0f;
+        Float4 p = { c.x + sx * axis[0].x + sy * axis[1].x + sz * axis[2].x, c.y + sx * axis[0].y + sy * axis[1].y + sz * axis[2].y,
+                     c.z + sx * axis[0].z + sy * axis[1].z + sz * axis[2].z, c.w + sx * axis[0].w + sy * axis[1].w + sz * axis[2].w };
+        if (p.z < 0.0f || p.w < MinClipW) {
+            ++nearCorners;
+            continue;
+        }
+        float invW = 1.0f / p.w;
+        float x = (p.x * invW + 1.0f) * 0.5f * m_width;
+        float y = (1.0f - p.y * invW) * 0.5f * m_height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minZ = std::min(minZ, p.z * invW);
+    }
+    // Entirely on the camera side of the near plane is hidden; crossing it is visible.
+    if (nearCorners == 8) return false;
+    if (nearCorners > 0) return true;
+    if (maxX < 0.0f || maxY < 0.0f || minX >= m_width || minY >= m_height) return false;
+
+    uint32_t ix0 = static_cast<uint32_t>(std::max(0.0f, minX));
+    uint32_t iy0 = static_cast<uint32_t>(std::max(0.0f, minY));
+    uint32_t ix1 = static_cast<uint32_t>(std::min(maxX, m_width - 1.0f));
+    uint32_t iy1 = static_cast<uint32_t>(std::min(maxY, m_height - 1.0f));
+    uint32_t level = 0;
+    const uint32_t topLevel = static_cast<uint32_t>(m_levels.size()) - 1;
+    while (level < topLevel && ((ix1 >> level) - (ix0 >> level) > 1 || (iy1 >> level) - (iy0 >> level) > 1)) ++level;
+
+    const Level& hiz = m_levels[level];
+    const uint32_t tx1 = std::min(ix1 >> level, hiz.width - 1), ty1 = std::min(iy1 >> level, hiz.height - 1);
+    for (uint32_t y = std::min(iy0 >> level, ty1); y <= ty1; ++y) {
+        for (uint32_t x = std::min(ix0 >> level, tx1); x <= tx1; ++x) {
+            if (minZ <= hiz.depth[size_t(y) * hiz.width + x]) return true;
+        }
+    }
+    return false;
+}
+
+bool OcclusionCuller::IsVisible(const Float3& center, const Float3& extent) const noexcept {
+    return !m_rendered || TestBox(center, extent);
+}
+
+void OcclusionCuller::Cull(const AabbStreams& bounds, const uint32_t* candidates, uint32_t count, std::vector<uint32_t>& visible) {
+    uint32_t blocks = (count + BlockSize - 1) / BlockSize;
+    if (m_blockResults.size() < blocks) m_blockResults.resize(blocks);
+
+    m_pool.Run(blocks, [&](uint32_t block, uint32_t) {
+        std::vector<uint32_t>& out = m_blockResults[block];
+        out.clear();
+        uint32_t end = std::min(count, (block + 1) * BlockSize);
+        for (uint32_t i = block * BlockSize; i < end; ++i) {
+            uint32_t object = candidates ? candidates[i] : i;
+            if (IsVisible({ bounds.centerX[object], bounds.centerY[object], bounds.centerZ[object] },
+                          { bounds.extentX[object], bounds.extentY[object], bounds.extentZ[object] })) {
+                out.push_back(object);
+            }
+        }
+    });
+
+    size_t offset = visible.size();
+    for (uint32_t b = 0; b < blocks; ++b) {
+        visible.insert(visible.end(), m_blockResults[b].begin(), m_blockResults[b].end());
+    }
+    m_stats.boxesTested += count;
+    m_stats.boxesOccluded += count - (visible.size() - offset);
+}
+
+} // namespace gfx
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "MathTypes.h"
+#include "Scene.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+struct OcclusionStats {
+    uint64_t occluderTriangles = 0;
+    uint64_t trianglesRasterized = 0;
+    uint64_t boxesTested = 0;
+    uint64_t boxesOccluded = 0;
+};
+
+// CPU occlusion culling against a low-resolution depth buffer. Selected occluder
+// meshes are rasterized depth-only with the nearest depth winning, so the buffer
+// does not depend on submission order or thread count. Each screen tile is cleared,
+// rasterized and reduced into its part of a max-depth pyramid by one task. Boxes are
+// then tested at the pyramid level where they span at most 2x2 texels: a box is
+// hidden when its nearest corner lies behind the farthest occluder depth there.
+// Occluder coverage is sampled at pixel centers, so small holes at occluder
+// silhouettes can hide a sliver of an object; boxes crossing the near plane are
+// always visible.
+class OcclusionCuller {
+public:
+    static constexpr uint32_t TileSize = 32;
+    static constexpr uint32_t BlockSize = 4096;
+
+    // width and height are rounded up to multiples of TileSize.
+    OcclusionCuller(ThreadPool& pool, uint32_t width = 256, uint32_t height = 128);
+
+    void SetSimdLevel(SimdLevel level) noexcept { m_level = level; }
+
+    // Starts a frame with viewProj as uploaded by UpdateViewProjBuffer.
+    void BeginFrame(const Float4x4& viewProj) noexcept;
+
+    // Queues a triangle list of float3 positions; positions and indices are read during
+    // RenderOccluders.
+    void AddOccluder(const void* positions, size_t stride, const uint32_t* indices, size_t indexCount, const Float4x4& world);
+
+    // Rasterizes the queued occluders and builds the depth pyramid.
+    void RenderOccluders();
+
+    // World-space box given as center and half extent, as in AabbStreams.
+    // Boxes entirely off screen count as hidden.
+    bool IsVisible(const Float3& center, const Float3& extent) const noexcept;
+
+    // Appends the candidates (or all of [0, count) when candidates is null) that may be
+    // visible, keeping their order.
+    void Cull(const AabbStreams& bounds, const uint32_t* candidates, uint32_t count, std::vector<uint32_t>& visible);
+
+    uint32_t Width() const noexcept { return m_width; }
+    uint32_t Height() const noexcept { return m_height; }
+    // Level 0 is the depth buffer itself, row-major.
+    uint32_t LevelCount() const noexcept { return static_cast<uint32_t>(m_levels.size()); }
+    // Each level is half the one below, rounded up.
+    uint32_t LevelWidth(uint32_t level) const noexcept { return m_levels[level].width; }
+    uint32_t LevelHeight(uint32_t level) const noexcept { return m_levels[level].height; }
+    const float* Depth(uint32_t level = 0) const noexcept { return m_levels[level].depth.data(); }
+
+    const OcclusionStats& Stats() const noexcept { return m_stats; }
+    void ResetStats() noexcept { m_stats = {}; }
+
+private:
+    struct Occluder {
+        const uint8_t* positions;
+        size_t stride;
+        const uint32_t* indices;
+        uint32_t firstTriangle;
+        Float4x4 worldViewProj;
+    };
+
+    // Edge i is edge[i][0] * x + edge[i][1] * y + edge[i][2] >= 0 inside; depth is a
+    // plane in screen space.
+    struct Triangle {
+        float edge[3][3];
+        float depth[3];
+        int32_t minX, minY, maxX, maxY;
+    };
+
+    struct Chunk {
+        uint32_t firstTriangle = 0;
+        uint32_t triangleCount = 0;
+        std::vector<Triangle> triangles;
+        std::vector<std::vector<uint32_t>> bins;
+        uint64_t submitted = 0;
+    };
+
+    struct Level {
+        uint32_t width, height;
+        std::vector<float> depth;
+    };
+
+    void SetupChunk(Chunk& chunk);
+    void EmitTriangle(Chunk& chunk, const Float4& a, const Float4& b, const Float4& c);
+    void RasterizeTile(uint32_t tile);
+    bool TestBox(const Float3& center, const Float3& extent) const noexcept;
+
+    ThreadPool& m_pool;
+    SimdLevel m_level = BestSimdLevel();
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_tilesX;
+    uint32_t m_tilesY;
+    // Levels up to this one are reduced per tile; the rest after all tiles are done.
+    uint32_t m_tileLevels;
+    Float4x4 m_viewProj = MatrixIdentity();
+    std::vector<Occluder> m_occluders;
+    uint32_t m_triangleCount = 0;
+    std::vector<Chunk> m_chunks;
+    uint32_t m_activeChunks = 0;
+    std::vector<Level> m_levels;
+    std::vector<std::vector<uint32_t>> m_blockResults;
+    bool m_rendered = false;
+    OcclusionStats m_stats;
+};
+
+} // namespace gfx
@@ -0,0 +1,49 @@
+#include "ParallelCommandRecorder.h"
+
+#include <algorithm>
+
+namespace gfx {
+
+void ParallelCommandRecorder::Record(uint32_t sliceCount, const RecordFn& record) {
+    m_sliceCount = sliceCount;
+    if (m_lists.size() < sliceCount) m_lists.resize(sliceCount);
+    m_pool.Run(sliceCount, [&](uint32_t slice, uint32_t) {
+        CommandBuffer& list = m_lists[slice];
+        list.Reset();
+        record(list, slice);
+    });
+}
+
+void ParallelCommandRecorder::Merge(CommandBuffer& out) {
+    out.Reset();
+
+    m_offsets.resize(m_sliceCount + 1);
+    m_offsets[0] = 0;
+    for (uint32_t slice = 0; slice < m_sliceCount; ++slice) {
+        const CommandBuffer& list = m_lists[slice];
+        m_offsets[slice + 1] = m_offsets[slice] + list.m_draws.size();
+
+        // Pass states are tiny; apply them serially so later slices win.
+        for (size_t pass = 0; pass < list.m_passes.size(); ++pass) {
+            if (list.m_passSet[pass]) out.SetPass(static_cast<uint32_t>(pass), list.m_passes[pass]);
+        }
+        if (out.m_passes.size() < list.m_passes.size()) {
+            out.m_passes.resize(list.m_passes.size(), PassState{});
+            out.m_passSet.resize(list.m_passes.size(), false);
+        }
+    }
+
+    size_t total = m_offsets[m_sliceCount];
+    out.m_draws.resize(total);
+    out.m_sorted.resize(total);
+    m_pool.Run(m_sliceCount, [&](uint32_t slice, uint32_t) {
+        const CommandBuffer& list = m_lists[slice];
+        size_t base = m_offsets[slice];
+        std::copy(list.m_draws.begin(), list.m_draws.end(), out.m_draws.begin() + base);
+        for (size_t i = 0; i < list.m_sorted.size(); ++i) {
+            out.m_sorted[base + i] = { list.m_sorted[i].key, static_cast<uint32_t>(base + list.m_sorted[i].index) };
+        }
+    });
+}
+
+} // namespace gfx
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "CommandBuffer.h"
+#include "ThreadPool.h"
+
+#include <functional>
+#include <vector>
+
+namespace gfx {
+
+// Records a frame as independent slices on the thread pool, one CommandBuffer
+// per slice (like D3D11 deferred contexts), then merges them in slice order.
+// The merged list depends only on the slice count, not on thread count or
+// scheduling, so a stable sort afterwards gives the same submission every run.
+class ParallelCommandRecorder {
+public:
+    using RecordFn = std::function<void(CommandBuffer& list, uint32_t slice)>;
+
+    explicit ParallelCommandRecorder(ThreadPool& pool) : m_pool(pool) {}
+
+    // Resets the slice lists and calls record once per slice.
+    void Record(uint32_t sliceCount, const RecordFn& record);
+
+    // Replaces out's draws with the slice lists concatenated in slice order.
+    void Merge(CommandBuffer& out);
+
+    uint32_t SliceCount() const noexcept { return m_sliceCount; }
+    const CommandBuffer& Slice(uint32_t slice) const noexcept { return m_lists[slice]; }
+
+private:
+    ThreadPool& m_pool;
+    std::vector<CommandBuffer> m_lists;
+    std::vector<size_t> m_offsets;
+    uint32_t m_sliceCount = 0;
+};
+
+} // namespace gfx
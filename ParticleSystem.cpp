@@ -0,0 +1,402 @@
+#include "ParticleSystem.h"
+
+#include "Hash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+using Streams = float* const*;
+
+struct Step {
+    float dt;
+    float damping;
+    // Gravity times dt.
+    float gravity[3];
+    float ground;
+    float negRestitution;
+    float size0, sizeDelta;
+    // Color channels in [0, 255].
+    float color0[4], colorDelta[4];
+};
+
+Step MakeStep(const ParticleSettings& settings, float dt) noexcept {
+    Step step;
+    step.dt = dt;
+    step.damping = std::exp(-settings.drag * dt);
+    step.gravity[0] = settings.gravity.x * dt;
+    step.gravity[1] = settings.gravity.y * dt;
+    step.gravity[2] = settings.gravity.z * dt;
+    step.ground = settings.groundHeight;
+    step.negRestitution = -settings.restitution;
+    step.size0 = settings.startSize;
+    step.sizeDelta = settings.endSize - settings.startSize;
+    for (int c = 0; c < 4; ++c) {
+        float start = static_cast<float>((settings.startColor >> (c * 8)) & 0xFF);
+        float end = static_cast<float>((settings.endColor >> (c * 8)) & 0xFF);
+        step.color0[c] = start;
+        step.colorDelta[c] = end - start;
+    }
+    return step;
+}
+
+// Lane permutations that move the lanes set in a compare mask to the front.
+struct PackTable {
+    alignas(32) int32_t lanes8[256][8];
+    alignas(16) uint8_t bytes4[16][16];
+    uint8_t count[256];
+
+    PackTable() noexcept {
+        for (uint32_t mask = 0; mask < 256; ++mask) {
+            uint32_t n = 0;
+            for (uint32_t lane = 0; lane < 8; ++lane) {
+                if (mask & (1u << lane)) lanes8[mask][n++] = static_cast<int32_t>(lane);
+            }
+            count[mask] = static_cast<uint8_t>(n);
+            for (uint32_t lane = n; lane < 8; ++lane) lanes8[mask][lane] = 0;
+        }
+        for (uint32_t mask = 0; mask < 16; ++mask) {
+            for (uint32_t lane = 0; lane < 4; ++lane) {
+                uint32_t from = lane < count[mask] ? static_cast<uint32_t>(lanes8[mask][lane]) : 0;
+                for (uint32_t b = 0; b < 4; ++b) bytes4[mask][lane * 4 + b] = static_cast<uint8_t>(from * 4 + b);
+            }
+        }
+    }
+};
+
+const PackTable& GetPackTable() noexcept {
+    static const PackTable table;
+    return table;
+}
+
+template<typename Fn>
+void ForEachChunk(ThreadPool* pool, uint32_t count, const Fn& fn) {
+    const uint32_t chunks = (count + ParticleSystem::ChunkSize - 1) / ParticleSystem::ChunkSize;
+    auto run = [&](uint32_t chunk) {
+        uint32_t begin = chunk * ParticleSystem::ChunkSize;
+        fn(chunk, begin, std::min(begin + ParticleSystem::ChunkSize, count));
+    };
+    if (pool && chunks > 1) {
+        pool->Run(chunks, [&](uint32_t chunk, uint32_t) { run(chunk); });
+    } else {
+        for (uint32_t chunk = 0; chunk < chunks; ++chunk) run(chunk);
+    }
+}
+
+float SignedUnit(uint64_t bits) noexcept {
+    return static_cast<float>(bits & 0xFFFFFF) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+// The SIMD kernels below evaluate the same expressions in the same order without
+// FMA, so every level produces the same bits.
+
+uint32_t IntegrateScalar(Streams s, const Step& step, uint32_t i, uint32_t end) noexcept {
+    uint32_t alive = 0;
+    for (; i < end; ++i) {
+        float vx = (s[ParticleVelocityX][i] + step.gravity[0]) * step.damping;
+        float vy = (s[ParticleVelocityY][i] + step.gravity[1]) * step.damping;
+        float vz = (s[ParticleVelocityZ][i] + step.gravity[2]) * step.damping;
+        float x = s[ParticleX][i] + vx * step.dt;
+        float y = s[ParticleY][i] + vy * step.dt;
+        float z = s[ParticleZ][i] + vz * step.dt;
+        bool below = y < step.ground;
+        y = below ? step.ground : y;
+        vy = below ? vy * step.negRestitution : vy;
+        float age = s[ParticleAge][i] + step.dt;
+        s[ParticleX][i] = x;
+        s[ParticleY][i] = y;
+        s[ParticleZ][i] = z;
+        s[ParticleVelocityX][i] = vx;
+        s[ParticleVelocityY][i] = vy;
+        s[ParticleVelocityZ][i] = vz;
+        s[ParticleAge][i] = age;
+        alive += age < s[ParticleLifetime][i];
+    }
+    return alive;
+}
+
+// Copies the live particles of source[i...] to destination[w, end) in order. The
+// loop stops at the last survivor, so stores never leave the destination range.
+void CompactScalar(Streams source, Streams destination, uint32_t i, uint32_t w, uint32_t end) noexcept {
+    for (; w < end; ++i) {
+        for (uint32_t s = 0; s < ParticleStreamCount; ++s) destination[s][w] = source[s][i];
+        w += source[ParticleAge][i] < source[ParticleLifetime][i];
+    }
+}
+
+void WriteScalar(Streams s, const Step& step, uint32_t i, uint32_t end, ParticleInstance* out) noexcept {
+    for (; i < end; ++i) {
+        float t = s[ParticleAge][i] / s[ParticleLifetime][i];
+        ParticleInstance instance;
+        instance.position[0] = s[ParticleX][i];
+        instance.position[1] = s[ParticleY][i];
+        instance.position[2] = s[ParticleZ][i];
+        instance.size = step.size0 + step.sizeDelta * t;
+        instance.rgba = 0;
+        for (int c = 0; c < 4; ++c) {
+            uint32_t channel = static_cast<uint32_t>(static_cast<int32_t>(step.color0[c] + step.colorDelta[c] * t + 0.5f));
+            instance.rgba |= channel << (c * 8);
+        }
+        out[i] = instance;
+    }
+}
+
+#if GFX_X86
+GFX_TARGET_SSE41 uint32_t IntegrateSSE(Streams s, const Step& step, uint32_t& i, uint32_t end, const PackTable& table) noexcept {
+    const __m128 dt = _mm_set1_ps(step.dt), damping = _mm_set1_ps(step.damping);
+    const __m128 gx = _mm_set1_ps(step.gravity[0]), gy = _mm_set1_ps(step.gravity[1]), gz = _mm_set1_ps(step.gravity[2]);
+    const __m128 ground = _mm_set1_ps(step.ground), negRestitution = _mm_set1_ps(step.negRestitution);
+    uint32_t alive = 0;
+    for (; i + 4 <= end; i += 4) {
+        __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(s[ParticleVelocityX] + i), gx), damping);
+        __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(s[ParticleVelocityY] + i), gy), damping);
+        __m128 vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(s[ParticleVelocityZ] + i), gz), damping);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(s[ParticleX] + i), _mm_mul_ps(vx, dt));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(s[ParticleY] + i), _mm_mul_ps(vy, dt));
+        __m128 z = _mm_add_ps(_mm_loadu_ps(s[ParticleZ] + i), _mm_mul_ps(vz, dt));
+        __m128 below = _mm_cmplt_ps(y, ground);
+        y = _mm_blendv_ps(y, ground, below);
+        vy = _mm_blendv_ps(vy, _mm_mul_ps(vy, negRestitution), below);
+        __m128 age = _mm_add_ps(_mm_loadu_ps(s[ParticleAge] + i), dt);
+        _mm_storeu_ps(s[ParticleX] + i, x);
+        _mm_storeu_ps(s[ParticleY] + i, y);
+        _mm_storeu_ps(s[ParticleZ] + i, z);
+        _mm_storeu_ps(s[ParticleVelocityX] + i, vx);
+        _mm_storeu_ps(s[ParticleVelocityY] + i, vy);
+        _mm_storeu_ps(s[ParticleVelocityZ] + i, vz);
+        _mm_storeu_ps(s[ParticleAge] + i, age);
+        alive += table.count[_mm_movemask_ps(_mm_cmplt_ps(age, _mm_loadu_ps(s[ParticleLifetime] + i)))];
+    }
+    return alive;
+}
+
+GFX_TARGET_SSE41 void CompactSSE(Streams source, Streams destination, uint32_t& i, uint32_t& w, uint32_t sourceEnd,
+                                 uint32_t end, const PackTable& table) noexcept {
+    for (; i + 4 <= sourceEnd && w + 4 <= end; i += 4) {
+        __m128 alive = _mm_cmplt_ps(_mm_loadu_ps(source[ParticleAge] + i), _mm_loadu_ps(source[ParticleLifetime] + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(alive));
+        __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(table.bytes4[mask]));
+        for (uint32_t s = 0; s < ParticleStreamCount; ++s) {
+            __m128i v = _mm_castps_si128(_mm_loadu_ps(source[s] + i));
+            _mm_storeu_ps(destination[s] + w, _mm_castsi128_ps(_mm_shuffle_epi8(v, shuffle)));
+        }
+        w += table.count[mask];
+    }
+}
+
+GFX_TARGET_SSE41 void WriteSSE(Streams s, const Step& step, uint32_t& i, uint32_t end, ParticleInstance* out) noexcept {
+    const __m128 size0 = _mm_set1_ps(step.size0), sizeDelta = _mm_set1_ps(step.sizeDelta), half = _mm_set1_ps(0.5f);
+    __m128 color0[4], colorDelta[4];
+    for (int c = 0; c < 4; ++c) {
+        color0[c] = _mm_set1_ps(step.color0[c]);
+        colorDelta[c] = _mm_set1_ps(step.colorDelta[c]);
+    }
+    for (; i + 4 <= end; i += 4) {
+        __m128 t = _mm_div_ps(_mm_loadu_ps(s[ParticleAge] + i), _mm_loadu_ps(s[ParticleLifetime] + i));
+        alignas(16) float size[4];
+        alignas(16) uint32_t rgba[4];
+        _mm_store_ps(size, _mm_add_ps(size0, _mm_mul_ps(sizeDelta, t)));
+        __m128i packed = _mm_setzero_si128();
+        for (int c = 0; c < 4; ++c) {
+            __m128i channel = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(color0[c], _mm_mul_ps(colorDelta[c], t)), half));
+            packed = _mm_or_si128(packed, _mm_slli_epi32(channel, c * 8));
+        }
+        _mm_store_si128(reinterpret_cast<__m128i*>(rgba), packed);
+        ParticleInstance batch[4];
+        for (uint32_t k = 0; k < 4; ++k) {
+            batch[k].position[0] = s[ParticleX][i + k];
+            batch[k].position[1] = s[ParticleY][i + k];
+            batch[k].position[2] = s[ParticleZ][i + k];
+            batch[k].size = size[k];
+            batch[k].rgba = rgba[k];
+        }
+        memcpy(out + i, batch, sizeof(batch));
+    }
+}
+
+GFX_TARGET_AVX2 uint32_t IntegrateAVX2(Streams s, const Step& step, uint32_t& i, uint32_t end, const PackTable& table) noexcept {
+    const __m256 dt = _mm256_set1_ps(step.dt), damping = _mm256_set1_ps(step.damping);
+    const __m256 gx = _mm256_set1_ps(step.gravity[0]), gy = _mm256_set1_ps(step.gravity[1]), gz = _mm256_set1_ps(step.gravity[2]);
+    const __m256 ground = _mm256_set1_ps(step.ground), negRestitution = _mm256_set1_ps(step.negRestitution);
+    uint32_t alive = 0;
+    for (; i + 8 <= end; i += 8) {
+        __m256 vx = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(s[ParticleVelocityX] + i), gx), damping);
+        __m256 vy = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(s[ParticleVelocityY] + i), gy), damping);
+        __m256 vz = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(s[ParticleVelocityZ] + i), gz), damping);
+        __m256 x = _mm256_add_ps(_mm256_loadu_ps(s[ParticleX] + i), _mm256_mul_ps(vx, dt));
+        __m256 y = _mm256_add_ps(_mm256_loadu_ps(s[ParticleY] + i), _mm256_mul_ps(vy, dt));
+        __m256 z = _mm256_add_ps(_mm256_loadu_ps(s[ParticleZ] + i), _mm256_mul_ps(vz, dt));
+        __m256 below = _mm256_cmp_ps(y, ground, _CMP_LT_OQ);
+        y = _mm256_blendv_ps(y, ground, below);
+        vy = _mm256_blendv_ps(vy, _mm256_mul_ps(vy, negRestitution), below);
+        __m256 age = _mm256_add_ps(_mm256_loadu_ps(s[ParticleAge] + i), dt);
+        _mm256_storeu_ps(s[ParticleX] + i, x);
+        _mm256_storeu_ps(s[ParticleY] + i, y);
+        _mm256_storeu_ps(s[ParticleZ] + i, z);
+        _mm256_storeu_ps(s[ParticleVelocityX] + i, vx);
+        _mm256_storeu_ps(s[ParticleVelocityY] + i, vy);
+        _mm256_storeu_ps(s[ParticleVelocityZ] + i, vz);
+        _mm256_storeu_ps(s[ParticleAge] + i, age);
+        alive += table.count[_mm256_movemask_ps(_mm256_cmp_ps(age, _mm256_loadu_ps(s[ParticleLifetime] + i), _CMP_LT_OQ))];
+    }
+    return alive;
+}
+
+GFX_TARGET_AVX2 void CompactAVX2(Streams source, Streams destination, uint32_t& i, uint32_t& w, uint32_t sourceEnd,
+                                 uint32_t end, const PackTable& table) noexcept {
+    for (; i + 8 <= sourceEnd && w + 8 <= end; i += 8) {
+        __m256 alive = _mm256_cmp_ps(_mm256_loadu_ps(source[ParticleAge] + i), _mm256_loadu_ps(source[ParticleLifetime] + i),
+                                     _CMP_LT_OQ);
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(alive));
+        __m256i lanes = _mm256_load_si256(reinterpret_cast<const __m256i*>(table.lanes8[mask]));
+        for (uint32_t s = 0; s < ParticleStreamCount; ++s) {
+            _mm256_storeu_ps(destination[s] + w, _mm256_permutevar8x32_ps(_mm256_loadu_ps(source[s] + i), lanes));
+        }
+        w += table.count[mask];
+    }
+}
+
+GFX_TARGET_AVX2 void WriteAVX2(Streams s, const Step& step, uint32_t& i, uint32_t end, ParticleInstance* out) noexcept {
+    const __m256 size0 = _mm256_set1_ps(step.size0), sizeDelta = _mm256_set1_ps(step.sizeDelta), half = _mm256_set1_ps(0.5f);
+    __m256 color0[4], colorDelta[4];
+    for (int c = 0; c < 4; ++c) {
+        color0[c] = _mm256_set1_ps(step.color0[c]);
+        colorDelta[c] = _mm256_set1_ps(step.colorDelta[c]);
+    }
+    for (; i + 8 <= end; i += 8) {
+        __m256 t = _mm256_div_ps(_mm256_loadu_ps(s[ParticleAge] + i), _mm256_loadu_ps(s[ParticleLifetime] + i));
+        alignas(32) float size[8];
+        alignas(32) uint32_t rgba[8];
+        _mm256_store_ps(size, _mm256_add_ps(size0, _mm256_mul_ps(sizeDelta, t)));
+        __m256i packed = _mm256_setzero_si256();
+        for (int c = 0; c < 4; ++c) {
+            __m256i channel = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_add_ps(color0[c], _mm256_mul_ps(colorDelta[c], t)), half));
+            packed = _mm256_or_si256(packed, _mm256_slli_epi32(channel, c * 8));
+        }
+        _mm256_store_si256(reinterpret_cast<__m256i*>(rgba), packed);
+        // Whole batches keep the stores to write-combined memory sequential.
+        ParticleInstance batch[8];
+        for (uint32_t k = 0; k < 8; ++k) {
+            batch[k].position[0] = s[ParticleX][i + k];
+            batch[k].position[1] = s[ParticleY][i + k];
+            batch[k].position[2] = s[ParticleZ][i + k];
+            batch[k].size = size[k];
+            batch[k].rgba = rgba[k];
+        }
+        memcpy(out + i, batch, sizeof(batch));
+    }
+}
+#endif
+
+// The SSE kernels use SSE4.1 blends and SSSE3 shuffles, which SimdLevel::SSE does not imply.
+inline bool UseSSE41(SimdLevel level) noexcept {
+    return level == SimdLevel::SSE && GetCpuFeatures().sse41;
+}
+
+} // namespace
+
+ParticleSystem::ParticleSystem(uint32_t capacity, const ParticleSettings& settings, uint64_t seed)
+    : m_settings(settings), m_seed(seed), m_capacity(capacity) {
+    for (auto& streams : m_streams) {
+        for (std::vector<float>& stream : streams) stream.resize(capacity);
+    }
+}
+
+uint32_t ParticleSystem::Emit(ParticleEmitter& emitter, float dt, ThreadPool* pool) {
+    float wanted = std::max(emitter.rate * dt + emitter.carry, 0.0f);
+    uint32_t count = static_cast<uint32_t>(wanted);
+    emitter.carry = wanted - static_cast<float>(count);
+    return Burst(emitter, count, pool);
+}
+
+uint32_t ParticleSystem::Burst(const ParticleEmitter& emitter, uint32_t count, ThreadPool* pool) {
+    const uint32_t added = std::min(count, m_capacity - m_count);
+    m_stats.dropped += count - added;
+
+    float* out[ParticleStreamCount];
+    for (uint32_t k = 0; k < ParticleStreamCount; ++k) out[k] = m_streams[m_current][k].data() + m_count;
+    const float lifetimeRange = emitter.lifetimeMax - emitter.lifetimeMin;
+    const uint64_t serial = m_serial;
+    ForEachChunk(pool, added, [&](uint32_t, uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            uint64_t h0 = Mix64(m_seed ^ ((serial + i) * 0x9e3779b97f4a7c15ull));
+            uint64_t h1 = Mix64(h0 + 1), h2 = Mix64(h0 + 2), h3 = Mix64(h0 + 3);
+            out[ParticleX][i] = emitter.position.x + SignedUnit(h0) * emitter.radius;
+            out[ParticleY][i] = emitter.position.y + SignedUnit(h0 >> 32) * emitter.radius;
+            out[ParticleZ][i] = emitter.position.z + SignedUnit(h1) * emitter.radius;
+            out[ParticleVelocityX][i] = emitter.velocity.x + SignedUnit(h1 >> 32) * emitter.velocitySpread;
+            out[ParticleVelocityY][i] = emitter.velocity.y + SignedUnit(h2) * emitter.velocitySpread;
+            out[ParticleVelocityZ][i] = emitter.velocity.z + SignedUnit(h2 >> 32) * emitter.velocitySpread;
+            out[ParticleAge][i] = 0.0f;
+            out[ParticleLifetime][i] = emitter.lifetimeMin + (SignedUnit(h3) * 0.5f + 0.5f) * lifetimeRange;
+        }
+    });
+    m_count += added;
+    m_serial += added;
+    m_stats.emitted += added;
+    return added;
+}
+
+uint32_t ParticleSystem::Update(float dt, ParticleInstance* instances, ThreadPool* pool) {
+    const Step step = MakeStep(m_settings, dt);
+    const PackTable& table = GetPackTable();
+    float* source[ParticleStreamCount];
+    float* destination[ParticleStreamCount];
+    for (uint32_t k = 0; k < ParticleStreamCount; ++k) {
+        source[k] = m_streams[m_current][k].data();
+        destination[k] = m_streams[m_current ^ 1][k].data();
+    }
+
+    const uint32_t chunks = (m_count + ChunkSize - 1) / ChunkSize;
+    m_chunkAlive.resize(chunks);
+    m_chunkOffset.resize(chunks);
+    const SimdLevel level = m_level;
+#if !GFX_X86
+    (void)level;
+    (void)table;
+#endif
+    ForEachChunk(pool, m_count, [&](uint32_t chunk, uint32_t begin, uint32_t end) {
+        uint32_t i = begin, alive = 0;
+#if GFX_X86
+        if (level == SimdLevel::AVX2) alive = IntegrateAVX2(source, step, i, end, table);
+        else if (UseSSE41(level)) alive = IntegrateSSE(source, step, i, end, table);
+#endif
+        m_chunkAlive[chunk] = alive + IntegrateScalar(source, step, i, end);
+    });
+
+    uint32_t total = 0;
+    for (uint32_t chunk = 0; chunk < chunks; ++chunk) {
+        m_chunkOffset[chunk] = total;
+        total += m_chunkAlive[chunk];
+    }
+
+    ForEachChunk(pool, m_count, [&](uint32_t chunk, uint32_t begin, uint32_t end) {
+        const uint32_t first = m_chunkOffset[chunk], last = first + m_chunkAlive[chunk];
+        uint32_t i = begin, w = first;
+#if GFX_X86
+        if (level == SimdLevel::AVX2) CompactAVX2(source, destination, i, w, end, last, table);
+        else if (UseSSE41(level)) CompactSSE(source, destination, i, w, end, last, table);
+#endif
+        CompactScalar(source, destination, i, w, last);
+        if (!instances) return;
+
+        // Survivors are still in cache after the compaction.
+        i = first;
+#if GFX_X86
+        if (level == SimdLevel::AVX2) WriteAVX2(destination, step, i, last, instances);
+        else if (UseSSE41(level)) WriteSSE(destination, step, i, last, instances);
+#endif
+        WriteScalar(destination, step, i, last, instances);
+    });
+
+    m_stats.died += m_count - total;
+    m_count = total;
+    m_current ^= 1;
+    return total;
+}
+
+} // namespace gfx
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "MathTypes.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+// Per-instance vertex data of one particle, written straight into a mapped
+// D3D11_USAGE_DYNAMIC buffer: POSITION R32G32B32_FLOAT at 0, PSIZE R32_FLOAT at 12,
+// COLOR R8G8B8A8_UNORM at 16, packed like ColoredVertex::rgba.
+struct ParticleInstance {
+    float position[3];
+    float size;
+    uint32_t rgba;
+};
+
+static_assert(sizeof(ParticleInstance) == 20, "ParticleInstance must match the 20-byte instance layout");
+
+// Spawns particles in a box of half size radius around position, with velocity
+// jittered per axis by up to velocitySpread.
+struct ParticleEmitter {
+    Float3 position = { 0.0f, 0.0f, 0.0f };
+    float radius = 0.05f;
+    Float3 velocity = { 0.0f, 3.0f, 0.0f };
+    float velocitySpread = 1.0f;
+    float lifetimeMin = 1.0f;
+    float lifetimeMax = 2.0f;
+    // Particles per second.
+    float rate = 1000.0f;
+    // Fraction of a particle left over from earlier frames.
+    float carry = 0.0f;
+};
+
+struct ParticleSettings {
+    Float3 gravity = { 0.0f, -9.81f, 0.0f };
+    // Velocity decays by exp(-drag * dt).
+    float drag = 0.1f;
+    // Particles below the ground plane are put back on it with their vertical
+    // velocity reflected and scaled by restitution.
+    float groundHeight = -1e30f;
+    float restitution = 0.5f;
+    // Size and color are interpolated over the normalized age.
+    float startSize = 0.05f;
+    float endSize = 0.01f;
+    uint32_t startColor = 0xFF40C0FFu;
+    uint32_t endColor = 0x00FF4010u;
+};
+
+// Particle state streams, readable through ParticleSystem::Stream.
+enum ParticleStream : uint32_t {
+    ParticleX,
+    ParticleY,
+    ParticleZ,
+    ParticleVelocityX,
+    ParticleVelocityY,
+    ParticleVelocityZ,
+    ParticleAge,
+    ParticleLifetime,
+    ParticleStreamCount
+};
+
+struct ParticleStats {
+    uint64_t emitted = 0;
+    uint64_t died = 0;
+    // Emissions cut short because the system was full.
+    uint64_t dropped = 0;
+};
+
+// Particle state in structure-of-arrays streams, updated in chunks of ChunkSize
+// across a thread pool. Update integrates every particle and counts the survivors
+// of each chunk in one pass, then left-packs the survivors into a second set of
+// streams at their prefix-sum offsets and writes their instances in a second pass,
+// so dead particles are removed without a branch per particle and the survivors
+// keep their order. Random values are hashed from a particle's emission serial,
+// which makes the results independent of the thread count.
+class ParticleSystem {
+public:
+    static constexpr uint32_t ChunkSize = 16384;
+
+    explicit ParticleSystem(uint32_t capacity, const ParticleSettings& settings = {}, uint64_t seed = 1);
+
+    void SetSettings(const ParticleSettings& settings) noexcept { m_settings = settings; }
+    const ParticleSettings& Settings() const noexcept { return m_settings; }
+    void SetSimdLevel(SimdLevel level) noexcept { m_level = level; }
+
+    // Emits rate * dt particles plus the carried fraction; returns how many were added.
+    uint32_t Emit(ParticleEmitter& emitter, float dt, ThreadPool* pool = nullptr);
+    uint32_t Burst(const ParticleEmitter& emitter, uint32_t count, ThreadPool* pool = nullptr);
+
+    // Advances every particle by dt, removes the expired ones and writes the instances
+    // of the survivors to instances (when not null), which needs room for Count()
+    // entries; it is only written to, so mapped write-combined memory is fine.
+    // Returns the number of live particles.
+    uint32_t Update(float dt, ParticleInstance* instances, ThreadPool* pool = nullptr);
+
+    void Clear() noexcept { m_count = 0; }
+
+    uint32_t Count() const noexcept { return m_count; }
+    uint32_t Capacity() const noexcept { return m_capacity; }
+    // Count() values of one state stream, valid until the next Emit or Update.
+    const float* Stream(ParticleStream stream) const noexcept { return m_streams[m_current][stream].data(); }
+
+    const ParticleStats& Stats() const noexcept { return m_stats; }
+    void ResetStats() noexcept { m_stats = {}; }
+
+private:
+    ParticleSettings m_settings;
+    SimdLevel m_level = BestSimdLevel();
+    uint64_t m_seed;
+    uint64_t m_serial = 0;
+    uint32_t m_capacity;
+    uint32_t m_count = 0;
+    // Streams holding the live particles; the other set receives the next compaction.
+    uint32_t m_current = 0;
+    std::vector<float> m_streams[2][ParticleStreamCount];
+    std::vector<uint32_t> m_chunkAlive;
+    std::vector<uint32_t> m_chunkOffset;
+    ParticleStats m_stats;
+};
+
+} // namespace gfx
@@ -0,0 +1,396 @@
+#include "ProceduralGeometry.h"
+
+#include "Hash.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+namespace {
+
+constexpr float Pi = 3.14159265358979f;
+
+// Below this many vertices a band is not worth a hand-off to the pool.
+constexpr uint64_t MinVerticesPerBand = 16384;
+
+// Runs fn(begin, end) over row bands of [0, rowCount); bands never share a row.
+template<typename Fn>
+void ForEachRowBand(ThreadPool* pool, uint32_t rowCount, uint64_t verticesPerRow, const Fn& fn) {
+    uint64_t bandLimit = (uint64_t(rowCount) * verticesPerRow) / MinVerticesPerBand;
+    uint32_t bands = pool ? static_cast<uint32_t>(std::min<uint64_t>({ rowCount, pool->ThreadCount() * 4ull, bandLimit })) : 1;
+    if (bands <= 1) {
+        fn(0u, rowCount);
+        return;
+    }
+    pool->Run(bands, [&](uint32_t band, uint32_t) {
+        fn(static_cast<uint32_t>(uint64_t(rowCount) * band / bands), static_cast<uint32_t>(uint64_t(rowCount) * (band + 1) / bands));
+    });
+}
+
+inline ColoredVertex MakeVertex(float x, float y, float z, uint32_t rgba) noexcept {
+    return { { x, y, z }, rgba };
+}
+
+inline uint32_t NormalColor(float nx, float ny, float nz) noexcept {
+    return PackRGBA8(0.5f + 0.5f * nx, 0.5f + 0.5f * ny, 0.5f + 0.5f * nz, 1.0f);
+}
+
+inline void WriteTriangle(uint32_t*& out, uint32_t a, uint32_t b, uint32_t c) noexcept {
+    out[0] = a;
+    out[1] = b;
+    out[2] = c;
+    out += 3;
+}
+
+UVSphereDesc Clamped(UVSphereDesc desc) noexcept {
+    desc.slices = std::max(desc.slices, 3u);
+    desc.stacks = std::max(desc.stacks, 2u);
+    return desc;
+}
+
+IcosphereDesc Clamped(IcosphereDesc desc) noexcept {
+    desc.frequency = std::max(desc.frequency, 1u);
+    return desc;
+}
+
+TorusDesc Clamped(TorusDesc desc) noexcept {
+    desc.majorSegments = std::max(desc.majorSegments, 3u);
+    desc.minorSegments = std::max(desc.minorSegments, 3u);
+    return desc;
+}
+
+GridDesc Clamped(GridDesc desc) noexcept {
+    desc.cellsX = std::max(desc.cellsX, 1u);
+    desc.cellsZ = std::max(desc.cellsZ, 1u);
+    return desc;
+}
+
+// Grid vertex rows run along X; row z holds vertices z * (cellsX + 1) ... + cellsX.
+template<typename VertexFn>
+void GenerateGridRows(const GridDesc& grid, ColoredVertex* vertices, uint32_t* indices, ThreadPool* pool, const VertexFn& makeVertex) {
+    const uint32_t columns = grid.cellsX + 1;
+    ForEachRowBand(pool, grid.cellsZ + 1, columns, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t z = begin; z < end; ++z) {
+            float fz = static_cast<float>(z) / grid.cellsZ;
+            ColoredVertex* row = vertices + uint64_t(z) * columns;
+            for (uint32_t x = 0; x < columns; ++x) {
+                float fx = static_cast<float>(x) / grid.cellsX;
+                row[x] = makeVertex((fx - 0.5f) * grid.sizeX, (fz - 0.5f) * grid.sizeZ, fx, fz);
+            }
+            if (z == grid.cellsZ) continue;
+            uint32_t* out = indices + uint64_t(z) * grid.cellsX * 6;
+            for (uint32_t x = 0; x < grid.cellsX; ++x) {
+                uint32_t v00 = z * columns + x;
+                uint32_t v10 = v00 + 1;
+                uint32_t v01 = v00 + columns;
+                uint32_t v11 = v01 + 1;
+                WriteTriangle(out, v00, v01, v10);
+                WriteTriangle(out, v10, v01, v11);
+            }
+        }
+    });
+}
+
+float ValueNoise(uint64_t seed, float x, float z) noexcept {
+    float fx = std::floor(x), fz = std::floor(z);
+    int64_t ix = static_cast<int64_t>(fx), iz = static_cast<int64_t>(fz);
+    auto lattice = [seed](int64_t px, int64_t pz) noexcept {
+        uint64_t h = Mix64(seed ^ Mix64(static_cast<uint64_t>(px) * 0x9E3779B97F4A7C15ull + static_cast<uint64_t>(pz)));
+        return static_cast<float>(h >> 40) * (1.0f / 16777216.0f);
+    };
+    float tx = x - fx, tz = z - fz;
+    tx = tx * tx * (3.0f - 2.0f * tx);
+    tz = tz * tz * (3.0f - 2.0f * tz);
+    float a = lattice(ix, iz), b = lattice(ix + 1, iz);
+    float c = lattice(ix, iz + 1), d = lattice(ix + 1, iz + 1);
+    float top = a + (b - a) * tx;
+    float bottom = c + (d - c) * tx;
+    return top + (bottom - top) * tz;
+}
+
+// Water, sand, grass, rock, snow.
+uint32_t TerrainColor(float t) noexcept {
+    static const float stops[5][4] = {
+        { 0.00f, 0.10f, 0.25f, 0.60f },
+        { 0.35f, 0.80f, 0.75f, 0.50f },
+        { 0.45f, 0.25f, 0.55f, 0.20f },
+        { 0.70f, 0.45f, 0.40f, 0.35f },
+        { 0.90f, 0.95f, 0.95f, 0.97f },
+    };
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    int i = 0;
+    while (i < 3 && t > stops[i + 1][0]) ++i;
+    float s = std::min((t - stops[i][0]) / (stops[i + 1][0] - stops[i][0]), 1.0f);
+    return PackRGBA8(stops[i][1] + (stops[i + 1][1] - stops[i][1]) * s, stops[i][2] + (stops[i + 1][2] - stops[i][2]) * s,
+                     stops[i][3] + (stops[i + 1][3] - stops[i][3]) * s, 1.0f);
+}
+
+// Icosahedron with faces wound clockwise from outside.
+const float IcoT = 1.61803398875f;
+const float IcoCorners[12][3] = {
+    { -1, IcoT, 0 }, { 1, IcoT, 0 }, { -1, -IcoT, 0 }, { 1, -IcoT, 0 },
+    { 0, -1, IcoT }, { 0, 1, IcoT }, { 0, -1, -IcoT }, { 0, 1, -IcoT },
+    { IcoT, 0, -1 }, { IcoT, 0, 1 }, { -IcoT, 0, -1 }, { -IcoT, 0, 1 },
+};
+const uint32_t IcoFaces[20][3] = {
+    { 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+    { 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+    { 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+    { 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 },
+};
+
+// Vertex numbering of the subdivided icosahedron: the 12 corners, then n - 1 vertices
+// per edge, then each face's interior. A lattice point on a shared edge or corner maps
+// to the same index from every face, and only the owning (lowest) face writes it.
+class IcosphereTopology {
+public:
+    explicit IcosphereTopology(uint32_t n) : m_n(n) {
+        for (uint32_t c = 0; c < 12; ++c) m_cornerOwner[c] = ~0u;
+        uint32_t edgeCount = 0;
+        for (uint32_t f = 0; f < 20; ++f) {
+            for (uint32_t e = 0; e < 3; ++e) {
+                uint32_t a = IcoFaces[f][e], b = IcoFaces[f][(e + 1) % 3];
+                if (m_cornerOwner[a] == ~0u) m_cornerOwner[a] = f;
+                if (FindEdge(a, b, edgeCount) == edgeCount) {
+                    m_edges[edgeCount] = { std::min(a, b), std::max(a, b), f };
+                    ++edgeCount;
+                }
+            }
+        }
+        m_edgeBase = 12;
+        m_interiorBase = m_edgeBase + 30 * (n - 1);
+        m_interiorPerFace = n >= 2 ? (n - 1) * (n - 2) / 2 : 0;
+    }
+
+    // Lattice point i steps towards B and j steps towards C from corner A of face f.
+    uint32_t Index(uint32_t f, uint32_t i, uint32_t j, bool& owned) const noexcept {
+        const uint32_t a = IcoFaces[f][0], b = IcoFaces[f][1], c = IcoFaces[f][2];
+        const uint32_t k = m_n - i - j;
+        if (i == m_n) return Corner(b, f, owned);
+        if (j == m_n) return Corner(c, f, owned);
+        if (k == m_n) return Corner(a, f, owned);
+        if (j == 0) return EdgeVertex(a, b, i, f, owned);
+        if (i == 0) return EdgeVertex(a, c, j, f, owned);
+        if (k == 0) return EdgeVertex(b, c, j, f, owned);
+        owned = true;
+        uint32_t rowOffset = (j - 1) * (m_n - 1) - (j - 1) * j / 2;
+        return m_interiorBase + f * m_interiorPerFace + rowOffset + (i - 1);
+    }
+
+private:
+    struct Edge {
+        uint32_t a, b, owner;
+    };
+
+    uint32_t FindEdge(uint32_t a, uint32_t b, uint32_t count) const noexcept {
+        uint32_t lo = std::min(a, b), hi = std::max(a, b);
+        for (uint32_t e = 0; e < count; ++e) {
+            if (m_edges[e].a == lo && m_edges[e].b == hi) return e;
+        }
+        return count;
+    }
+
+    uint32_t Corner(uint32_t corner, uint32_t f, bool& owned) const noexcept {
+        owned = m_cornerOwner[corner] == f;
+        return corner;
+    }
+
+    // t steps from p towards q.
+    uint32_t EdgeVertex(uint32_t p, uint32_t q, uint32_t t, uint32_t f, bool& owned) const noexcept {
+        uint32_t e = FindEdge(p, q, 30);
+        owned = m_edges[e].owner == f;
+        uint32_t along = p < q ? t : m_n - t;
+        return m_edgeBase + e * (m_n - 1) + along - 1;
+    }
+
+    uint32_t m_n;
+    uint32_t m_edgeBase;
+    uint32_t m_interiorBase;
+    uint32_t m_interiorPerFace;
+    uint32_t m_cornerOwner[12];
+    Edge m_edges[30];
+};
+
+} // namespace
+
+MeshCounts UVSphereCounts(const UVSphereDesc& desc) noexcept {
+    UVSphereDesc d = Clamped(desc);
+    return { uint64_t(d.slices) * (d.stacks - 1) + 2, uint64_t(d.slices) * (d.stacks - 1) * 6 };
+}
+
+MeshCounts IcosphereCounts(const IcosphereDesc& desc) noexcept {
+    uint64_t n = Clamped(desc).frequency;
+    return { 10 * n * n + 2, 60 * n * n };
+}
+
+MeshCounts TorusCounts(const TorusDesc& desc) noexcept {
+    TorusDesc d = Clamped(desc);
+    uint64_t quads = uint64_t(d.majorSegments) * d.minorSegments;
+    return { quads, quads * 6 };
+}
+
+MeshCounts GridCounts(const GridDesc& desc) noexcept {
+    GridDesc d = Clamped(desc);
+    return { uint64_t(d.cellsX + 1) * (d.cellsZ + 1), uint64_t(d.cellsX) * d.cellsZ * 6 };
+}
+
+MeshCounts TerrainCounts(const TerrainDesc& desc) noexcept {
+    return GridCounts(desc.grid);
+}
+
+// Vertex row 0 is the north pole, rows 1..stacks-1 are rings and row stacks the south
+// pole. Triangle row j joins vertex rows j and j + 1; the longitude seam wraps to column 0.
+void GenerateUVSphere(const UVSphereDesc& desc, ColoredVertex* vertices, uint32_t* indices, ThreadPool* pool) {
+    const UVSphereDesc d = Clamped(desc);
+    const uint32_t slices = d.slices, stacks = d.stacks;
+    const uint32_t south = slices * (stacks - 1) + 1;
+    auto ring = [slices](uint32_t j, uint32_t i) noexcept { return 1 + (j - 1) * slices + i % slices; };
+
+    ForEachRowBand(pool, stacks + 1, slices, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t j = begin; j < end; ++j) {
+            if (j == 0) {
+                vertices[0] = MakeVertex(0.0f, d.radius, 0.0f, NormalColor(0.0f, 1.0f, 0.0f));
+            } else if (j == stacks) {
+                vertices[south] = MakeVertex(0.0f, -d.radius, 0.0f, NormalColor(0.0f, -1.0f, 0.0f));
+            } else {
+                float theta = Pi * j / stacks;
+                float sinTheta = std::sin(theta), cosTheta = std::cos(theta);
+                for (uint32_t i = 0; i < slices; ++i) {
+                    float phi = 2.0f * Pi * i / slices;
+                    float nx = sinTheta * std::cos(phi), nz = sinTheta * std::sin(phi);
+                    vertices[ring(j, i)] = MakeVertex(nx * d.radius, cosTheta * d.radius, nz * d.radius, NormalColor(nx, cosTheta, nz));
+                }
+            }
+
+            if (j == stacks) continue;
+            uint32_t* out = indices + (j == 0 ? 0 : uint64_t(slices) * 3 + uint64_t(j - 1) * slices * 6);
+            for (uint32_t i = 0; i < slices; ++i) {
+                if (j == 0) {
+                    WriteTriangle(out, 0, ring(1, i + 1), ring(1, i));
+                } else if (j == stacks - 1) {
+                    WriteTriangle(out, ring(j, i), ring(j, i + 1), south);
+                } else {
+                    WriteTriangle(out, ring(j, i), ring(j, i + 1), ring(j + 1, i));
+                    WriteTriangle(out, ring(j, i + 1), ring(j + 1, i + 1), ring(j + 1, i));
+                }
+            }
+        }
+    });
+}
+
+// Each face is a triangular lattice of frequency rows; the work items are
+// (face, row band) patches and write disjoint vertex and index ranges.
+void GenerateIcosphere(const IcosphereDesc& desc, ColoredVertex* vertices, uint32_t* indices, ThreadPool* pool) {
+    const uint32_t n = Clamped(desc).frequency;
+    const float radius = desc.radius;
+    const IcosphereTopology topology(n);
+
+    uint32_t bandsPerFace = 1;
+    if (pool && 20ull * n * n > 4 * MinVerticesPerBand) {
+        bandsPerFace = std::min(n, (pool->ThreadCount() * 4 + 19) / 20);
+    }
+    auto patch = [&](uint32_t task, uint32_t) {
+        const uint32_t f = task / bandsPerFace, band = task % bandsPerFace;
+        const uint32_t begin = n * band / bandsPerFace, end = n * (band + 1) / bandsPerFace;
+        const float* a = IcoCorners[IcoFaces[f][0]];
+        const float* b = IcoCorners[IcoFaces[f][1]];
+        const float* c = IcoCorners[IcoFaces[f][2]];
+
+        // The last band also writes lattice row n, the face's C corner.
+        for (uint32_t j = begin; j < (end == n ? n + 1 : end); ++j) {
+            for (uint32_t i = 0; i + j <= n; ++i) {
+                bool owned;
+                uint32_t index = topology.Index(f, i, j, owned);
+                if (!owned) continue;
+                float wa = float(n - i - j), wb = float(i), wc = float(j);
+                float x = a[0] * wa + b[0] * wb + c[0] * wc;
+                float y = a[1] * wa + b[1] * wb + c[1] * wc;
+                float z = a[2] * wa + b[2] * wb + c[2] * wc;
+                float inv = 1.0f / std::sqrt(x * x + y * y + z * z);
+                x *= inv;
+                y *= inv;
+                z *= inv;
+                vertices[index] = MakeVertex(x * radius, y * radius, z * radius, NormalColor(x, y, z));
+            }
+        }
+
+        bool owned;
+        uint32_t* out = indices + (uint64_t(f) * n * n + uint64_t(2 * n * begin - begin * begin)) * 3;
+        for (uint32_t j = begin; j < end; ++j) {
+            for (uint32_t i = 0; i + j < n; ++i) {
+                uint32_t p = topology.Index(f, i, j, owned);
+                uint32_t q = topology.Index(f, i + 1, j, owned);
+                uint32_t r = topology.Index(f, i, j + 1, owned);
+                WriteTriangle(out, p, q, r);
+                if (i + j + 1 < n) WriteTriangle(out, q, topology.Index(f, i + 1, j + 1, owned), r);
+            }
+        }
+    };
+
+    if (pool && 20ull * n * n > MinVerticesPerBand) {
+        pool->Run(20 * bandsPerFace, patch);
+    } else {
+        for (uint32_t task = 0; task < 20 * bandsPerFace; ++task) patch(task, 0);
+    }
+}
+
+// Vertex row i is the tube cross-section at major angle i; both directions wrap.
+void GenerateTorus(const TorusDesc& desc, ColoredVertex* vertices, uint32_t* indices, ThreadPool* pool) {
+    const TorusDesc d = Clamped(desc);
+    const uint32_t major = d.majorSegments, minor = d.minorSegments;
+
+    ForEachRowBand(pool, major, minor, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            float phi = 2.0f * Pi * i / major;
+            float cosPhi = std::cos(phi), sinPhi = std::sin(phi);
+            for (uint32_t j = 0; j < minor; ++j) {
+                float theta = 2.0f * Pi * j / minor;
+                float cosTheta = std::cos(theta), sinTheta = std::sin(theta);
+                float ring = d.majorRadius + d.minorRadius * cosTheta;
+                vertices[uint64_t(i) * minor + j] = MakeVertex(ring * cosPhi, d.minorRadius * sinTheta, ring * sinPhi,
+                                                               NormalColor(cosTheta * cosPhi, sinTheta, cosTheta * sinPhi));
+            }
+
+            uint32_t next = (i + 1) % major;
+            uint32_t* out = indices + uint64_t(i) * minor * 6;
+            for (uint32_t j = 0; j < minor; ++j) {
+                uint32_t j1 = (j + 1) % minor;
+                uint32_t a = i * minor + j, b = i * minor + j1;
+                uint32_t c = next * minor + j, e = next * minor + j1;
+                WriteTriangle(out, a, b, c);
+                WriteTriangle(out, c, b, e);
+            }
+        }
+    });
+}
+
+void GenerateGrid(const GridDesc& desc, ColoredVertex* vertices, uint32_t* indices, ThreadPool* pool) {
+    GenerateGridRows(Clamped(desc), vertices, indices, pool, [](float x, float z, float u, float v) noexcept {
+        return MakeVertex(x, 0.0f, z, PackRGBA8(u, 0.5f, v, 1.0f));
+    });
+}
+
+float TerrainHeight(const TerrainDesc& desc, float x, float z) noexcept {
+    float u = (x / desc.grid.sizeX + 0.5f) * desc.frequency;
+    float v = (z / desc.grid.sizeZ + 0.5f) * desc.frequency;
+    float sum = 0.0f, amplitude = 1.0f, total = 0.0f;
+    for (uint32_t octave = 0; octave < desc.octaves; ++octave) {
+        sum += ValueNoise(Mix64(desc.seed + octave), u, v) * amplitude;
+        total += amplitude;
+        amplitude *= 0.5f;
+        u *= 2.0f;
+        v *= 2.0f;
+    }
+    return total > 0.0f ? (sum / total - 0.5f) * desc.height : 0.0f;
+}
+
+void GenerateTerrain(const TerrainDesc& desc, ColoredVertex* vertices, uint32_t* indices, ThreadPool* pool) {
+    GenerateGridRows(Clamped(desc.grid), vertices, indices, pool, [&desc](float x, float z, float, float) noexcept {
+        float y = TerrainHeight(desc, x, z);
+        float t = desc.height > 0.0f ? y / desc.height + 0.5f : 0.5f;
+        return MakeVertex(x, y, z, TerrainColor(t));
+    });
+}
+
+} // namespace gfx
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ColoredVertex.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+
+namespace gfx {
+
+// Every generator writes indexed triangle lists into caller-provided buffers sized
+// from the matching *Counts function, so the output can go straight into a mapped
+// or pSysMem upload. Triangles are clockwise seen from outside (D3D11 front faces).
+// Vertices shared across a seam exist once, and with a pool the work is split into
+// row bands or patches whose vertex and index ranges are known up front, so no
+// locking or merge pass is needed and the output does not depend on the thread count.
+
+struct MeshCounts {
+    uint64_t vertexCount;
+    uint64_t indexCount;
+};
+
+// Latitude/longitude sphere centred at the origin with single-vertex poles.
+struct UVSphereDesc {
+    float radius = 0.5f;
+    uint32_t slices = 32;
+    uint32_t stacks = 16;
+};
+
+// Icosahedron whose faces are split into frequency^2 triangles and projected onto
+// the sphere, so triangles stay close to equal in size.
+struct IcosphereDesc {
+    float radius = 0.5f;
+    uint32_t frequency = 8;
+};
+
+// Torus around the Y axis.
+struct TorusDesc {
+    float majorRadius = 0.4f;
+    float minorRadius = 0.15f;
+    uint32_t majorSegments = 48;
+    uint32_t minorSegments = 24;
+};
+
+// Y-up plane centred at the origin.
+struct GridDesc {
+    float sizeX = 1.0f;
+    float sizeZ = 1.0f;
+    uint32_t cellsX = 16;
+    uint32_t cellsZ = 16;
+};
+
+// Grid displaced by value-noise fBm and coloured by height.
+struct TerrainDesc {
+    GridDesc grid;
+    float height = 0.15f;
+    float frequency = 4.0f;
+    uint32_t octaves = 5;
+    uint32_t seed = 1;
+};
+
+MeshCounts UVSphereCounts(const UVSphereDesc& desc) noexcept;
+MeshCounts IcosphereCounts(const IcosphereDesc& desc) noexcept;
+MeshCounts TorusCounts(const TorusDesc& desc) noexcept;
+MeshCounts GridCounts(const GridDesc& desc) noexcept;
+MeshCounts TerrainCounts(const TerrainDesc& desc) noexcept;
+
+void GenerateUVSphere(const UVSphereDesc& desc, ColoredVertex* vertices, uint32_t* indices, ThreadPool* pool = nullptr);
+void GenerateIcosphere(const IcosphereDesc& desc, ColoredVertex* vertices, uint32_t* indices, ThreadPool* pool = nullptr);
+void GenerateTorus(const TorusDesc& desc, ColoredVertex* vertices, uint32_t* indices, ThreadPool* pool = nullptr);
+void GenerateGrid(const GridDesc& desc, ColoredVertex* vertices, uint32_t* indices, ThreadPool* pool = nullptr);
+void GenerateTerrain(const TerrainDesc& desc, ColoredVertex* vertices, uint32_t* indices, ThreadPool* pool = nullptr);
+
+// Terrain surface height at (x, z), as used for the vertices.
+float TerrainHeight(const TerrainDesc& desc, float x, float z) noexcept;
+
+} // namespace gfx
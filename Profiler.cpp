@@ -0,0 +1,174 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+void WriteJsonString(FILE* file, const char* text) {
+    std::fputc('"', file);
+    for (const char* p = text ? text : ""; *p; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') std::fprintf(file, "\\%c", c);
+        else if (c < 0x20) std::fprintf(file, "\\u%04x", c);
+        else std::fputc(c, file);
+    }
+    std::fputc('"', file);
+}
+
+} // namespace
+
+// Returns the calling thread's ring to the pool when the thread exits.
+struct RingLease {
+    Profiler::ThreadRing* ring = nullptr;
+    ~RingLease() {
+        if (ring) ring->inUse.store(false, std::memory_order_release);
+    }
+};
+
+Profiler& GetProfiler() noexcept {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::ThreadRing& Profiler::LocalRing() noexcept {
+    thread_local RingLease lease;
+    if (!lease.ring) {
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        for (const std::unique_ptr<ThreadRing>& ring : m_rings) {
+            if (!ring->inUse.load(std::memory_order_acquire)) {
+                ring->inUse.store(true, std::memory_order_relaxed);
+                ring->named.store(false, std::memory_order_relaxed);
+                lease.ring = ring.get();
+                break;
+            }
+        }
+        if (!lease.ring) {
+            m_rings.push_back(std::make_unique<ThreadRing>());
+            lease.ring = m_rings.back().get();
+            lease.ring->threadId = static_cast<uint32_t>(m_rings.size());
+        }
+    }
+    return *lease.ring;
+}
+
+void Profiler::Record(const char* name, uint64_t beginNs, uint64_t endNs) noexcept {
+    ThreadRing& ring = LocalRing();
+    uint64_t index = ring.written.load(std::memory_order_relaxed);
+    // Seqlock write side: a reader that sees any of the stores below also sees the
+    // earlier publication of index, so it knows this slot is being replaced.
+    std::atomic_thread_fence(std::memory_order_release);
+    Event& event = ring.events[index & (RingCapacity - 1)];
+    event.name.store(name, std::memory_order_relaxed);
+    event.begin.store(beginNs, std::memory_order_relaxed);
+    event.end.store(endNs, std::memory_order_relaxed);
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(const char* name) noexcept {
+    ThreadRing& ring = LocalRing();
+    ring.named.store(false, std::memory_order_relaxed);
+    std::strncpy(ring.threadName, name, sizeof(ring.threadName) - 1);
+    ring.threadName[sizeof(ring.threadName) - 1] = '\0';
+    ring.named.store(true, std::memory_order_release);
+}
+
+void Profiler::EndFrame() noexcept {
+    uint64_t now = ProfilerNow();
+    if (m_lastFrameEnd) {
+        m_frameMs[m_frameCount % FrameHistory] = static_cast<float>((now - m_lastFrameEnd) * 1e-6);
+        ++m_frameCount;
+    }
+    m_lastFrameEnd = now;
+}
+
+FrameStats Profiler::GetFrameStats() const {
+    uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(m_frameCount, FrameHistory));
+    FrameStats stats = { count, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    if (count == 0) return stats;
+
+    std::vector<float> sorted(m_frameMs, m_frameMs + count);
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (float ms : sorted) sum += ms;
+    auto percentile = [&](double p) { return double(sorted[std::min<size_t>(count - 1, static_cast<size_t>(p * count))]); };
+    stats.meanMs = sum / count;
+    stats.p50Ms = percentile(0.50);
+    stats.p95Ms = percentile(0.95);
+    stats.p99Ms = percentile(0.99);
+    stats.maxMs = sorted.back();
+    return stats;
+}
+
+bool Profiler::WriteChromeTrace(const char* path) const {
+    FILE* file = std::fopen(path, "wb");
+    if (!file) return false;
+
+    std::lock_guard<std::mutex> lock(m_ringsMutex);
+    uint64_t origin = ~0ull;
+    struct Copied {
+        const char* name;
+        uint64_t begin, end;
+        uint32_t tid;
+    };
+    std::vector<Copied> events;
+    for (const std::unique_ptr<ThreadRing>& ring : m_rings) {
+        uint64_t written = ring->written.load(std::memory_order_acquire);
+        uint64_t first = std::max(ring->discardBefore.load(std::memory_order_relaxed),
+                                  written > RingCapacity ? written - RingCapacity : 0);
+        size_t start = events.size();
+        for (uint64_t i = first; i < written; ++i) {
+            const Event& e = ring->events[i & (RingCapacity - 1)];
+            events.push_back({ e.name.load(std::memory_order_relaxed), e.begin.load(std::memory_order_relaxed),
+                               e.end.load(std::memory_order_relaxed), ring->threadId });
+        }
+        // Entries the owner overwrote while we were copying may be torn, and so may
+        // the one in the slot it is writing now, which still holds index
+        // after - RingCapacity. The fence keeps the relaxed copies above from being
+        // read after this load; it pairs with the fence in Record.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = ring->written.load(std::memory_order_relaxed);
+        uint64_t overwritten = after + 1 > RingCapacity ? after + 1 - RingCapacity : 0;
+        if (overwritten > first) {
+            size_t drop = static_cast<size_t>(std::min<uint64_t>(overwritten - first, written - first));
+            events.erase(events.begin() + start, events.begin() + start + drop);
+        }
+    }
+    for (const Copied& e : events) origin = std::min(origin, e.begin);
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (const std::unique_ptr<ThreadRing>& ring : m_rings) {
+        if (!ring->named.load(std::memory_order_acquire)) continue;
+        const char* name = ring->threadName;
+        std::fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", ring->threadId);
+        WriteJsonString(file, name);
+        std::fprintf(file, "}}");
+        first = false;
+    }
+    for (const Copied& e : events) {
+        std::fprintf(file, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":", first ? "" : ",\n", e.tid,
+                     (e.begin - origin) * 1e-3, (e.end - e.begin) * 1e-3);
+        WriteJsonString(file, e.name);
+        std::fputc('}', file);
+        first = false;
+    }
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
+
+void Profiler::Reset() noexcept {
+    {
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        for (const std::unique_ptr<ThreadRing>& ring : m_rings) {
+            ring->discardBefore.store(ring->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+        }
+    }
+    m_frameCount = 0;
+    m_lastFrameEnd = 0;
+}
+
+} // namespace gfx
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Set to 0 to compile GFX_PROFILE_SCOPE out entirely.
+#ifndef GFX_ENABLE_PROFILER
+#define GFX_ENABLE_PROFILER 1
+#endif
+
+namespace gfx {
+
+inline uint64_t ProfilerNow() noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+struct FrameStats {
+    uint32_t frameCount;
+    double meanMs;
+    double p50Ms;
+    double p95Ms;
+    double p99Ms;
+    double maxMs;
+};
+
+// Collects timed CPU scopes from any thread into per-thread rings and keeps a
+// rolling window of frame times. Recording is wait-free: each thread owns its
+// ring and only publishes a write counter; readers drop entries that were
+// overwritten while they copied. A ring is handed to a new thread once its
+// owner exits, so memory is bounded by the peak thread count. Event names must
+// outlive the profiler (string literals). There is one instance, GetProfiler().
+class Profiler {
+public:
+    static constexpr uint32_t RingCapacity = 1u << 15;
+    static constexpr uint32_t FrameHistory = 1024;
+
+    void SetEnabled(bool enabled) noexcept { m_enabled.store(enabled, std::memory_order_relaxed); }
+    bool Enabled() const noexcept { return m_enabled.load(std::memory_order_relaxed); }
+
+    void Record(const char* name, uint64_t beginNs, uint64_t endNs) noexcept;
+
+    // Names the calling thread in exported traces; the name is copied.
+    void SetThreadName(const char* name) noexcept;
+
+    // Main thread only: closes the current frame, adding its duration to the window.
+    void EndFrame() noexcept;
+    FrameStats GetFrameStats() const;
+
+    // Writes every event still held in the rings as Chrome trace_event JSON
+    // (load it in chrome://tracing or Perfetto).
+    bool WriteChromeTrace(const char* path) const;
+
+    // Drops recorded events and frame history.
+    void Reset() noexcept;
+
+private:
+    friend Profiler& GetProfiler() noexcept;
+    friend struct RingLease;
+    Profiler() = default;
+
+    struct Event {
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> begin;
+        std::atomic<uint64_t> end;
+    };
+
+    struct ThreadRing {
+        uint32_t threadId;
+        std::atomic<bool> inUse{ true };
+        std::atomic<bool> named{ false };
+        char threadName[32];
+        std::atomic<uint64_t> written{ 0 };
+        std::atomic<uint64_t> discardBefore{ 0 };
+        Event events[RingCapacity];
+    };
+
+    ThreadRing& LocalRing() noexcept;
+
+    std::atomic<bool> m_enabled{ true };
+    mutable std::mutex m_ringsMutex;
+    std::vector<std::unique_ptr<ThreadRing>> m_rings;
+
+    float m_frameMs[FrameHistory] = {};
+    uint64_t m_frameCount = 0;
+    uint64_t m_lastFrameEnd = 0;
+};
+
+Profiler& GetProfiler() noexcept;
+
+// Times the enclosing scope when the profiler is enabled.
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) noexcept
+        : m_name(name), m_begin(GetProfiler().Enabled() ? ProfilerNow() : 0) {}
+    ~ProfileScope() {
+        if (m_begin) GetProfiler().Record(m_name, m_begin, ProfilerNow());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_begin;
+};
+
+} // namespace gfx
+
+#define GFX_PROFILE_CONCAT_(a, b) a##b
+#define GFX_PROFILE_CONCAT(a, b) GFX_PROFILE_CONCAT_(a, b)
+#if GFX_ENABLE_PROFILER
+#define GFX_PROFILE_SCOPE(name) ::gfx::ProfileScope GFX_PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#else
+#define GFX_PROFILE_SCOPE(name) ((void)0)
+#endif
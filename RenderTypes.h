@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+
+namespace gfx {
+
+// Same fields and order as D3D11_VIEWPORT.
+struct Viewport {
+    float topLeftX, topLeftY;
+    float width, height;
+    float minDepth, maxDepth;
+};
+
+// Same fields and order as D3D11_RECT.
+struct ScissorRect {
+    int32_t left, top, right, bottom;
+};
+
+enum class IndexFormat { UInt16, UInt32 };
+
+inline uint32_t IndexSize(IndexFormat format) noexcept {
+    return format == IndexFormat::UInt16 ? 2 : 4;
+}
+
+// Vertex element formats, numbered like their DXGI_FORMAT counterparts so they
+// can be cast directly when building D3D11_INPUT_ELEMENT_DESC arrays.
+enum class ElementFormat : uint32_t {
+    Unknown = 0,
+    R32G32B32A32_Float = 2,
+    R32G32B32_Float = 6,
+    R16G16B16A16_Float = 10,
+    R16G16B16A16_UNorm = 11,
+    R16G16B16A16_SNorm = 13,
+    R32G32_Float = 16,
+    R8G8B8A8_UNorm = 28,
+    R16G16_Float = 34,
+    R16G16_SNorm = 37,
+    R32_Float = 41,
+};
+
+constexpr uint32_t ElementSize(ElementFormat format) noexcept {
+    switch (format) {
+    case ElementFormat::R32G32B32A32_Float: return 16;
+    case ElementFormat::R32G32B32_Float: return 12;
+    case ElementFormat::R16G16B16A16_Float: return 8;
+    case ElementFormat::R16G16B16A16_UNorm: return 8;
+    case ElementFormat::R16G16B16A16_SNorm: return 8;
+    case ElementFormat::R32G32_Float: return 8;
+    case ElementFormat::R8G8B8A8_UNorm: return 4;
+    case ElementFormat::R16G16_Float: return 4;
+    case ElementFormat::R16G16_SNorm: return 4;
+    case ElementFormat::R32_Float: return 4;
+    default: return 0;
+    }
+}
+
+// Number of values in one element.
+constexpr uint32_t ElementComponents(ElementFormat format) noexcept {
+    switch (format) {
+    case ElementFormat::R32G32B32_Float: return 3;
+    case ElementFormat::R32G32_Float:
+    case ElementFormat::R16G16_Float:
+    case ElementFormat::R16G16_SNorm: return 2;
+    case ElementFormat::R32_Float: return 1;
+    case ElementFormat::Unknown: return 0;
+    default: return 4;
+    }
+}
+
+// Texture formats, numbered like DXGI_FORMAT.
+enum class TextureFormat : uint32_t {
+    Unknown = 0,
+    R8G8B8A8_UNorm = 28,
+    R8G8B8A8_UNorm_SRGB = 29,
+    BC1_UNorm = 71,
+    BC1_UNorm_SRGB = 72,
+    BC3_UNorm = 77,
+    BC3_UNorm_SRGB = 78,
+};
+
+inline bool IsBlockCompressed(TextureFormat format) noexcept {
+    return format >= TextureFormat::BC1_UNorm;
+}
+
+inline bool IsSrgb(TextureFormat format) noexcept {
+    return format == TextureFormat::R8G8B8A8_UNorm_SRGB || format == TextureFormat::BC1_UNorm_SRGB ||
+           format == TextureFormat::BC3_UNorm_SRGB;
+}
+
+// The sRGB or linear variant of a format; the SRGB value always follows the UNorm one.
+inline TextureFormat WithSrgb(TextureFormat format, bool srgb) noexcept {
+    if (format == TextureFormat::Unknown) return format;
+    uint32_t linear = static_cast<uint32_t>(format) - (IsSrgb(format) ? 1 : 0);
+    return static_cast<TextureFormat>(linear + (srgb ? 1 : 0));
+}
+
+// Bytes per pixel, or per 4x4 block for block-compressed formats.
+inline uint32_t TexelBlockSize(TextureFormat format) noexcept {
+    switch (format) {
+    case TextureFormat::R8G8B8A8_UNorm:
+    case TextureFormat::R8G8B8A8_UNorm_SRGB: return 4;
+    case TextureFormat::BC1_UNorm:
+    case TextureFormat::BC1_UNorm_SRGB: return 8;
+    case TextureFormat::BC3_UNorm:
+    case TextureFormat::BC3_UNorm_SRGB: return 16;
+    default: return 0;
+    }
+}
+
+// Bytes per row of pixels or blocks, and the number of such rows, as D3D11 expects
+// in D3D11_SUBRESOURCE_DATA.
+inline uint32_t TextureRowPitch(TextureFormat format, uint32_t width) noexcept {
+    return (IsBlockCompressed(format) ? (width + 3) / 4 : width) * TexelBlockSize(format);
+}
+
+inline uint32_t TextureRowCount(TextureFormat format, uint32_t height) noexcept {
+    return IsBlockCompressed(format) ? (height + 3) / 4 : height;
+}
+
+} // namespace gfx
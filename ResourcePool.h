@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace gfx {
+
+// 32-bit typed handle: slot index in the low 20 bits, generation in the high 12.
+// Generations start at 1, so a zero value is never handed out and means "none".
+template<typename Tag>
+struct Handle {
+    static constexpr uint32_t IndexBits = 20;
+    static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+    static constexpr uint32_t MaxGeneration = (1u << (32 - IndexBits)) - 1;
+
+    uint32_t value = 0;
+
+    static Handle Make(uint32_t index, uint32_t generation) noexcept { return Handle{ (generation << IndexBits) | index }; }
+
+    uint32_t Index() const noexcept { return value & IndexMask; }
+    uint32_t Generation() const noexcept { return value >> IndexBits; }
+    explicit operator bool() const noexcept { return value != 0; }
+
+    friend bool operator==(Handle a, Handle b) noexcept { return a.value == b.value; }
+    friend bool operator!=(Handle a, Handle b) noexcept { return a.value != b.value; }
+};
+
+// Objects of one type packed in a dense array, addressed through a sparse array of
+// slots that holds each object's dense position and the slot's current generation.
+// Create, Get and Destroy are O(1); destroying moves the last object into the hole,
+// so iteration over Data() never meets a gap. A stale handle fails Get because its
+// slot's generation has moved on. Slots whose generation would wrap are retired
+// instead of reused, so a handle can never alias a later object.
+template<typename T, typename Tag>
+class HandlePool {
+public:
+    using HandleType = Handle<Tag>;
+
+    void Reserve(size_t count) {
+        m_items.reserve(count);
+        m_owners.reserve(count);
+        m_slots.reserve(count);
+    }
+
+    // Returns a null handle once every slot index is in use.
+    HandleType Create(T item) {
+        uint32_t index;
+        if (m_freeHead != InvalidIndex) {
+            index = m_freeHead;
+            m_freeHead = m_slots[index].dense;
+        } else {
+            if (m_slots.size() > HandleType::IndexMask) return HandleType{};
+            index = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back({ InvalidIndex, 1 });
+        }
+        m_slots[index].dense = static_cast<uint32_t>(m_items.size());
+        m_items.push_back(std::move(item));
+        m_owners.push_back(index);
+        return HandleType::Make(index, m_slots[index].generation);
+    }
+
+    bool Contains(HandleType handle) const noexcept { return Find(handle) != InvalidIndex; }
+
+    T* Get(HandleType handle) noexcept {
+        uint32_t dense = Find(handle);
+        return dense == InvalidIndex ? nullptr : &m_items[dense];
+    }
+
+    const T* Get(HandleType handle) const noexcept {
+        uint32_t dense = Find(handle);
+        return dense == InvalidIndex ? nullptr : &m_items[dense];
+    }
+
+    // Moves the object into out when given. Returns false for stale or null handles.
+    bool Destroy(HandleType handle, T* out = nullptr) {
+        uint32_t dense = Find(handle);
+        if (dense == InvalidIndex) return false;
+        if (out) *out = std::move(m_items[dense]);
+
+        uint32_t last = static_cast<uint32_t>(m_items.size() - 1);
+        if (dense != last) {
+            m_items[dense] = std::move(m_items[last]);
+            m_owners[dense] = m_owners[last];
+            m_slots[m_owners[dense]].dense = dense;
+        }
+        m_items.pop_back();
+        m_owners.pop_back();
+
+        Slot& slot = m_slots[handle.Index()];
+        if (slot.generation == HandleType::MaxGeneration) {
+            slot.generation = 0;
+            slot.dense = InvalidIndex;
+            ++m_retiredSlots;
+        } else {
+            ++slot.generation;
+            slot.dense = m_freeHead;
+            m_freeHead = handle.Index();
+        }
+        return true;
+    }
+
+    void Clear() noexcept {
+        m_items.clear();
+        m_owners.clear();
+        m_slots.clear();
+        m_freeHead = InvalidIndex;
+        m_retiredSlots = 0;
+    }
+
+    // Live objects in dense order; HandleAt gives the handle of the object at a dense position.
+    size_t Size() const noexcept { return m_items.size(); }
+    T* Data() noexcept { return m_items.data(); }
+    const T* Data() const noexcept { return m_items.data(); }
+    T* begin() noexcept { return m_items.data(); }
+    T* end() noexcept { return m_items.data() + m_items.size(); }
+    const T* begin() const noexcept { return m_items.data(); }
+    const T* end() const noexcept { return m_items.data() + m_items.size(); }
+
+    HandleType HandleAt(size_t dense) const noexcept {
+        uint32_t index = m_owners[dense];
+        return HandleType::Make(index, m_slots[index].generation);
+    }
+
+    size_t SlotCount() const noexcept { return m_slots.size(); }
+    size_t RetiredSlots() const noexcept { return m_retiredSlots; }
+
+private:
+    static constexpr uint32_t InvalidIndex = ~0u;
+
+    // While a slot is free, dense links it to the next free slot.
+    struct Slot {
+        uint32_t dense;
+        uint32_t generation;
+    };
+
+    uint32_t Find(HandleType handle) const noexcept {
+        uint32_t index = handle.Index();
+        if (!handle || index >= m_slots.size() || m_slots[index].generation != handle.Generation()) return InvalidIndex;
+        return m_slots[index].dense;
+    }
+
+    std::vector<T> m_items;
+    std::vector<uint32_t> m_owners;
+    std::vector<Slot> m_slots;
+    uint32_t m_freeHead = InvalidIndex;
+    size_t m_retiredSlots = 0;
+};
+
+} // namespace gfx
@@ -0,0 +1,80 @@
+#include "ResourceRegistry.h"
+
+namespace gfx {
+
+void ResourceRegistry::Initialize(ResourceDevice* device, uint32_t framesInFlight) noexcept {
+    m_device = device;
+    m_framesInFlight = framesInFlight ? framesInFlight : 1;
+}
+
+void ResourceRegistry::Clear() {
+    if (m_device) {
+        for (const BufferRecord& record : m_buffers) m_device->Release(record.native);
+        for (const ShaderRecord& record : m_shaders) m_device->Release(record.native);
+        for (const InputLayoutRecord& record : m_inputLayouts) m_device->Release(record.native);
+        for (size_t i = m_pendingHead; i < m_pending.size(); ++i) m_device->Release(m_pending[i].native);
+        m_stats.released += m_buffers.Size() + m_shaders.Size() + m_inputLayouts.Size() + PendingReleases();
+    }
+    m_buffers.Clear();
+    m_shaders.Clear();
+    m_inputLayouts.Clear();
+    m_pending.clear();
+    m_pendingHead = 0;
+}
+
+void ResourceRegistry::BeginFrame() {
+    ++m_frame;
+    while (m_pendingHead < m_pending.size() && m_pending[m_pendingHead].frame + m_framesInFlight <= m_frame) {
+        m_device->Release(m_pending[m_pendingHead].native);
+        ++m_pendingHead;
+        ++m_stats.released;
+    }
+    // Compact once the released prefix outweighs what is still pending.
+    if (m_pendingHead > 0 && m_pendingHead * 2 >= m_pending.size()) {
+        m_pending.erase(m_pending.begin(), m_pending.begin() + m_pendingHead);
+        m_pendingHead = 0;
+    }
+}
+
+template<typename Record, typename Tag>
+Handle<Tag> ResourceRegistry::Add(HandlePool<Record, Tag>& pool, const Record& record) {
+    if (!record.native) {
+        ++m_stats.failedCreates;
+        return Handle<Tag>{};
+    }
+    Handle<Tag> handle = pool.Create(record);
+    if (!handle) {
+        m_device->Release(record.native);
+        ++m_stats.failedCreates;
+        return handle;
+    }
+    ++m_stats.created;
+    return handle;
+}
+
+template<typename Record, typename Tag>
+void ResourceRegistry::Remove(HandlePool<Record, Tag>& pool, Handle<Tag> handle) {
+    Record record;
+    if (!pool.Destroy(handle, &record)) return;
+    m_pending.push_back({ record.native, m_frame });
+    ++m_stats.destroyed;
+    if (PendingReleases() > m_stats.peakPendingReleases) m_stats.peakPendingReleases = PendingReleases();
+}
+
+BufferHandle ResourceRegistry::CreateBuffer(const BufferDesc& desc, const void* initialData) {
+    return Add(m_buffers, BufferRecord{ m_device->CreateBuffer(desc, initialData), desc });
+}
+
+ShaderHandle ResourceRegistry::CreateShader(ShaderStage stage, const void* bytecode, size_t size) {
+    return Add(m_shaders, ShaderRecord{ m_device->CreateShader(stage, bytecode, size), stage });
+}
+
+InputLayoutHandle ResourceRegistry::CreateInputLayout(const MeshVertexLayout& layout, const void* vsBytecode, size_t size) {
+    return Add(m_inputLayouts, InputLayoutRecord{ m_device->CreateInputLayout(layout, vsBytecode, size), layout.stride });
+}
+
+void ResourceRegistry::Destroy(BufferHandle handle) { Remove(m_buffers, handle); }
+void ResourceRegistry::Destroy(ShaderHandle handle) { Remove(m_shaders, handle); }
+void ResourceRegistry::Destroy(InputLayoutHandle handle) { Remove(m_inputLayouts, handle); }
+
+} // namespace gfx
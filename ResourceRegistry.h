@@ -0,0 +1,162 @@
+#pragma once
+
+#include "MeshFile.h"
+#include "ResourcePool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+struct BufferTag;
+struct ShaderTag;
+struct InputLayoutTag;
+
+using BufferHandle = Handle<BufferTag>;
+using ShaderHandle = Handle<ShaderTag>;
+using InputLayoutHandle = Handle<InputLayoutTag>;
+
+// Backend object (an ID3D11DeviceChild* on D3D11); opaque to the registry.
+using NativeResource = void*;
+
+enum class BufferUsage : uint8_t { Immutable, Default, Dynamic };
+
+enum BufferBindFlags : uint32_t {
+    BindVertexBuffer = 1,
+    BindIndexBuffer = 2,
+    BindConstantBuffer = 4,
+};
+
+struct BufferDesc {
+    uint32_t size;
+    BufferUsage usage;
+    uint32_t bindFlags;
+};
+
+enum class ShaderStage : uint8_t { Vertex, Pixel };
+
+struct BufferRecord {
+    NativeResource native;
+    BufferDesc desc;
+};
+
+struct ShaderRecord {
+    NativeResource native;
+    ShaderStage stage;
+};
+
+struct InputLayoutRecord {
+    NativeResource native;
+    uint32_t stride;
+};
+
+// Creates and releases the native objects behind registry handles. Create*
+// returns nullptr on failure.
+class ResourceDevice {
+public:
+    virtual ~ResourceDevice() = default;
+
+    virtual NativeResource CreateBuffer(const BufferDesc& desc, const void* initialData) = 0;
+    virtual NativeResource CreateShader(ShaderStage stage, const void* bytecode, size_t size) = 0;
+    virtual NativeResource CreateInputLayout(const MeshVertexLayout& layout, const void* vsBytecode, size_t size) = 0;
+    virtual void Release(NativeResource object) = 0;
+};
+
+// Backend that hands out distinct fake objects and only counts them.
+class NullResourceDevice final : public ResourceDevice {
+public:
+    NativeResource CreateBuffer(const BufferDesc&, const void*) override { return Next(); }
+    NativeResource CreateShader(ShaderStage, const void*, size_t) override { return Next(); }
+    NativeResource CreateInputLayout(const MeshVertexLayout&, const void*, size_t) override { return Next(); }
+    void Release(NativeResource) override { ++m_released; }
+
+    uint64_t Created() const noexcept { return m_created; }
+    uint64_t Released() const noexcept { return m_released; }
+    uint64_t Live() const noexcept { return m_created - m_released; }
+
+private:
+    NativeResource Next() noexcept { return reinterpret_cast<NativeResource>(static_cast<uintptr_t>(++m_created)); }
+
+    uint64_t m_created = 0;
+    uint64_t m_released = 0;
+};
+
+struct ResourceRegistryStats {
+    uint64_t created = 0;
+    uint64_t failedCreates = 0;
+    uint64_t destroyed = 0;
+    uint64_t released = 0;
+    uint64_t peakPendingReleases = 0;
+};
+
+// Owns every GPU object of the renderer, one dense pool per type. Destroying a
+// handle invalidates it at once, but the native object is only released when
+// framesInFlight further frames have begun, since the GPU may still read it.
+class ResourceRegistry {
+public:
+    ResourceRegistry() = default;
+    ~ResourceRegistry() { Clear(); }
+
+    ResourceRegistry(const ResourceRegistry&) = delete;
+    ResourceRegistry& operator=(const ResourceRegistry&) = delete;
+
+    void Initialize(ResourceDevice* device, uint32_t framesInFlight) noexcept;
+    // Releases every live and pending object right away; the GPU must be idle.
+    void Clear();
+
+    // Releases the objects destroyed framesInFlight frames ago.
+    void BeginFrame();
+
+    BufferHandle CreateBuffer(const BufferDesc& desc, const void* initialData = nullptr);
+    ShaderHandle CreateShader(ShaderStage stage, const void* bytecode, size_t size);
+    InputLayoutHandle CreateInputLayout(const MeshVertexLayout& layout, const void* vsBytecode, size_t size);
+
+    // Stale and null handles are ignored.
+    void Destroy(BufferHandle handle);
+    void Destroy(ShaderHandle handle);
+    void Destroy(InputLayoutHandle handle);
+
+    // nullptr for stale handles.
+    const BufferRecord* Get(BufferHandle handle) const noexcept { return m_buffers.Get(handle); }
+    const ShaderRecord* Get(ShaderHandle handle) const noexcept { return m_shaders.Get(handle); }
+    const InputLayoutRecord* Get(InputLayoutHandle handle) const noexcept { return m_inputLayouts.Get(handle); }
+
+    template<typename HandleType>
+    NativeResource Native(HandleType handle) const noexcept {
+        const auto* record = Get(handle);
+        return record ? record->native : nullptr;
+    }
+
+    const HandlePool<BufferRecord, BufferTag>& Buffers() const noexcept { return m_buffers; }
+    const HandlePool<ShaderRecord, ShaderTag>& Shaders() const noexcept { return m_shaders; }
+    const HandlePool<InputLayoutRecord, InputLayoutTag>& InputLayouts() const noexcept { return m_inputLayouts; }
+
+    uint64_t FrameIndex() const noexcept { return m_frame; }
+    size_t PendingReleases() const noexcept { return m_pending.size() - m_pendingHead; }
+    const ResourceRegistryStats& Stats() const noexcept { return m_stats; }
+
+private:
+    struct PendingRelease {
+        NativeResource native;
+        uint64_t frame;
+    };
+
+    template<typename Record, typename Tag>
+    Handle<Tag> Add(HandlePool<Record, Tag>& pool, const Record& record);
+    template<typename Record, typename Tag>
+    void Remove(HandlePool<Record, Tag>& pool, Handle<Tag> handle);
+
+    ResourceDevice* m_device = nullptr;
+    uint32_t m_framesInFlight = 1;
+    uint64_t m_frame = 0;
+    HandlePool<BufferRecord, BufferTag> m_buffers;
+    HandlePool<ShaderRecord, ShaderTag> m_shaders;
+    HandlePool<InputLayoutRecord, InputLayoutTag> m_inputLayouts;
+    // Ordered by frame; entries before m_pendingHead have been released.
+    std::vector<PendingRelease> m_pending;
+    size_t m_pendingHead = 0;
+    ResourceRegistryStats m_stats;
+};
+
+} // namespace gfx
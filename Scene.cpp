@@ -0,0 +1,65 @@
+#include "Scene.h"
+
+#include <cmath>
+
+namespace gfx {
+
+uint32_t Scene::AddObject(const Float4x4& world, const Float3& localMin, const Float3& localMax) {
+    uint32_t object = static_cast<uint32_t>(m_world.size());
+    m_world.push_back(world);
+    m_localCenter.push_back((localMin + localMax) * 0.5f);
+    m_localExtent.push_back((localMax - localMin) * 0.5f);
+    m_centerX.push_back(0.0f);
+    m_centerY.push_back(0.0f);
+    m_centerZ.push_back(0.0f);
+    m_extentX.push_back(0.0f);
+    m_extentY.push_back(0.0f);
+    m_extentZ.push_back(0.0f);
+    UpdateBounds(object);
+    return object;
+}
+
+void Scene::SetWorld(uint32_t object, const Float4x4& world) noexcept {
+    m_world[object] = world;
+    UpdateBounds(object);
+}
+
+void Scene::Clear() noexcept {
+    m_world.clear();
+    m_localCenter.clear();
+    m_localExtent.clear();
+    m_centerX.clear();
+    m_centerY.clear();
+    m_centerZ.clear();
+    m_extentX.clear();
+    m_extentY.clear();
+    m_extentZ.clear();
+}
+
+void Scene::Reserve(size_t count) {
+    m_world.reserve(count);
+    m_localCenter.reserve(count);
+    m_localExtent.reserve(count);
+    m_centerX.reserve(count);
+    m_centerY.reserve(count);
+    m_centerZ.reserve(count);
+    m_extentX.reserve(count);
+    m_extentY.reserve(count);
+    m_extentZ.reserve(count);
+}
+
+// Transformed box: center goes through the matrix, extent through its absolute 3x3 part.
+void Scene::UpdateBounds(uint32_t object) noexcept {
+    const Float4x4& m = m_world[object];
+    const Float3& c = m_localCenter[object];
+    const Float3& e = m_localExtent[object];
+    Float4 center = TransformPoint(c, m);
+    m_centerX[object] = center.x;
+    m_centerY[object] = center.y;
+    m_centerZ[object] = center.z;
+    m_extentX[object] = e.x * std::fabs(m.m[0][0]) + e.y * std::fabs(m.m[1][0]) + e.z * std::fabs(m.m[2][0]);
+    m_extentY[object] = e.x * std::fabs(m.m[0][1]) + e.y * std::fabs(m.m[1][1]) + e.z * std::fabs(m.m[2][1]);
+    m_extentZ[object] = e.x * std::fabs(m.m[0][2]) + e.y * std::fabs(m.m[1][2]) + e.z * std::fabs(m.m[2][2]);
+}
+
+} // namespace gfx
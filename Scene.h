@@ -0,0 +1,46 @@
+#pragma once
+
+#include "MathTypes.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+// World-space AABBs as center/extent streams, one entry per object.
+struct AabbStreams {
+    const float* centerX;
+    const float* centerY;
+    const float* centerZ;
+    const float* extentX;
+    const float* extentY;
+    const float* extentZ;
+};
+
+// Flat container of scene objects: world matrix, local bounds and the derived
+// world AABB kept in SoA form for the culling kernels.
+class Scene {
+public:
+    uint32_t AddObject(const Float4x4& world, const Float3& localMin, const Float3& localMax);
+    void SetWorld(uint32_t object, const Float4x4& world) noexcept;
+    void Clear() noexcept;
+    void Reserve(size_t count);
+
+    size_t ObjectCount() const noexcept { return m_world.size(); }
+    const Float4x4& World(uint32_t object) const noexcept { return m_world[object]; }
+
+    AabbStreams Bounds() const noexcept {
+        return { m_centerX.data(), m_centerY.data(), m_centerZ.data(), m_extentX.data(), m_extentY.data(), m_extentZ.data() };
+    }
+
+private:
+    void UpdateBounds(uint32_t object) noexcept;
+
+    std::vector<Float4x4> m_world;
+    std::vector<Float3> m_localCenter;
+    std::vector<Float3> m_localExtent;
+    std::vector<float> m_centerX, m_centerY, m_centerZ;
+    std::vector<float> m_extentX, m_extentY, m_extentZ;
+};
+
+} // namespace gfx
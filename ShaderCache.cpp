@@ -0,0 +1,132 @@
+#include "ShaderCache.h"
+
+#include "Hash.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+namespace gfx {
+
+namespace {
+
+constexpr uint32_t EntryMagic = 0x43485347; // "GSHC"
+constexpr uint32_t EntryVersion = 1;
+
+// Bytecode starts right after the header, 32 bytes into the file.
+struct EntryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint64_t bytecodeSize;
+    uint64_t bytecodeHash;
+};
+static_assert(sizeof(EntryHeader) == 32, "cache entry header layout");
+
+uint64_t HashString(uint64_t seed, const char* s) noexcept {
+    if (!s) return HashCombine(seed, 0);
+    return HashCombine(seed, Hash64(s, std::strlen(s) + 1));
+}
+
+} // namespace
+
+ShaderCache::ShaderCache(std::string directory, ShaderCompiler& compiler)
+    : m_directory(std::move(directory)), m_compiler(compiler) {
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory, ec);
+}
+
+uint64_t ShaderCache::ComputeKey(const ShaderCompileRequest& request, uint64_t compilerVersion) noexcept {
+    uint64_t key = HashCombine(EntryVersion, compilerVersion);
+    key = HashCombine(key, Hash64(request.source, request.sourceSize));
+    key = HashString(key, request.entryPoint);
+    key = HashString(key, request.profile);
+    key = HashCombine(key, request.flags);
+    for (uint32_t i = 0; i < request.defineCount; ++i) {
+        key = HashString(key, request.defines[i].name);
+        key = HashString(key, request.defines[i].value);
+    }
+    return key;
+}
+
+std::string ShaderCache::EntryPath(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.cso", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(m_directory) / name).string();
+}
+
+bool ShaderCache::Load(const ShaderCompileRequest& request, ShaderBytecode& out, std::string* errors) {
+    uint64_t key = ComputeKey(request, m_compiler.VersionHash());
+    if (TryMap(key, out)) {
+        ++m_stats.hits;
+        return true;
+    }
+
+    ++m_stats.misses;
+    std::string compileErrors;
+    out.m_mapping.Close();
+    out.m_owned.clear();
+    if (!m_compiler.Compile(request, out.m_owned, compileErrors)) {
+        if (errors) *errors = std::move(compileErrors);
+        out.m_data = nullptr;
+        out.m_size = 0;
+        return false;
+    }
+    out.m_data = out.m_owned.data();
+    out.m_size = out.m_owned.size();
+    if (!Store(key, out.m_owned)) ++m_stats.writeFailures;
+    return true;
+}
+
+bool ShaderCache::TryMap(uint64_t key, ShaderBytecode& out) {
+    std::string path = EntryPath(key);
+    MappedFile file;
+    if (!file.Open(path.c_str())) return false;
+
+    EntryHeader header;
+    bool valid = file.Size() >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, file.Data(), sizeof(header));
+        valid = header.magic == EntryMagic && header.version == EntryVersion && header.key == key &&
+                header.bytecodeSize == file.Size() - sizeof(header) &&
+                header.bytecodeHash == Hash64(file.Data() + sizeof(header), static_cast<size_t>(header.bytecodeSize));
+    }
+    if (!valid) {
+        ++m_stats.invalidEntries;
+        file.Close();
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return false;
+    }
+
+    out.m_owned.clear();
+    out.m_mapping = std::move(file);
+    out.m_data = out.m_mapping.Data() + sizeof(header);
+    out.m_size = static_cast<size_t>(header.bytecodeSize);
+    return true;
+}
+
+// Written to a temporary name and renamed, so readers never map a partial entry.
+bool ShaderCache::Store(uint64_t key, const std::vector<uint8_t>& bytecode) {
+    EntryHeader header = { EntryMagic, EntryVersion, key, bytecode.size(), Hash64(bytecode.data(), bytecode.size()) };
+    std::string path = EntryPath(key);
+    std::string tempPath = path + ".tmp";
+
+    FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) return false;
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   (bytecode.empty() || std::fwrite(bytecode.data(), bytecode.size(), 1, file) == 1);
+    written = std::fclose(file) == 0 && written;
+
+    std::error_code ec;
+    if (written) std::filesystem::rename(tempPath, path, ec);
+    if (!written || ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace gfx
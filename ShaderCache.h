@@ -0,0 +1,84 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gfx {
+
+// Same layout as D3D_SHADER_MACRO.
+struct ShaderDefine {
+    const char* name;
+    const char* value;
+};
+
+struct ShaderCompileRequest {
+    const char* source;
+    size_t sourceSize;
+    const char* entryPoint;
+    const char* profile;
+    const ShaderDefine* defines;
+    uint32_t defineCount;
+    uint32_t flags;
+    const char* debugName;
+};
+
+// Anything that turns HLSL into bytecode: D3DCompile on Windows, a stand-in elsewhere.
+class ShaderCompiler {
+public:
+    virtual ~ShaderCompiler() = default;
+
+    // Identifies the compiler build; part of every cache key.
+    virtual uint64_t VersionHash() const noexcept = 0;
+    virtual bool Compile(const ShaderCompileRequest& request, std::vector<uint8_t>& bytecode, std::string& errors) = 0;
+};
+
+// Bytecode that either points into a mapped cache file or owns a fresh compile.
+class ShaderBytecode {
+public:
+    const void* Data() const noexcept { return m_data; }
+    size_t Size() const noexcept { return m_size; }
+    bool IsMapped() const noexcept { return m_mapping.IsOpen(); }
+
+private:
+    friend class ShaderCache;
+
+    MappedFile m_mapping;
+    std::vector<uint8_t> m_owned;
+    const void* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+struct ShaderCacheStats {
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t invalidEntries = 0;
+    uint32_t writeFailures = 0;
+};
+
+// On-disk bytecode cache keyed by source, entry point, profile, defines, flags
+// and compiler version. Entries are memory-mapped on a hit; entries with a bad
+// header, size or checksum are recompiled and overwritten.
+class ShaderCache {
+public:
+    ShaderCache(std::string directory, ShaderCompiler& compiler);
+
+    bool Load(const ShaderCompileRequest& request, ShaderBytecode& out, std::string* errors = nullptr);
+
+    static uint64_t ComputeKey(const ShaderCompileRequest& request, uint64_t compilerVersion) noexcept;
+    std::string EntryPath(uint64_t key) const;
+
+    const ShaderCacheStats& Stats() const noexcept { return m_stats; }
+
+private:
+    bool TryMap(uint64_t key, ShaderBytecode& out);
+    bool Store(uint64_t key, const std::vector<uint8_t>& bytecode);
+
+    std::string m_directory;
+    ShaderCompiler& m_compiler;
+    ShaderCacheStats m_stats;
+};
+
+} // namespace gfx
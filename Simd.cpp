@@ -0,0 +1,96 @@
+#include "Simd.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#if GFX_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#elif GFX_X86
+#include <cpuid.h>
+#endif
+
+namespace gfx {
+
+namespace {
+
+#if GFX_X86
+void CpuId(int leaf, int subleaf, int regs[4]) noexcept {
+#if defined(_MSC_VER)
+    __cpuidex(regs, leaf, subleaf);
+#else
+    unsigned a, b, c, d;
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+    regs[0] = static_cast<int>(a);
+    regs[1] = static_cast<int>(b);
+    regs[2] = static_cast<int>(c);
+    regs[3] = static_cast<int>(d);
+#endif
+}
+
+unsigned long long ReadXcr0() noexcept {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+CpuFeatures DetectCpuFeatures() noexcept {
+    CpuFeatures features;
+#if GFX_X86
+    int regs[4];
+    CpuId(0, 0, regs);
+    int maxLeaf = regs[0];
+    if (maxLeaf < 1) return features;
+
+    CpuId(1, 0, regs);
+    bool osxsave = (regs[2] & (1 << 27)) != 0;
+    bool ymmEnabled = osxsave && (ReadXcr0() & 0x6) == 0x6;
+    features.sse41 = (regs[2] & (1 << 19)) != 0;
+    features.avx = ymmEnabled && (regs[2] & (1 << 28)) != 0;
+    features.fma = features.avx && (regs[2] & (1 << 12)) != 0;
+    features.f16c = features.avx && (regs[2] & (1 << 29)) != 0;
+    if (maxLeaf >= 7) {
+        CpuId(7, 0, regs);
+        features.avx2 = features.avx && (regs[1] & (1 << 5)) != 0;
+    }
+#endif
+    return features;
+}
+
+} // namespace
+
+const CpuFeatures& GetCpuFeatures() noexcept {
+    static const CpuFeatures features = DetectCpuFeatures();
+    return features;
+}
+
+SimdLevel BestSimdLevel() noexcept {
+    static const SimdLevel level = [] {
+        const CpuFeatures& cpu = GetCpuFeatures();
+        SimdLevel best = SimdLevel::Scalar;
+#if GFX_X86
+        best = (cpu.avx2 && cpu.fma) ? SimdLevel::AVX2 : SimdLevel::SSE;
+#endif
+        const char* cap = std::getenv("GFX_SIMD");
+        if (cap && !std::strcmp(cap, "scalar")) best = SimdLevel::Scalar;
+        else if (cap && !std::strcmp(cap, "sse") && best == SimdLevel::AVX2) best = SimdLevel::SSE;
+        (void)cpu;
+        return best;
+    }();
+    return level;
+}
+
+const char* SimdLevelName(SimdLevel level) noexcept {
+    switch (level) {
+    case SimdLevel::Scalar: return "scalar";
+    case SimdLevel::SSE: return "sse";
+    case SimdLevel::AVX2: return "avx2";
+    }
+    return "unknown";
+}
+
+} // namespace gfx
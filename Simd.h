@@ -0,0 +1,61 @@
+#pragma once
+
+// x86 and x64 builds get the intrinsics; other targets only have the scalar paths.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GFX_X86 1
+#include <immintrin.h>
+#else
+#define GFX_X86 0
+#endif
+
+// __cpuid and _xgetbv for GetCpuFeatures.
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <cstdint>
+
+// MSVC allows any intrinsic in any function; GCC and Clang need the ISA named per function.
+#if GFX_X86 && !defined(_MSC_VER)
+#define GFX_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define GFX_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define GFX_TARGET_F16C __attribute__((target("avx,f16c")))
+#else
+#define GFX_TARGET_SSE41
+#define GFX_TARGET_AVX2
+#define GFX_TARGET_F16C
+#endif
+
+namespace gfx {
+
+enum class SimdLevel { Scalar, SSE, AVX2 };
+
+struct CpuFeatures {
+    bool sse41 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+};
+
+// Detected once; AVX features also require OS support for the YMM state.
+const CpuFeatures& GetCpuFeatures() noexcept;
+
+// Widest level supported by this CPU, capped by the GFX_SIMD environment
+// variable ("scalar", "sse" or "avx2") when it is set.
+SimdLevel BestSimdLevel() noexcept;
+
+const char* SimdLevelName(SimdLevel level) noexcept;
+
+// Index of the lowest set bit; value must be non-zero.
+inline uint32_t CountTrailingZeros(uint32_t value) noexcept {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+}
+
+} // namespace gfx
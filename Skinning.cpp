@@ -0,0 +1,308 @@
+#include "Skinning.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+namespace {
+
+constexpr uint32_t SkinChunkSize = 4096;
+constexpr uint32_t CharactersPerTask = 8;
+
+// The SIMD kernels below evaluate the same expressions in the same order without
+// FMA: blended row r = ((w0 * M0[r] + w1 * M1[r]) + w2 * M2[r]) + w3 * M3[r], and the
+// position = ((x * row0 + y * row1) + z * row2) + row3.
+
+void SkinScalar(const ColoredVertex* bind, const SkinInfluence* influences, const Float4x4* skin, ColoredVertex* out,
+                uint32_t i, uint32_t end) noexcept {
+    for (; i < end; ++i) {
+        const SkinInfluence& influence = influences[i];
+        const float* w = influence.weights;
+        const Float4x4& m0 = skin[influence.joints[0]];
+        const Float4x4& m1 = skin[influence.joints[1]];
+        const Float4x4& m2 = skin[influence.joints[2]];
+        const Float4x4& m3 = skin[influence.joints[3]];
+        float rows[4][3];
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                rows[r][c] = ((w[0] * m0.m[r][c] + w[1] * m1.m[r][c]) + w[2] * m2.m[r][c]) + w[3] * m3.m[r][c];
+            }
+        }
+        const float* p = bind[i].position;
+        ColoredVertex vertex;
+        for (int c = 0; c < 3; ++c) {
+            vertex.position[c] = ((p[0] * rows[0][c] + p[1] * rows[1][c]) + p[2] * rows[2][c]) + rows[3][c];
+        }
+        vertex.rgba = bind[i].rgba;
+        out[i] = vertex;
+    }
+}
+
+#if GFX_X86
+// One vertex per register; lane 3 carries the color bits through shuffles only.
+uint32_t SkinSSE(const ColoredVertex* bind, const SkinInfluence* influences, const Float4x4* skin, ColoredVertex* out,
+                 uint32_t i, uint32_t end) noexcept {
+    for (; i < end; ++i) {
+        const SkinInfluence& influence = influences[i];
+        const float* m0 = skin[influence.joints[0]].m[0];
+        const float* m1 = skin[influence.joints[1]].m[0];
+        const float* m2 = skin[influence.joints[2]].m[0];
+        const float* m3 = skin[influence.joints[3]].m[0];
+        const __m128 w0 = _mm_set1_ps(influence.weights[0]);
+        const __m128 w1 = _mm_set1_ps(influence.weights[1]);
+        const __m128 w2 = _mm_set1_ps(influence.weights[2]);
+        const __m128 w3 = _mm_set1_ps(influence.weights[3]);
+        __m128 rows[4];
+        for (int r = 0; r < 4; ++r) {
+            __m128 row = _mm_add_ps(_mm_mul_ps(w0, _mm_loadu_ps(m0 + r * 4)), _mm_mul_ps(w1, _mm_loadu_ps(m1 + r * 4)));
+            row = _mm_add_ps(row, _mm_mul_ps(w2, _mm_loadu_ps(m2 + r * 4)));
+            rows[r] = _mm_add_ps(row, _mm_mul_ps(w3, _mm_loadu_ps(m3 + r * 4)));
+        }
+        const __m128 vertex = _mm_loadu_ps(bind[i].position);
+        __m128 p = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(vertex, vertex, 0x00), rows[0]),
+                              _mm_mul_ps(_mm_shuffle_ps(vertex, vertex, 0x55), rows[1]));
+        p = _mm_add_ps(p, _mm_mul_ps(_mm_shuffle_ps(vertex, vertex, 0xAA), rows[2]));
+        p = _mm_add_ps(p, rows[3]);
+        // (p.x, p.y, p.z, vertex.w)
+        const __m128 zw = _mm_shuffle_ps(p, vertex, _MM_SHUFFLE(3, 3, 2, 2));
+        _mm_storeu_ps(out[i].position, _mm_shuffle_ps(p, zw, _MM_SHUFFLE(2, 0, 1, 0)));
+    }
+    return i;
+}
+
+GFX_TARGET_AVX2 inline __m256 LoadPair(const float* low, const float* high) noexcept {
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+}
+
+// Two vertices per register, one in each 128-bit half.
+GFX_TARGET_AVX2 uint32_t SkinAVX2(const ColoredVertex* bind, const SkinInfluence* influences, const Float4x4* skin,
+                                  ColoredVertex* out, uint32_t i, uint32_t end) noexcept {
+    for (; i + 2 <= end; i += 2) {
+        const SkinInfluence& a = influences[i];
+        const SkinInfluence& b = influences[i + 1];
+        const __m256 w = LoadPair(a.weights, b.weights);
+        const __m256 weights[4] = { _mm256_permute_ps(w, 0x00), _mm256_permute_ps(w, 0x55), _mm256_permute_ps(w, 0xAA),
+                                    _mm256_permute_ps(w, 0xFF) };
+        const float* ma[4];
+        const float* mb[4];
+        for (int k = 0; k < 4; ++k) {
+            ma[k] = skin[a.joints[k]].m[0];
+            mb[k] = skin[b.joints[k]].m[0];
+        }
+        __m256 rows[4];
+        for (int r = 0; r < 4; ++r) {
+            __m256 row = _mm256_add_ps(_mm256_mul_ps(weights[0], LoadPair(ma[0] + r * 4, mb[0] + r * 4)),
+                                       _mm256_mul_ps(weights[1], LoadPair(ma[1] + r * 4, mb[1] + r * 4)));
+            row = _mm256_add_ps(row, _mm256_mul_ps(weights[2], LoadPair(ma[2] + r * 4, mb[2] + r * 4)));
+            rows[r] = _mm256_add_ps(row, _mm256_mul_ps(weights[3], LoadPair(ma[3] + r * 4, mb[3] + r * 4)));
+        }
+        const __m256 vertex = _mm256_loadu_ps(bind[i].position);
+        __m256 p = _mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(vertex, 0x00), rows[0]),
+                                 _mm256_mul_ps(_mm256_permute_ps(vertex, 0x55), rows[1]));
+        p = _mm256_add_ps(p, _mm256_mul_ps(_mm256_permute_ps(vertex, 0xAA), rows[2]));
+        p = _mm256_add_ps(p, rows[3]);
+        _mm256_storeu_ps(out[i].position, _mm256_blend_ps(p, vertex, 0x88));
+    }
+    return i;
+}
+#endif
+
+float Lerp(float a, float b, float t) noexcept {
+    return a + (b - a) * t;
+}
+
+} // namespace
+
+void SkinVertices(const ColoredVertex* bind, const SkinInfluence* influences, uint32_t count, const Float4x4* skin,
+                  ColoredVertex* out, SimdLevel level) noexcept {
+    uint32_t i = 0;
+#if GFX_X86
+    if (level == SimdLevel::AVX2) i = SkinAVX2(bind, influences, skin, out, i, count);
+    if (level != SimdLevel::Scalar) i = SkinSSE(bind, influences, skin, out, i, count);
+#else
+    (void)level;
+#endif
+    SkinScalar(bind, influences, skin, out, i, count);
+}
+
+void SkinVertices(const ColoredVertex* bind, const SkinInfluence* influences, uint32_t count, const Float4x4* skin,
+                  ColoredVertex* out, ThreadPool* pool, SimdLevel level) {
+    const uint32_t chunks = (count + SkinChunkSize - 1) / SkinChunkSize;
+    auto run = [&](uint32_t chunk) {
+        uint32_t begin = chunk * SkinChunkSize;
+        uint32_t end = std::min(begin + SkinChunkSize, count);
+        SkinVertices(bind + begin, influences + begin, end - begin, skin, out + begin, level);
+    };
+    if (pool && chunks > 1) {
+        pool->Run(chunks, [&](uint32_t chunk, uint32_t) { run(chunk); });
+    } else {
+        for (uint32_t chunk = 0; chunk < chunks; ++chunk) run(chunk);
+    }
+}
+
+void BuildTentacle(const TentacleDesc& desc, Skeleton& skeleton, SkinnedMesh& mesh) {
+    const uint32_t jointCount = std::max(desc.jointCount, 1u);
+    const uint32_t rings = jointCount * std::max(desc.ringsPerJoint, 1u) + 1;
+    const uint32_t sides = std::max(desc.sides, 3u);
+    const float segment = desc.length / static_cast<float>(jointCount);
+
+    skeleton = {};
+    skeleton.parents.resize(jointCount);
+    skeleton.bindPose.resize(jointCount);
+    for (uint32_t j = 0; j < jointCount; ++j) {
+        skeleton.parents[j] = j ? j - 1 : NoJoint;
+        skeleton.bindPose[j].translation = { 0.0f, j ? segment : 0.0f, 0.0f };
+    }
+    ComputeInverseBind(skeleton);
+
+    float base[4], tip[4];
+    UnpackRGBA8(desc.baseColor, base);
+    UnpackRGBA8(desc.tipColor, tip);
+    mesh.vertices.resize(size_t(rings) * sides);
+    mesh.influences.resize(mesh.vertices.size());
+    for (uint32_t ring = 0; ring < rings; ++ring) {
+        const float t = static_cast<float>(ring) / static_cast<float>(rings - 1);
+        const float y = desc.length * t;
+        const float radius = desc.radius * Lerp(1.0f, desc.tipScale, t);
+        const uint32_t rgba = PackRGBA8(Lerp(base[0], tip[0], t), Lerp(base[1], tip[1], t), Lerp(base[2], tip[2], t),
+                                        Lerp(base[3], tip[3], t));
+
+        // Uniform cubic B-spline weights of joints first - 1 .. first + 2, clamped to the chain.
+        const float u = y / segment;
+        const float first = std::floor(u);
+        const float f = u - first;
+        const float weights[4] = { (1.0f - f) * (1.0f - f) * (1.0f - f) / 6.0f, (3.0f * f * f * f - 6.0f * f * f + 4.0f) / 6.0f,
+                                   (-3.0f * f * f * f + 3.0f * f * f + 3.0f * f + 1.0f) / 6.0f, f * f * f / 6.0f };
+        SkinInfluence influence;
+        for (uint32_t k = 0; k < MaxSkinInfluences; ++k) {
+            int32_t joint = static_cast<int32_t>(first) - 1 + static_cast<int32_t>(k);
+            joint = std::min(std::max(joint, 0), static_cast<int32_t>(jointCount) - 1);
+            influence.joints[k] = static_cast<uint16_t>(joint);
+            influence.weights[k] = weights[k];
+        }
+
+        for (uint32_t side = 0; side < sides; ++side) {
+            const float angle = 6.2831853f * static_cast<float>(side) / static_cast<float>(sides);
+            ColoredVertex& vertex = mesh.vertices[size_t(ring) * sides + side];
+            vertex.position[0] = radius * std::cos(angle);
+            vertex.position[1] = y;
+            vertex.position[2] = radius * std::sin(angle);
+            vertex.rgba = rgba;
+            mesh.influences[size_t(ring) * sides + side] = influence;
+        }
+    }
+
+    mesh.indices.clear();
+    mesh.indices.reserve(size_t(rings - 1) * sides * 6);
+    for (uint32_t ring = 0; ring + 1 < rings; ++ring) {
+        for (uint32_t side = 0; side < sides; ++side) {
+            const uint32_t next = (side + 1) % sides;
+            const uint32_t a = ring * sides + side, b = ring * sides + next;
+            const uint32_t c = a + sides, d = b + sides;
+            mesh.indices.insert(mesh.indices.end(), { c, d, b, c, b, a });
+        }
+    }
+}
+
+AnimationClip MakeSwayClip(const Skeleton& skeleton, float duration, const Float3& axis, float amplitude, float phasePerJoint,
+                           uint32_t keysPerCycle) {
+    const uint32_t jointCount = skeleton.JointCount();
+    const uint32_t keys = std::max(keysPerCycle, 2u);
+    AnimationClip clip(jointCount, duration);
+    std::vector<float> times(keys + 1);
+    std::vector<Float4> values(keys + 1);
+    for (uint32_t j = 0; j < jointCount; ++j) {
+        for (uint32_t k = 0; k <= keys; ++k) {
+            const float cycle = static_cast<float>(k) / static_cast<float>(keys);
+            times[k] = duration * cycle;
+            values[k] = QuaternionRotationAxis(axis, amplitude * std::sin(6.2831853f * cycle + phasePerJoint * static_cast<float>(j)));
+        }
+        clip.SetKeys(j, AnimationChannel::Rotation, times.data(), values.data(), keys + 1);
+    }
+    return clip;
+}
+
+CrowdAnimator::CrowdAnimator(const Skeleton& skeleton, const SkinnedMesh& mesh) : m_skeleton(skeleton), m_mesh(mesh) {}
+
+uint32_t CrowdAnimator::Add(const CharacterState& state) {
+    m_characters.push_back(state);
+    m_cursors.resize(m_characters.size() * 2);
+    return Count() - 1;
+}
+
+void CrowdAnimator::Clear() noexcept {
+    m_characters.clear();
+    m_cursors.clear();
+}
+
+void CrowdAnimator::Advance(float dt) noexcept {
+    // Clocks are kept within one loop so they do not lose precision over a long run.
+    auto advance = [](float time, float step, const AnimationClip* clip) noexcept {
+        time += step;
+        return clip && clip->Duration() > 0.0f ? std::fmod(time, clip->Duration()) : time;
+    };
+    for (CharacterState& character : m_characters) {
+        const float step = dt * character.speed;
+        character.time = advance(character.time, step, character.clip);
+        character.blendTime = advance(character.blendTime, step, character.blendClip);
+    }
+}
+
+void CrowdAnimator::UpdatePoses(ThreadPool* pool) {
+    const uint32_t jointCount = m_skeleton.JointCount();
+    const uint32_t threads = pool ? pool->ThreadCount() : 1;
+    m_skin.resize(size_t(Count()) * jointCount);
+    if (m_scratch.size() < threads) m_scratch.resize(threads);
+    for (Scratch& scratch : m_scratch) {
+        scratch.pose.resize(jointCount);
+        scratch.blend.resize(jointCount);
+        scratch.joints.resize(jointCount);
+    }
+
+    auto update = [&](uint32_t index, Scratch& scratch) {
+        const CharacterState& character = m_characters[index];
+        JointTransform* pose = scratch.pose.data();
+        if (character.clip) {
+            SampleClip(*character.clip, m_skeleton, character.time, pose, &m_cursors[size_t(index) * 2]);
+        } else {
+            std::copy(m_skeleton.bindPose.begin(), m_skeleton.bindPose.end(), pose);
+        }
+        if (character.blendClip && character.blendWeight > 0.0f) {
+            SampleClip(*character.blendClip, m_skeleton, character.blendTime, scratch.blend.data(), &m_cursors[size_t(index) * 2 + 1]);
+            BlendPoses(pose, scratch.blend.data(), character.blendWeight, jointCount, pose);
+        }
+        ComputeSkinMatrices(m_skeleton, pose, character.world, scratch.joints.data(), m_skin.data() + size_t(index) * jointCount,
+                            m_level);
+    };
+    const uint32_t tasks = (Count() + CharactersPerTask - 1) / CharactersPerTask;
+    auto run = [&](uint32_t task, uint32_t thread) {
+        const uint32_t end = std::min((task + 1) * CharactersPerTask, Count());
+        for (uint32_t index = task * CharactersPerTask; index < end; ++index) update(index, m_scratch[thread]);
+    };
+    if (pool && tasks > 1) {
+        pool->Run(tasks, run);
+    } else {
+        for (uint32_t task = 0; task < tasks; ++task) run(task, 0);
+    }
+}
+
+void CrowdAnimator::Skin(ColoredVertex* out, ThreadPool* pool) {
+    const uint32_t vertexCount = m_mesh.VertexCount();
+    const uint32_t chunksPerCharacter = (vertexCount + SkinChunkSize - 1) / SkinChunkSize;
+    const uint32_t tasks = Count() * chunksPerCharacter;
+    auto run = [&](uint32_t task, uint32_t) {
+        const uint32_t index = task / chunksPerCharacter;
+        const uint32_t begin = task % chunksPerCharacter * SkinChunkSize;
+        const uint32_t end = std::min(begin + SkinChunkSize, vertexCount);
+        SkinVertices(m_mesh.vertices.data() + begin, m_mesh.influences.data() + begin, end - begin, SkinMatrices(index),
+                     out + size_t(index) * vertexCount + begin, m_level);
+    };
+    if (pool && tasks > 1) {
+        pool->Run(tasks, run);
+    } else {
+        for (uint32_t task = 0; task < tasks; ++task) run(task, 0);
+    }
+}
+
+} // namespace gfx
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Animation.h"
+#include "ColoredVertex.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+constexpr uint32_t MaxSkinInfluences = 4;
+
+// Joint weights of one vertex. Weights sum to 1; unused slots have weight 0 and
+// may name any valid joint.
+struct SkinInfluence {
+    uint16_t joints[MaxSkinInfluences];
+    float weights[MaxSkinInfluences];
+};
+
+// Bind-pose vertices with one influence each, drawn with indices.
+struct SkinnedMesh {
+    std::vector<ColoredVertex> vertices;
+    std::vector<SkinInfluence> influences;
+    std::vector<uint32_t> indices;
+
+    uint32_t VertexCount() const noexcept { return static_cast<uint32_t>(vertices.size()); }
+};
+
+// Linear blend skinning: every position is transformed by the weighted sum of its
+// joints' skin matrices, and colors are copied. All four influences are always
+// blended, in a fixed order and without FMA, so every level writes the same bits.
+// out is only written to, so it may point into a mapped dynamic vertex buffer.
+void SkinVertices(const ColoredVertex* bind, const SkinInfluence* influences, uint32_t count, const Float4x4* skin,
+                  ColoredVertex* out, SimdLevel level = BestSimdLevel()) noexcept;
+// Same, in chunks across the pool.
+void SkinVertices(const ColoredVertex* bind, const SkinInfluence* influences, uint32_t count, const Float4x4* skin,
+                  ColoredVertex* out, ThreadPool* pool, SimdLevel level = BestSimdLevel());
+
+// Tapered open tube along +Y from the origin, driven by a chain of joints. Each
+// vertex takes cubic B-spline weights from the four nearest joints, so the surface
+// bends smoothly across joint boundaries.
+struct TentacleDesc {
+    uint32_t jointCount = 12;
+    float length = 1.0f;
+    float radius = 0.08f;
+    // Radius at the tip relative to the base.
+    float tipScale = 0.3f;
+    uint32_t ringsPerJoint = 4;
+    uint32_t sides = 16;
+    uint32_t baseColor = 0xFF2040C0u;
+    uint32_t tipColor = 0xFF40E0FFu;
+};
+
+void BuildTentacle(const TentacleDesc& desc, Skeleton& skeleton, SkinnedMesh& mesh);
+
+// Looping clip that swings every joint about axis by amplitude * sin(phase), with
+// the phase advancing by phasePerJoint down the chain. Rotation keys replace the
+// bind rotations, which are identity for BuildTentacle rigs.
+AnimationClip MakeSwayClip(const Skeleton& skeleton, float duration, const Float3& axis, float amplitude, float phasePerJoint,
+                           uint32_t keysPerCycle = 16);
+
+struct CharacterState {
+    const AnimationClip* clip = nullptr;
+    float time = 0.0f;
+    // Optional second clip blended in by blendWeight.
+    const AnimationClip* blendClip = nullptr;
+    float blendTime = 0.0f;
+    float blendWeight = 0.0f;
+    float speed = 1.0f;
+    Float4x4 world = MatrixIdentity();
+};
+
+// Many instances of one skinned mesh. UpdatePoses samples, blends and resolves the
+// skin matrices of every character, one character per task with per-thread pose
+// scratch and a cursor per character and clip. Skin writes Count() copies of the
+// mesh, character c at vertex c * mesh.VertexCount(), so a single index buffer
+// draws each character with a base vertex offset.
+class CrowdAnimator {
+public:
+    // Keeps references to both; they must outlive the animator.
+    CrowdAnimator(const Skeleton& skeleton, const SkinnedMesh& mesh);
+
+    uint32_t Add(const CharacterState& state);
+    void Clear() noexcept;
+    CharacterState& Character(uint32_t index) noexcept { return m_characters[index]; }
+    uint32_t Count() const noexcept { return static_cast<uint32_t>(m_characters.size()); }
+    uint32_t VertexCount() const noexcept { return Count() * m_mesh.VertexCount(); }
+    void SetSimdLevel(SimdLevel level) noexcept { m_level = level; }
+
+    // Moves every character's clock by dt * speed.
+    void Advance(float dt) noexcept;
+
+    void UpdatePoses(ThreadPool* pool = nullptr);
+    void Skin(ColoredVertex* out, ThreadPool* pool = nullptr);
+    void Update(ColoredVertex* out, ThreadPool* pool = nullptr) {
+        UpdatePoses(pool);
+        Skin(out, pool);
+    }
+
+    // Skin matrices of one character from the last UpdatePoses.
+    const Float4x4* SkinMatrices(uint32_t index) const noexcept {
+        return m_skin.data() + size_t(index) * m_skeleton.JointCount();
+    }
+
+private:
+    struct Scratch {
+        std::vector<JointTransform> pose;
+        std::vector<JointTransform> blend;
+        std::vector<Float4x4> joints;
+    };
+
+    const Skeleton& m_skeleton;
+    const SkinnedMesh& m_mesh;
+    SimdLevel m_level = BestSimdLevel();
+    std::vector<CharacterState> m_characters;
+    // Two cursors per character: clip and blendClip.
+    std::vector<AnimationCursor> m_cursors;
+    std::vector<Float4x4> m_skin;
+    std::vector<Scratch> m_scratch;
+};
+
+} // namespace gfx
@@ -0,0 +1,367 @@
+#include "SoftRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+
+namespace {
+
+constexpr int SubpixelBits = 4;
+constexpr int SubpixelScale = 1 << SubpixelBits;
+constexpr uint32_t VerticesPerTask = 4096;
+constexpr uint32_t MinTrianglesPerChunk = 256;
+constexpr float GuardBand = 16.0f;
+constexpr float MinClipW = 1e-6f;
+
+// Clip planes as dot(plane, clipPos) >= 0: near, far, w > 0 and the x/y guard band
+// that keeps the fixed-point edge equations in range.
+constexpr float ClipPlanes[][4] = {
+    { 0.0f, 0.0f, 1.0f, 0.0f },
+    { 0.0f, 0.0f, -1.0f, 1.0f },
+    { 0.0f, 0.0f, 0.0f, 1.0f },
+    { 1.0f, 0.0f, 0.0f, GuardBand },
+    { -1.0f, 0.0f, 0.0f, GuardBand },
+    { 0.0f, 1.0f, 0.0f, GuardBand },
+    { 0.0f, -1.0f, 0.0f, GuardBand },
+};
+constexpr int ClipPlaneCount = sizeof(ClipPlanes) / sizeof(ClipPlanes[0]);
+constexpr int MaxClipVertices = 3 + ClipPlaneCount;
+
+inline float PlaneDistance(int plane, const float pos[4]) noexcept {
+    const float* p = ClipPlanes[plane];
+    float d = p[0] * pos[0] + p[1] * pos[1] + p[2] * pos[2] + p[3] * pos[3];
+    return plane == 2 ? d - MinClipW : d;
+}
+
+inline uint32_t OutCode(const float pos[4]) noexcept {
+    uint32_t code = 0;
+    for (int i = 0; i < ClipPlaneCount; ++i) {
+        if (PlaneDistance(i, pos) < 0.0f) code |= 1u << i;
+    }
+    return code;
+}
+
+inline int64_t EdgeFunction(int32_t ax, int32_t ay, int32_t bx, int32_t by, int64_t px, int64_t py) noexcept {
+    return int64_t(bx - ax) * (py - ay) - int64_t(by - ay) * (px - ax);
+}
+
+// Top-left fill rule for clockwise (positive area, y down) triangles.
+inline bool IsTopLeft(int32_t ax, int32_t ay, int32_t bx, int32_t by) noexcept {
+    int32_t dx = bx - ax;
+    int32_t dy = by - ay;
+    return dy < 0 || (dy == 0 && dx > 0);
+}
+
+inline uint32_t ToByte(float v) noexcept {
+    v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    return static_cast<uint32_t>(v * 255.0f + 0.5f);
+}
+
+} // namespace
+
+SoftRasterizer::SoftRasterizer(ThreadPool& pool) : m_pool(pool) {
+}
+
+void SoftRasterizer::SetRenderTargets(RenderTarget* color, DepthTarget* depth) noexcept {
+    m_color = color;
+    m_depth = depth;
+    if (m_color) {
+        m_tilesX = (m_color->width + TileSize - 1) / TileSize;
+        m_tilesY = (m_color->height + TileSize - 1) / TileSize;
+    }
+    else {
+        m_tilesX = m_tilesY = 0;
+    }
+}
+
+void SoftRasterizer::SetVertexBuffer(const ColoredVertex* vertices, uint32_t vertexCount) noexcept {
+    m_vertices = vertices;
+    m_vertexCount = vertexCount;
+}
+
+void SoftRasterizer::SetIndexBuffer(const void* indices, IndexFormat format) noexcept {
+    m_indices = indices;
+    m_indexFormat = format;
+}
+
+void SoftRasterizer::ClearRenderTarget(const float color[4]) {
+    if (!m_color) return;
+    Flush();
+    uint32_t value = ToByte(color[0]) | (ToByte(color[1]) << 8) | (ToByte(color[2]) << 16) | (ToByte(color[3]) << 24);
+    uint32_t rows = m_color->height;
+    m_pool.Run(m_tilesY, [&](uint32_t ty, uint32_t) {
+        uint32_t y0 = ty * TileSize;
+        uint32_t y1 = std::min(rows, y0 + TileSize);
+        std::fill(m_color->pixels.begin() + size_t(y0) * m_color->width, m_color->pixels.begin() + size_t(y1) * m_color->width, value);
+    });
+}
+
+void SoftRasterizer::ClearDepth(float depth) {
+    if (!m_depth) return;
+    Flush();
+    std::fill(m_depth->depth.begin(), m_depth->depth.end(), depth);
+}
+
+uint32_t SoftRasterizer::FetchIndex(uint32_t i) const noexcept {
+    return m_indexFormat == IndexFormat::UInt16 ? static_cast<const uint16_t*>(m_indices)[i] : static_cast<const uint32_t*>(m_indices)[i];
+}
+
+void SoftRasterizer::DrawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int32_t baseVertexLocation) {
+    if (!m_color || !m_vertices || !m_indices || m_tilesX == 0) return;
+    uint32_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) return;
+
+    // Vertex stage: the whole bound vertex buffer, same math as g_VS_Source.
+    Float4x4 mvp = Multiply(m_model, m_viewProj);
+    m_clipVertices.resize(m_vertexCount);
+    uint32_t vertexTasks = (m_vertexCount + VerticesPerTask - 1) / VerticesPerTask;
+    m_pool.Run(vertexTasks, [&](uint32_t task, uint32_t) {
+        uint32_t begin = task * VerticesPerTask;
+        uint32_t end = std::min(m_vertexCount, begin + VerticesPerTask);
+        for (uint32_t i = begin; i < end; ++i) {
+            const ColoredVertex& v = m_vertices[i];
+            Float4 p = TransformPoint({ v.position[0], v.position[1], v.position[2] }, mvp);
+            ClipVertex& out = m_clipVertices[i];
+            out.pos[0] = p.x;
+            out.pos[1] = p.y;
+            out.pos[2] = p.z;
+            out.pos[3] = p.w;
+            UnpackRGBA8(v.rgba, out.color);
+        }
+    });
+
+    // Setup and binning in chunks so that per-tile order equals submission order.
+    uint32_t threads = m_pool.ThreadCount();
+    uint32_t perChunk = std::max(MinTrianglesPerChunk, (triangleCount + threads * 4 - 1) / (threads * 4));
+    uint32_t newChunks = (triangleCount + perChunk - 1) / perChunk;
+    uint32_t firstChunk = m_activeChunks;
+    m_activeChunks += newChunks;
+    if (m_chunks.size() < m_activeChunks) m_chunks.resize(m_activeChunks);
+
+    uint32_t tileCount = m_tilesX * m_tilesY;
+    for (uint32_t c = 0; c < newChunks; ++c) {
+        Chunk& chunk = m_chunks[firstChunk + c];
+        chunk.firstTriangle = c * perChunk;
+        chunk.triangleCount = std::min(perChunk, triangleCount - chunk.firstTriangle);
+        if (chunk.bins.size() != tileCount) chunk.bins.assign(tileCount, {});
+    }
+
+    m_pool.Run(newChunks, [&](uint32_t c, uint32_t) {
+        SetupChunk(m_chunks[firstChunk + c], m_clipVertices.data(), startIndexLocation, baseVertexLocation);
+    });
+
+    m_stats.trianglesSubmitted += triangleCount;
+    for (uint32_t c = firstChunk; c < m_activeChunks; ++c) {
+        m_stats.trianglesCulled += m_chunks[c].culled;
+        m_stats.trianglesClipped += m_chunks[c].clipped;
+        m_stats.trianglesBinned += m_chunks[c].triangles.size();
+    }
+}
+
+void SoftRasterizer::SetupChunk(Chunk& chunk, const ClipVertex* verts, uint32_t startIndex, int32_t baseVertex) {
+    chunk.triangles.clear();
+    chunk.culled = 0;
+    chunk.clipped = 0;
+
+    uint32_t end = chunk.firstTriangle + chunk.triangleCount;
+    for (uint32_t t = chunk.firstTriangle; t < end; ++t) {
+        uint32_t base = startIndex + t * 3;
+        int64_t i0 = int64_t(FetchIndex(base)) + baseVertex;
+        int64_t i1 = int64_t(FetchIndex(base + 1)) + baseVertex;
+        int64_t i2 = int64_t(FetchIndex(base + 2)) + baseVertex;
+        if (i0 < 0 || i1 < 0 || i2 < 0 || i0 >= m_vertexCount || i1 >= m_vertexCount || i2 >= m_vertexCount) continue;
+
+        const ClipVertex* v[3] = { &verts[i0], &verts[i1], &verts[i2] };
+        uint32_t c0 = OutCode(v[0]->pos);
+        uint32_t c1 = OutCode(v[1]->pos);
+        uint32_t c2 = OutCode(v[2]->pos);
+        if (c0 & c1 & c2) {
+            ++chunk.culled;
+            continue;
+        }
+        if ((c0 | c1 | c2) == 0) {
+            EmitTriangle(chunk, v[0], v[1], v[2]);
+            continue;
+        }
+
+        // Sutherland-Hodgman in homogeneous clip space.
+        ++chunk.clipped;
+        ClipVertex bufferA[MaxClipVertices], bufferB[MaxClipVertices];
+        ClipVertex* in = bufferA;
+        ClipVertex* out = bufferB;
+        int count = 3;
+        in[0] = *v[0];
+        in[1] = *v[1];
+        in[2] = *v[2];
+        uint32_t planes = c0 | c1 | c2;
+        for (int p = 0; p < ClipPlaneCount && count >= 3; ++p) {
+            if (!(planes & (1u << p))) continue;
+            int outCount = 0;
+            for (int i = 0; i < count; ++i) {
+                const ClipVertex& a = in[i];
+                const ClipVertex& b = in[(i + 1) % count];
+                float da = PlaneDistance(p, a.pos);
+                float db = PlaneDistance(p, b.pos);
+                if (da >= 0.0f) out[outCount++] = a;
+                if ((da >= 0.0f) != (db >= 0.0f)) {
+                    float s = da / (da - db);
+                    ClipVertex& r = out[outCount++];
+                    for (int k = 0; k < 4; ++k) {
+                        r.pos[k] = a.pos[k] + (b.pos[k] - a.pos[k]) * s;
+                        r.color[k] = a.color[k] + (b.color[k] - a.color[k]) * s;
+                    }
+                }
+            }
+            std::swap(in, out);
+            count = outCount;
+        }
+        for (int i = 1; i + 1 < count; ++i) {
+            EmitTriangle(chunk, &in[0], &in[i], &in[i + 1]);
+        }
+    }
+
+    for (uint32_t i = 0; i < chunk.triangles.size(); ++i) {
+        const Triangle& tri = chunk.triangles[i];
+        uint32_t tx0 = uint32_t(tri.minX) / TileSize;
+        uint32_t ty0 = uint32_t(tri.minY) / TileSize;
+        uint32_t tx1 = uint32_t(tri.maxX) / TileSize;
+        uint32_t ty1 = uint32_t(tri.maxY) / TileSize;
+        for (uint32_t ty = ty0; ty <= ty1; ++ty) {
+            for (uint32_t tx = tx0; tx <= tx1; ++tx) {
+                chunk.bins[ty * m_tilesX + tx].push_back(i);
+            }
+        }
+    }
+}
+
+void SoftRasterizer::EmitTriangle(Chunk& chunk, const ClipVertex* a, const ClipVertex* b, const ClipVertex* c) {
+    const ClipVertex* v[3] = { a, b, c };
+    Triangle tri;
+    float sx[3], sy[3];
+    for (int i = 0; i < 3; ++i) {
+        float invW = 1.0f / v[i]->pos[3];
+        sx[i] = m_viewport.topLeftX + (v[i]->pos[0] * invW + 1.0f) * 0.5f * m_viewport.width;
+        sy[i] = m_viewport.topLeftY + (1.0f - v[i]->pos[1] * invW) * 0.5f * m_viewport.height;
+        tri.x[i] = static_cast<int32_t>(std::lround(sx[i] * SubpixelScale));
+        tri.y[i] = static_cast<int32_t>(std::lround(sy[i] * SubpixelScale));
+        tri.z[i] = m_viewport.minDepth + v[i]->pos[2] * invW * (m_viewport.maxDepth - m_viewport.minDepth);
+        tri.invW[i] = invW;
+        for (int k = 0; k < 4; ++k) tri.colorOverW[i][k] = v[i]->color[k] * invW;
+    }
+
+    tri.area = EdgeFunction(tri.x[0], tri.y[0], tri.x[1], tri.y[1], tri.x[2], tri.y[2]);
+    if (tri.area == 0 ||
+        (m_cullMode == CullMode::Back && tri.area < 0) ||
+        (m_cullMode == CullMode::Front && tri.area > 0)) {
+        ++chunk.culled;
+        return;
+    }
+    if (tri.area < 0) {
+        // Counter-clockwise survivor: swap to positive winding so one edge test serves both.
+        std::swap(tri.x[1], tri.x[2]);
+        std::swap(tri.y[1], tri.y[2]);
+        std::swap(tri.z[1], tri.z[2]);
+        std::swap(tri.invW[1], tri.invW[2]);
+        std::swap(tri.colorOverW[1], tri.colorOverW[2]);
+        tri.area = -tri.area;
+    }
+
+    int32_t vpX0 = std::max(0, static_cast<int32_t>(std::floor(m_viewport.topLeftX)));
+    int32_t vpY0 = std::max(0, static_cast<int32_t>(std::floor(m_viewport.topLeftY)));
+    int32_t vpX1 = std::min(static_cast<int32_t>(m_color->width), static_cast<int32_t>(std::ceil(m_viewport.topLeftX + m_viewport.width))) - 1;
+    int32_t vpY1 = std::min(static_cast<int32_t>(m_color->height), static_cast<int32_t>(std::ceil(m_viewport.topLeftY + m_viewport.height))) - 1;
+
+    tri.minX = std::max(vpX0, std::min({ tri.x[0], tri.x[1], tri.x[2] }) >> SubpixelBits);
+    tri.minY = std::max(vpY0, std::min({ tri.y[0], tri.y[1], tri.y[2] }) >> SubpixelBits);
+    tri.maxX = std::min(vpX1, std::max({ tri.x[0], tri.x[1], tri.x[2] }) >> SubpixelBits);
+    tri.maxY = std::min(vpY1, std::max({ tri.y[0], tri.y[1], tri.y[2] }) >> SubpixelBits);
+    if (tri.minX > tri.maxX || tri.minY > tri.maxY) {
+        ++chunk.culled;
+        return;
+    }
+    chunk.triangles.push_back(tri);
+}
+
+void SoftRasterizer::Flush() {
+    if (m_activeChunks == 0) return;
+
+    uint32_t tileCount = m_tilesX * m_tilesY;
+    m_pool.Run(tileCount, [this](uint32_t tile, uint32_t) { ShadeTile(tile); });
+
+    for (uint32_t c = 0; c < m_activeChunks; ++c) {
+        for (const std::vector<uint32_t>& bin : m_chunks[c].bins) m_stats.binEntries += bin.size();
+        for (std::vector<uint32_t>& bin : m_chunks[c].bins) bin.clear();
+        m_chunks[c].triangles.clear();
+    }
+    m_activeChunks = 0;
+}
+
+void SoftRasterizer::ShadeTile(uint32_t tileIndex) {
+    int32_t x0 = static_cast<int32_t>((tileIndex % m_tilesX) * TileSize);
+    int32_t y0 = static_cast<int32_t>((tileIndex / m_tilesX) * TileSize);
+    int32_t x1 = std::min<int32_t>(x0 + TileSize, m_color->width) - 1;
+    int32_t y1 = std::min<int32_t>(y0 + TileSize, m_color->height) - 1;
+
+    for (uint32_t c = 0; c < m_activeChunks; ++c) {
+        const Chunk& chunk = m_chunks[c];
+        for (uint32_t triIndex : chunk.bins[tileIndex]) {
+            RasterizeTriangle(chunk.triangles[triIndex], x0, y0, x1, y1);
+        }
+    }
+}
+
+void SoftRasterizer::RasterizeTriangle(const Triangle& tri, int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+    int32_t minX = std::max(tri.minX, x0);
+    int32_t minY = std::max(tri.minY, y0);
+    int32_t maxX = std::min(tri.maxX, x1);
+    int32_t maxY = std::min(tri.maxY, y1);
+    if (minX > maxX || minY > maxY) return;
+
+    // Edge e is opposite vertex e, so its value is that vertex's barycentric weight.
+    const int next[3] = { 1, 2, 0 };
+    int64_t rowValue[3], stepX[3], stepY[3];
+    int64_t px = int64_t(minX) * SubpixelScale + SubpixelScale / 2;
+    int64_t py = int64_t(minY) * SubpixelScale + SubpixelScale / 2;
+    for (int e = 0; e < 3; ++e) {
+        int a = next[e];
+        int b = next[a];
+        int64_t bias = IsTopLeft(tri.x[a], tri.y[a], tri.x[b], tri.y[b]) ? 0 : -1;
+        rowValue[e] = EdgeFunction(tri.x[a], tri.y[a], tri.x[b], tri.y[b], px, py) + bias;
+        stepX[e] = -int64_t(tri.y[b] - tri.y[a]) * SubpixelScale;
+        stepY[e] = int64_t(tri.x[b] - tri.x[a]) * SubpixelScale;
+    }
+
+    const float invArea = 1.0f / static_cast<float>(tri.area);
+    const uint32_t pitch = m_color->width;
+    float* depthRow = m_depth ? m_depth->depth.data() : nullptr;
+
+    for (int32_t y = minY; y <= maxY; ++y) {
+        int64_t w0 = rowValue[0], w1 = rowValue[1], w2 = rowValue[2];
+        uint32_t* colorOut = m_color->pixels.data() + size_t(y) * pitch;
+        float* depthOut = depthRow ? depthRow + size_t(y) * pitch : nullptr;
+        for (int32_t x = minX; x <= maxX; ++x) {
+            if ((w0 | w1 | w2) >= 0) {
+                float b0 = static_cast<float>(w0) * invArea;
+                float b1 = static_cast<float>(w1) * invArea;
+                float b2 = static_cast<float>(w2) * invArea;
+                float z = b0 * tri.z[0] + b1 * tri.z[1] + b2 * tri.z[2];
+                if (!depthOut || z < depthOut[x]) {
+                    if (depthOut) depthOut[x] = z;
+                    float w = 1.0f / (b0 * tri.invW[0] + b1 * tri.invW[1] + b2 * tri.invW[2]);
+                    float rgba[4];
+                    for (int k = 0; k < 4; ++k) {
+                        rgba[k] = (b0 * tri.colorOverW[0][k] + b1 * tri.colorOverW[1][k] + b2 * tri.colorOverW[2][k]) * w;
+                    }
+                    colorOut[x] = ToByte(rgba[0]) | (ToByte(rgba[1]) << 8) | (ToByte(rgba[2]) << 16) | (ToByte(rgba[3]) << 24);
+                }
+            }
+            w0 += stepX[0];
+            w1 += stepX[1];
+            w2 += stepX[2];
+        }
+        for (int e = 0; e < 3; ++e) rowValue[e] += stepY[e];
+    }
+}
+
+} // namespace gfx
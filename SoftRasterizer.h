@@ -0,0 +1,131 @@
+#pragma once
+
+#include "ColoredVertex.h"
+#include "MathTypes.h"
+#include "RenderTypes.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+// In-memory RGBA8 color target, rows tightly packed.
+struct RenderTarget {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint32_t> pixels;
+
+    void Resize(uint32_t w, uint32_t h) {
+        width = w;
+        height = h;
+        pixels.assign(size_t(w) * h, 0);
+    }
+};
+
+struct DepthTarget {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<float> depth;
+
+    void Resize(uint32_t w, uint32_t h) {
+        width = w;
+        height = h;
+        depth.assign(size_t(w) * h, 1.0f);
+    }
+};
+
+// Matches D3D11_CULL_MODE with FrontCounterClockwise = FALSE.
+enum class CullMode { None, Front, Back };
+
+struct RasterStats {
+    uint64_t trianglesSubmitted = 0;
+    uint64_t trianglesCulled = 0;
+    uint64_t trianglesClipped = 0;
+    uint64_t trianglesBinned = 0;
+    uint64_t binEntries = 0;
+};
+
+// CPU implementation of the Lab3.cpp pipeline: position * model * viewProj,
+// near/far clipping, back-face culling, perspective-correct vertex color.
+// Draws are transformed and binned into screen tiles as they are issued;
+// Flush() shades all tiles in parallel while keeping submission order per tile.
+class SoftRasterizer {
+public:
+    static constexpr uint32_t TileSize = 64;
+
+    explicit SoftRasterizer(ThreadPool& pool);
+
+    void SetRenderTargets(RenderTarget* color, DepthTarget* depth) noexcept;
+    void SetViewport(const Viewport& viewport) noexcept { m_viewport = viewport; }
+    void SetCullMode(CullMode mode) noexcept { m_cullMode = mode; }
+
+    // Constant buffers b0 and b1 of g_VS_Source.
+    void SetModel(const Float4x4& model) noexcept { m_model = model; }
+    void SetViewProj(const Float4x4& viewProj) noexcept { m_viewProj = viewProj; }
+
+    void SetVertexBuffer(const ColoredVertex* vertices, uint32_t vertexCount) noexcept;
+    void SetIndexBuffer(const void* indices, IndexFormat format) noexcept;
+
+    void ClearRenderTarget(const float color[4]);
+    void ClearDepth(float depth);
+    void DrawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int32_t baseVertexLocation);
+
+    // Rasterizes everything drawn since the last flush into the bound targets.
+    void Flush();
+
+    const RasterStats& Stats() const noexcept { return m_stats; }
+    void ResetStats() noexcept { m_stats = {}; }
+
+private:
+    struct ClipVertex {
+        float pos[4];
+        float color[4];
+    };
+
+    struct Triangle {
+        int32_t x[3], y[3];   // 28.4 fixed-point screen position
+        int64_t area;
+        float z[3];
+        float invW[3];
+        float colorOverW[3][4];
+        int32_t minX, minY, maxX, maxY;
+    };
+
+    struct Chunk {
+        std::vector<Triangle> triangles;
+        std::vector<std::vector<uint32_t>> bins;
+        uint32_t firstTriangle = 0;
+        uint32_t triangleCount = 0;
+        uint64_t culled = 0;
+        uint64_t clipped = 0;
+    };
+
+    void SetupChunk(Chunk& chunk, const ClipVertex* verts, uint32_t startIndex, int32_t baseVertex);
+    void EmitTriangle(Chunk& chunk, const ClipVertex* a, const ClipVertex* b, const ClipVertex* c);
+    void ShadeTile(uint32_t tileIndex);
+    void RasterizeTriangle(const Triangle& tri, int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+    uint32_t FetchIndex(uint32_t i) const noexcept;
+
+    ThreadPool& m_pool;
+    RenderTarget* m_color = nullptr;
+    DepthTarget* m_depth = nullptr;
+    Viewport m_viewport = {};
+    CullMode m_cullMode = CullMode::Back;
+    Float4x4 m_model = MatrixIdentity();
+    Float4x4 m_viewProj = MatrixIdentity();
+
+    const ColoredVertex* m_vertices = nullptr;
+    uint32_t m_vertexCount = 0;
+    const void* m_indices = nullptr;
+    IndexFormat m_indexFormat = IndexFormat::UInt16;
+
+    uint32_t m_tilesX = 0;
+    uint32_t m_tilesY = 0;
+    std::vector<ClipVertex> m_clipVertices;
+    std::vector<Chunk> m_chunks;
+    uint32_t m_activeChunks = 0;
+    RasterStats m_stats;
+};
+
+} // namespace gfx
@@ -0,0 +1,134 @@
+#include "TextureFile.h"
+
+#include "Hash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+namespace gfx {
+
+namespace {
+
+static_assert(sizeof(TextureFileHeader) == 560, "texture file header layout");
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) noexcept {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool Fail(std::string* error, const char* message) {
+    if (error) *error = message;
+    return false;
+}
+
+// Fills the size fields of every level from the format and base size.
+void LayoutMips(TextureFileHeader& header) noexcept {
+    const TextureFormat format = static_cast<TextureFormat>(header.format);
+    uint64_t offset = AlignUp(sizeof(TextureFileHeader), TextureFileBlobAlignment);
+    for (uint32_t level = 0; level < header.mipCount; ++level) {
+        TextureMipInfo& mip = header.mips[level];
+        mip.width = std::max(header.width >> level, 1u);
+        mip.height = std::max(header.height >> level, 1u);
+        mip.rowPitch = TextureRowPitch(format, mip.width);
+        mip.rowCount = TextureRowCount(format, mip.height);
+        mip.offset = offset;
+        mip.size = uint64_t(mip.rowPitch) * mip.rowCount;
+        offset = AlignUp(offset + mip.size, TextureFileBlobAlignment);
+    }
+    header.fileSize = header.mipCount ? header.mips[header.mipCount - 1].offset + header.mips[header.mipCount - 1].size : offset;
+}
+
+uint64_t HashMips(const TextureFileHeader& header, const void* const* mips) noexcept {
+    uint64_t hash = 0;
+    for (uint32_t level = 0; level < header.mipCount; ++level) {
+        hash = HashCombine(hash, Hash64(mips[level], static_cast<size_t>(header.mips[level].size)));
+    }
+    return hash;
+}
+
+} // namespace
+
+bool WriteTextureFile(const char* path, const TextureSource& texture, std::string* error) {
+    if (TexelBlockSize(texture.format) == 0) return Fail(error, "unsupported texture format");
+    if (texture.width == 0 || texture.height == 0) return Fail(error, "empty texture");
+    uint32_t fullChain = 0;
+    for (uint32_t size = std::max(texture.width, texture.height); size; size >>= 1) ++fullChain;
+    if (texture.mipCount == 0 || texture.mipCount > std::min(fullChain, MaxTextureMips)) return Fail(error, "bad mip count");
+
+    TextureFileHeader header = {};
+    header.magic = TextureFileMagic;
+    header.versionMajor = TextureFileVersionMajor;
+    header.versionMinor = TextureFileVersionMinor;
+    header.headerSize = sizeof(TextureFileHeader);
+    header.format = static_cast<uint32_t>(texture.format);
+    header.width = texture.width;
+    header.height = texture.height;
+    header.mipCount = texture.mipCount;
+    LayoutMips(header);
+    header.blobHash = HashMips(header, texture.mips);
+
+    std::string tempPath = std::string(path) + ".tmp";
+    FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) return Fail(error, "cannot create texture file");
+
+    static const uint8_t padding[TextureFileBlobAlignment] = {};
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t position = sizeof(header);
+    for (uint32_t level = 0; written && level < header.mipCount; ++level) {
+        const TextureMipInfo& mip = header.mips[level];
+        written = (mip.offset == position || std::fwrite(padding, static_cast<size_t>(mip.offset - position), 1, file) == 1) &&
+                  std::fwrite(texture.mips[level], static_cast<size_t>(mip.size), 1, file) == 1;
+        position = mip.offset + mip.size;
+    }
+    written = std::fclose(file) == 0 && written;
+
+    std::error_code ec;
+    if (written) std::filesystem::rename(tempPath, path, ec);
+    if (!written || ec) {
+        std::filesystem::remove(tempPath, ec);
+        return Fail(error, "cannot write texture file");
+    }
+    return true;
+}
+
+bool TextureFile::Open(const char* path, std::string* error, bool verifyChecksum) {
+    Close();
+    if (!m_file.Open(path)) return Fail(error, "cannot map texture file");
+
+    const TextureFileHeader* header = reinterpret_cast<const TextureFileHeader*>(m_file.Data());
+    const char* problem = nullptr;
+    if (m_file.Size() < sizeof(TextureFileHeader) || header->magic != TextureFileMagic) {
+        problem = "not a texture file";
+    } else if (header->versionMajor != TextureFileVersionMajor || header->headerSize != sizeof(TextureFileHeader)) {
+        problem = "unsupported texture file version";
+    } else if (TexelBlockSize(static_cast<TextureFormat>(header->format)) == 0 || header->width == 0 || header->height == 0 ||
+               header->mipCount == 0 || header->mipCount > MaxTextureMips ||
+               std::max(header->width, header->height) >> (header->mipCount - 1) == 0) {
+        problem = "bad texture description";
+    } else {
+        // Every level must sit exactly where the writer puts it.
+        TextureFileHeader expected = *header;
+        LayoutMips(expected);
+        if (std::memcmp(expected.mips, header->mips, sizeof(TextureMipInfo) * header->mipCount) != 0 ||
+            expected.fileSize != header->fileSize || header->fileSize != m_file.Size()) {
+            problem = "truncated texture file";
+        }
+    }
+    if (!problem) {
+        m_header = header;
+        if (verifyChecksum) {
+            const void* mips[MaxTextureMips];
+            for (uint32_t level = 0; level < header->mipCount; ++level) mips[level] = MipData(level);
+            if (header->blobHash != HashMips(*header, mips)) problem = "texture file checksum mismatch";
+        }
+    }
+    if (problem) {
+        Close();
+        return Fail(error, problem);
+    }
+    return true;
+}
+
+} // namespace gfx
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "RenderTypes.h"
+
+#include <cstdint>
+#include <string>
+
+namespace gfx {
+
+constexpr uint32_t MaxTextureMips = 16;
+
+// One mip level: rowCount rows of rowPitch bytes (pixels or 4x4 blocks), the
+// layout D3D11_SUBRESOURCE_DATA takes.
+struct TextureMipInfo {
+    uint32_t width;
+    uint32_t height;
+    uint32_t rowPitch;
+    uint32_t rowCount;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// On-disk header. Mips follow largest first, each at a BlobAlignment-aligned
+// offset, so a mapped file can be handed to CreateTexture2D as initial data.
+struct TextureFileHeader {
+    uint32_t magic;
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    uint32_t headerSize;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipCount;
+    uint32_t reserved;
+    uint64_t fileSize;
+    uint64_t blobHash;
+    TextureMipInfo mips[MaxTextureMips];
+};
+
+constexpr uint32_t TextureFileMagic = 0x58455447; // "GTEX"
+constexpr uint16_t TextureFileVersionMajor = 1;
+constexpr uint16_t TextureFileVersionMinor = 0;
+constexpr uint64_t TextureFileBlobAlignment = 64;
+
+// Level l is max(width >> l, 1) by max(height >> l, 1), packed at TextureRowPitch.
+struct TextureSource {
+    TextureFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipCount;
+    const void* mips[MaxTextureMips];
+};
+
+// Writes the file atomically.
+bool WriteTextureFile(const char* path, const TextureSource& texture, std::string* error = nullptr);
+
+// Read-only view of a mapped texture file; mip pointers stay valid while it is open.
+class TextureFile {
+public:
+    // Header, version and mip layout are always validated; the checksum only when asked.
+    bool Open(const char* path, std::string* error = nullptr, bool verifyChecksum = false);
+    void Close() noexcept { m_file.Close(); m_header = nullptr; }
+    bool IsOpen() const noexcept { return m_header != nullptr; }
+
+    const TextureFileHeader& Header() const noexcept { return *m_header; }
+    TextureFormat Format() const noexcept { return static_cast<TextureFormat>(m_header->format); }
+    uint32_t Width() const noexcept { return m_header->width; }
+    uint32_t Height() const noexcept { return m_header->height; }
+    uint32_t MipCount() const noexcept { return m_header->mipCount; }
+    const TextureMipInfo& Mip(uint32_t level) const noexcept { return m_header->mips[level]; }
+    const void* MipData(uint32_t level) const noexcept { return m_file.Data() + m_header->mips[level].offset; }
+
+private:
+    MappedFile m_file;
+    const TextureFileHeader* m_header = nullptr;
+};
+
+} // namespace gfx
@@ -0,0 +1,72 @@
+#include "TextureImporter.h"
+
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+// The largest 2D texture D3D11 accepts.
+constexpr uint32_t MaxTextureSize = 16384;
+
+bool Fail(std::string* error, const char* message) {
+    if (error) *error = message;
+    return false;
+}
+
+} // namespace
+
+TextureSource TextureData::Source() const noexcept {
+    TextureSource source = {};
+    source.format = format;
+    source.width = width;
+    source.height = height;
+    source.mipCount = static_cast<uint32_t>(std::min<size_t>(mips.size(), MaxTextureMips));
+    for (uint32_t level = 0; level < source.mipCount; ++level) source.mips[level] = mips[level].data();
+    return source;
+}
+
+bool BuildTexture(const Image& image, ThreadPool& pool, TextureData& out, const TextureImportOptions& options, std::string* error) {
+    if (image.width == 0 || image.height == 0) return Fail(error, "empty image");
+    if (image.width > MaxTextureSize || image.height > MaxTextureSize) return Fail(error, "image larger than the maximum texture size");
+
+    TextureFormat format = options.format;
+    if (format == TextureFormat::Unknown) {
+        bool translucent = std::any_of(image.pixels.begin(), image.pixels.end(), [](uint32_t p) { return (p >> 24) != 0xFF; });
+        format = WithSrgb(translucent ? TextureFormat::BC3_UNorm : TextureFormat::BC1_UNorm, options.mips.srgb);
+    }
+    if (TexelBlockSize(format) == 0) return Fail(error, "unsupported texture format");
+
+    MipOptions mipOptions = options.mips;
+    mipOptions.maxLevels = options.generateMips ? std::min(mipOptions.maxLevels ? mipOptions.maxLevels : MaxTextureMips, MaxTextureMips) : 1;
+    std::vector<Image> levels;
+    GenerateMips(image, mipOptions, levels, &pool);
+
+    out.format = format;
+    out.width = image.width;
+    out.height = image.height;
+    out.mips.resize(levels.size());
+    for (size_t level = 0; level < levels.size(); ++level) {
+        const Image& mip = levels[level];
+        if (IsBlockCompressed(format)) {
+            CompressImage(mip, format, out.mips[level], &pool);
+        } else {
+            out.mips[level].resize(mip.pixels.size() * sizeof(uint32_t));
+            std::memcpy(out.mips[level].data(), mip.pixels.data(), out.mips[level].size());
+        }
+    }
+    return true;
+}
+
+bool ConvertImageToTextureFile(const char* imagePath, const char* texturePath, ThreadPool& pool,
+                               const TextureImportOptions& options, std::string* error) {
+    Image image;
+    TextureData texture;
+    return LoadImage(imagePath, image, error) && BuildTexture(image, pool, texture, options, error) &&
+           WriteTextureFile(texturePath, texture.Source(), error);
+}
+
+} // namespace gfx
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Image.h"
+#include "MipChain.h"
+#include "TextureFile.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gfx {
+
+struct TextureImportOptions {
+    // Unknown picks BC3 when any pixel is translucent and BC1 otherwise, in the sRGB
+    // variant when mips.srgb is set. An explicit format is used as given.
+    TextureFormat format = TextureFormat::Unknown;
+    bool generateMips = true;
+    MipOptions mips;
+};
+
+struct TextureData {
+    TextureFormat format = TextureFormat::Unknown;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // Largest first, each packed at TextureRowPitch.
+    std::vector<std::vector<uint8_t>> mips;
+
+    TextureSource Source() const noexcept;
+};
+
+// Builds the mip chain and encodes every level, both spread across the pool.
+bool BuildTexture(const Image& image, ThreadPool& pool, TextureData& out,
+                  const TextureImportOptions& options = {}, std::string* error = nullptr);
+
+// LoadImage, BuildTexture and WriteTextureFile.
+bool ConvertImageToTextureFile(const char* imagePath, const char* texturePath, ThreadPool& pool,
+                               const TextureImportOptions& options = {}, std::string* error = nullptr);
+
+} // namespace gfx
@@ -0,0 +1,97 @@
+#include "ThreadPool.h"
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <cstdio>
+
+namespace gfx {
+
+ThreadPool::ThreadPool(uint32_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) threadCount = 1;
+    }
+    m_threadCount = threadCount;
+    m_workers.reserve(threadCount - 1);
+    for (uint32_t i = 1; i < threadCount; ++i) {
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::ThreadPool(JobSystem& jobs) : m_jobs(&jobs), m_threadCount(jobs.ThreadCount()) {}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Run(uint32_t taskCount, const TaskFn& fn) {
+    if (taskCount == 0) return;
+    if (m_jobs) {
+        // Callers already size their tasks, so each one is a piece of its own.
+        m_jobs->ParallelFor(taskCount, [&fn](uint32_t begin, uint32_t end, uint32_t thread) {
+            for (uint32_t i = begin; i < end; ++i) fn(i, thread);
+        }, 1);
+        return;
+    }
+    std::unique_lock<std::mutex> batch(m_runMutex, std::defer_lock);
+    if (m_workers.empty() || taskCount == 1 || !batch.try_lock()) {
+        for (uint32_t i = 0; i < taskCount; ++i) fn(i, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &fn;
+        m_taskCount = taskCount;
+        m_nextTask.store(0, std::memory_order_relaxed);
+        m_busyWorkers = static_cast<uint32_t>(m_workers.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    Drain(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busyWorkers == 0; });
+    m_job = nullptr;
+}
+
+void ThreadPool::WorkerLoop(uint32_t threadIndex) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "Worker %u", threadIndex);
+    GetProfiler().SetThreadName(name);
+
+    uint64_t seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seenGeneration; });
+            if (m_stop) return;
+            seenGeneration = m_generation;
+        }
+
+        Drain(threadIndex);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busyWorkers == 0) m_done.notify_one();
+    }
+}
+
+void ThreadPool::Drain(uint32_t threadIndex) {
+    GFX_PROFILE_SCOPE("ThreadPool::Run");
+    for (;;) {
+        uint32_t task = m_nextTask.fetch_add(1, std::memory_order_relaxed);
+        if (task >= m_taskCount) break;
+        (*m_job)(task, threadIndex);
+    }
+}
+
+} // namespace gfx
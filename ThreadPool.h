@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gfx {
+
+class JobSystem;
+
+// Fixed set of worker threads that execute one batch of indexed tasks at a time.
+// The calling thread takes part in the batch as thread index 0.
+class ThreadPool {
+public:
+    using TaskFn = std::function<void(uint32_t taskIndex, uint32_t threadIndex)>;
+
+    // threadCount includes the caller; 0 picks std::thread::hardware_concurrency().
+    explicit ThreadPool(uint32_t threadCount = 0);
+    // Starts no threads and runs every batch as a ParallelFor on jobs, so code that
+    // takes a ThreadPool shares the job system's workers. Batches may then run
+    // concurrently and from inside jobs; thread indices are the job system's.
+    explicit ThreadPool(JobSystem& jobs);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t ThreadCount() const noexcept { return m_threadCount; }
+
+    // Runs fn for every task index in [0, taskCount) and returns when all are done.
+    // With its own workers, one batch runs at a time: if another thread's batch is in
+    // flight (e.g. two stages of a TaskGraph), the tasks run on the calling thread as
+    // thread index 0.
+    // Not reentrant from inside fn.
+    void Run(uint32_t taskCount, const TaskFn& fn);
+
+private:
+    void WorkerLoop(uint32_t threadIndex);
+    void Drain(uint32_t threadIndex);
+
+    JobSystem* m_jobs = nullptr;
+    uint32_t m_threadCount = 1;
+    std::vector<std::thread> m_workers;
+    std::mutex m_runMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const TaskFn* m_job = nullptr;
+    uint32_t m_taskCount = 0;
+    std::atomic<uint32_t> m_nextTask{ 0 };
+    uint32_t m_busyWorkers = 0;
+    uint64_t m_generation = 0;
+    bool m_stop = false;
+};
+
+} // namespace gfx
@@ -0,0 +1,228 @@
+#include "TransformHierarchy.h"
+
+#include "Simd.h"
+
+#include <algorithm>
+
+namespace gfx {
+
+namespace {
+
+// world = local * parent with row vectors: each row of local combines the parent's rows.
+inline void MultiplyInto(const Float4x4& local, const Float4x4& parent, Float4x4& world) noexcept {
+#if GFX_X86
+    __m128 p0 = _mm_loadu_ps(parent.m[0]);
+    __m128 p1 = _mm_loadu_ps(parent.m[1]);
+    __m128 p2 = _mm_loadu_ps(parent.m[2]);
+    __m128 p3 = _mm_loadu_ps(parent.m[3]);
+    for (int i = 0; i < 4; ++i) {
+        __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(local.m[i][0]), p0), _mm_mul_ps(_mm_set1_ps(local.m[i][1]), p1)),
+                              _mm_add_ps(_mm_mul_ps(_mm_set1_ps(local.m[i][2]), p2), _mm_mul_ps(_mm_set1_ps(local.m[i][3]), p3)));
+        _mm_storeu_ps(world.m[i], r);
+    }
+#else
+    world = Multiply(local, parent);
+#endif
+}
+
+} // namespace
+
+void TransformHierarchy::Reserve(size_t count) {
+    m_slotOf.reserve(count);
+    m_idOf.reserve(count);
+    m_parentSlot.reserve(count);
+    m_firstChild.reserve(count);
+    m_childCount.reserve(count);
+    m_depth.reserve(count);
+    m_local.reserve(count);
+    m_world.reserve(count);
+    m_dirty.reserve(count);
+    m_stamp.reserve(count);
+}
+
+void TransformHierarchy::Clear() noexcept {
+    m_slotOf.clear();
+    m_idOf.clear();
+    m_parentSlot.clear();
+    m_firstChild.clear();
+    m_childCount.clear();
+    m_depth.clear();
+    m_local.clear();
+    m_world.clear();
+    m_dirty.clear();
+    m_stamp.clear();
+    m_levelStart.clear();
+    m_queued.clear();
+    m_layoutDirty = false;
+}
+
+TransformId TransformHierarchy::Add(const Float4x4& local, TransformId parent) {
+    TransformId id = static_cast<TransformId>(m_slotOf.size());
+    uint32_t parentSlot = parent == NoTransform ? NoTransform : m_slotOf[parent];
+    m_slotOf.push_back(static_cast<uint32_t>(m_idOf.size()));
+    m_idOf.push_back(id);
+    m_parentSlot.push_back(parentSlot);
+    m_firstChild.push_back(0);
+    m_childCount.push_back(0);
+    m_depth.push_back(parent == NoTransform ? 0 : m_depth[parentSlot] + 1);
+    m_local.push_back(local);
+    m_world.push_back(local);
+    m_dirty.push_back(1);
+    m_stamp.push_back(0);
+    m_layoutDirty = true;
+    return id;
+}
+
+void TransformHierarchy::SetLocal(TransformId node, const Float4x4& local) noexcept {
+    uint32_t slot = m_slotOf[node];
+    m_local[slot] = local;
+    if (m_dirty[slot]) return;
+    m_dirty[slot] = 1;
+    m_queued.push_back(slot);
+}
+
+TransformId TransformHierarchy::Parent(TransformId node) const noexcept {
+    uint32_t parentSlot = m_parentSlot[m_slotOf[node]];
+    return parentSlot == NoTransform ? NoTransform : m_idOf[parentSlot];
+}
+
+// Breadth-first reorder: roots in insertion order, then the children of each node in
+// turn, which keeps levels contiguous and siblings adjacent. Every dirty node is queued.
+void TransformHierarchy::RebuildLayout() {
+    const uint32_t count = static_cast<uint32_t>(m_idOf.size());
+    std::vector<uint32_t> childStart(count + 1, 0);
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        if (m_parentSlot[slot] != NoTransform) ++childStart[m_parentSlot[slot] + 1];
+    }
+    for (uint32_t slot = 0; slot < count; ++slot) childStart[slot + 1] += childStart[slot];
+    std::vector<uint32_t> children(childStart[count]);
+    std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+    std::vector<uint32_t> order;
+    order.reserve(count);
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        if (m_parentSlot[slot] == NoTransform) order.push_back(slot);
+        else children[fill[m_parentSlot[slot]]++] = slot;
+    }
+    for (size_t i = 0; i < order.size(); ++i) {
+        uint32_t slot = order[i];
+        order.insert(order.end(), children.begin() + childStart[slot], children.begin() + childStart[slot + 1]);
+    }
+
+    std::vector<uint32_t> newSlot(count);
+    for (uint32_t i = 0; i < count; ++i) newSlot[order[i]] = i;
+
+    std::vector<TransformId> idOf(count);
+    std::vector<uint32_t> parentSlot(count), firstChild(count), childCount(count), depth(count), stamp(count);
+    std::vector<Float4x4> local(count), world(count);
+    std::vector<uint8_t> dirty(count);
+    for (uint32_t to = 0; to < count; ++to) {
+        uint32_t from = order[to];
+        idOf[to] = m_idOf[from];
+        parentSlot[to] = m_parentSlot[from] == NoTransform ? NoTransform : newSlot[m_parentSlot[from]];
+        childCount[to] = childStart[from + 1] - childStart[from];
+        firstChild[to] = childCount[to] ? newSlot[children[childStart[from]]] : 0;
+        depth[to] = m_depth[from];
+        local[to] = m_local[from];
+        world[to] = m_world[from];
+        dirty[to] = m_dirty[from];
+        stamp[to] = m_stamp[from];
+        m_slotOf[m_idOf[from]] = to;
+    }
+    m_idOf.swap(idOf);
+    m_parentSlot.swap(parentSlot);
+    m_firstChild.swap(firstChild);
+    m_childCount.swap(childCount);
+    m_depth.swap(depth);
+    m_local.swap(local);
+    m_world.swap(world);
+    m_dirty.swap(dirty);
+    m_stamp.swap(stamp);
+
+    uint32_t levels = count ? m_depth.back() + 1 : 0;
+    m_levelStart.assign(levels + 1, 0);
+    for (uint32_t d : m_depth) ++m_levelStart[d + 1];
+    for (uint32_t level = 0; level < levels; ++level) m_levelStart[level + 1] += m_levelStart[level];
+
+    m_queued.clear();
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        if (m_dirty[slot]) m_queued.push_back(slot);
+    }
+    m_layoutDirty = false;
+}
+
+void TransformHierarchy::NextUpdate() noexcept {
+    // Stamps are compared for equality only, so after a wrap they just need clearing.
+    if (++m_update == 0) {
+        std::fill(m_stamp.begin(), m_stamp.end(), 0u);
+        m_update = 1;
+    }
+}
+
+inline void TransformHierarchy::UpdateSlot(uint32_t slot) noexcept {
+    uint32_t parent = m_parentSlot[slot];
+    if (parent == NoTransform) m_world[slot] = m_local[slot];
+    else MultiplyInto(m_local[slot], m_world[parent], m_world[slot]);
+    m_dirty[slot] = 0;
+    m_stamp[slot] = m_update;
+}
+
+// With all set the whole level is rewritten, otherwise only its queue.
+uint32_t TransformHierarchy::UpdateLevel(uint32_t level, bool all, ThreadPool* pool) {
+    const uint32_t* queue = m_levelQueues[level].data();
+    const uint32_t begin = all ? m_levelStart[level] : 0;
+    const uint32_t count = all ? m_levelStart[level + 1] - begin : static_cast<uint32_t>(m_levelQueues[level].size());
+    auto run = [&](uint32_t first, uint32_t last) {
+        if (all) {
+            for (uint32_t i = first; i < last; ++i) UpdateSlot(begin + i);
+        } else {
+            for (uint32_t i = first; i < last; ++i) UpdateSlot(queue[i]);
+        }
+    };
+    const uint32_t chunks = (count + ChunkSize - 1) / ChunkSize;
+    if (!pool || chunks < 2) {
+        run(0, count);
+    } else {
+        pool->Run(chunks, [&](uint32_t chunk, uint32_t) { run(chunk * ChunkSize, std::min(count, (chunk + 1) * ChunkSize)); });
+    }
+    return count;
+}
+
+uint32_t TransformHierarchy::Update(ThreadPool* pool) {
+    if (m_layoutDirty) RebuildLayout();
+    NextUpdate();
+    if (m_queued.empty()) return 0;
+
+    const uint32_t levels = LevelCount();
+    m_levelQueues.resize(levels);
+    for (std::vector<uint32_t>& queue : m_levelQueues) queue.clear();
+    for (uint32_t slot : m_queued) m_levelQueues[m_depth[slot]].push_back(slot);
+    m_queued.clear();
+
+    uint32_t written = 0;
+    for (uint32_t level = 0; level < levels; ++level) {
+        std::vector<uint32_t>& queue = m_levelQueues[level];
+        if (level > 0) {
+            // Children of everything rewritten on the level above; m_dirty drops duplicates.
+            for (uint32_t parent : m_levelQueues[level - 1]) {
+                const uint32_t first = m_firstChild[parent], last = first + m_childCount[parent];
+                for (uint32_t child = first; child < last; ++child) {
+                    if (m_dirty[child]) continue;
+                    m_dirty[child] = 1;
+                    queue.push_back(child);
+                }
+            }
+        }
+        written += UpdateLevel(level, false, pool);
+    }
+    return written;
+}
+
+void TransformHierarchy::UpdateAll(ThreadPool* pool) {
+    if (m_layoutDirty) RebuildLayout();
+    NextUpdate();
+    m_levelQueues.resize(LevelCount());
+    for (uint32_t level = 0; level < LevelCount(); ++level) UpdateLevel(level, true, pool);
+    m_queued.clear();
+}
+
+} // namespace gfx
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "MathTypes.h"
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+using TransformId = uint32_t;
+constexpr TransformId NoTransform = ~0u;
+
+// Parent/child transforms stored as SoA arrays in breadth-first order: levels are
+// contiguous, every parent precedes its children and a node's children sit next to
+// each other. world = local * parentWorld is computed one level at a time; nodes of
+// a level never depend on each other, so each level is split into chunks on the pool.
+// SetLocal only queues a node. Update walks the queued nodes level by level and
+// pulls in the children of every node it rewrote, so its cost follows the number of
+// changed nodes rather than the size of the hierarchy.
+class TransformHierarchy {
+public:
+    static constexpr uint32_t ChunkSize = 16384;
+
+    void Reserve(size_t count);
+    void Clear() noexcept;
+
+    // parent must already exist. Ids are stable, but adding nodes re-sorts the
+    // storage on the next Update in O(n), so additions are best batched.
+    TransformId Add(const Float4x4& local, TransformId parent = NoTransform);
+    void SetLocal(TransformId node, const Float4x4& local) noexcept;
+
+    // Recomputes the world matrices of changed nodes and their descendants and
+    // returns how many were written.
+    uint32_t Update(ThreadPool* pool = nullptr);
+    // Recomputes every world matrix, for comparison with Update.
+    void UpdateAll(ThreadPool* pool = nullptr);
+
+    const Float4x4& Local(TransformId node) const noexcept { return m_local[m_slotOf[node]]; }
+    // As of the last Update.
+    const Float4x4& World(TransformId node) const noexcept { return m_world[m_slotOf[node]]; }
+    // True when the last Update rewrote node's world matrix.
+    bool WorldChanged(TransformId node) const noexcept { return m_stamp[m_slotOf[node]] == m_update; }
+    TransformId Parent(TransformId node) const noexcept;
+    uint32_t Depth(TransformId node) const noexcept { return m_depth[m_slotOf[node]]; }
+
+    size_t Count() const noexcept { return m_idOf.size(); }
+    uint32_t LevelCount() const noexcept { return m_levelStart.empty() ? 0 : static_cast<uint32_t>(m_levelStart.size() - 1); }
+
+private:
+    void RebuildLayout();
+    uint32_t UpdateLevel(uint32_t level, bool all, ThreadPool* pool);
+    void UpdateSlot(uint32_t slot) noexcept;
+    void NextUpdate() noexcept;
+
+    // Indexed by id.
+    std::vector<uint32_t> m_slotOf;
+    // Indexed by slot (breadth-first order).
+    std::vector<TransformId> m_idOf;
+    std::vector<uint32_t> m_parentSlot;
+    std::vector<uint32_t> m_firstChild;
+    std::vector<uint32_t> m_childCount;
+    std::vector<uint32_t> m_depth;
+    std::vector<Float4x4> m_local;
+    std::vector<Float4x4> m_world;
+    // Set while a slot is queued for the next Update.
+    std::vector<uint8_t> m_dirty;
+    // Update number that last wrote the slot's world matrix.
+    std::vector<uint32_t> m_stamp;
+    // Indexed by level.
+    std::vector<uint32_t> m_levelStart;
+    std::vector<std::vector<uint32_t>> m_levelQueues;
+    std::vector<uint32_t> m_queued;
+    uint32_t m_update = 1;
+    bool m_layoutDirty = false;
+};
+
+} // namespace gfx
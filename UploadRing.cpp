@@ -0,0 +1,50 @@
+#include "UploadRing.h"
+
+namespace gfx {
+
+void UploadRing::Reset(uint32_t capacity, uint32_t framesInFlight) {
+    m_capacity = capacity & ~(ConstantBlockAlignment - 1);
+    m_frameEnds.assign(framesInFlight ? framesInFlight : 1, 0);
+    m_head = 0;
+    m_tail = 0;
+    m_frame = 0;
+    m_inFrame = false;
+    m_stats = {};
+}
+
+void UploadRing::BeginFrame() noexcept {
+    if (m_frame >= m_frameEnds.size()) m_tail = m_frameEnds[m_frame % m_frameEnds.size()];
+    m_inFrame = true;
+}
+
+void UploadRing::EndFrame() noexcept {
+    m_frameEnds[m_frame % m_frameEnds.size()] = m_head;
+    ++m_frame;
+    m_inFrame = false;
+}
+
+bool UploadRing::Allocate(uint32_t size, UploadAllocation& out, uint32_t alignment) noexcept {
+    uint64_t position = (m_head + alignment - 1) & ~(uint64_t(alignment) - 1);
+    uint64_t offset = m_capacity ? position % m_capacity : 0;
+    bool wrapped = false;
+    if (offset + size > m_capacity) {
+        // Blocks never straddle the end; the tail of the ring is skipped instead.
+        position += m_capacity - offset;
+        offset = 0;
+        wrapped = true;
+    }
+    if (!m_inFrame || size > m_capacity || position + size - m_tail > m_capacity) {
+        ++m_stats.failedAllocations;
+        return false;
+    }
+
+    m_head = position + size;
+    if (wrapped) ++m_stats.wraps;
+    ++m_stats.allocations;
+    if (m_head - m_tail > m_stats.peakBytesInFlight) m_stats.peakBytesInFlight = m_head - m_tail;
+    out.offset = static_cast<uint32_t>(offset);
+    out.size = size;
+    return true;
+}
+
+} // namespace gfx
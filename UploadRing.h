@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+// Constant buffer offsets bound through VSSetConstantBuffers1 must be multiples of 16
+// constants (256 bytes).
+constexpr uint32_t ConstantBlockAlignment = 256;
+
+struct UploadAllocation {
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct UploadRingStats {
+    uint64_t allocations = 0;
+    uint64_t failedAllocations = 0;
+    uint64_t wraps = 0;
+    uint64_t peakBytesInFlight = 0;
+};
+
+// Offset allocator for a ring of upload memory shared by several frames in flight.
+// Blocks handed out during a frame stay reserved until framesInFlight further frames
+// have begun, at which point the GPU is assumed to be done reading them. It only
+// hands out offsets, so the mapping is left to the backend.
+class UploadRing {
+public:
+    UploadRing() = default;
+    UploadRing(uint32_t capacity, uint32_t framesInFlight) { Reset(capacity, framesInFlight); }
+
+    // capacity is rounded down to a multiple of ConstantBlockAlignment.
+    void Reset(uint32_t capacity, uint32_t framesInFlight);
+
+    // Retires the frame that began framesInFlight frames ago.
+    void BeginFrame() noexcept;
+    void EndFrame() noexcept;
+
+    // Fails when the ring is full of in-flight data; the caller has to skip the draw
+    // or grow the ring. alignment must be a power of two no larger than ConstantBlockAlignment.
+    bool Allocate(uint32_t size, UploadAllocation& out, uint32_t alignment = ConstantBlockAlignment) noexcept;
+
+    uint32_t Capacity() const noexcept { return m_capacity; }
+    uint32_t FramesInFlight() const noexcept { return static_cast<uint32_t>(m_frameEnds.size()); }
+    uint64_t FrameIndex() const noexcept { return m_frame; }
+    uint64_t BytesInFlight() const noexcept { return m_head - m_tail; }
+    const UploadRingStats& Stats() const noexcept { return m_stats; }
+
+private:
+    // Positions grow without wrapping; the physical offset is position % capacity.
+    uint64_t m_head = 0;
+    uint64_t m_tail = 0;
+    uint64_t m_frame = 0;
+    uint32_t m_capacity = 0;
+    bool m_inFrame = false;
+    std::vector<uint64_t> m_frameEnds;
+    UploadRingStats m_stats;
+};
+
+} // namespace gfx
@@ -0,0 +1,170 @@
+#include "VertexLayout.h"
+
+namespace gfx {
+
+namespace {
+
+// The kernels return how far they got; the scalar loops finish the rest with the
+// same rounding, so every level writes the same bytes.
+
+#if GFX_X86
+size_t UNorm8SSE(const float* in, size_t count, uint8_t* out) noexcept {
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), scale = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+    auto quantize = [&](const float* p) noexcept {
+        __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(p), zero), one);
+        return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half));
+    };
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i low = _mm_packs_epi32(quantize(in + i), quantize(in + i + 4));
+        __m128i high = _mm_packs_epi32(quantize(in + i + 8), quantize(in + i + 12));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+    }
+    return i;
+}
+
+GFX_TARGET_AVX2 inline __m256i QuantizeUNorm8(const float* p) noexcept {
+    __m256 v = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(p), _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+}
+
+GFX_TARGET_AVX2 size_t UNorm8AVX2(const float* in, size_t count, uint8_t* out) noexcept {
+    // The packs work per 128-bit lane; the permute puts the dwords back in order.
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i low = _mm256_packs_epi32(QuantizeUNorm8(in + i), QuantizeUNorm8(in + i + 8));
+        __m256i high = _mm256_packs_epi32(QuantizeUNorm8(in + i + 16), QuantizeUNorm8(in + i + 24));
+        __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(low, high), order);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), bytes);
+    }
+    return i;
+}
+
+GFX_TARGET_SSE41 size_t UNorm16SSE41(const float* in, size_t count, uint16_t* out) noexcept {
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), scale = _mm_set1_ps(65535.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), zero), one), scale));
+        __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), zero), one), scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi32(a, b));
+    }
+    return i;
+}
+
+GFX_TARGET_AVX2 size_t UNorm16AVX2(const float* in, size_t count, uint16_t* out) noexcept {
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), scale = _mm256_set1_ps(65535.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i), zero), one), scale));
+        __m256i b = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i + 8), zero), one), scale));
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    return i;
+}
+
+size_t SNorm16SSE(const float* in, size_t count, int16_t* out) noexcept {
+    const __m128 low = _mm_set1_ps(-1.0f), high = _mm_set1_ps(1.0f), scale = _mm_set1_ps(32767.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), low), high), scale));
+        __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), low), high), scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+    }
+    return i;
+}
+
+GFX_TARGET_AVX2 size_t SNorm16AVX2(const float* in, size_t count, int16_t* out) noexcept {
+    const __m256 low = _mm256_set1_ps(-1.0f), high = _mm256_set1_ps(1.0f), scale = _mm256_set1_ps(32767.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i), low), high), scale));
+        __m256i b = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i + 8), low), high), scale));
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    return i;
+}
+
+GFX_TARGET_SSE41 size_t SwizzleSSE41(const uint32_t* in, size_t count, const uint8_t mask[32], uint32_t setBits, uint32_t* out) noexcept {
+    const __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask));
+    const __m128i set = _mm_set1_epi32(static_cast<int32_t>(setBits));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i colors = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_or_si128(_mm_shuffle_epi8(colors, shuffle), set));
+    }
+    return i;
+}
+
+GFX_TARGET_AVX2 size_t SwizzleAVX2(const uint32_t* in, size_t count, const uint8_t mask[32], uint32_t setBits, uint32_t* out) noexcept {
+    const __m256i shuffle = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask));
+    const __m256i set = _mm256_set1_epi32(static_cast<int32_t>(setBits));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i colors = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_or_si256(_mm256_shuffle_epi8(colors, shuffle), set));
+    }
+    return i;
+}
+#endif
+
+inline bool UseSSE41(SimdLevel level) noexcept {
+    return level != SimdLevel::Scalar && GetCpuFeatures().sse41;
+}
+
+} // namespace
+
+void ConvertToUNorm8(const float* in, size_t count, uint8_t* out, SimdLevel level) noexcept {
+    size_t i = 0;
+#if GFX_X86
+    if (level == SimdLevel::AVX2) i = UNorm8AVX2(in, count, out);
+    if (level != SimdLevel::Scalar) i += UNorm8SSE(in + i, count - i, out + i);
+#else
+    (void)level;
+#endif
+    for (; i < count; ++i) out[i] = FloatToUNorm8(in[i]);
+}
+
+void ConvertToUNorm16(const float* in, size_t count, uint16_t* out, SimdLevel level) noexcept {
+    size_t i = 0;
+#if GFX_X86
+    if (level == SimdLevel::AVX2) i = UNorm16AVX2(in, count, out);
+    if (UseSSE41(level)) i += UNorm16SSE41(in + i, count - i, out + i);
+#else
+    (void)level;
+#endif
+    for (; i < count; ++i) out[i] = FloatToUNorm16(in[i]);
+}
+
+void ConvertToSNorm16(const float* in, size_t count, int16_t* out, SimdLevel level) noexcept {
+    size_t i = 0;
+#if GFX_X86
+    if (level == SimdLevel::AVX2) i = SNorm16AVX2(in, count, out);
+    if (level != SimdLevel::Scalar) i += SNorm16SSE(in + i, count - i, out + i);
+#else
+    (void)level;
+#endif
+    for (; i < count; ++i) out[i] = FloatToSNorm16(in[i]);
+}
+
+void SwizzleColors(const uint32_t* in, size_t count, ColorSwizzle swizzle, uint32_t setBits, uint32_t* out, SimdLevel level) noexcept {
+    size_t i = 0;
+#if GFX_X86
+    // pshufb mask for eight colors.
+    uint8_t mask[32];
+    for (uint32_t b = 0; b < 32; ++b) mask[b] = static_cast<uint8_t>((b & 12) + (swizzle.source[b & 3] & 3));
+    if (level == SimdLevel::AVX2) i = SwizzleAVX2(in, count, mask, setBits, out);
+    if (UseSSE41(level)) i += SwizzleSSE41(in + i, count - i, mask, setBits, out + i);
+#else
+    (void)level;
+#endif
+    for (; i < count; ++i) {
+        uint32_t color = in[i], result = setBits;
+        for (uint32_t c = 0; c < 4; ++c) result |= ((color >> ((swizzle.source[c] & 3) * 8)) & 0xFF) << (c * 8);
+        out[i] = result;
+    }
+}
+
+} // namespace gfx
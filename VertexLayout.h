@@ -0,0 +1,196 @@
+#pragma once
+
+#include "MeshFile.h"
+#include "RenderTypes.h"
+#include "Simd.h"
+#include "VertexQuantization.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <utility>
+
+namespace gfx {
+
+enum class VertexSemantic : uint32_t { Position, Normal, Tangent, Color, Texcoord, PointSize, BlendIndices, BlendWeight };
+
+constexpr const char* SemanticName(VertexSemantic semantic) noexcept {
+    switch (semantic) {
+    case VertexSemantic::Position: return "POSITION";
+    case VertexSemantic::Normal: return "NORMAL";
+    case VertexSemantic::Tangent: return "TANGENT";
+    case VertexSemantic::Color: return "COLOR";
+    case VertexSemantic::Texcoord: return "TEXCOORD";
+    case VertexSemantic::PointSize: return "PSIZE";
+    case VertexSemantic::BlendIndices: return "BLENDINDICES";
+    case VertexSemantic::BlendWeight: return "BLENDWEIGHT";
+    }
+    return "";
+}
+
+// Scalar conversions used by the packers. UNorm8 rounds half up like PackRGBA8;
+// the 16-bit normalized formats round to nearest even. NaN becomes the lower bound.
+inline uint8_t FloatToUNorm8(float v) noexcept {
+    v = v > 0.0f ? v : 0.0f;
+    v = v < 1.0f ? v : 1.0f;
+    return static_cast<uint8_t>(v * 255.0f + 0.5f);
+}
+
+inline uint16_t FloatToUNorm16(float v) noexcept {
+    v = v > 0.0f ? v : 0.0f;
+    v = v < 1.0f ? v : 1.0f;
+    return static_cast<uint16_t>(std::lrint(v * 65535.0f));
+}
+
+inline int16_t FloatToSNorm16(float v) noexcept {
+    v = v > -1.0f ? v : -1.0f;
+    v = v < 1.0f ? v : 1.0f;
+    return static_cast<int16_t>(std::lrint(v * 32767.0f));
+}
+
+// Output byte c of a packed 4x8-bit color is input byte source[c].
+struct ColorSwizzle {
+    uint8_t source[4];
+};
+
+constexpr ColorSwizzle SwizzleNone = { { 0, 1, 2, 3 } };
+// BGRA in memory (D3DCOLOR, 0xAARRGGBB) to RGBA and back.
+constexpr ColorSwizzle SwizzleBGRA = { { 2, 1, 0, 3 } };
+
+// Batch conversions of count values (colors for SwizzleColors). Every level
+// produces the same output; out may alias in for SwizzleColors.
+void ConvertToUNorm8(const float* in, size_t count, uint8_t* out, SimdLevel level = BestSimdLevel()) noexcept;
+void ConvertToUNorm16(const float* in, size_t count, uint16_t* out, SimdLevel level = BestSimdLevel()) noexcept;
+void ConvertToSNorm16(const float* in, size_t count, int16_t* out, SimdLevel level = BestSimdLevel()) noexcept;
+// setBits is OR-ed into every result, e.g. 0xFF000000 to make a COLORREF opaque.
+void SwizzleColors(const uint32_t* in, size_t count, ColorSwizzle swizzle, uint32_t setBits, uint32_t* out,
+                   SimdLevel level = BestSimdLevel()) noexcept;
+
+// Source of one attribute for VertexLayout::Pack. Float streams hold
+// ElementComponents(format) packed floats per vertex. Packed streams already hold
+// elements of the target format and are copied; for R8G8B8A8_UNorm they are run
+// through swizzle and setBits on the way.
+struct AttributeStream {
+    enum Type { Float, Packed };
+
+    const void* data = nullptr;
+    Type type = Float;
+    ColorSwizzle swizzle = SwizzleNone;
+    uint32_t setBits = 0;
+};
+
+template<VertexSemantic Semantic, ElementFormat Format, uint32_t SemanticIndex = 0>
+struct VertexAttribute {
+    static constexpr VertexSemantic semantic = Semantic;
+    static constexpr ElementFormat format = Format;
+    static constexpr uint32_t semanticIndex = SemanticIndex;
+    static constexpr uint32_t size = ElementSize(Format);
+    static_assert(size != 0, "unsupported vertex element format");
+};
+
+// Interleaved vertex whose attributes follow each other in declaration order
+// without padding. Stride, offsets, the runtime MeshVertexLayout (and through
+// D3D11InputLayout.h the input element array) are all compile-time constants, and
+// Pack is instantiated per layout, so the conversion of each attribute is chosen
+// at compile time and the interleave copies fixed-size elements.
+template<typename... Attributes>
+struct VertexLayout {
+    static constexpr uint32_t AttributeCount = sizeof...(Attributes);
+    static constexpr uint32_t Stride = (Attributes::size + ...);
+    static_assert(AttributeCount > 0 && AttributeCount <= MaxMeshAttributes, "vertex layouts hold 1 to MaxMeshAttributes attributes");
+
+    template<uint32_t Index>
+    using Attribute = std::tuple_element_t<Index, std::tuple<Attributes...>>;
+
+    static constexpr uint32_t Offset(uint32_t index) noexcept {
+        const uint32_t sizes[] = { Attributes::size... };
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < index; ++i) offset += sizes[i];
+        return offset;
+    }
+
+    static constexpr MeshVertexLayout Describe() noexcept {
+        const VertexSemantic semantics[] = { Attributes::semantic... };
+        const uint32_t indices[] = { Attributes::semanticIndex... };
+        const ElementFormat formats[] = { Attributes::format... };
+        MeshVertexLayout layout = {};
+        layout.stride = Stride;
+        layout.attributeCount = AttributeCount;
+        for (uint32_t i = 0; i < AttributeCount; ++i) {
+            MeshAttribute& attribute = layout.attributes[i];
+            const char* name = SemanticName(semantics[i]);
+            for (uint32_t k = 0; name[k] && k + 1 < sizeof(attribute.semantic); ++k) attribute.semantic[k] = name[k];
+            attribute.semanticIndex = indices[i];
+            attribute.format = formats[i];
+            attribute.offset = Offset(i);
+        }
+        return layout;
+    }
+
+    // Packs count vertices from one stream per attribute into Stride-byte records.
+    // out is only written to, so it may point into mapped write-combined memory.
+    static void Pack(const AttributeStream (&streams)[AttributeCount], size_t count, void* out,
+                     SimdLevel level = BestSimdLevel()) noexcept {
+        Pack(streams, count, static_cast<uint8_t*>(out), level, std::index_sequence_for<Attributes...>{});
+    }
+
+private:
+    // Vertices converted per attribute before interleaving; the block stays in L1.
+    static constexpr size_t PackBlock = 256;
+
+    template<size_t... Index>
+    static void Pack(const AttributeStream (&streams)[AttributeCount], size_t count, uint8_t* out, SimdLevel level,
+                     std::index_sequence<Index...>) noexcept {
+        for (size_t begin = 0; begin < count; begin += PackBlock) {
+            const size_t n = count - begin < PackBlock ? count - begin : PackBlock;
+            (PackAttribute<Attributes>(streams[Index], begin, n, out + begin * Stride + Offset(Index), level), ...);
+        }
+    }
+
+    template<typename A>
+    static void PackAttribute(const AttributeStream& stream, size_t begin, size_t n, uint8_t* out, SimdLevel level) noexcept {
+        constexpr ElementFormat format = A::format;
+        constexpr uint32_t size = A::size;
+        constexpr uint32_t components = ElementComponents(format);
+        constexpr bool isFloat32 = format == ElementFormat::R32G32B32A32_Float || format == ElementFormat::R32G32B32_Float ||
+                                   format == ElementFormat::R32G32_Float || format == ElementFormat::R32_Float;
+        alignas(32) uint8_t block[PackBlock * size];
+        const uint8_t* packed = block;
+        const float* floats = static_cast<const float*>(stream.data) + begin * components;
+
+        if (stream.type == AttributeStream::Packed) {
+            packed = static_cast<const uint8_t*>(stream.data) + begin * size;
+            if constexpr (format == ElementFormat::R8G8B8A8_UNorm) {
+                SwizzleColors(reinterpret_cast<const uint32_t*>(packed), n, stream.swizzle, stream.setBits,
+                              reinterpret_cast<uint32_t*>(block), level);
+                packed = block;
+            }
+        } else if constexpr (isFloat32) {
+            packed = reinterpret_cast<const uint8_t*>(floats);
+        } else if constexpr (format == ElementFormat::R8G8B8A8_UNorm) {
+            ConvertToUNorm8(floats, n * components, block, level);
+        } else if constexpr (format == ElementFormat::R16G16B16A16_UNorm) {
+            ConvertToUNorm16(floats, n * components, reinterpret_cast<uint16_t*>(block), level);
+        } else if constexpr (format == ElementFormat::R16G16B16A16_SNorm || format == ElementFormat::R16G16_SNorm) {
+            ConvertToSNorm16(floats, n * components, reinterpret_cast<int16_t*>(block), level);
+        } else {
+            static_assert(format == ElementFormat::R16G16B16A16_Float || format == ElementFormat::R16G16_Float, "no packer for format");
+            EncodeHalf(floats, n * components, reinterpret_cast<uint16_t*>(block), level);
+        }
+        for (size_t i = 0; i < n; ++i) std::memcpy(out + i * Stride, packed + i * size, size);
+    }
+
+};
+
+// The 16-byte ColoredVertex, and a tightly packed vertex with a normal and texcoord
+// for meshes that need lighting.
+using ColoredVertexFormat = VertexLayout<VertexAttribute<VertexSemantic::Position, ElementFormat::R32G32B32_Float>,
+                                         VertexAttribute<VertexSemantic::Color, ElementFormat::R8G8B8A8_UNorm>>;
+using LitVertexFormat = VertexLayout<VertexAttribute<VertexSemantic::Position, ElementFormat::R32G32B32_Float>,
+                                     VertexAttribute<VertexSemantic::Normal, ElementFormat::R16G16B16A16_SNorm>,
+                                     VertexAttribute<VertexSemantic::Texcoord, ElementFormat::R16G16_Float>,
+                                     VertexAttribute<VertexSemantic::Color, ElementFormat::R8G8B8A8_UNorm>>;
+
+} // namespace gfx
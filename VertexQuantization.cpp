@@ -0,0 +1,574 @@
+#include "VertexQuantization.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+constexpr size_t EncodeBlock = 256;
+
+inline float CopySign(float magnitude, float sign) noexcept { return std::copysign(magnitude, sign); }
+
+inline uint16_t QuantizeUNorm16(float value) noexcept {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return static_cast<uint16_t>(std::nearbyint(value * 65535.0f));
+}
+
+inline int16_t QuantizeSNorm16(float value) noexcept {
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    return static_cast<int16_t>(std::nearbyint(value * 32767.0f));
+}
+
+void EncodePositionsScalar(const float* p, size_t begin, size_t end, const float inverseScale[3], const float offset[3], uint16_t* out) noexcept {
+    for (size_t i = begin; i < end; ++i) {
+        for (int axis = 0; axis < 3; ++axis) out[i * 4 + axis] = QuantizeUNorm16((p[i * 3 + axis] - offset[axis]) * inverseScale[axis]);
+        out[i * 4 + 3] = 0xFFFF;
+    }
+}
+
+void DecodePositionsScalar(const uint16_t* in, size_t begin, size_t end, const QuantizationBounds& b, float* p) noexcept {
+    for (size_t i = begin; i < end; ++i) {
+        for (int axis = 0; axis < 3; ++axis) p[i * 3 + axis] = b.offset[axis] + in[i * 4 + axis] * (1.0f / 65535.0f) * b.scale[axis];
+    }
+}
+
+// Projects onto the octahedron |x| + |y| + |z| = 1 and folds the lower half over the diagonals.
+void EncodeNormalsScalar(const float* n, size_t begin, size_t end, int16_t* out) noexcept {
+    for (size_t i = begin; i < end; ++i) {
+        float x = n[i * 3], y = n[i * 3 + 1], z = n[i * 3 + 2];
+        float l1 = std::fabs(x) + std::fabs(y) + std::fabs(z);
+        float u = l1 > 0.0f ? x / l1 : 0.0f;
+        float v = l1 > 0.0f ? y / l1 : 0.0f;
+        if (z < 0.0f) {
+            float fu = CopySign(1.0f - std::fabs(v), u);
+            float fv = CopySign(1.0f - std::fabs(u), v);
+            u = fu;
+            v = fv;
+        }
+        out[i * 2] = QuantizeSNorm16(u);
+        out[i * 2 + 1] = QuantizeSNorm16(v);
+    }
+}
+
+void DecodeNormalsScalar(const int16_t* in, size_t begin, size_t end, float* n) noexcept {
+    for (size_t i = begin; i < end; ++i) {
+        float u = std::fmax(in[i * 2] * (1.0f / 32767.0f), -1.0f);
+        float v = std::fmax(in[i * 2 + 1] * (1.0f / 32767.0f), -1.0f);
+        float z = 1.0f - std::fabs(u) - std::fabs(v);
+        float t = std::fmax(-z, 0.0f);
+        u -= CopySign(t, u);
+        v -= CopySign(t, v);
+        float inverseLength = 1.0f / std::sqrt(u * u + v * v + z * z);
+        n[i * 3] = u * inverseLength;
+        n[i * 3 + 1] = v * inverseLength;
+        n[i * 3 + 2] = z * inverseLength;
+    }
+}
+
+#if GFX_X86
+// Four packed float3 in three registers <-> one register per component. The
+// components of each vertex sit in distinct lanes, so a blend plus an in-lane
+// permute does the transpose; the same code works on both halves of a __m256.
+GFX_TARGET_SSE41 inline void Deinterleave3(__m128 a, __m128 b, __m128 c, __m128& x, __m128& y, __m128& z) noexcept {
+    x = _mm_blend_ps(_mm_blend_ps(a, b, 0x4), c, 0x2);
+    y = _mm_blend_ps(_mm_blend_ps(a, b, 0x9), c, 0x4);
+    z = _mm_blend_ps(_mm_blend_ps(a, b, 0x2), c, 0x9);
+    x = _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 2, 3, 0));
+    y = _mm_shuffle_ps(y, y, _MM_SHUFFLE(2, 3, 0, 1));
+    z = _mm_shuffle_ps(z, z, _MM_SHUFFLE(3, 0, 1, 2));
+}
+
+GFX_TARGET_SSE41 inline void Interleave3(__m128 x, __m128 y, __m128 z, __m128& a, __m128& b, __m128& c) noexcept {
+    x = _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 2, 3, 0));
+    y = _mm_shuffle_ps(y, y, _MM_SHUFFLE(2, 3, 0, 1));
+    z = _mm_shuffle_ps(z, z, _MM_SHUFFLE(3, 0, 1, 2));
+    a = _mm_blend_ps(_mm_blend_ps(x, y, 0x2), z, 0x4);
+    b = _mm_blend_ps(_mm_blend_ps(y, z, 0x2), x, 0x4);
+    c = _mm_blend_ps(_mm_blend_ps(z, x, 0x2), y, 0x4);
+}
+
+GFX_TARGET_AVX2 inline void Deinterleave3(__m256 a, __m256 b, __m256 c, __m256& x, __m256& y, __m256& z) noexcept {
+    x = _mm256_blend_ps(_mm256_blend_ps(a, b, 0x44), c, 0x22);
+    y = _mm256_blend_ps(_mm256_blend_ps(a, b, 0x99), c, 0x44);
+    z = _mm256_blend_ps(_mm256_blend_ps(a, b, 0x22), c, 0x99);
+    x = _mm256_shuffle_ps(x, x, _MM_SHUFFLE(1, 2, 3, 0));
+    y = _mm256_shuffle_ps(y, y, _MM_SHUFFLE(2, 3, 0, 1));
+    z = _mm256_shuffle_ps(z, z, _MM_SHUFFLE(3, 0, 1, 2));
+}
+
+GFX_TARGET_AVX2 inline void Interleave3(__m256 x, __m256 y, __m256 z, __m256& a, __m256& b, __m256& c) noexcept {
+    x = _mm256_shuffle_ps(x, x, _MM_SHUFFLE(1, 2, 3, 0));
+    y = _mm256_shuffle_ps(y, y, _MM_SHUFFLE(2, 3, 0, 1));
+    z = _mm256_shuffle_ps(z, z, _MM_SHUFFLE(3, 0, 1, 2));
+    a = _mm256_blend_ps(_mm256_blend_ps(x, y, 0x22), z, 0x44);
+    b = _mm256_blend_ps(_mm256_blend_ps(y, z, 0x22), x, 0x44);
+    c = _mm256_blend_ps(_mm256_blend_ps(z, x, 0x22), y, 0x44);
+}
+
+// Eight float3 starting at p: vertices 0-3 in the low halves, 4-7 in the high halves.
+GFX_TARGET_AVX2 inline void Load8x3(const float* p, __m256& x, __m256& y, __m256& z) noexcept {
+    __m256 a = _mm256_set_m128(_mm_loadu_ps(p + 12), _mm_loadu_ps(p));
+    __m256 b = _mm256_set_m128(_mm_loadu_ps(p + 16), _mm_loadu_ps(p + 4));
+    __m256 c = _mm256_set_m128(_mm_loadu_ps(p + 20), _mm_loadu_ps(p + 8));
+    Deinterleave3(a, b, c, x, y, z);
+}
+
+GFX_TARGET_AVX2 inline void Store8x3(float* p, __m256 x, __m256 y, __m256 z) noexcept {
+    __m256 a, b, c;
+    Interleave3(x, y, z, a, b, c);
+    _mm_storeu_ps(p, _mm256_castps256_ps128(a));
+    _mm_storeu_ps(p + 4, _mm256_castps256_ps128(b));
+    _mm_storeu_ps(p + 8, _mm256_castps256_ps128(c));
+    _mm_storeu_ps(p + 12, _mm256_extractf128_ps(a, 1));
+    _mm_storeu_ps(p + 16, _mm256_extractf128_ps(b, 1));
+    _mm_storeu_ps(p + 20, _mm256_extractf128_ps(c, 1));
+}
+
+GFX_TARGET_SSE41 inline __m128i QuantizeUNorm16(__m128 v, __m128 offset, __m128 inverseScale) noexcept {
+    v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(v, offset), inverseScale), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(65535.0f)));
+}
+
+GFX_TARGET_AVX2 inline __m256i QuantizeUNorm16(__m256 v, __m256 offset, __m256 inverseScale) noexcept {
+    v = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(v, offset), inverseScale), _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    return _mm256_cvtps_epi32(_mm256_mul_ps(v, _mm256_set1_ps(65535.0f)));
+}
+
+GFX_TARGET_SSE41 size_t EncodePositionsSSE41(const float* p, size_t count, const float inverseScale[3], const float offset[3], uint16_t* out) noexcept {
+    const __m128 ox = _mm_set1_ps(offset[0]), oy = _mm_set1_ps(offset[1]), oz = _mm_set1_ps(offset[2]);
+    const __m128 sx = _mm_set1_ps(inverseScale[0]), sy = _mm_set1_ps(inverseScale[1]), sz = _mm_set1_ps(inverseScale[2]);
+    const __m128i w = _mm_set1_epi32(0xFFFF);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y, z;
+        Deinterleave3(_mm_loadu_ps(p + i * 3), _mm_loadu_ps(p + i * 3 + 4), _mm_loadu_ps(p + i * 3 + 8), x, y, z);
+        __m128i xy = _mm_packus_epi32(QuantizeUNorm16(x, ox, sx), QuantizeUNorm16(y, oy, sy));
+        __m128i zw = _mm_packus_epi32(QuantizeUNorm16(z, oz, sz), w);
+        __m128i xz = _mm_unpacklo_epi16(xy, zw);
+        __m128i yw = _mm_unpackhi_epi16(xy, zw);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), _mm_unpacklo_epi16(xz, yw));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4 + 8), _mm_unpackhi_epi16(xz, yw));
+    }
+    return i;
+}
+
+GFX_TARGET_AVX2 size_t EncodePositionsAVX2(const float* p, size_t count, const float inverseScale[3], const float offset[3], uint16_t* out) noexcept {
+    const __m256 ox = _mm256_set1_ps(offset[0]), oy = _mm256_set1_ps(offset[1]), oz = _mm256_set1_ps(offset[2]);
+    const __m256 sx = _mm256_set1_ps(inverseScale[0]), sy = _mm256_set1_ps(inverseScale[1]), sz = _mm256_set1_ps(inverseScale[2]);
+    const __m256i w = _mm256_set1_epi32(0xFFFF);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x, y, z;
+        Load8x3(p + i * 3, x, y, z);
+        __m256i xy = _mm256_packus_epi32(QuantizeUNorm16(x, ox, sx), QuantizeUNorm16(y, oy, sy));
+        __m256i zw = _mm256_packus_epi32(QuantizeUNorm16(z, oz, sz), w);
+        __m256i xz = _mm256_unpacklo_epi16(xy, zw);
+        __m256i yw = _mm256_unpackhi_epi16(xy, zw);
+        __m256i v01 = _mm256_unpacklo_epi16(xz, yw);
+        __m256i v23 = _mm256_unpackhi_epi16(xz, yw);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 4), _mm256_permute2x128_si256(v01, v23, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 4 + 16), _mm256_permute2x128_si256(v01, v23, 0x31));
+    }
+    return i;
+}
+
+GFX_TARGET_SSE41 size_t DecodePositionsSSE41(const uint16_t* in, size_t count, const QuantizationBounds& b, float* p) noexcept {
+    // offset + q * (1 / 65535) * scale with the scalar path's rounding steps.
+    const __m128 unorm = _mm_set1_ps(1.0f / 65535.0f);
+    const __m128 scale = _mm_setr_ps(b.scale[0], b.scale[1], b.scale[2], 0.0f);
+    const __m128 offset = _mm_setr_ps(b.offset[0], b.offset[1], b.offset[2], 0.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i q01 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 4));
+        __m128i q23 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 4 + 8));
+        __m128 v0 = _mm_add_ps(offset, _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(q01)), unorm), scale));
+        __m128 v1 = _mm_add_ps(offset, _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(q01, 8))), unorm), scale));
+        __m128 v2 = _mm_add_ps(offset, _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(q23)), unorm), scale));
+        __m128 v3 = _mm_add_ps(offset, _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(q23, 8))), unorm), scale));
+        // [x y z 0] per vertex -> three registers of packed float3.
+        _mm_storeu_ps(p + i * 3, _mm_blend_ps(v0, _mm_shuffle_ps(v1, v1, _MM_SHUFFLE(0, 0, 0, 0)), 0x8));
+        _mm_storeu_ps(p + i * 3 + 4, _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(1, 0, 2, 1)));
+        _mm_storeu_ps(p + i * 3 + 8, _mm_blend_ps(_mm_shuffle_ps(v3, v3, _MM_SHUFFLE(2, 1, 0, 0)), _mm_shuffle_ps(v2, v2, _MM_SHUFFLE(2, 2, 2, 2)), 0x1));
+    }
+    return i;
+}
+
+GFX_TARGET_AVX2 size_t DecodePositionsAVX2(const uint16_t* in, size_t count, const QuantizationBounds& b, float* p) noexcept {
+    // No FMA and no folded 1 / 65535 * scale, so the result matches the scalar path.
+    const __m256 unorm = _mm256_set1_ps(1.0f / 65535.0f);
+    const __m256 sx = _mm256_set1_ps(b.scale[0]), ox = _mm256_set1_ps(b.offset[0]);
+    const __m256 sy = _mm256_set1_ps(b.scale[1]), oy = _mm256_set1_ps(b.offset[1]);
+    const __m256 sz = _mm256_set1_ps(b.scale[2]), oz = _mm256_set1_ps(b.offset[2]);
+    const __m256i lowHalf = _mm256_set1_epi32(0xFFFF);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // Each 64-bit lane is one vertex (x | y << 16 | z << 32 | w << 48); gather x, y, z
+        // into 32-bit lanes ordered like Load8x3 expects.
+        __m256i q0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i * 4));      // vertices 0-3
+        __m256i q1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i * 4 + 16)); // vertices 4-7
+        __m256i lo = _mm256_permute2x128_si256(q0, q1, 0x20); // v0 v1 | v4 v5
+        __m256i hi = _mm256_permute2x128_si256(q0, q1, 0x31); // v2 v3 | v6 v7
+        __m256i xy = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+        __m256i zw = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi), _MM_SHUFFLE(3, 1, 3, 1)));
+        __m256 x = _mm256_add_ps(ox, _mm256_mul_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(xy, lowHalf)), unorm), sx));
+        __m256 y = _mm256_add_ps(oy, _mm256_mul_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(xy, 16)), unorm), sy));
+        __m256 z = _mm256_add_ps(oz, _mm256_mul_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(zw, lowHalf)), unorm), sz));
+        Store8x3(p + i * 3, x, y, z);
+    }
+    return i;
+}
+
+GFX_TARGET_SSE41 size_t EncodeNormalsSSE41(const float* n, size_t count, int16_t* out) noexcept {
+    const __m128 signMask = _mm_set1_ps(-0.0f), one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+    const __m128 snorm = _mm_set1_ps(32767.0f);
+    const __m128i interleave = _mm_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y, z;
+        Deinterleave3(_mm_loadu_ps(n + i * 3), _mm_loadu_ps(n + i * 3 + 4), _mm_loadu_ps(n + i * 3 + 8), x, y, z);
+        __m128 l1 = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(signMask, x), _mm_andnot_ps(signMask, y)), _mm_andnot_ps(signMask, z));
+        __m128 valid = _mm_cmpgt_ps(l1, zero);
+        __m128 u = _mm_and_ps(_mm_div_ps(x, l1), valid);
+        __m128 v = _mm_and_ps(_mm_div_ps(y, l1), valid);
+        __m128 fu = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, v)), _mm_and_ps(u, signMask));
+        __m128 fv = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, u)), _mm_and_ps(v, signMask));
+        __m128 lower = _mm_cmplt_ps(z, zero);
+        u = _mm_blendv_ps(u, fu, lower);
+        v = _mm_blendv_ps(v, fv, lower);
+        __m128i qu = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(u, _mm_set1_ps(-1.0f)), one), snorm));
+        __m128i qv = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-1.0f)), one), snorm));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), _mm_shuffle_epi8(_mm_packs_epi32(qu, qv), interleave));
+    }
+    return i;
+}
+
+GFX_TARGET_AVX2 size_t EncodeNormalsAVX2(const float* n, size_t count, int16_t* out) noexcept {
+    const __m256 signMask = _mm256_set1_ps(-0.0f), one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps();
+    const __m256 snorm = _mm256_set1_ps(32767.0f), minusOne = _mm256_set1_ps(-1.0f);
+    const __m256i interleave = _mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15,
+                                                0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x, y, z;
+        Load8x3(n + i * 3, x, y, z);
+        __m256 l1 = _mm256_add_ps(_mm256_add_ps(_mm256_andnot_ps(signMask, x), _mm256_andnot_ps(signMask, y)), _mm256_andnot_ps(signMask, z));
+        __m256 valid = _mm256_cmp_ps(l1, zero, _CMP_GT_OQ);
+        __m256 u = _mm256_and_ps(_mm256_div_ps(x, l1), valid);
+        __m256 v = _mm256_and_ps(_mm256_div_ps(y, l1), valid);
+        __m256 fu = _mm256_or_ps(_mm256_sub_ps(one, _mm256_andnot_ps(signMask, v)), _mm256_and_ps(u, signMask));
+        __m256 fv = _mm256_or_ps(_mm256_sub_ps(one, _mm256_andnot_ps(signMask, u)), _mm256_and_ps(v, signMask));
+        __m256 lower = _mm256_cmp_ps(z, zero, _CMP_LT_OQ);
+        u = _mm256_blendv_ps(u, fu, lower);
+        v = _mm256_blendv_ps(v, fv, lower);
+        __m256i qu = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(u, minusOne), one), snorm));
+        __m256i qv = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(v, minusOne), one), snorm));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 2), _mm256_shuffle_epi8(_mm256_packs_epi32(qu, qv), interleave));
+    }
+    return i;
+}
+
+GFX_TARGET_SSE41 size_t DecodeNormalsSSE41(const int16_t* in, size_t count, float* n) noexcept {
+    const __m128 signMask = _mm_set1_ps(-0.0f), one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+    const __m128 scale = _mm_set1_ps(1.0f / 32767.0f), minusOne = _mm_set1_ps(-1.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2));
+        __m128 u = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(q, 16), 16)), scale), minusOne);
+        __m128 v = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(q, 16)), scale), minusOne);
+        __m128 z = _mm_sub_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, u)), _mm_andnot_ps(signMask, v));
+        __m128 t = _mm_max_ps(_mm_sub_ps(zero, z), zero);
+        u = _mm_sub_ps(u, _mm_or_ps(t, _mm_and_ps(u, signMask)));
+        v = _mm_sub_ps(v, _mm_or_ps(t, _mm_and_ps(v, signMask)));
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(u, u), _mm_mul_ps(v, v)), _mm_mul_ps(z, z)));
+        __m128 inverseLength = _mm_div_ps(one, length);
+        __m128 a, b, c;
+        Interleave3(_mm_mul_ps(u, inverseLength), _mm_mul_ps(v, inverseLength), _mm_mul_ps(z, inverseLength), a, b, c);
+        _mm_storeu_ps(n + i * 3, a);
+        _mm_storeu_ps(n + i * 3 + 4, b);
+        _mm_storeu_ps(n + i * 3 + 8, c);
+    }
+    return i;
+}
+
+GFX_TARGET_AVX2 size_t DecodeNormalsAVX2(const int16_t* in, size_t count, float* n) noexcept {
+    const __m256 signMask = _mm256_set1_ps(-0.0f), one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps();
+    const __m256 scale = _mm256_set1_ps(1.0f / 32767.0f), minusOne = _mm256_set1_ps(-1.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i * 2));
+        __m256 u = _mm256_max_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(q, 16), 16)), scale), minusOne);
+        __m256 v = _mm256_max_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(q, 16)), scale), minusOne);
+        __m256 z = _mm256_sub_ps(_mm256_sub_ps(one, _mm256_andnot_ps(signMask, u)), _mm256_andnot_ps(signMask, v));
+        __m256 t = _mm256_max_ps(_mm256_sub_ps(zero, z), zero);
+        u = _mm256_sub_ps(u, _mm256_or_ps(t, _mm256_and_ps(u, signMask)));
+        v = _mm256_sub_ps(v, _mm256_or_ps(t, _mm256_and_ps(v, signMask)));
+        __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(u, u), _mm256_mul_ps(v, v)), _mm256_mul_ps(z, z)));
+        __m256 inverseLength = _mm256_div_ps(one, length);
+        Store8x3(n + i * 3, _mm256_mul_ps(u, inverseLength), _mm256_mul_ps(v, inverseLength), _mm256_mul_ps(z, inverseLength));
+    }
+    return i;
+}
+
+GFX_TARGET_F16C size_t EncodeHalfF16C(const float* in, size_t count, uint16_t* out) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), h);
+    }
+    return i;
+}
+
+GFX_TARGET_F16C size_t DecodeHalfF16C(const uint16_t* in, size_t count, float* out) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+    }
+    return i;
+}
+#endif
+
+inline bool UseSSE41(SimdLevel level) noexcept {
+    return level != SimdLevel::Scalar && GetCpuFeatures().sse41;
+}
+
+} // namespace
+
+const char* const OctahedralDecodeHlsl =
+    "float3 OctDecode(float2 e) {\n"
+    "    float3 n = float3(e, 1.0 - abs(e.x) - abs(e.y));\n"
+    "    float t = saturate(-n.z);\n"
+    "    n.xy += n.xy >= 0.0 ? -t : t;\n"
+    "    return normalize(n);\n"
+    "}\n";
+
+MeshVertexLayout BuildVertexLayout(const VertexFormat& format) noexcept {
+    MeshVertexLayout layout = {};
+    AppendAttribute(layout, "POSITION", format.position == PositionEncoding::UNorm16 ? ElementFormat::R16G16B16A16_UNorm
+                                                                                      : ElementFormat::R32G32B32_Float);
+    if (format.color) AppendAttribute(layout, "COLOR", ElementFormat::R8G8B8A8_UNorm);
+    if (format.normal != NormalEncoding::None) {
+        AppendAttribute(layout, "NORMAL", format.normal == NormalEncoding::Octahedral16 ? ElementFormat::R16G16_SNorm
+                                                                                       : ElementFormat::R32G32B32_Float);
+    }
+    if (format.texcoord != TexcoordEncoding::None) {
+        AppendAttribute(layout, "TEXCOORD", format.texcoord == TexcoordEncoding::Half2 ? ElementFormat::R16G16_Float
+                                                                                      : ElementFormat::R32G32_Float);
+    }
+    return layout;
+}
+
+QuantizationBounds ComputeQuantizationBounds(const float* positions, size_t count) noexcept {
+    float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (size_t i = 0; i < count; ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            float v = positions[i * 3 + axis];
+            lo[axis] = v < lo[axis] ? v : lo[axis];
+            hi[axis] = v > hi[axis] ? v : hi[axis];
+        }
+    }
+    QuantizationBounds bounds;
+    for (int axis = 0; axis < 3; ++axis) {
+        bounds.offset[axis] = count ? lo[axis] : 0.0f;
+        bounds.scale[axis] = count && hi[axis] > lo[axis] ? hi[axis] - lo[axis] : 1.0f;
+    }
+    return bounds;
+}
+
+Float4x4 DequantizationMatrix(const QuantizationBounds& bounds) noexcept {
+    return Multiply(MatrixScaling(bounds.scale[0], bounds.scale[1], bounds.scale[2]),
+                    MatrixTranslation(bounds.offset[0], bounds.offset[1], bounds.offset[2]));
+}
+
+// Half a quantization step plus a few ulps for the float math on both sides.
+float PositionErrorBound(const QuantizationBounds& bounds) noexcept {
+    float bound = 0.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        float axisBound = 0.5f * bounds.scale[axis] / 65535.0f + 4.0f * FLT_EPSILON * (std::fabs(bounds.offset[axis]) + bounds.scale[axis]);
+        bound = std::fmax(bound, axisBound);
+    }
+    return bound;
+}
+
+void EncodePositionsUNorm16(const float* positions, size_t count, const QuantizationBounds& bounds, uint16_t* out, SimdLevel level) noexcept {
+    const float inverseScale[3] = { 1.0f / bounds.scale[0], 1.0f / bounds.scale[1], 1.0f / bounds.scale[2] };
+    size_t done = 0;
+#if GFX_X86
+    if (level == SimdLevel::AVX2) done = EncodePositionsAVX2(positions, count, inverseScale, bounds.offset, out);
+    else if (UseSSE41(level)) done = EncodePositionsSSE41(positions, count, inverseScale, bounds.offset, out);
+#else
+    (void)level;
+#endif
+    EncodePositionsScalar(positions, done, count, inverseScale, bounds.offset, out);
+}
+
+void DecodePositionsUNorm16(const uint16_t* in, size_t count, const QuantizationBounds& bounds, float* positions, SimdLevel level) noexcept {
+    size_t done = 0;
+#if GFX_X86
+    if (level == SimdLevel::AVX2) done = DecodePositionsAVX2(in, count, bounds, positions);
+    else if (UseSSE41(level)) done = DecodePositionsSSE41(in, count, bounds, positions);
+#else
+    (void)level;
+#endif
+    DecodePositionsScalar(in, done, count, bounds, positions);
+}
+
+void EncodeNormalsOctahedral(const float* normals, size_t count, int16_t* out, SimdLevel level) noexcept {
+    size_t done = 0;
+#if GFX_X86
+    if (level == SimdLevel::AVX2) done = EncodeNormalsAVX2(normals, count, out);
+    else if (UseSSE41(level)) done = EncodeNormalsSSE41(normals, count, out);
+#else
+    (void)level;
+#endif
+    EncodeNormalsScalar(normals, done, count, out);
+}
+
+void DecodeNormalsOctahedral(const int16_t* in, size_t count, float* normals, SimdLevel level) noexcept {
+    size_t done = 0;
+#if GFX_X86
+    if (level == SimdLevel::AVX2) done = DecodeNormalsAVX2(in, count, normals);
+    else if (UseSSE41(level)) done = DecodeNormalsSSE41(in, count, normals);
+#else
+    (void)level;
+#endif
+    DecodeNormalsScalar(in, done, count, normals);
+}
+
+// Round-to-nearest-even with overflow to infinity, after Fabian Giesen's float_to_half_fast3_rtne.
+uint16_t FloatToHalf(float value) noexcept {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    bits &= 0x7FFFFFFF;
+    if (bits >= 0x47800000) return sign | (bits > 0x7F800000 ? 0x7E00 : 0x7C00);
+    if (bits < 0x38800000) {
+        // Subnormal half: let the FPU round by adding 0.5, whose ulp is 2^-24.
+        float magnitude;
+        std::memcpy(&magnitude, &bits, sizeof(magnitude));
+        magnitude += 0.5f;
+        std::memcpy(&bits, &magnitude, sizeof(bits));
+        return sign | static_cast<uint16_t>(bits - 0x3F000000);
+    }
+    uint32_t odd = (bits >> 13) & 1;
+    bits += 0xC8000FFFu + odd;
+    return sign | static_cast<uint16_t>(bits >> 13);
+}
+
+float HalfToFloat(uint16_t value) noexcept {
+    uint32_t sign = uint32_t(value & 0x8000) << 16;
+    uint32_t exponent = value & 0x7C00;
+    uint32_t bits = uint32_t(value & 0x7FFF) << 13;
+    float result;
+    if (exponent == 0x7C00) {
+        bits += (255 - 31) << 23;
+    } else if (exponent == 0) {
+        // Subnormal: renormalize through the FPU.
+        bits += 113 << 23;
+        std::memcpy(&result, &bits, sizeof(result));
+        result -= 6.103515625e-05f;
+        std::memcpy(&bits, &result, sizeof(bits));
+    } else {
+        bits += (127 - 15) << 23;
+    }
+    bits |= sign;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void EncodeHalf(const float* in, size_t count, uint16_t* out, SimdLevel level) noexcept {
+    size_t done = 0;
+#if GFX_X86
+    if (level == SimdLevel::AVX2 && GetCpuFeatures().f16c) done = EncodeHalfF16C(in, count, out);
+#else
+    (void)level;
+#endif
+    for (size_t i = done; i < count; ++i) out[i] = FloatToHalf(in[i]);
+}
+
+void DecodeHalf(const uint16_t* in, size_t count, float* out, SimdLevel level) noexcept {
+    size_t done = 0;
+#if GFX_X86
+    if (level == SimdLevel::AVX2 && GetCpuFeatures().f16c) done = DecodeHalfF16C(in, count, out);
+#else
+    (void)level;
+#endif
+    for (size_t i = done; i < count; ++i) out[i] = HalfToFloat(in[i]);
+}
+
+// Both directions go through packed per-attribute blocks, so the SIMD codecs
+// run on contiguous data and only the interleave touches the vertex stride.
+void EncodeVertices(const VertexStreams& in, size_t count, const VertexFormat& format, const QuantizationBounds& bounds,
+                    void* out, SimdLevel level) {
+    const MeshVertexLayout layout = BuildVertexLayout(format);
+    uint8_t* vertices = static_cast<uint8_t*>(out);
+    uint16_t positions[EncodeBlock * 4];
+    int16_t normals[EncodeBlock * 2];
+    uint16_t texcoords[EncodeBlock * 2];
+
+    for (size_t begin = 0; begin < count; begin += EncodeBlock) {
+        size_t n = count - begin < EncodeBlock ? count - begin : EncodeBlock;
+        for (uint32_t a = 0; a < layout.attributeCount; ++a) {
+            const MeshAttribute& attribute = layout.attributes[a];
+            const uint32_t size = ElementSize(attribute.format);
+            const void* source = nullptr;
+            switch (attribute.format) {
+            case ElementFormat::R16G16B16A16_UNorm:
+                EncodePositionsUNorm16(in.positions + begin * 3, n, bounds, positions, level);
+                source = positions;
+                break;
+            case ElementFormat::R16G16_SNorm:
+                EncodeNormalsOctahedral(in.normals + begin * 3, n, normals, level);
+                source = normals;
+                break;
+            case ElementFormat::R16G16_Float:
+                EncodeHalf(in.texcoords + begin * 2, n * 2, texcoords, level);
+                source = texcoords;
+                break;
+            case ElementFormat::R8G8B8A8_UNorm: source = in.colors + begin; break;
+            case ElementFormat::R32G32_Float: source = in.texcoords + begin * 2; break;
+            default: source = (a == 0 ? in.positions : in.normals) + begin * 3; break;
+            }
+            const uint8_t* src = static_cast<const uint8_t*>(source);
+            uint8_t* dst = vertices + begin * layout.stride + attribute.offset;
+            for (size_t i = 0; i < n; ++i) std::memcpy(dst + i * layout.stride, src + i * size, size);
+        }
+    }
+}
+
+void DecodeVertices(const void* in, size_t count, const VertexFormat& format, const QuantizationBounds& bounds,
+                    const VertexOutputStreams& out, SimdLevel level) {
+    const MeshVertexLayout layout = BuildVertexLayout(format);
+    const uint8_t* vertices = static_cast<const uint8_t*>(in);
+    uint16_t packed[EncodeBlock * 4];
+
+    for (size_t begin = 0; begin < count; begin += EncodeBlock) {
+        size_t n = count - begin < EncodeBlock ? count - begin : EncodeBlock;
+        for (uint32_t a = 0; a < layout.attributeCount; ++a) {
+            const MeshAttribute& attribute = layout.attributes[a];
+            const uint32_t size = ElementSize(attribute.format);
+            uint8_t* destination = nullptr;
+            switch (attribute.format) {
+            case ElementFormat::R16G16B16A16_UNorm:
+            case ElementFormat::R16G16_SNorm:
+            case ElementFormat::R16G16_Float: destination = reinterpret_cast<uint8_t*>(packed); break;
+            case ElementFormat::R8G8B8A8_UNorm: destination = reinterpret_cast<uint8_t*>(out.colors + begin); break;
+            case ElementFormat::R32G32_Float: destination = reinterpret_cast<uint8_t*>(out.texcoords + begin * 2); break;
+            default: destination = reinterpret_cast<uint8_t*>((a == 0 ? out.positions : out.normals) + begin * 3); break;
+            }
+            const uint8_t* src = vertices + begin * layout.stride + attribute.offset;
+            for (size_t i = 0; i < n; ++i) std::memcpy(destination + i * size, src + i * layout.stride, size);
+
+            switch (attribute.format) {
+            case ElementFormat::R16G16B16A16_UNorm: DecodePositionsUNorm16(packed, n, bounds, out.positions + begin * 3, level); break;
+            case ElementFormat::R16G16_SNorm: DecodeNormalsOctahedral(reinterpret_cast<int16_t*>(packed), n, out.normals + begin * 3, level); break;
+            case ElementFormat::R16G16_Float: DecodeHalf(packed, n * 2, out.texcoords + begin * 2, level); break;
+            default: break;
+            }
+        }
+    }
+}
+
+} // namespace gfx
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "MathTypes.h"
+#include "MeshFile.h"
+#include "Simd.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gfx {
+
+enum class PositionEncoding { Float3, UNorm16 };
+enum class NormalEncoding { None, Float3, Octahedral16 };
+enum class TexcoordEncoding { None, Float2, Half2 };
+
+// Interleaved vertex made of POSITION, COLOR, NORMAL, TEXCOORD in that order.
+// Float3 positions with color and nothing else is exactly the ColoredVertex layout.
+struct VertexFormat {
+    PositionEncoding position = PositionEncoding::Float3;
+    NormalEncoding normal = NormalEncoding::None;
+    TexcoordEncoding texcoord = TexcoordEncoding::None;
+    bool color = true;
+};
+
+MeshVertexLayout BuildVertexLayout(const VertexFormat& format) noexcept;
+
+// Packed float3 positions and normals, float2 texcoords, RGBA8 colors.
+// Streams the format does not use may be null.
+struct VertexStreams {
+    const float* positions;
+    const float* normals;
+    const float* texcoords;
+    const uint32_t* colors;
+};
+
+struct VertexOutputStreams {
+    float* positions;
+    float* normals;
+    float* texcoords;
+    uint32_t* colors;
+};
+
+// UNorm16 positions store (p - offset) / scale; the decoded position is offset + q * scale.
+struct QuantizationBounds {
+    float offset[3];
+    float scale[3];
+};
+
+QuantizationBounds ComputeQuantizationBounds(const float* positions, size_t count) noexcept;
+
+// Maps decoded [0, 1] positions back to object space; multiply it in front of the
+// model matrix so the vertex shader stays unchanged.
+Float4x4 DequantizationMatrix(const QuantizationBounds& bounds) noexcept;
+
+// Worst-case error of each encoding. Positions: absolute, in object units per axis.
+// Normals: angle in radians, not counting float rounding in the decoder.
+// Half texcoords: relative to the value for |v| >= 2^-14, absolute below that.
+float PositionErrorBound(const QuantizationBounds& bounds) noexcept;
+constexpr float OctahedralNormalErrorBound = 6.48e-5f; // sqrt(18) * 0.5 / 32767
+constexpr float HalfRelativeErrorBound = 1.0f / 2048.0f;
+constexpr float HalfAbsoluteErrorBound = 1.0f / 33554432.0f;
+
+// Batch codecs over packed arrays. Positions encode to four UNorm16 per vertex
+// with w = 1.0; normals to two SNorm16 octahedral coordinates.
+void EncodePositionsUNorm16(const float* positions, size_t count, const QuantizationBounds& bounds,
+                            uint16_t* out, SimdLevel level = BestSimdLevel()) noexcept;
+void DecodePositionsUNorm16(const uint16_t* in, size_t count, const QuantizationBounds& bounds,
+                            float* positions, SimdLevel level = BestSimdLevel()) noexcept;
+void EncodeNormalsOctahedral(const float* normals, size_t count, int16_t* out, SimdLevel level = BestSimdLevel()) noexcept;
+void DecodeNormalsOctahedral(const int16_t* in, size_t count, float* normals, SimdLevel level = BestSimdLevel()) noexcept;
+
+// Round-to-nearest-even float <-> half; uses F16C at the AVX2 level when the CPU has it.
+void EncodeHalf(const float* in, size_t count, uint16_t* out, SimdLevel level = BestSimdLevel()) noexcept;
+void DecodeHalf(const uint16_t* in, size_t count, float* out, SimdLevel level = BestSimdLevel()) noexcept;
+
+uint16_t FloatToHalf(float value) noexcept;
+float HalfToFloat(uint16_t value) noexcept;
+
+// Interleaves and encodes whole vertices into BuildVertexLayout(format).stride-byte records.
+void EncodeVertices(const VertexStreams& in, size_t count, const VertexFormat& format, const QuantizationBounds& bounds,
+                    void* out, SimdLevel level = BestSimdLevel());
+void DecodeVertices(const void* in, size_t count, const VertexFormat& format, const QuantizationBounds& bounds,
+                    const VertexOutputStreams& out, SimdLevel level = BestSimdLevel());
+
+// HLSL for decoding octahedral normals in a vertex shader: float3 OctDecode(float2 e).
+extern const char* const OctahedralDecodeHlsl;
+
+} // namespace gfx
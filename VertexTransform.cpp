@@ -0,0 +1,88 @@
+#include "VertexTransform.h"
+
+namespace gfx {
+
+namespace {
+
+void TransformScalar(const PositionStreams& in, size_t begin, size_t end, const Float4x4& m, const ClipStreams& out) noexcept {
+    for (size_t i = begin; i < end; ++i) {
+        float x = in.x[i], y = in.y[i], z = in.z[i];
+        out.x[i] = x * m.m[0][0] + y * m.m[1][0] + z * m.m[2][0] + m.m[3][0];
+        out.y[i] = x * m.m[0][1] + y * m.m[1][1] + z * m.m[2][1] + m.m[3][1];
+        out.z[i] = x * m.m[0][2] + y * m.m[1][2] + z * m.m[2][2] + m.m[3][2];
+        out.w[i] = x * m.m[0][3] + y * m.m[1][3] + z * m.m[2][3] + m.m[3][3];
+    }
+}
+
+#if GFX_X86
+size_t TransformSSE(const PositionStreams& in, size_t count, const Float4x4& m, const ClipStreams& out) noexcept {
+    __m128 c[4][4];
+    for (int r = 0; r < 4; ++r) {
+        for (int col = 0; col < 4; ++col) c[r][col] = _mm_set1_ps(m.m[r][col]);
+    }
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(in.x + i);
+        __m128 y = _mm_loadu_ps(in.y + i);
+        __m128 z = _mm_loadu_ps(in.z + i);
+        float* dst[4] = { out.x, out.y, out.z, out.w };
+        for (int col = 0; col < 4; ++col) {
+            __m128 r = _mm_add_ps(_mm_mul_ps(x, c[0][col]), c[3][col]);
+            r = _mm_add_ps(r, _mm_mul_ps(y, c[1][col]));
+            r = _mm_add_ps(r, _mm_mul_ps(z, c[2][col]));
+            _mm_storeu_ps(dst[col] + i, r);
+        }
+    }
+    return i;
+}
+
+GFX_TARGET_AVX2 size_t TransformAVX2(const PositionStreams& in, size_t count, const Float4x4& m, const ClipStreams& out) noexcept {
+    __m256 c[4][4];
+    for (int r = 0; r < 4; ++r) {
+        for (int col = 0; col < 4; ++col) c[r][col] = _mm256_set1_ps(m.m[r][col]);
+    }
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(in.x + i);
+        __m256 y = _mm256_loadu_ps(in.y + i);
+        __m256 z = _mm256_loadu_ps(in.z + i);
+        float* dst[4] = { out.x, out.y, out.z, out.w };
+        for (int col = 0; col < 4; ++col) {
+            __m256 r = _mm256_fmadd_ps(x, c[0][col], c[3][col]);
+            r = _mm256_fmadd_ps(y, c[1][col], r);
+            r = _mm256_fmadd_ps(z, c[2][col], r);
+            _mm256_storeu_ps(dst[col] + i, r);
+        }
+    }
+    return i;
+}
+#endif
+
+} // namespace
+
+void TransformPositions(const PositionStreams& in, size_t count, const Float4x4& model, const Float4x4& viewProj,
+                        const ClipStreams& out, SimdLevel level) noexcept {
+    TransformPositions(in, count, Multiply(model, viewProj), out, level);
+}
+
+void TransformPositions(const PositionStreams& in, size_t count, const Float4x4& modelViewProj,
+                        const ClipStreams& out, SimdLevel level) noexcept {
+    size_t done = 0;
+#if GFX_X86
+    if (level == SimdLevel::AVX2) done = TransformAVX2(in, count, modelViewProj, out);
+    else if (level == SimdLevel::SSE) done = TransformSSE(in, count, modelViewProj, out);
+#else
+    (void)level;
+#endif
+    TransformScalar(in, done, count, modelViewProj, out);
+}
+
+void SplitPositions(const ColoredVertex* vertices, size_t count, float* x, float* y, float* z) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        x[i] = vertices[i].position[0];
+        y[i] = vertices[i].position[1];
+        z[i] = vertices[i].position[2];
+    }
+}
+
+} // namespace gfx
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ColoredVertex.h"
+#include "MathTypes.h"
+#include "Simd.h"
+
+#include <cstddef>
+
+namespace gfx {
+
+// Structure-of-arrays position streams. Float4x4 is layout-compatible with
+// XMFLOAT4X4, so the matrices from UpdateModelBuffer/UpdateViewProjBuffer can be passed directly.
+struct PositionStreams {
+    const float* x;
+    const float* y;
+    const float* z;
+};
+
+struct ClipStreams {
+    float* x;
+    float* y;
+    float* z;
+    float* w;
+};
+
+// Batched equivalent of g_VS_Source: clip = float4(pos, 1) * model * viewProj.
+// The AVX2 path handles 8 vertices per iteration, SSE 4, with a scalar tail.
+void TransformPositions(const PositionStreams& in, size_t count, const Float4x4& model, const Float4x4& viewProj,
+                        const ClipStreams& out, SimdLevel level = BestSimdLevel()) noexcept;
+
+// Same, with model * viewProj already combined.
+void TransformPositions(const PositionStreams& in, size_t count, const Float4x4& modelViewProj,
+                        const ClipStreams& out, SimdLevel level = BestSimdLevel()) noexcept;
+
+// Deinterleaves ColoredVertex positions into SoA streams.
+void SplitPositions(const ColoredVertex* vertices, size_t count, float* x, float* y, float* z) noexcept;
+
+} // namespace gfx